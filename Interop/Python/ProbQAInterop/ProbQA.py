@@ -108,6 +108,16 @@ class CiRatedTarget(ctypes.Structure):
     ]
 
 
+class CiQuestionInfo(ctypes.Structure):
+    _pack_ = 8
+    _fields_ = [
+        ('iQuestion', ctypes.c_int64),
+        ('infoGain', ctypes.c_double),
+        ('selectionProb', ctypes.c_double),
+        ('iRedundantWith', ctypes.c_int64),
+    ]
+
+
 class CiAddQorTParam(ctypes.Structure):
     _pack_ = 8
     _fields_ = [
@@ -116,6 +126,19 @@ class CiAddQorTParam(ctypes.Structure):
     ]
 
 
+class CiCheckpointStats(ctypes.Structure):
+    _pack_ = 8
+    _fields_ = [
+        ('lastTimeSec', ctypes.c_int64),
+        ('lastBytes', ctypes.c_uint64),
+        ('lastDurationSec', ctypes.c_double),
+        ('bLastIncremental', ctypes.c_uint8),
+        ('bInProgress', ctypes.c_uint8),
+        ('nCheckpoints', ctypes.c_uint64),
+        ('nFailures', ctypes.c_uint64),
+    ]
+
+
 # PQACORE_API void CiDebugBreak(void);
 pqa_core.CiDebugBreak.restype = None
 pqa_core.CiDebugBreak.argtypes = None
@@ -144,6 +167,17 @@ pqa_core.PqaEngineFactory_LoadCpuEngine.restype = ctypes.c_void_p  # C Engine
 pqa_core.PqaEngineFactory_LoadCpuEngine.argtypes = (ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p),
     ctypes.c_char_p, ctypes.c_uint64)
 
+# PQACORE_API void* PqaEngineFactory_LoadHotSwapCpuEngine(void *pvFactory, void **ppError, const char* filePath,
+#   uint64_t memPoolMaxBytes);
+pqa_core.PqaEngineFactory_LoadHotSwapCpuEngine.restype = ctypes.c_void_p  # C Engine
+pqa_core.PqaEngineFactory_LoadHotSwapCpuEngine.argtypes = (ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p),
+    ctypes.c_char_p, ctypes.c_uint64)
+
+# PQACORE_API void* PqaEngineFactory_FoldKBDelta(void *pvFactory, const char* const basePath,
+#   const char* const destPath);
+pqa_core.PqaEngineFactory_FoldKBDelta.restype = ctypes.c_void_p
+pqa_core.PqaEngineFactory_FoldKBDelta.argtypes = (ctypes.c_void_p, ctypes.c_char_p, ctypes.c_char_p)
+
 # PQACORE_API void CiReleasePqaError(void *pvErr);
 pqa_core.CiReleasePqaError.restype = None
 pqa_core.CiReleasePqaError.argtypes = (ctypes.c_void_p,)
@@ -164,6 +198,15 @@ pqa_core.PqaEngine_Train.restype = ctypes.c_void_p # The error
 pqa_core.PqaEngine_Train.argtypes = (ctypes.c_void_p, ctypes.c_int64, ctypes.POINTER(CiAnsweredQuestion),
     ctypes.c_int64, ctypes.c_double)
 
+# PQACORE_API void* PqaEngine_DecayStatistics(void *pvEngine, const double factor,
+#   const int64_t maxSliceQuestions = 0);
+pqa_core.PqaEngine_DecayStatistics.restype = ctypes.c_void_p # The error
+pqa_core.PqaEngine_DecayStatistics.argtypes = (ctypes.c_void_p, ctypes.c_double, ctypes.c_int64)
+
+# PQACORE_API void* PqaEngine_RecomputeD(void *pvEngine, double *pMaxDrift, const int64_t maxSliceQuestions = 0);
+pqa_core.PqaEngine_RecomputeD.restype = ctypes.c_void_p # The error
+pqa_core.PqaEngine_RecomputeD.argtypes = (ctypes.c_void_p, ctypes.POINTER(ctypes.c_double), ctypes.c_int64)
+
 # PQACORE_API uint8_t PqaEngine_QuestionPermFromComp(void *pvEngine, const int64_t count, int64_t *pIds);
 pqa_core.PqaEngine_QuestionPermFromComp.restype = ctypes.c_bool
 pqa_core.PqaEngine_QuestionPermFromComp.argtypes = (ctypes.c_void_p, ctypes.c_int64, ctypes.POINTER(ctypes.c_int64))
@@ -237,6 +280,12 @@ pqa_core.PqaEngine_ListTopTargets.restype = ctypes.c_int64
 pqa_core.PqaEngine_ListTopTargets.argtypes = (ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p), ctypes.c_int64,
     ctypes.c_int64, ctypes.POINTER(CiRatedTarget))
 
+# PQACORE_API int64_t PqaEngine_AnalyzeQuestions(void *pvEngine, void **ppError, const int64_t maxCount,
+#   CiQuestionInfo *pDest);
+pqa_core.PqaEngine_AnalyzeQuestions.restype = ctypes.c_int64
+pqa_core.PqaEngine_AnalyzeQuestions.argtypes = (ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p), ctypes.c_int64,
+    ctypes.POINTER(CiQuestionInfo))
+
 # PQACORE_API void* PqaEngine_RecordQuizTarget(void *pvEngine, const int64_t iQuiz, const int64_t iTarget,
 #   const double amount = 1.0);
 pqa_core.PqaEngine_RecordQuizTarget.restype = ctypes.c_void_p
@@ -250,6 +299,52 @@ pqa_core.PqaEngine_ReleaseQuiz.argtypes = (ctypes.c_void_p, ctypes.c_int64)
 pqa_core.PqaEngine_SaveKB.restype = ctypes.c_void_p
 pqa_core.PqaEngine_SaveKB.argtypes = (ctypes.c_void_p, ctypes.c_char_p, ctypes.c_bool)
 
+# PQACORE_API void* PqaEngine_SaveIncremental(void *pvEngine);
+pqa_core.PqaEngine_SaveIncremental.restype = ctypes.c_void_p
+pqa_core.PqaEngine_SaveIncremental.argtypes = (ctypes.c_void_p,)
+
+# PQACORE_API void* PqaEngine_StartWal(void *pvEngine, const bool bWaitCommit);
+pqa_core.PqaEngine_StartWal.restype = ctypes.c_void_p
+pqa_core.PqaEngine_StartWal.argtypes = (ctypes.c_void_p, ctypes.c_bool)
+
+# PQACORE_API void* PqaEngine_StopWal(void *pvEngine);
+pqa_core.PqaEngine_StopWal.restype = ctypes.c_void_p
+pqa_core.PqaEngine_StopWal.argtypes = (ctypes.c_void_p,)
+
+# PQACORE_API void* PqaEngine_SetCompressKB(void *pvEngine, const bool bCompress);
+pqa_core.PqaEngine_SetCompressKB.restype = ctypes.c_void_p
+pqa_core.PqaEngine_SetCompressKB.argtypes = (ctypes.c_void_p, ctypes.c_bool)
+
+# PQACORE_API void* PqaEngine_StartCheckpointer(void *pvEngine, const char* const filePath, const double intervalSec,
+#   const uint64_t nTrainings, const uint32_t maxIncremental, const double maxBytesPerSec, const uint32_t maxWorkers);
+pqa_core.PqaEngine_StartCheckpointer.restype = ctypes.c_void_p
+pqa_core.PqaEngine_StartCheckpointer.argtypes = (ctypes.c_void_p, ctypes.c_char_p, ctypes.c_double, ctypes.c_uint64,
+    ctypes.c_uint32, ctypes.c_double, ctypes.c_uint32)
+
+# PQACORE_API void* PqaEngine_StopCheckpointer(void *pvEngine);
+pqa_core.PqaEngine_StopCheckpointer.restype = ctypes.c_void_p
+pqa_core.PqaEngine_StopCheckpointer.argtypes = (ctypes.c_void_p,)
+
+# PQACORE_API void* PqaEngine_GetCheckpointStats(void *pvEngine, CiCheckpointStats *pStats);
+pqa_core.PqaEngine_GetCheckpointStats.restype = ctypes.c_void_p
+pqa_core.PqaEngine_GetCheckpointStats.argtypes = (ctypes.c_void_p, ctypes.POINTER(CiCheckpointStats))
+
+# PQACORE_API void* PqaEngine_HotSwapKB(void *pvEngine, const char* const filePath);
+pqa_core.PqaEngine_HotSwapKB.restype = ctypes.c_void_p
+pqa_core.PqaEngine_HotSwapKB.argtypes = (ctypes.c_void_p, ctypes.c_char_p)
+
+# PQACORE_API void* PqaEngine_Warmup(void *pvEngine);
+pqa_core.PqaEngine_Warmup.restype = ctypes.c_void_p
+pqa_core.PqaEngine_Warmup.argtypes = (ctypes.c_void_p,)
+
+# PQACORE_API void* PqaEngine_SaveQuizzes(void *pvEngine, const char* const filePath);
+pqa_core.PqaEngine_SaveQuizzes.restype = ctypes.c_void_p
+pqa_core.PqaEngine_SaveQuizzes.argtypes = (ctypes.c_void_p, ctypes.c_char_p)
+
+# PQACORE_API int64_t PqaEngine_LoadQuizzes(void *pvEngine, void **ppError, const char* const filePath);
+pqa_core.PqaEngine_LoadQuizzes.restype = ctypes.c_int64
+pqa_core.PqaEngine_LoadQuizzes.argtypes = (ctypes.c_void_p, ctypes.POINTER(ctypes.c_void_p), ctypes.c_char_p)
+
 # Second batch of interop implementation
 
 # PQACORE_API void* PqaEngine_StartMaintenance(void *pvEngine, const bool forceQuizes);
@@ -293,6 +388,15 @@ pqa_core.PqaEngine_Shutdown.argtypes = (ctypes.c_void_p, ctypes.c_char_p)
 pqa_core.PqaEngine_ClearOldQuizzes.restype = ctypes.c_void_p
 pqa_core.PqaEngine_ClearOldQuizzes.argtypes = (ctypes.c_void_p, ctypes.c_int64, ctypes.c_double)
 
+# PQACORE_API void* PqaEngine_SetQuizExpiry(void *pvEngine, const int64_t maxCount, const double maxAgeSec,
+#   const uint8_t bBackgroundReaper);
+pqa_core.PqaEngine_SetQuizExpiry.restype = ctypes.c_void_p
+pqa_core.PqaEngine_SetQuizExpiry.argtypes = (ctypes.c_void_p, ctypes.c_int64, ctypes.c_double, ctypes.c_uint8)
+
+# PQACORE_API void* PqaEngine_ReapQuizzes(void *pvEngine);
+pqa_core.PqaEngine_ReapQuizzes.restype = ctypes.c_void_p
+pqa_core.PqaEngine_ReapQuizzes.argtypes = (ctypes.c_void_p,)
+
 # PQACORE_API void* PqaEngine_SetLogger(void *pvEngine, void *pSRLogger);
 # TODO: implement after the API exposing loggers is implemented
 
@@ -353,6 +457,18 @@ class RatedTarget:
         return '[i_target=%d, P=%f%%]' % (self.i_target, self.prob * 100)
 
 
+class QuestionInfo:
+    def __init__(self, i_question: int, info_gain: float, selection_prob: float, i_redundant_with: int):
+        self.i_question = i_question
+        self.info_gain = info_gain
+        self.selection_prob = selection_prob
+        self.i_redundant_with = i_redundant_with
+
+    def __repr__(self):
+        return '[i_question=%d, gain=%f bits, P(select)=%f%%, redundant_with=%d]' % (self.i_question, self.info_gain,
+            self.selection_prob * 100, self.i_redundant_with)
+
+
 class EngineDefinition:
     DEFAULT_MEM_POOL_MAX_BYTES = 512 * 1024 * 1024
     def __init__(self, n_answers : int, n_questions : int, n_targets : int, init_amount = 1.0,
@@ -378,6 +494,22 @@ class EngineDimensions:
         return '[n_answers=%d, n_questions=%d, n_targets=%d]' % (self.n_answers, self.n_questions, self.n_targets)
 
 
+class CheckpointStats:
+    def __init__(self, c_stats: CiCheckpointStats):
+        self.last_time_sec = c_stats.lastTimeSec # since the Unix epoch, 0 if there has been no checkpoint yet
+        self.last_bytes = c_stats.lastBytes
+        self.last_duration_sec = c_stats.lastDurationSec
+        self.last_incremental = bool(c_stats.bLastIncremental)
+        self.in_progress = bool(c_stats.bInProgress)
+        self.n_checkpoints = c_stats.nCheckpoints
+        self.n_failures = c_stats.nFailures
+
+    def __repr__(self):
+        return '[last_time_sec=%d, last_bytes=%d, last_duration_sec=%f, last_incremental=%s, in_progress=%s,' \
+            ' n_checkpoints=%d, n_failures=%d]' % (self.last_time_sec, self.last_bytes, self.last_duration_sec,
+            self.last_incremental, self.in_progress, self.n_checkpoints, self.n_failures)
+
+
 class AddQuestionParam:
     def __init__(self, init_amount = 1.0):
         self.i_question = INVALID_PQA_ID
@@ -508,6 +640,30 @@ class PqaEngine:
                 raise PqaException('Failed to train() the engine: ' + str(err))
         return err
 
+    # Multiplies the amounts of all the training so far by the factor, so that the older training fades. The questions
+    #   are decayed in slices of max_slice_questions, or all at once if it's not positive.
+    def decay_statistics(self, factor: float, max_slice_questions: int = 0, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_DecayStatistics(self.c_engine, ctypes.c_double(factor),
+            ctypes.c_int64(max_slice_questions))
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to decay_statistics(): ' + str(err))
+        return err
+
+    # Recomputes matrix D from matrix A, removing the summation errors accumulated by the training. Returns the maximum
+    #   relative difference found between the old and the recomputed D.
+    def recompute_d(self, max_slice_questions: int = 0) -> float:
+        c_err = ctypes.c_void_p()
+        c_max_drift = ctypes.c_double()
+        c_err.value = pqa_core.PqaEngine_RecomputeD(self.c_engine, ctypes.byref(c_max_drift),
+            ctypes.c_int64(max_slice_questions))
+        err = PqaError.factor(c_err)
+        if err:
+            raise PqaException('Failed to recompute_d(): ' + str(err))
+        return c_max_drift.value
+
     def get_total_questions_asked(self) -> int:
         c_err = ctypes.c_void_p()
         ans = pqa_core.PqaEngine_GetTotalQuestionsAsked(self.c_engine, ctypes.byref(c_err))
@@ -601,6 +757,24 @@ class PqaEngine:
             ans.append(RatedTarget(c_rated_targets[i].iTarget, c_rated_targets[i].prob))
         return ans
 
+    # Returns up to max_count questions, the least informative first.
+    def analyze_questions(self, max_count: int) -> List[QuestionInfo]:
+        c_err = ctypes.c_void_p()
+        try:
+            array_type = CiQuestionInfo * max_count
+            c_infos = array_type()
+            n_listed = pqa_core.PqaEngine_AnalyzeQuestions(self.c_engine, ctypes.byref(c_err),
+                ctypes.c_int64(max_count), c_infos)
+        finally:
+            err = PqaError.factor(c_err)
+        if err:
+            raise PqaException('Failed to analyze_questions(): [%d, %s]' % (n_listed, str(err)))
+        ans = []
+        for i in range(n_listed):
+            ans.append(QuestionInfo(c_infos[i].iQuestion, c_infos[i].infoGain, c_infos[i].selectionProb,
+                c_infos[i].iRedundantWith))
+        return ans
+
     def record_quiz_target(self, i_quiz: int, i_target: int, amount: float = 1.0, throw: bool = True) -> PqaError:
         c_err = ctypes.c_void_p()
         c_err.value = pqa_core.PqaEngine_RecordQuizTarget(self.c_engine, ctypes.c_int64(i_quiz),
@@ -630,6 +804,120 @@ class PqaEngine:
                 raise PqaException('Failed to save_kb(): ' + str(err))
         return err
 
+    # Saves the changes since the last full save_kb() into a delta file next to that KB file.
+    def save_incremental(self, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_SaveIncremental(self.c_engine)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to save_incremental(): ' + str(err))
+        return err
+
+    def start_wal(self, wait_commit: bool, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_StartWal(self.c_engine, wait_commit)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to start_wal(): ' + str(err))
+        return err
+
+    def stop_wal(self, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_StopWal(self.c_engine)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to stop_wal(): ' + str(err))
+        return err
+
+    # Makes save_kb() write the compressed KB file format, which is smaller but is read rather than mapped on load.
+    def set_compress_kb(self, compress: bool, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_SetCompressKB(self.c_engine, compress)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to set_compress_kb(): ' + str(err))
+        return err
+
+    # Saves the KB periodically in a background thread of the engine: every |interval_sec| seconds and/or after
+    #   |n_trainings| trainings (0 for no such trigger), incrementally up to |max_incremental| times in a row,
+    #   writing no more than |max_bytes_per_sec| (0 for no limit) with |max_workers| worker threads (0 for all).
+    def start_checkpointer(self, file_path: str, interval_sec: float = 0, n_trainings: int = 0,
+            max_incremental: int = 0, max_bytes_per_sec: float = 0, max_workers: int = 1,
+            throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_StartCheckpointer(self.c_engine, Utils.str_to_c_char_p(file_path),
+            interval_sec, n_trainings, max_incremental, max_bytes_per_sec, max_workers)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to start_checkpointer(): ' + str(err))
+        return err
+
+    def stop_checkpointer(self, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_StopCheckpointer(self.c_engine)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to stop_checkpointer(): ' + str(err))
+        return err
+
+    def get_checkpoint_stats(self) -> CheckpointStats:
+        c_stats = CiCheckpointStats()
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_GetCheckpointStats(self.c_engine, ctypes.byref(c_stats))
+        err = PqaError.factor(c_err)
+        if err:
+            raise PqaException('Failed to get_checkpoint_stats(): ' + str(err))
+        return CheckpointStats(c_stats)
+
+    # Puts the KB loaded from the file in service, while the quizzes already started keep running on the old KB. Only
+    #   the engines loaded with load_hot_swap_cpu_engine() support it.
+    def hot_swap_kb(self, file_path: str, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_HotSwapKB(self.c_engine, Utils.str_to_c_char_p(file_path))
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to hot_swap_kb(): ' + str(err))
+        return err
+
+    # Pages the KB in and runs a synthetic quiz, so that the first users see the steady-state latency.
+    def warmup(self, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_Warmup(self.c_engine)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to warmup(): ' + str(err))
+        return err
+
+    # Saves the quizzes in progress, so that load_quizzes() restores them after a restart under the same permanent IDs.
+    def save_quizzes(self, file_path: str, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_SaveQuizzes(self.c_engine, Utils.str_to_c_char_p(file_path))
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to save_quizzes(): ' + str(err))
+        return err
+
+    # Returns the number of quizzes restored. Some quizzes may be restored even if an error is raised.
+    def load_quizzes(self, file_path: str) -> int:
+        c_err = ctypes.c_void_p()
+        try:
+            n_restored = pqa_core.PqaEngine_LoadQuizzes(self.c_engine, ctypes.byref(c_err),
+                Utils.str_to_c_char_p(file_path))
+        finally:
+            err = PqaError.factor(c_err)
+        if err:
+            raise PqaException('Failed to load_quizzes(): [%d, %s]' % (n_restored, str(err)))
+        return n_restored
+
     # Note that this function may throw or return error in case there are just active quizzes on the engine
     def start_maintenance(self, force_quizzes: bool, throw: bool = True) -> PqaError:
         c_err = ctypes.c_void_p()
@@ -737,6 +1025,27 @@ class PqaEngine:
                 raise PqaException('Failed to clear_old_quizzes(): ' + str(err))
         return err
 
+    def set_quiz_expiry(self, max_count: int, max_age_sec: float, background_reaper: bool,
+                        throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_SetQuizExpiry(self.c_engine, ctypes.c_int64(max_count),
+                                                       ctypes.c_double(max_age_sec),
+                                                       ctypes.c_uint8(1 if background_reaper else 0))
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to set_quiz_expiry(): ' + str(err))
+        return err
+
+    def reap_quizzes(self, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngine_ReapQuizzes(self.c_engine)
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to reap_quizzes(): ' + str(err))
+        return err
+
 
 class PqaEngineFactory:
     def __init__(self):
@@ -764,8 +1073,9 @@ class PqaEngineFactory:
             raise PqaException('Couldn\'t create a CPU Engine due to a native error: ' + str(err))
         return PqaEngine(c_engine), err
 
-    def load_cpu_engine(self, file_path:str, mem_pool_max_bytes:int = EngineDefinition.DEFAULT_MEM_POOL_MAX_BYTES
-                        ) -> Tuple[PqaEngine, PqaError]:
+    # With warmup=True, calls PqaEngine.warmup() on the engine loaded.
+    def load_cpu_engine(self, file_path:str, mem_pool_max_bytes:int = EngineDefinition.DEFAULT_MEM_POOL_MAX_BYTES,
+                        warmup: bool = False) -> Tuple[PqaEngine, PqaError]:
         c_err = ctypes.c_void_p()
         c_engine = ctypes.c_void_p()
         try:
@@ -775,8 +1085,35 @@ class PqaEngineFactory:
             err = PqaError.factor(c_err)
         if (c_engine.value is None) or (c_engine.value == 0):
             raise PqaException('Couldn\'t load a CPU Engine due to a native error: ' + str(err))
+        engine = PqaEngine(c_engine)
+        if warmup:
+            engine.warmup()
+        return engine, err
+
+    def load_hot_swap_cpu_engine(self, file_path:str,
+                                 mem_pool_max_bytes:int = EngineDefinition.DEFAULT_MEM_POOL_MAX_BYTES
+                                 ) -> Tuple[PqaEngine, PqaError]:
+        c_err = ctypes.c_void_p()
+        c_engine = ctypes.c_void_p()
+        try:
+            c_engine.value = pqa_core.PqaEngineFactory_LoadHotSwapCpuEngine(self.c_factory, ctypes.byref(c_err),
+                Utils.str_to_c_char_p(file_path), ctypes.c_uint64(mem_pool_max_bytes))
+        finally:
+            err = PqaError.factor(c_err)
+        if (c_engine.value is None) or (c_engine.value == 0):
+            raise PqaException('Couldn\'t load a hot-swap CPU Engine due to a native error: ' + str(err))
         return PqaEngine(c_engine), err
 
+    def fold_kb_delta(self, base_path: str, dest_path: str, throw: bool = True) -> PqaError:
+        c_err = ctypes.c_void_p()
+        c_err.value = pqa_core.PqaEngineFactory_FoldKBDelta(self.c_factory, Utils.str_to_c_char_p(base_path),
+            Utils.str_to_c_char_p(dest_path))
+        err = PqaError.factor(c_err)
+        if err:
+            if throw:
+                raise PqaException('Failed to fold_kb_delta(): ' + str(err))
+        return err
+
 
 pqa_engine_factory_instance = PqaEngineFactory()
 
@@ -248,6 +248,44 @@ int LearnBinarySearch(const char* const initKbFp) {
   return 0;
 }
 
+// Measures the throughput of Train() with large batches of answered questions, where the distribution of the
+//   questions among the workers takes a noticeable share of the time.
+int BenchmarkTrain() {
+  PqaError err;
+  EngineDefinition ed;
+  ed._dims._nAnswers = 5;
+  ed._dims._nQuestions = 100 * 1000;
+  ed._dims._nTargets = 100;
+  ed._prec._type = TPqaPrecisionType::Double;
+  IPqaEngine *pEngine = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  if (!err.IsOk() || pEngine == nullptr) {
+    fprintf(stderr, "Failed to instantiate a ProbQA engine: %s\n", err.ToString(true).ToStd().c_str());
+    return int(SRExitCode::UnspecifiedError);
+  }
+  SRFastRandom fr;
+  SREntropyAdapter ea(fr);
+  constexpr TPqaId cnAQs = 1000 * 1000;
+  constexpr int cnBatches = 16;
+  std::vector<AnsweredQuestion> aqs;
+  aqs.reserve(cnAQs);
+  for (TPqaId i = 0; i < cnAQs; i++) {
+    aqs.emplace_back(ea.Generate<TPqaId>(ed._dims._nQuestions), ea.Generate<TPqaId>(ed._dims._nAnswers));
+  }
+  const uint64_t pcStart = GetPerfCnt();
+  for (int i = 0; i < cnBatches; i++) {
+    err = pEngine->Train(cnAQs, aqs.data(), ea.Generate<TPqaId>(ed._dims._nTargets));
+    if (!err.IsOk()) {
+      fprintf(stderr, "Failed to train: %s\n", err.ToString(true).ToStd().c_str());
+      delete pEngine;
+      return int(SRExitCode::UnspecifiedError);
+    }
+  }
+  const double elapsedSec = double(GetPerfCnt() - pcStart) / gPerfCntFreq;
+  printf("Train: %.3lf answered questions/sec\n", cnAQs * cnBatches / elapsedSec);
+  delete pEngine;
+  return 0;
+}
+
 int __cdecl main() {
   const char* baseName = "Logs\\PqaClient";
   if (!CreateDirectoryA("Logs", nullptr)) {
@@ -271,6 +309,7 @@ int __cdecl main() {
     }
   }
 
+  //return BenchmarkTrain(); // To measure the training with large batches
   //return LearnBinarySearch("KBs\\initial.kb"); // To load a saved KB
   return LearnBinarySearch(nullptr); // To create a KB from scratch by training
 }
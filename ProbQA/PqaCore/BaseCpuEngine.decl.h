@@ -14,6 +14,11 @@
 namespace ProbQA {
 
 class BaseCpuEngine : public BaseEngine {
+public: // constants
+  // When the statistics or the buffers of a quiz outgrow their capacity, 1/2^this of the new size is reserved on top
+  //   for the questions and targets appended later.
+  static constexpr uint8_t _cLogGrowthHeadroom = 3;
+
 private:
   const SRPlat::SRThreadCount _nLooseWorkers;
   const SRPlat::SRThreadCount _nMemOpThreads;
@@ -30,6 +35,7 @@ protected: // methods
   PqaError ShutdownWorkers() override final;
 
 public: // Internal interface methods
+  static size_t GrowthHeadroom(const size_t nItems) { return nItems >> _cLogGrowthHeadroom; }
   SRPlat::SRThreadPool& GetWorkers() { return _tpWorkers; }
   const SRPlat::SRThreadCount GetNLooseWorkers() const { return _nLooseWorkers; }
 };
@@ -7,6 +7,7 @@
 #include "../PqaCore/ErrorHelper.h"
 #include "../PqaCore/PqaException.h"
 #include "../PqaCore/BaseQuiz.h"
+#include "../PqaCore/IoThrottle.h"
 
 using namespace SRPlat;
 
@@ -16,9 +17,18 @@ namespace ProbQA {
 
 BaseEngine::BaseEngine(const EngineDefinition& engDef, KBFileInfo *pKbFi) : _dims(engDef._dims),
   _precDef(engDef._prec), _maintSwitch(MaintenanceSwitch::Mode::Regular), _pLogger(SRDefaultLogger::Get()),
-  _memPool(1 + (engDef._memPoolMaxBytes >> SRSimd::_cLogNBytes))
+  _memPool(1 + (engDef._memPoolMaxBytes >> SRSimd::_cLogNBytes)), _quizExpiry(QuizRegistry::CoarseNowSec()),
+  _quizMaxCount(-1), _quizMaxAgeSec(0), _dirtyQuestions(engDef._dims._nQuestions)
 {
-  if (pKbFi != nullptr) {
+  if (pKbFi != nullptr && pKbFi->IsSectioned()) {
+    _nQuestionsAsked.store(pKbFi->HasDelta() ? pKbFi->_delta._nQuestionsAsked : pKbFi->_header._nQuestionsAsked,
+      std::memory_order_release);
+    // The engine marks the questions of the regions in the delta file as dirty when applying it.
+    _checkpointBase = pKbFi->_filePath;
+    _checkpointId = pKbFi->_header._checkpointId;
+    _walLsn = pKbFi->HasDelta() ? pKbFi->_delta._walLsn : pKbFi->_header._walLsn;
+  }
+  else if (pKbFi != nullptr) {
     uint64_t nQuestionsAsked;
     if (std::fread(&nQuestionsAsked, sizeof(nQuestionsAsked), 1, pKbFi->_sf.Get()) != 1) {
       PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(pKbFi->_filePath), SRString::MakeUnowned(SR_FILE_LINE
@@ -33,6 +43,16 @@ void BaseEngine::AfterStatisticsInit(KBFileInfo *pKbFi) {
   _targetGaps.GrowTo(_dims._nTargets);
 
   if (pKbFi != nullptr) {
+    if (pKbFi->HasDelta()) {
+      if (_fseeki64(pKbFi->MetaFile(), int64_t(pKbFi->_delta._meta._offset), SEEK_SET) != 0) {
+        PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(pKbFi->_filePath), SRString::MakeUnowned(
+          SR_FILE_LINE "Can't seek to the meta section of the delta file.")).ThrowMoving();
+      }
+    }
+    else if (pKbFi->IsSectioned() && !pKbFi->Seek(pKbFi->_header.Section(KBSection::Meta)._offset)) {
+      PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(pKbFi->_filePath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't seek to the meta section.")).ThrowMoving();
+    }
     if (!ReadGaps(_questionGaps, *pKbFi)) {
       PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(pKbFi->_filePath), SRString::MakeUnowned(SR_FILE_LINE
         "Can't read the question gaps.")).ThrowMoving();
@@ -42,15 +62,15 @@ void BaseEngine::AfterStatisticsInit(KBFileInfo *pKbFi) {
         "Can't read the target gaps.")).ThrowMoving();
     }
 
-    if (!_pimQuestions.Load(pKbFi->_sf.Get())) {
+    if (!_pimQuestions.Load(pKbFi->MetaFile())) {
       PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(pKbFi->_filePath), SRString::MakeUnowned(SR_FILE_LINE
         "Can't read the question permanent-compact ID mapping.")).ThrowMoving();
     }
-    if (!_pimTargets.Load(pKbFi->_sf.Get())) {
+    if (!_pimTargets.Load(pKbFi->MetaFile())) {
       PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(pKbFi->_filePath), SRString::MakeUnowned(SR_FILE_LINE
         "Can't read the target permanent-compact ID mapping.")).ThrowMoving();
     }
-    if (!_pimQuizzes.Load(pKbFi->_sf.Get())) {
+    if (!_pimQuizzes.Load(pKbFi->MetaFile())) {
       PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(pKbFi->_filePath), SRString::MakeUnowned(SR_FILE_LINE
         "Can't read the quizzes permanent-compact ID mapping.")).ThrowMoving();
     }
@@ -124,7 +144,7 @@ TPqaId BaseEngine::FindNearestQuestion(const TPqaId iMiddle, const __m256i *pQAs
 }
 
 bool BaseEngine::ReadGaps(GapTracker<TPqaId> &gt, KBFileInfo &kbfi) {
-  FILE *fpin = kbfi._sf.Get();
+  FILE *fpin = kbfi.MetaFile();
   TPqaId nGaps;
   if (std::fread(&nGaps, sizeof(nGaps), 1, fpin) != 1) {
     return false;
@@ -189,34 +209,72 @@ bool BaseEngine::TargetCompFromPerm(const TPqaId count, TPqaId *pIds) {
 
 bool BaseEngine::QuizPermFromComp(const TPqaId count, TPqaId *pIds) {
   MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
-  SRLock<SRCriticalSection> csl(_csQuizReg);
+  SRLock<SRCriticalSection> csl(_csQuizPim);
   for (TPqaId i = 0; i < count; i++) {
-    pIds[i] = _pimQuizzes.PermFromComp(pIds[i]);
+    const TPqaId iQuiz = pIds[i];
+    // Compact IDs of the quizzes are generation-tagged slots: reject stale IDs.
+    if (iQuiz < 0 || _quizReg.IdAtSlot(QuizRegistry::SlotFromId(iQuiz)) != iQuiz) {
+      pIds[i] = cInvalidPqaId;
+      continue;
+    }
+    pIds[i] = _pimQuizzes.PermFromComp(QuizRegistry::SlotFromId(iQuiz));
   }
   return true;
 }
 
 bool BaseEngine::QuizCompFromPerm(const TPqaId count, TPqaId *pIds) {
   MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
-  SRLock<SRCriticalSection> csl(_csQuizReg);
+  SRLock<SRCriticalSection> csl(_csQuizPim);
   for (TPqaId i = 0; i < count; i++) {
-    pIds[i] = _pimQuizzes.CompFromPerm(pIds[i]);
+    const TPqaId iSlot = _pimQuizzes.CompFromPerm(pIds[i]);
+    pIds[i] = ((iSlot == cInvalidPqaId) ? cInvalidPqaId : _quizReg.IdAtSlot(uint32_t(iSlot)));
   }
   return true;
 }
 
 bool BaseEngine::EnsurePermQuizGreater(const TPqaId bound) {
   MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
-  SRLock<SRCriticalSection> csl(_csQuizReg);
+  SRLock<SRCriticalSection> csl(_csQuizPim);
   return _pimQuizzes.EnsurePermIdGreater(bound);
 }
 
 bool BaseEngine::RemapQuizPermId(const TPqaId srcPermId, const TPqaId destPermId) {
   MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
-  SRLock<SRCriticalSection> csl(_csQuizReg);
+  SRLock<SRCriticalSection> csl(_csQuizPim);
   return _pimQuizzes.RemapPermId(srcPermId, destPermId);
 }
 
+TPqaId BaseEngine::GetNextPermQuizId() {
+  SRLock<SRCriticalSection> csl(_csQuizPim);
+  return _pimQuizzes.GetNextPermId();
+}
+
+PqaError BaseEngine::RunWarmupQuiz() {
+  PqaError err;
+  const TPqaId iQuiz = StartQuiz(err);
+  if (!err.IsOk()) {
+    return err;
+  }
+  AggregateErrorParams aep;
+  try {
+    PickNextQuestion(err, iQuiz, false);
+    if (err.IsOk()) {
+      aep.Add(RecordAnswer(iQuiz, 0));
+    }
+    aep.Add(std::move(err));
+    // Listing a few targets heapifies the priors, while listing all of them radix-sorts.
+    std::vector<RatedTarget> rts(SRCast::ToSizeT(CopyDims()._nTargets));
+    ListTopTargets(err, iQuiz, 1, rts.data());
+    aep.Add(std::move(err));
+    ListTopTargets(err, iQuiz, TPqaId(rts.size()), rts.data());
+    aep.Add(std::move(err));
+  }
+  CATCH_TO_ERR_SET(err);
+  aep.Add(std::move(err));
+  aep.Add(ReleaseQuiz(iQuiz));
+  return aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Error(s) occurred during the warm-up quiz."));
+}
+
 EngineDimensions BaseEngine::CopyDims() const {
   MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
   if (msal.GetMode() == MaintenanceSwitch::Mode::Regular) {
@@ -244,7 +302,11 @@ PqaError BaseEngine::Train(const TPqaId nQuestions, const AnsweredQuestion* cons
       return PqaError(PqaErrorCode::NonPositiveAmount, new NonPositiveAmountErrorParams(amount), SRString::MakeUnowned(
         SR_FILE_LINE "|amount| must be positive."));
     }
-    return TrainSpec(nQuestions, pAQs, iTarget, amount);
+    PqaError err = TrainSpec(nQuestions, pAQs, iTarget, amount);
+    if (!err.IsOk()) {
+      return err;
+    }
+    return AwaitWalCommit();
   }
   CATCH_TO_ERR_RETURN;
 }
@@ -259,6 +321,10 @@ PqaError BaseEngine::SetLogger(ISRLogger *pLogger) {
 
 PqaError BaseEngine::Shutdown(const char* const saveFilePath) {
   AggregateErrorParams aep;
+  // The reaper would otherwise be waiting for the regular mode, which is never to come.
+  StopQuizReaper(true);
+  // The final save, if any, must not interleave with a checkpoint.
+  StopCheckpointer(true);
   if (!_maintSwitch.Shutdown()) {
     // Return an error saying that the engine seems already shut down.
     SRMessageBuilder mbMsg("MaintenanceSwitch seems already shut down.");
@@ -270,34 +336,62 @@ PqaError BaseEngine::Shutdown(const char* const saveFilePath) {
   }
   // By this moment, all operations must have shut down and no new operations can be started.
 
+  {
+    std::shared_ptr<WriteAheadLog> pWal = std::atomic_exchange(&_pWal, std::shared_ptr<WriteAheadLog>());
+    if (pWal != nullptr && !pWal->WaitCommitted(pWal->GetLastLsn())) {
+      aep.Add(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(pWal->GetPath().c_str()), SRString::MakeUnowned(
+        SR_FILE_LINE "Failed in flushing the write-ahead log when shutting down. See ProbQA log for details.")));
+    }
+  }
+
   if (saveFilePath != nullptr) do {
-    SRSmartFile sf(std::fopen(saveFilePath, "wb"));
+    // As in SaveFullKB(), the previous KB file is replaced only once the new one is complete.
+    const std::string tempPath = std::string(saveFilePath) + ".tmp";
+    SRSmartFile sf(std::fopen(tempPath.c_str(), "wb"));
     if (sf.Get() == nullptr) {
-      aep.Add(PqaError(PqaErrorCode::CantOpenFile, new CantOpenFileErrorParams(saveFilePath), SRString::MakeUnowned(
-        SR_FILE_LINE "Can't open the file to write KB to.")));
+      aep.Add(PqaError(PqaErrorCode::CantOpenFile, new CantOpenFileErrorParams(tempPath.c_str()),
+        SRString::MakeUnowned(SR_FILE_LINE "Can't open the file to write KB to.")));
       break;
     }
-    KBFileInfo kbfi(sf, saveFilePath);
-    aep.Add(LockedSaveKB(kbfi, false));
-    if (!sf.HardFlush()) {
-      aep.Add(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(saveFilePath), SRString::MakeUnowned(SR_FILE_LINE
-        "Failed in hard flushing the KB when shutting down. See ProbQA log for details.")));
+    KBFileInfo kbfi(sf, tempPath.c_str(), KBFormatVersion());
+    PqaError err = LockedSaveKB(kbfi, false);
+    if (err.IsOk() && kbfi.IsSectioned()) {
+      err = SaveSectionedSnapshot(kbfi);
+    }
+    if (err.IsOk() && !sf.HardFlush()) {
+      err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(tempPath.c_str()), SRString::MakeUnowned(
+        SR_FILE_LINE "Failed in hard flushing the KB when shutting down. See ProbQA log for details."));
+    }
+    else if (err.IsOk() && !sf.EarlyClose()) {
+      err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(tempPath.c_str()), SRString::MakeUnowned(
+        SR_FILE_LINE "Failed in closing the file."));
+    }
+    if (err.IsOk()) {
+      err = UnmapKBFile(saveFilePath);
+    }
+    if (err.IsOk()) {
+      err = ReplaceKBFile(tempPath, saveFilePath);
+    }
+    if (!err.IsOk()) {
+      sf.EarlyClose();
+      std::remove(tempPath.c_str());
+      aep.Add(std::move(err));
     }
   } WHILE_FALSE;
 
   //// Release quizzes
-  for (size_t i = 0; i < _quizzes.size(); i++) {
-    if (_quizGaps.IsGap(i)) {
-      continue;
+  _quizReg.ForEachLive([&](const TPqaId iQuiz, BaseQuiz*) {
+    BaseQuiz *pQuiz = _quizReg.Invalidate(iQuiz);
+    if (pQuiz == nullptr) {
+      return;
     }
-    if (!_pimQuizzes.RemoveComp(i)) {
+    if (!_pimQuizzes.RemoveComp(QuizRegistry::SlotFromId(iQuiz))) {
       aep.Add(PqaError(PqaErrorCode::Internal, new InternalErrorParams(__FILE__, __LINE__),
         SRString::MakeUnowned("Failed to remove quiz compact ID.") ));
     }
-    aep.Add(DestroyQuiz(_quizzes[i]));
-  }
-  _quizzes.clear();
-  _quizGaps.Compact(0);
+    _quizReg.Recycle(QuizRegistry::SlotFromId(iQuiz));
+    aep.Add(DestroyQuiz(pQuiz));
+  });
   if (!_pimQuizzes.OnCompact(0, nullptr)) {
     aep.Add(PqaError(PqaErrorCode::Internal, new InternalErrorParams(__FILE__, __LINE__),
       SRString::MakeUnowned("Failed to compact the quiz permanent-compact ID mapper.") ));
@@ -324,7 +418,8 @@ PqaError BaseEngine::LockedSaveKB(KBFileInfo &kbfi, const bool bDoubleBuffer) {
   const size_t nTargets = SRCast::ToSizeT(_dims._nTargets);
 
   size_t bufSize;
-  if (bDoubleBuffer) {
+  // The sectioned format is saved from a snapshot instead, see LockedSaveSectionedKB().
+  if (bDoubleBuffer && !kbfi.IsSectioned()) {
     bufSize = /* reserve */ SRSimd::_cNBytes + sizeof(_precDef) + sizeof(_dims)
       + sizeof(decltype(_nQuestionsAsked)::value_type)
       + NumberSize() * nTargets * (_dims._nQuestions * _dims._nAnswers + _dims._nQuestions + 1);
@@ -337,6 +432,11 @@ PqaError BaseEngine::LockedSaveKB(KBFileInfo &kbfi, const bool bDoubleBuffer) {
       "Can't set file buffer size to ")(bufSize).GetOwnedSRString());
   }
 
+  const uint64_t nQuestionsAsked = _nQuestionsAsked.load(std::memory_order_acquire);
+  if (kbfi.IsSectioned()) {
+    return LockedSaveSectionedKB(kbfi, nQuestionsAsked);
+  }
+
   // Can be out of locks so long that the member variable is const
   if (std::fwrite(&_precDef, sizeof(_precDef), 1, kbfi._sf.Get()) != 1) {
     return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
@@ -348,7 +448,6 @@ PqaError BaseEngine::LockedSaveKB(KBFileInfo &kbfi, const bool bDoubleBuffer) {
       "Can't write engine dimensions header."));
   }
 
-  const uint64_t nQuestionsAsked = _nQuestionsAsked.load(std::memory_order_acquire);
   if (std::fwrite(&nQuestionsAsked, sizeof(nQuestionsAsked), 1, kbfi._sf.Get()) != 1) {
     return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
       "Can't write the number of questions asked."));
@@ -359,6 +458,10 @@ PqaError BaseEngine::LockedSaveKB(KBFileInfo &kbfi, const bool bDoubleBuffer) {
     return err;
   }
 
+  return SaveMeta(kbfi);
+}
+
+PqaError BaseEngine::SaveMeta(KBFileInfo &kbfi) {
   if (!WriteGaps(_questionGaps, kbfi)) {
     return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
       "Can't write the question gaps."));
@@ -384,6 +487,397 @@ PqaError BaseEngine::LockedSaveKB(KBFileInfo &kbfi, const bool bDoubleBuffer) {
   return PqaError();
 }
 
+PqaError BaseEngine::LockedSaveSectionedKB(KBFileInfo &kbfi, const uint64_t nQuestionsAsked) {
+  KBFileHeader &header = kbfi._header;
+  header = KBFileHeader();
+  header._magic = KBFileHeader::_cMagic;
+  header._formatVersion = kbfi._formatVersion;
+  header._headerBytes = sizeof(KBFileHeader);
+  header._prec = _precDef;
+  header._dims = _dims;
+  header._nQuestionsAsked = nQuestionsAsked;
+  header._checkpointId = KBFileHeader::NewCheckpointId();
+  header._walLsn = _walLsn;
+
+  // The engine lays out the sections of statistics, and keeps them as of now for writing them out of the KB lock.
+  try {
+    TakeSnapshot(kbfi);
+  }
+  CATCH_TO_ERR_RETURN;
+
+  // The meta section is small, so it's written right away.
+  PqaError err;
+  KBFileSection &meta = header.Section(KBSection::Meta);
+  meta._offset = header.MetaOffset();
+  if (!kbfi.Seek(meta._offset)) {
+    err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't seek to the meta section."));
+  }
+  else {
+    err = SaveMeta(kbfi);
+    if (err.IsOk()) {
+      const int64_t metaLim = kbfi.Tell();
+      if (metaLim < 0) {
+        err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(
+          SR_FILE_LINE "Can't get the position after the meta section."));
+      }
+      else {
+        meta._nBytes = uint64_t(metaLim) - meta._offset;
+      }
+    }
+  }
+  if (!err.IsOk()) {
+    ReleaseSnapshot();
+  }
+  return err;
+}
+
+PqaError BaseEngine::SaveSectionedSnapshot(KBFileInfo &kbfi) {
+  // The engine writes the sections of statistics at their offsets, in parallel.
+  PqaError err = SaveStatistics(kbfi);
+  {
+    SRRWLock<false> rwl(_rws);
+    ReleaseSnapshot();
+  }
+  if (!err.IsOk()) {
+    return err;
+  }
+
+  // The header is written last, when the section table is known.
+  if (!kbfi.Seek(0) || std::fwrite(&kbfi._header, sizeof(kbfi._header), 1, kbfi._sf.Get()) != 1) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't write KB file header."));
+  }
+  return PqaError();
+}
+
+PqaError BaseEngine::LockedSaveDelta(KBFileInfo &kbfi, const uint64_t nQuestionsAsked) {
+  KBFileHeader &header = kbfi._header;
+  header = KBFileHeader();
+  header._dims = _dims;
+  KBDeltaHeader &delta = kbfi._delta;
+  delta = KBDeltaHeader();
+  delta._magic = KBDeltaHeader::_cMagic;
+  delta._formatVersion = KBDeltaHeader::_cVersion;
+  delta._headerBytes = sizeof(KBDeltaHeader);
+  delta._baseCheckpointId = _checkpointId;
+  delta._dims = _dims;
+  delta._nQuestionsAsked = nQuestionsAsked;
+  delta._walLsn = _walLsn;
+
+  // The engine selects the dirty regions in the layout of the base, and writes them with the index.
+  PqaError err = SaveDeltaStatistics(kbfi);
+  if (!err.IsOk()) {
+    return err;
+  }
+
+  if (!kbfi.Seek(delta._meta._offset)) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't seek to the meta section of the delta file."));
+  }
+  err = SaveMeta(kbfi);
+  if (!err.IsOk()) {
+    return err;
+  }
+  const int64_t metaLim = kbfi.Tell();
+  if (metaLim < 0) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't get the position after the meta section of the delta file."));
+  }
+  delta._meta._nBytes = uint64_t(metaLim) - delta._meta._offset;
+
+  if (!kbfi.Seek(0) || std::fwrite(&delta, sizeof(delta), 1, kbfi._sf.Get()) != 1) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't write KB delta file header."));
+  }
+  return PqaError();
+}
+
+void BaseEngine::MarkQuestionsDirty(const TPqaId nAnswered, const AnsweredQuestion* const pAQs) {
+  for (TPqaId i = 0; i < nAnswered; i++) {
+    _dirtyQuestions.SetOne(pAQs[i]._iQuestion);
+  }
+}
+
+void BaseEngine::MarkQuestionsDirty(const TPqaId iFirstQuestion, const TPqaId iLimQuestion) {
+  for (TPqaId i = iFirstQuestion; i < iLimQuestion; i++) {
+    _dirtyQuestions.SetOne(i);
+  }
+}
+
+void BaseEngine::LogOperation(const WalOp op, std::initializer_list<WriteAheadLog::Chunk> chunks) {
+  if (_pWal == nullptr) {
+    _nUnloggedChanges++;
+    return;
+  }
+  _walLsn++;
+  _pWal->Append(_walLsn, op, chunks);
+}
+
+void BaseEngine::LogTraining(const WalOp op, const TPqaId nAnswered, const AnsweredQuestion* const pAQs,
+  const TPqaId iTarget, const TPqaAmount amount)
+{
+  _nTrainings.fetch_add(1, std::memory_order_relaxed);
+  const WalTrainingHead wth = { iTarget, amount, nAnswered };
+  LogOperation(op, { { &wth, sizeof(wth) }, { pAQs, sizeof(AnsweredQuestion) * SRCast::ToSizeT(nAnswered) } });
+}
+
+PqaError BaseEngine::AwaitWalCommit() {
+  if (!_bWalWaitCommit.load(std::memory_order_relaxed)) {
+    return PqaError();
+  }
+  std::shared_ptr<WriteAheadLog> pWal = std::atomic_load(&_pWal);
+  if (pWal == nullptr) {
+    return PqaError();
+  }
+  // The records of the concurrent operations are flushed at once, so wait for the last one.
+  if (!pWal->WaitCommitted(pWal->GetLastLsn())) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(pWal->GetPath().c_str()), SRString::MakeUnowned(
+      SR_FILE_LINE "The operation is done, but failed to write it to the write-ahead log. See ProbQA log for"
+      " details."));
+  }
+  return PqaError();
+}
+
+void BaseEngine::ReplayWal(KBFileInfo &kbfi) {
+  const std::string walPath = WalFileHeader::PathFor(kbfi._filePath);
+  SRSmartFile sf(std::fopen(walPath.c_str(), "rb"));
+  if (sf.Get() == nullptr) {
+    return; // Nothing has been logged against this base.
+  }
+  WalFileHeader wfh;
+  if (std::fread(&wfh, sizeof(wfh), 1, sf.Get()) != 1 || wfh._magic != WalFileHeader::_cMagic
+    || wfh._formatVersion != WalFileHeader::_cVersion || wfh._headerBytes != sizeof(WalFileHeader))
+  {
+    BELOG(Warning) << SR_FILE_LINE << "Ignoring the write-ahead log with a wrong header: " << walPath;
+    return;
+  }
+  if (wfh._baseCheckpointId != _checkpointId) {
+    // A leftover of an older base saved to the same path.
+    BELOG(Warning) << SR_FILE_LINE << "Ignoring the write-ahead log made against another base: " << walPath;
+    return;
+  }
+  if (_fseeki64(sf.Get(), 0, SEEK_END) != 0) {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(walPath.c_str()), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't seek to the end of the write-ahead log.")).ThrowMoving();
+  }
+  const uint64_t fileBytes = uint64_t(_ftelli64(sf.Get()));
+  if (_fseeki64(sf.Get(), sizeof(wfh), SEEK_SET) != 0) {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(walPath.c_str()), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't seek to the records of the write-ahead log.")).ThrowMoving();
+  }
+
+  const EngineDimensions oldDims = _dims;
+  std::vector<uint8_t> payload;
+  // Consecutive training records are replayed at once, in parallel.
+  std::vector<WalTraining> trainings;
+  std::vector<AnsweredQuestion> trainingAQs;
+  auto&& fnReplayTrainings = [&]() {
+    if (trainings.empty()) {
+      return;
+    }
+    // The answered questions of each training follow those of the previous one.
+    size_t iFirstAQ = 0;
+    for (WalTraining &wt : trainings) {
+      wt._pAQs = trainingAQs.data() + iFirstAQ;
+      iFirstAQ += SRCast::ToSizeT(wt._nAQs);
+    }
+    ReplayTrainingSpec(trainings.data(), trainings.size());
+    trainings.clear();
+    trainingAQs.clear();
+  };
+  auto&& fnThrowCorrupt = [&](const uint64_t lsn) {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(walPath.c_str()), SRMessageBuilder(SR_FILE_LINE
+      "Wrong record in the write-ahead log at LSN=")(lsn).GetOwnedSRString()).ThrowMoving();
+  };
+  auto&& fnThrowIfError = [&](PqaError &err, const uint64_t lsn) {
+    if (!err.IsOk()) {
+      PqaException(err.GetCode(), err.DetachParams(), SRMessageBuilder(SR_FILE_LINE "Failed to replay the operation"
+        " at LSN=")(lsn)(" from the write-ahead log: ")(err.GetMessage()).GetOwnedSRString()).ThrowMoving();
+    }
+  };
+
+  uint64_t validBytes = sizeof(wfh);
+  for (;;) {
+    //// A torn or corrupt record ends the log: it can only be the last group, whose flush hasn't completed.
+    WalRecordHeader wrh;
+    if (fileBytes - validBytes < sizeof(wrh) || std::fread(&wrh, sizeof(wrh), 1, sf.Get()) != 1
+      || fileBytes - validBytes - sizeof(wrh) < wrh._nBytes)
+    {
+      break;
+    }
+    payload.resize(wrh._nBytes);
+    if (wrh._nBytes > 0 && std::fread(payload.data(), wrh._nBytes, 1, sf.Get()) != 1) {
+      break;
+    }
+    const uint32_t checksum = wrh._checksum;
+    wrh._checksum = 0;
+    if (SRChecksum::Crc32c(payload.data(), payload.size(), SRChecksum::Crc32c(&wrh, sizeof(wrh))) != checksum) {
+      break;
+    }
+    validBytes += sizeof(wrh) + wrh._nBytes;
+    if (wrh._lsn <= _walLsn) {
+      continue; // included in the KB files loaded
+    }
+    if (wrh._lsn != _walLsn + 1) {
+      PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(walPath.c_str()), SRMessageBuilder(SR_FILE_LINE
+        "Records are missing in the write-ahead log after LSN=")(_walLsn).GetOwnedSRString()).ThrowMoving();
+    }
+
+    switch (wrh._op) {
+    case WalOp::Train:
+    case WalOp::QuizTarget: {
+      WalTrainingHead wth;
+      if (payload.size() < sizeof(wth)) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      std::memcpy(&wth, payload.data(), sizeof(wth));
+      if (wth._nAQs < 0 || payload.size() != sizeof(wth) + sizeof(AnsweredQuestion) * uint64_t(wth._nAQs)) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      const AnsweredQuestion *pAQs = reinterpret_cast<const AnsweredQuestion*>(payload.data() + sizeof(wth));
+      trainingAQs.insert(trainingAQs.end(), pAQs, pAQs + wth._nAQs);
+      WalTraining wt;
+      wt._pAQs = nullptr; // assigned when the whole batch is read
+      wt._nAQs = wth._nAQs;
+      wt._iTarget = wth._iTarget;
+      wt._amount = wth._amount;
+      wt._bCountAsked = (wrh._op == WalOp::Train);
+      trainings.push_back(wt);
+      if (trainingAQs.size() >= _cWalReplayBatchAQs) {
+        fnReplayTrainings();
+      }
+      break;
+    }
+    case WalOp::AddQsTs:
+    case WalOp::AppendQsTs: {
+      fnReplayTrainings();
+      WalAddHead wah;
+      if (payload.size() < sizeof(wah)) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      std::memcpy(&wah, payload.data(), sizeof(wah));
+      if (wah._nQuestions < 0 || wah._nTargets < 0 || payload.size() != sizeof(wah)
+        + sizeof(TPqaAmount) * (uint64_t(wah._nQuestions) + uint64_t(wah._nTargets)))
+      {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      const TPqaAmount *pAmounts = reinterpret_cast<const TPqaAmount*>(payload.data() + sizeof(wah));
+      // The engine acquires the same gaps as originally, if any, because it's in the same state.
+      std::unique_ptr<AddQuestionParam[]> aqps(new AddQuestionParam[SRCast::ToSizeT(wah._nQuestions)]);
+      for (TPqaId i = 0; i < wah._nQuestions; i++) {
+        aqps[i]._initialAmount = pAmounts[i];
+      }
+      std::unique_ptr<AddTargetParam[]> atps(new AddTargetParam[SRCast::ToSizeT(wah._nTargets)]);
+      for (TPqaId i = 0; i < wah._nTargets; i++) {
+        atps[i]._initialAmount = pAmounts[wah._nQuestions + i];
+      }
+      PqaError err = LockedAddQsTs(wah._nQuestions, aqps.get(), wah._nTargets, atps.get(),
+        /*bReuseGaps*/ wrh._op == WalOp::AddQsTs);
+      fnThrowIfError(err, wrh._lsn);
+      break;
+    }
+    case WalOp::RemoveQuestions:
+    case WalOp::RemoveTargets: {
+      fnReplayTrainings();
+      TPqaId nIds;
+      if (payload.size() < sizeof(nIds)) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      std::memcpy(&nIds, payload.data(), sizeof(nIds));
+      if (nIds < 0 || payload.size() != sizeof(nIds) * (1 + uint64_t(nIds))) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      const TPqaId *pIds = reinterpret_cast<const TPqaId*>(payload.data() + sizeof(nIds));
+      PqaError err = (wrh._op == WalOp::RemoveQuestions) ? LockedRemoveQuestions(nIds, pIds)
+        : LockedRemoveTargets(nIds, pIds);
+      fnThrowIfError(err, wrh._lsn);
+      break;
+    }
+    case WalOp::Compact: {
+      fnReplayTrainings();
+      // The records of the earlier versions have no payload.
+      uint8_t orderByWeight = 0;
+      if (payload.size() == sizeof(orderByWeight)) {
+        orderByWeight = payload[0];
+      }
+      if (payload.size() > sizeof(orderByWeight) || orderByWeight > 1) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      CompactionResult cr;
+      PqaError err = LockedCompact(cr, cInvalidPqaId, orderByWeight == 1);
+      fnThrowIfError(err, wrh._lsn);
+      break;
+    }
+    case WalOp::CompactSlice: {
+      fnReplayTrainings();
+      TPqaId maxMoves;
+      if (payload.size() != sizeof(maxMoves)) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      std::memcpy(&maxMoves, payload.data(), sizeof(maxMoves));
+      if (maxMoves < 0) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      CompactionResult cr;
+      PqaError err = LockedCompact(cr, maxMoves, false);
+      fnThrowIfError(err, wrh._lsn);
+      break;
+    }
+    case WalOp::Decay: {
+      fnReplayTrainings();
+      WalDecayHead wdh;
+      if (payload.size() != sizeof(wdh)) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      std::memcpy(&wdh, payload.data(), sizeof(wdh));
+      if (!(wdh._factor > 0) || !std::isfinite(wdh._factor) || wdh._iFirstQuestion < 0
+        || wdh._iLimQuestion < wdh._iFirstQuestion || wdh._iLimQuestion > _dims._nQuestions || wdh._bDecayB > 1)
+      {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      PqaError err = LockedDecay(wdh._factor, wdh._iFirstQuestion, wdh._iLimQuestion, wdh._bDecayB == 1);
+      fnThrowIfError(err, wrh._lsn);
+      break;
+    }
+    case WalOp::RecomputeD: {
+      fnReplayTrainings();
+      WalQuestionRange wqr;
+      if (payload.size() != sizeof(wqr)) {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      std::memcpy(&wqr, payload.data(), sizeof(wqr));
+      if (wqr._iFirstQuestion < 0 || wqr._iLimQuestion < wqr._iFirstQuestion
+        || wqr._iLimQuestion > _dims._nQuestions)
+      {
+        fnThrowCorrupt(wrh._lsn);
+      }
+      TPqaAmount maxDrift;
+      PqaError err = LockedRecomputeD(wqr._iFirstQuestion, wqr._iLimQuestion, maxDrift);
+      fnThrowIfError(err, wrh._lsn);
+      break;
+    }
+    default:
+      fnThrowCorrupt(wrh._lsn);
+    }
+    _walLsn = wrh._lsn;
+  }
+  fnReplayTrainings();
+
+  if (validBytes < fileBytes) {
+    BELOG(Warning) << SR_FILE_LINE << "Discarding a torn record at byte " << validBytes << " of the write-ahead log "
+      << walPath;
+  }
+  // The log is continued after the valid records, if turned on. The changes replayed are in the log.
+  _walValidBytes = validBytes;
+  _nUnloggedChanges = 0;
+  if (_dims._nQuestions != oldDims._nQuestions || _dims._nTargets != oldDims._nTargets) {
+    // Same as when finishing maintenance.
+    UpdateWithDimensions();
+    _memPool.FreeAllChunks();
+  }
+}
+
 TPqaId BaseEngine::ResumeQuiz(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs) {
   if (nAnswered < 0) {
     err = PqaError(PqaErrorCode::NegativeCount, new NegativeCountErrorParams(nAnswered), SRString::MakeUnowned(
@@ -396,29 +890,40 @@ TPqaId BaseEngine::ResumeQuiz(PqaError& err, const TPqaId nAnswered, const Answe
   return ResumeQuizSpec(err, nAnswered, pAQs);
 }
 
-BaseQuiz* BaseEngine::UseQuiz(PqaError& err, const TPqaId iQuiz) {
-  SRLock<SRCriticalSection> csl(_csQuizReg);
-  const TPqaId nQuizzes = _quizzes.size();
-  if (iQuiz < 0 || iQuiz >= nQuizzes) {
-    csl.EarlyRelease();
-    // For nQuizzes == 0, this may return [0;-1] range: we can't otherwise return an empty range because we return
+PqaError BaseEngine::MakeQuizLookupError(const TPqaId iQuiz) {
+  const TPqaId slotRange = _quizReg.GetSlotRange();
+  if (iQuiz < 0 || TPqaId(QuizRegistry::SlotFromId(iQuiz)) >= slotRange) {
+    // For slotRange == 0, this may return [0;-1] range: we can't otherwise return an empty range because we return
     //   the range with both bounds inclusive.
-    err = PqaError(PqaErrorCode::IndexOutOfRange, new IndexOutOfRangeErrorParams(iQuiz, 0, nQuizzes - 1),
-      SRString::MakeUnowned(SR_FILE_LINE "Quiz index is not in quiz registry range."));
-    return nullptr;
+    return PqaError(PqaErrorCode::IndexOutOfRange, new IndexOutOfRangeErrorParams(iQuiz, 0, slotRange - 1),
+      SRString::MakeUnowned(SR_FILE_LINE "Quiz slot is not in quiz registry range."));
   }
-  if (_quizGaps.IsGap(iQuiz)) {
-    csl.EarlyRelease();
-    err = PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iQuiz), SRString::MakeUnowned(
-      SR_FILE_LINE "Quiz index is not in the registry (but rather at a gap)."));
+  return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iQuiz), SRString::MakeUnowned(
+    SR_FILE_LINE "Quiz ID is not in the registry (released already or stale)."));
+}
+
+BaseQuiz* BaseEngine::UseQuiz(PqaError& err, const TPqaId iQuiz, QuizRegistry::UsageLock &qul) {
+  BaseQuiz *ans = _quizReg.Use(iQuiz);
+  if (ans == nullptr) {
+    err = MakeQuizLookupError(iQuiz);
     return nullptr;
   }
-  BaseQuiz *ans = _quizzes[iQuiz];
-  ans->OnUsage();
+  qul.Init(_quizReg, iQuiz);
+  // The dimensions are read-only in regular mode, except during a pause, when no quiz is in use.
+  if (ans->GetNQuestions() != _dims._nQuestions || ans->GetNTargets() != _dims._nTargets) {
+    err = GrowQuizSpec(ans);
+    if (!err.IsOk()) {
+      return nullptr;
+    }
+  }
   return ans;
 }
 
 TPqaId BaseEngine::NextQuestion(PqaError& err, const TPqaId iQuiz) {
+  return PickNextQuestion(err, iQuiz, true);
+}
+
+TPqaId BaseEngine::PickNextQuestion(PqaError& err, const TPqaId iQuiz, const bool bCount) {
   constexpr auto msMode = MaintenanceSwitch::Mode::Regular;
   if (!_maintSwitch.TryEnterSpecific<msMode>()) {
     err = PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform regular-only"
@@ -427,13 +932,18 @@ TPqaId BaseEngine::NextQuestion(PqaError& err, const TPqaId iQuiz) {
   }
   MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
 
-  BaseQuiz *pQuiz = UseQuiz(err, iQuiz);
+  QuizRegistry::UsageLock qul;
+  BaseQuiz *pQuiz = UseQuiz(err, iQuiz, qul);
   if (pQuiz == nullptr) {
     assert(!err.IsOk());
     return cInvalidPqaId;
   }
 
-  return NextQuestionSpec(err, pQuiz);
+  const TPqaId iQuestion = NextQuestionSpec(err, pQuiz);
+  if (bCount && iQuestion != cInvalidPqaId) {
+    _nQuestionsAsked.fetch_add(1, std::memory_order_relaxed);
+  }
+  return iQuestion;
 }
 
 PqaError BaseEngine::RecordAnswer(const TPqaId iQuiz, const TPqaId iAnswer) {
@@ -451,9 +961,10 @@ PqaError BaseEngine::RecordAnswer(const TPqaId iQuiz, const TPqaId iAnswer) {
   }
 
   BaseQuiz *pQuiz;
+  QuizRegistry::UsageLock qul;
   {
     PqaError err;
-    pQuiz = UseQuiz(err, iQuiz);
+    pQuiz = UseQuiz(err, iQuiz, qul);
     if (pQuiz == nullptr) {
       assert(!err.IsOk());
       return std::move(err);
@@ -463,6 +974,29 @@ PqaError BaseEngine::RecordAnswer(const TPqaId iQuiz, const TPqaId iAnswer) {
   return pQuiz->RecordAnswer(iAnswer);
 }
 
+PqaError BaseEngine::CopyQuizAnswers(const TPqaId iQuiz, std::vector<AnsweredQuestion> &answers) {
+  try {
+    constexpr auto msMode = MaintenanceSwitch::Mode::Regular;
+    if (!_maintSwitch.TryEnterSpecific<msMode>()) {
+      return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform"
+        " regular-only mode operation (copy quiz answers) because current mode is not regular"
+        " (but maintenance/shutdown?)."));
+    }
+    MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+
+    PqaError err;
+    QuizRegistry::UsageLock qul;
+    BaseQuiz *pQuiz = UseQuiz(err, iQuiz, qul);
+    if (pQuiz == nullptr) {
+      assert(!err.IsOk());
+      return err;
+    }
+    answers = pQuiz->GetAnswers();
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
 TPqaId BaseEngine::GetActiveQuestionId(PqaError &err, const TPqaId iQuiz) {
   constexpr auto msMode = MaintenanceSwitch::Mode::Regular;
   if (!_maintSwitch.TryEnterSpecific<msMode>()) {
@@ -474,8 +1008,9 @@ TPqaId BaseEngine::GetActiveQuestionId(PqaError &err, const TPqaId iQuiz) {
   MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
 
   BaseQuiz *pQuiz;
+  QuizRegistry::UsageLock qul;
   {
-    pQuiz = UseQuiz(err, iQuiz);
+    pQuiz = UseQuiz(err, iQuiz, qul);
     if (pQuiz == nullptr) {
       assert(!err.IsOk());
       return cInvalidPqaId;
@@ -495,9 +1030,10 @@ PqaError BaseEngine::SetActiveQuestion(const TPqaId iQuiz, const TPqaId iQuestio
   MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
 
   BaseQuiz *pQuiz;
+  QuizRegistry::UsageLock qul;
   {
     PqaError err;
-    pQuiz = UseQuiz(err, iQuiz);
+    pQuiz = UseQuiz(err, iQuiz, qul);
     if (pQuiz == nullptr) {
       assert(!err.IsOk());
       return err;
@@ -517,7 +1053,8 @@ TPqaId BaseEngine::ListTopTargets(PqaError& err, const TPqaId iQuiz, const TPqaI
   }
   MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
 
-  BaseQuiz *pQuiz = UseQuiz(err, iQuiz);
+  QuizRegistry::UsageLock qul;
+  BaseQuiz *pQuiz = UseQuiz(err, iQuiz, qul);
   if (pQuiz == nullptr) {
     assert(!err.IsOk());
     return cInvalidPqaId;
@@ -526,6 +1063,24 @@ TPqaId BaseEngine::ListTopTargets(PqaError& err, const TPqaId iQuiz, const TPqaI
   return ListTopTargetsSpec(err, pQuiz, maxCount, pDest);
 }
 
+TPqaId BaseEngine::AnalyzeQuestions(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) {
+  if (maxCount < 0) {
+    err = PqaError(PqaErrorCode::NegativeCount, new NegativeCountErrorParams(maxCount), SRString::MakeUnowned(
+      SR_FILE_LINE "The number of questions to list cannot be less than 0."));
+    return cInvalidPqaId;
+  }
+  // The priors of a fresh quiz are only maintained in regular mode.
+  constexpr auto msMode = MaintenanceSwitch::Mode::Regular;
+  if (!_maintSwitch.TryEnterSpecific<msMode>()) {
+    err = PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform regular-only"
+      " mode operation (analyze questions) because current mode is not regular (but maintenance/shutdown?)."));
+    return cInvalidPqaId;
+  }
+  MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+
+  return AnalyzeQuestionsSpec(err, maxCount, pDest);
+}
+
 PqaError BaseEngine::RecordQuizTarget(const TPqaId iQuiz, const TPqaId iTarget, const TPqaAmount amount) {
   if (amount <= 0) {
     return PqaError(PqaErrorCode::NonPositiveAmount, new NonPositiveAmountErrorParams(amount), SRString::MakeUnowned(
@@ -553,16 +1108,21 @@ PqaError BaseEngine::RecordQuizTarget(const TPqaId iQuiz, const TPqaId iTarget,
   }
 
   BaseQuiz *pQuiz;
+  QuizRegistry::UsageLock qul;
   {
     PqaError err;
-    pQuiz = UseQuiz(err, iQuiz);
+    pQuiz = UseQuiz(err, iQuiz, qul);
     if (pQuiz == nullptr) {
       assert(!err.IsOk());
       return std::move(err);
     }
   }
 
-  return RecordQuizTargetSpec(pQuiz, iTarget, amount);
+  PqaError err = RecordQuizTargetSpec(pQuiz, iTarget, amount);
+  if (!err.IsOk()) {
+    return err;
+  }
+  return AwaitWalCommit();
 }
 
 PqaError BaseEngine::ReleaseQuiz(const TPqaId iQuiz) {
@@ -573,100 +1133,645 @@ PqaError BaseEngine::ReleaseQuiz(const TPqaId iQuiz) {
   }
   MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
 
-  BaseQuiz *pQuiz;
-  {
-    SRLock<SRCriticalSection> csl(_csQuizReg);
-    const TPqaId nQuizzes = _quizzes.size();
-    if (iQuiz < 0 || iQuiz >= nQuizzes) {
-      csl.EarlyRelease();
-      // For nQuizzes == 0, this may return [0;-1] range: we can't otherwise return an empty range because we return
-      //   the range with both bounds inclusive.
-      return PqaError(PqaErrorCode::IndexOutOfRange, new IndexOutOfRangeErrorParams(iQuiz, 0, nQuizzes - 1),
-        SRString::MakeUnowned(SR_FILE_LINE "Quiz index is not in quiz registry range."));
-    }
-    if (_quizGaps.IsGap(iQuiz)) {
-      csl.EarlyRelease();
-      return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iQuiz), SRString::MakeUnowned(
-        SR_FILE_LINE "Quiz index is not in the registry (but rather at a gap)."));
-    }
-
-    pQuiz = _quizzes[iQuiz];
-    _quizzes[iQuiz] = nullptr; // avoid double-free problems
-
-    _quizGaps.Release(iQuiz);
-    if (!_pimQuizzes.RemoveComp(iQuiz)) {
-      BELOG(Error) << SR_FILE_LINE << "Failed to remove quiz " << iQuiz << " from permanent-compact ID mapper.";
-    }
+  // Only one of concurrent releases of the same quiz gets it, which avoids double-free problems.
+  BaseQuiz *pQuiz = _quizReg.Invalidate(iQuiz);
+  if (pQuiz == nullptr) {
+    return MakeQuizLookupError(iQuiz);
   }
+  RetireQuizSlot(iQuiz);
 
   return DestroyQuiz(pQuiz);
 }
 
+PqaError BaseEngine::SaveQuizzes(const char* const filePath) {
+  try {
+    PqaError err;
+    // No quiz can be answered, released or expired while it's written.
+    _maintSwitch.Pause<MaintenanceSwitch::Mode::Regular>([&]() {
+      try {
+        err = PausedSaveQuizzes(filePath);
+      }
+      CATCH_TO_ERR_SET(err);
+    });
+    return err;
+  }
+  CATCH_TO_ERR_RETURN;
+}
 
-PqaError BaseEngine::SaveKB(const char* const filePath, const bool bDoubleBuffer) {
+PqaError BaseEngine::PausedSaveQuizzes(const char* const filePath) {
   SRSmartFile sf(std::fopen(filePath, "wb"));
   if (sf.Get() == nullptr) {
     return PqaError(PqaErrorCode::CantOpenFile, new CantOpenFileErrorParams(filePath), SRString::MakeUnowned(
-      SR_FILE_LINE "Can't open the file to write KB to."));
-  }
-
-  KBFileInfo kbfi(sf, filePath);
+      SR_FILE_LINE "Can't open the file to write quizzes to."));
+  }
+  if (std::setvbuf(sf.Get(), nullptr, _IOFBF, _cFileBufSize) != 0) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRMessageBuilder(SR_FILE_LINE
+      "Can't set file buffer size to ")(_cFileBufSize).GetOwnedSRString());
+  }
+
+  std::vector<std::pair<TPqaId, BaseQuiz*>> quizzes;
+  _quizReg.ForEachLive([&](const TPqaId iQuiz, BaseQuiz *pQuiz) {
+    quizzes.emplace_back(iQuiz, pQuiz);
+  });
+
+  QuizFileHeader qfh;
+  std::memset(&qfh, 0, sizeof(qfh));
+  qfh._magic = QuizFileHeader::_cMagic;
+  qfh._formatVersion = QuizFileHeader::_cVersion;
+  qfh._headerBytes = sizeof(QuizFileHeader);
+  qfh._prec = _precDef;
+  qfh._dims = _dims; // read-only in regular mode
+  qfh._priorBytes = NumberSize() * SRCast::ToSizeT(_dims._nTargets);
+  qfh._nQuizzes = quizzes.size();
+  std::vector<TPqaId> permIds(quizzes.size());
   {
-    MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
-    // Can't write engine dimensions before reader-writer lock, because maintenance switch doesn't prevent their change
-    //   in maintenance mode.
-    SRRWLock<false> rwl(_rws);
-
-    PqaError err = LockedSaveKB(kbfi, bDoubleBuffer);
-    if (!err.IsOk()) {
-      return std::move(err);
+    SRLock<SRCriticalSection> csl(_csQuizPim);
+    qfh._nextPermId = _pimQuizzes.GetNextPermId();
+    for (size_t i = 0; i < quizzes.size(); i++) {
+      permIds[i] = _pimQuizzes.PermFromComp(QuizRegistry::SlotFromId(quizzes[i].first));
     }
   }
-
-  if (!sf.HardFlush()) {
+  if (std::fwrite(&qfh, sizeof(qfh), 1, sf.Get()) != 1) {
     return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRString::MakeUnowned(SR_FILE_LINE
-      "Failed in hard flushing the KB. See ProbQA log for details."));
+      "Can't write the header of the quiz file."));
+  }
+
+  for (size_t i = 0; i < quizzes.size(); i++) {
+    BaseQuiz *pQuiz = quizzes[i].second;
+    const std::vector<AnsweredQuestion>& answers = pQuiz->GetAnswers();
+    const void *pPriors = QuizOwnPriors(pQuiz);
+    const size_t nAnswerBytes = sizeof(AnsweredQuestion) * answers.size();
+    const size_t nPriorBytes = ((pPriors == nullptr) ? 0 : SRCast::ToSizeT(qfh._priorBytes));
+
+    QuizFileRecord qfr;
+    std::memset(&qfr, 0, sizeof(qfr));
+    qfr._permId = permIds[i];
+    qfr._activeQuestion = pQuiz->GetActiveQuestion();
+    qfr._nAnswered = TPqaId(answers.size());
+    qfr._bOwnPriors = (pPriors != nullptr);
+    uint32_t crc = SRChecksum::Crc32c(&qfr, sizeof(qfr));
+    crc = SRChecksum::Crc32c(answers.data(), nAnswerBytes, crc);
+    qfr._checksum = SRChecksum::Crc32c(pPriors, nPriorBytes, crc);
+
+    if (std::fwrite(&qfr, sizeof(qfr), 1, sf.Get()) != 1
+      || std::fwrite(answers.data(), 1, nAnswerBytes, sf.Get()) != nAnswerBytes
+      || std::fwrite(pPriors, 1, nPriorBytes, sf.Get()) != nPriorBytes)
+    {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRMessageBuilder(SR_FILE_LINE
+        "Can't write the quiz with permanent ID ")(permIds[i]).GetOwnedSRString());
+    }
   }
-  // Close it explicitly here, to be able to handle and report an error
-  if (!sf.EarlyClose()) {
+  if (!sf.HardFlush()) {
     return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRString::MakeUnowned(SR_FILE_LINE
-      "Failed in closing the file."));
+      "Failed in hard flushing the quizzes. See ProbQA log for details."));
   }
-
   return PqaError();
 }
 
-
-PqaError BaseEngine::StartMaintenance(const bool forceQuizzes) {
+TPqaId BaseEngine::LoadQuizzes(PqaError& err, const char* const filePath) {
   try {
-    constexpr auto cOrigMode = MaintenanceSwitch::Mode::Regular;
-    constexpr auto cTargMode = MaintenanceSwitch::Mode::Maintenance;
-    AggregateErrorParams aep;
-    MaintenanceSwitch::SpecificLeaver<cTargMode> mssl;
-    SRRWLock<true> rwl; // block every read and write until we are clear about quizzes
-    SRLock<SRCriticalSection> csl;
-    mssl = _maintSwitch.SwitchMode<cTargMode>([&]() {
-      rwl.Init(_rws);
-      csl.Init(_csQuizReg);
+    TPqaId nRestored = cInvalidPqaId;
+    // No quiz can be started between the check that there are none and the restore. The quizzes are restored on this
+    //   thread, which may thus enter the regular mode during the pause.
+    _maintSwitch.Pause<MaintenanceSwitch::Mode::Regular>([&]() {
+      try {
+        nRestored = PausedLoadQuizzes(err, filePath);
+      }
+      CATCH_TO_ERR_SET(err);
     });
-    const TPqaId quizRange = _quizzes.size();
-    const TPqaId nQuizzes = quizRange - _quizGaps.GetNGaps();
-    assert(nQuizzes >= 0);
-    if (nQuizzes != 0) {
-      if (forceQuizzes) {
-        for (TPqaId i = 0; i < quizRange; i++) {
-          if (_quizGaps.IsGap(i)) {
-            continue;
-          }
-          BaseQuiz *pQuiz = _quizzes[i];
-          aep.Add(DestroyQuiz(pQuiz));
-          _quizGaps.Release(i);
-          if (!_pimQuizzes.RemoveComp(i)) {
-            aep.Add(PqaError(PqaErrorCode::Internal, new InternalErrorParams(__FILE__, __LINE__),
+    return nRestored;
+  }
+  CATCH_TO_ERR_SET(err);
+  return cInvalidPqaId;
+}
+
+TPqaId BaseEngine::PausedLoadQuizzes(PqaError& err, const char* const filePath) {
+  const TPqaId nLive = _quizReg.GetNLive();
+  if (nLive != 0) {
+    err = PqaError(PqaErrorCode::QuizzesActive, new QuizzesActiveErrorParams(nLive), SRString::MakeUnowned(
+      SR_FILE_LINE "Can't restore quizzes while there are quizzes in progress, because their permanent IDs may"
+      " conflict."));
+    return cInvalidPqaId;
+  }
+  SRSmartFile sf(std::fopen(filePath, "rb"));
+  if (sf.Get() == nullptr) {
+    err = PqaError(PqaErrorCode::CantOpenFile, new CantOpenFileErrorParams(filePath), SRString::MakeUnowned(
+      SR_FILE_LINE "Can't open the file to read quizzes from."));
+    return cInvalidPqaId;
+  }
+  if (std::setvbuf(sf.Get(), nullptr, _IOFBF, _cFileBufSize) != 0) {
+    err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRMessageBuilder(SR_FILE_LINE
+      "Can't set file buffer size to ")(_cFileBufSize).GetOwnedSRString());
+    return cInvalidPqaId;
+  }
+  QuizFileHeader qfh;
+  if (std::fread(&qfh, sizeof(qfh), 1, sf.Get()) != 1 || qfh._magic != QuizFileHeader::_cMagic
+    || qfh._formatVersion != QuizFileHeader::_cVersion || qfh._headerBytes != sizeof(QuizFileHeader))
+  {
+    err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Wrong header of the quiz file."));
+    return cInvalidPqaId;
+  }
+  // In regular mode the dimensions don't change, and the quizzes are only created in regular mode.
+  const bool bSameLayout = qfh._prec._type == _precDef._type && qfh._prec._mantissa == _precDef._mantissa
+    && qfh._prec._exponent == _precDef._exponent && qfh._dims._nAnswers == _dims._nAnswers
+    && qfh._dims._nQuestions == _dims._nQuestions && qfh._dims._nTargets == _dims._nTargets
+    && qfh._priorBytes == NumberSize() * SRCast::ToSizeT(_dims._nTargets);
+  {
+    SRLock<SRCriticalSection> csl(_csQuizPim);
+    // The quizzes get fresh permanent IDs first, which are then remapped to the saved ones below.
+    _pimQuizzes.EnsurePermIdGreater(qfh._nextPermId - 1);
+  }
+
+  AggregateErrorParams aep;
+  TPqaId nRestored = 0;
+  std::vector<AnsweredQuestion> answers;
+  std::vector<uint8_t> priors;
+  for (uint64_t i = 0; i < qfh._nQuizzes; i++) {
+    QuizFileRecord qfr;
+    if (std::fread(&qfr, sizeof(qfr), 1, sf.Get()) != 1 || qfr._nAnswered < 0
+      || qfr._nAnswered > qfh._dims._nQuestions)
+    {
+      aep.Add(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRMessageBuilder(SR_FILE_LINE
+        "Can't read the record of quiz #")(i)(" from the quiz file.").GetOwnedSRString()));
+      break;
+    }
+    answers.resize(SRCast::ToSizeT(qfr._nAnswered));
+    priors.resize(qfr._bOwnPriors ? SRCast::ToSizeT(qfh._priorBytes) : 0);
+    const size_t nAnswerBytes = sizeof(AnsweredQuestion) * answers.size();
+    const uint32_t checksum = qfr._checksum;
+    qfr._checksum = 0;
+    if (std::fread(answers.data(), 1, nAnswerBytes, sf.Get()) != nAnswerBytes
+      || std::fread(priors.data(), 1, priors.size(), sf.Get()) != priors.size()
+      || SRChecksum::Crc32c(priors.data(), priors.size(), SRChecksum::Crc32c(answers.data(), nAnswerBytes,
+        SRChecksum::Crc32c(&qfr, sizeof(qfr)))) != checksum)
+    {
+      // The rest of the file can't be trusted either.
+      aep.Add(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRMessageBuilder(SR_FILE_LINE
+        "Wrong data of the quiz with permanent ID ")(qfr._permId)(" in the quiz file.").GetOwnedSRString()));
+      break;
+    }
+
+    PqaError quizErr;
+    const TPqaId iQuiz = RestoreQuizSpec(quizErr, qfr._nAnswered, answers.data(),
+      (bSameLayout && !priors.empty()) ? priors.data() : nullptr);
+    if (iQuiz == cInvalidPqaId) {
+      aep.Add(PqaError(quizErr.GetCode(), quizErr.DetachParams(), SRMessageBuilder(SR_FILE_LINE "Can't restore"
+        " the quiz with permanent ID ")(qfr._permId)(": ")(quizErr.GetMessage()).GetOwnedSRString()));
+      continue;
+    }
+    // No one knows the ID of the quiz yet, so it can't be used concurrently.
+    _quizReg.Lookup(iQuiz)->SetActiveQuestion(qfr._activeQuestion);
+    bool bRemapped;
+    {
+      SRLock<SRCriticalSection> csl(_csQuizPim);
+      bRemapped = _pimQuizzes.RemapPermId(_pimQuizzes.PermFromComp(QuizRegistry::SlotFromId(iQuiz)),
+        qfr._permId);
+    }
+    if (!bRemapped) {
+      DiscardQuiz(iQuiz, aep);
+      aep.Add(PqaError(PqaErrorCode::Internal, new InternalErrorParams(__FILE__, __LINE__), SRMessageBuilder(
+        SR_FILE_LINE "Can't remap the restored quiz to its permanent ID ")(qfr._permId).GetOwnedSRString()));
+      continue;
+    }
+    nRestored++;
+  }
+  err = aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Some quizzes couldn't be restored."));
+  return nRestored;
+}
+
+
+PqaError BaseEngine::SaveKB(const char* const filePath, const bool bDoubleBuffer) {
+  return SaveFullKB(filePath, bDoubleBuffer, nullptr, 0);
+}
+
+PqaError BaseEngine::SaveFullKB(const char* const filePath, const bool bDoubleBuffer, IoThrottle *pThrottle,
+  const SRThreadCount maxWorkers)
+{
+  SRLock<SRCriticalSection> csl(_csCheckpoint);
+  // Write to a temporary file first, so that a failure doesn't destroy the previous KB file, which may be the base.
+  const std::string tempPath = std::string(filePath) + ".tmp";
+  SRSmartFile sf(std::fopen(tempPath.c_str(), "wb"));
+  if (sf.Get() == nullptr) {
+    return PqaError(PqaErrorCode::CantOpenFile, new CantOpenFileErrorParams(tempPath.c_str()), SRString::MakeUnowned(
+      SR_FILE_LINE "Can't open the file to write KB to."));
+  }
+
+  KBFileInfo kbfi(sf, tempPath.c_str(), KBFormatVersion());
+  kbfi._pThrottle = pThrottle;
+  kbfi._maxWorkers = maxWorkers;
+  std::shared_ptr<WriteAheadLog> pWal;
+  uint64_t nUnloggedChanges = 0;
+  PqaError err;
+  {
+    MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+    {
+      // Can't write engine dimensions before reader-writer lock, because maintenance switch doesn't prevent their
+      //   change in maintenance mode.
+      SRRWLock<false> rwl(_rws);
+
+      err = LockedSaveKB(kbfi, bDoubleBuffer);
+      if (!err.IsOk()) {
+        sf.EarlyClose();
+        std::remove(tempPath.c_str());
+        return std::move(err);
+      }
+      if (kbfi.IsSectioned()) {
+        // The file saved becomes the base once it replaces |filePath|. Meanwhile there is no base.
+        _checkpointBase.clear();
+        _dirtyQuestions.ClearRange(0, _dirtyQuestions.Size());
+        _bKbLayoutChanged = false;
+        nUnloggedChanges = _nUnloggedChanges;
+        // The records from now on belong to the new base. None can be appended concurrently under the shared lock.
+        pWal = _pWal;
+        if (pWal != nullptr && !pWal->BeginRotation(WalFileHeader::PathFor(filePath).c_str(),
+          kbfi._header._checkpointId))
+        {
+          BELOG(Error) << SR_FILE_LINE << "Can't start the write-ahead log for the new base KB file " << filePath;
+        }
+      }
+    }
+    if (kbfi.IsSectioned()) {
+      // The statistics are written from the snapshot while the KB is in use. The layout of the KB can't change
+      //   meanwhile because the maintenance operations wait for _csCheckpoint .
+      err = SaveSectionedSnapshot(kbfi);
+    }
+  }
+
+  bool bDurable = err.IsOk();
+  if (bDurable && !sf.HardFlush()) {
+    bDurable = false;
+    err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(tempPath.c_str()), SRString::MakeUnowned(SR_FILE_LINE
+      "Failed in hard flushing the KB. See ProbQA log for details."));
+  }
+  // Close it explicitly here, to be able to handle and report an error
+  else if (bDurable && !sf.EarlyClose()) {
+    bDurable = false;
+    err = PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(tempPath.c_str()), SRString::MakeUnowned(SR_FILE_LINE
+      "Failed in closing the file."));
+  }
+  if (bDurable) {
+    // The KB may be saved back to the file it's mapped from.
+    MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+    SRRWLock<true> rwl(_rws);
+    err = UnmapKBFile(filePath);
+    bDurable = err.IsOk();
+  }
+  if (bDurable) {
+    err = ReplaceKBFile(tempPath, filePath);
+    bDurable = err.IsOk();
+  }
+  if (!bDurable) {
+    sf.EarlyClose();
+    std::remove(tempPath.c_str());
+  }
+  // The log of the previous base is only truncated once the new base has replaced it durably.
+  if (pWal != nullptr) {
+    pWal->FinishRotation(bDurable);
+  }
+  if (!bDurable) {
+    return err;
+  }
+
+  if (kbfi.IsSectioned()) {
+    _checkpointBase = filePath;
+    _checkpointId = kbfi._header._checkpointId;
+    _nUnloggedSaved = nUnloggedChanges;
+    _walValidBytes = 0;
+    _bWalLost = false;
+    // A delta file made against an earlier base at this path is useless now.
+    std::remove(KBDeltaHeader::PathFor(filePath).c_str());
+  }
+  return PqaError();
+}
+
+PqaError BaseEngine::ReplaceKBFile(const std::string &tempPath, const char* const filePath) {
+  if (!MoveFileExA(tempPath.c_str(), filePath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    const uint32_t le = GetLastError();
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRMessageBuilder(SR_FILE_LINE
+      "Can't replace the KB file with the one saved, GetLastError=")(le).GetOwnedSRString());
+  }
+  return PqaError();
+}
+
+PqaError BaseEngine::SaveIncremental() {
+  return SaveDelta(nullptr, 0);
+}
+
+PqaError BaseEngine::SaveDelta(IoThrottle *pThrottle, const SRThreadCount maxWorkers) {
+  SRLock<SRCriticalSection> csl(_csCheckpoint);
+  if (_checkpointBase.empty()) {
+    return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "There is no base KB file"
+      " to save the changes against. Save the KB in full first."));
+  }
+  const std::string deltaPath = KBDeltaHeader::PathFor(_checkpointBase.c_str());
+  // Write to a temporary file first, so that a failure doesn't destroy the previous delta.
+  const std::string tempPath = deltaPath + ".tmp";
+  uint64_t nUnloggedChanges = 0;
+  {
+    SRSmartFile sf(std::fopen(tempPath.c_str(), "wb"));
+    if (sf.Get() == nullptr) {
+      return PqaError(PqaErrorCode::CantOpenFile, new CantOpenFileErrorParams(tempPath.c_str()),
+        SRString::MakeUnowned(SR_FILE_LINE "Can't open the file to write KB delta to."));
+    }
+    KBFileInfo kbfi(sf, tempPath.c_str(), KBFormatVersion());
+    kbfi._pThrottle = pThrottle;
+    kbfi._maxWorkers = maxWorkers;
+    {
+      MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+      SRRWLock<false> rwl(_rws);
+      if (_bKbLayoutChanged) {
+        return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "KB dimensions have"
+          " changed since the base KB file was saved. Save the KB in full."));
+      }
+      PqaError err = LockedSaveDelta(kbfi, _nQuestionsAsked.load(std::memory_order_acquire));
+      if (!err.IsOk()) {
+        return std::move(err);
+      }
+      nUnloggedChanges = _nUnloggedChanges;
+    }
+    if (!sf.HardFlush()) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(tempPath.c_str()), SRString::MakeUnowned(
+        SR_FILE_LINE "Failed in hard flushing the KB delta. See ProbQA log for details."));
+    }
+    if (!sf.EarlyClose()) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(tempPath.c_str()), SRString::MakeUnowned(
+        SR_FILE_LINE "Failed in closing the file."));
+    }
+  }
+  if (!MoveFileExA(tempPath.c_str(), deltaPath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    const uint32_t le = GetLastError();
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRMessageBuilder(SR_FILE_LINE
+      "Can't replace the KB delta file, GetLastError=")(le).GetOwnedSRString());
+  }
+  // The log is continued over the changes in the delta.
+  _nUnloggedSaved = nUnloggedChanges;
+  _bWalLost = false;
+  return PqaError();
+}
+
+PqaError BaseEngine::StartWal(const bool bWaitCommit) {
+  try {
+    SRLock<SRCriticalSection> csl(_csCheckpoint);
+    if (_checkpointBase.empty()) {
+      return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "There is no base KB file"
+        " to log the changes against. Save the KB in full first."));
+    }
+    MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+    SRRWLock<true> rwl(_rws);
+    if (_pWal == nullptr) {
+      if (_nUnloggedChanges != _nUnloggedSaved || _bWalLost) {
+        return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "The KB has changed"
+          " since the last save without the write-ahead log. Save the KB first."));
+      }
+      std::atomic_store(&_pWal, std::make_shared<WriteAheadLog>(WalFileHeader::PathFor(_checkpointBase.c_str()).c_str(),
+        _checkpointId, _walValidBytes, _walLsn));
+    }
+    _bWalWaitCommit.store(bWaitCommit, std::memory_order_relaxed);
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+PqaError BaseEngine::StopWal() {
+  SRLock<SRCriticalSection> csl(_csCheckpoint);
+  std::shared_ptr<WriteAheadLog> pWal;
+  {
+    MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+    SRRWLock<true> rwl(_rws);
+    pWal = std::atomic_exchange(&_pWal, std::shared_ptr<WriteAheadLog>());
+  }
+  if (pWal == nullptr) {
+    return PqaError();
+  }
+  if (!pWal->WaitCommitted(pWal->GetLastLsn())) {
+    // Can't continue the log until the next save.
+    _bWalLost = true;
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(pWal->GetPath().c_str()), SRString::MakeUnowned(
+      SR_FILE_LINE "Failed in flushing the write-ahead log. See ProbQA log for details."));
+  }
+  _walValidBytes = pWal->GetNBytes();
+  return PqaError();
+}
+
+PqaError BaseEngine::SetCompressKB(const bool bCompress) {
+  // Takes effect from the next save, including the one in progress if it hasn't chosen the format yet.
+  _bCompressKB.store(bCompress, std::memory_order_relaxed);
+  return PqaError();
+}
+
+PqaError BaseEngine::StartCheckpointer(const CheckpointPolicy &policy) {
+  try {
+    if (policy._filePath == nullptr) {
+      return PqaError(PqaErrorCode::NullArgument, nullptr, SRString::MakeUnowned(SR_FILE_LINE "The file path of the"
+        " checkpoint policy is null."));
+    }
+    if (policy._intervalSec < 0 || policy._maxBytesPerSec < 0) {
+      return PqaError(PqaErrorCode::NonPositiveAmount, new NonPositiveAmountErrorParams(
+        std::min(policy._intervalSec, policy._maxBytesPerSec)), SRString::MakeUnowned(SR_FILE_LINE "The interval and"
+        " the write rate limit of the checkpoint policy must be non-negative."));
+    }
+    if (policy._intervalSec == 0 && policy._nTrainings == 0) {
+      return PqaError(PqaErrorCode::NonPositiveAmount, new NonPositiveAmountErrorParams(0), SRString::MakeUnowned(
+        SR_FILE_LINE "The checkpoint policy has no trigger: set the interval or the number of trainings."));
+    }
+    SRLock<SRCriticalSection> csl(_csCheckpointer);
+    if (_bCheckpointerShutdown) {
+      return PqaError(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
+        "BaseEngine::StartCheckpointer()")), SRString::MakeUnowned(SR_FILE_LINE "Can't start the checkpoint"
+        " scheduler."));
+    }
+    _cpPath = policy._filePath;
+    _cpPolicy = policy;
+    _cpPolicy._filePath = _cpPath.c_str();
+    if (_checkpointer.joinable()) {
+      // Let it reconsider the time to wait with the new policy.
+      _checkpointerWake.WakeAll();
+    }
+    else {
+      _checkpointerEpoch++;
+      _checkpointer = std::thread(&BaseEngine::RunCheckpointer, this, _checkpointerEpoch);
+    }
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+PqaError BaseEngine::StopCheckpointer() {
+  StopCheckpointer(false);
+  return PqaError();
+}
+
+PqaError BaseEngine::GetCheckpointStats(CheckpointStats &stats) {
+  SRLock<SRCriticalSection> csl(_csCheckpointer);
+  stats = _cpStats;
+  return PqaError();
+}
+
+PqaError BaseEngine::HotSwapKB(const char* const) {
+  return PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "Hot swap of the KB of an engine not loaded by IPqaEngineFactory::LoadHotSwapCpuEngine().")));
+}
+
+PqaError BaseEngine::Warmup() {
+  try {
+    constexpr auto msMode = MaintenanceSwitch::Mode::Regular;
+    if (!_maintSwitch.TryEnterSpecific<msMode>()) {
+      return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform"
+        " regular-only mode operation (warm-up) because current mode is not regular (but maintenance/shutdown?)."));
+    }
+    {
+      MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+      SRRWLock<false> rwl(_rws);
+      PrefaultStatistics();
+    }
+    return RunWarmupQuiz();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+void BaseEngine::RunCheckpointer(const uint64_t epoch) {
+  // How often to check the number of trainings against the policy.
+  constexpr uint64_t cTrainingPollMs = 1000;
+  SRLock<SRCriticalSection> csl(_csCheckpointer);
+  uint64_t lastMs = GetTickCount64();
+  uint64_t lastTrainings = _nTrainings.load(std::memory_order_relaxed);
+  while (_checkpointerEpoch == epoch) {
+    // The policy may be replaced while waiting, so it's reread on each wake.
+    const uint64_t intervalMs = uint64_t(_cpPolicy._intervalSec * 1000);
+    const uint64_t nowMs = GetTickCount64();
+    bool bDue = (intervalMs != 0 && nowMs - lastMs >= intervalMs) || (_cpPolicy._nTrainings != 0
+      && _nTrainings.load(std::memory_order_relaxed) - lastTrainings >= _cpPolicy._nTrainings);
+    if (!bDue) {
+      uint64_t waitMs = (_cpPolicy._nTrainings != 0) ? cTrainingPollMs : UINT32_MAX - 1;
+      if (intervalMs != 0) {
+        waitMs = std::min(waitMs, lastMs + intervalMs - nowMs);
+      }
+      _checkpointerWake.Wait(_csCheckpointer, uint32_t(waitMs));
+      continue;
+    }
+    const std::string path = _cpPath;
+    CheckpointPolicy policy = _cpPolicy;
+    policy._filePath = path.c_str();
+    const bool bTryIncremental = (_nIncrementalInRow < policy._maxIncremental);
+    _cpStats._bInProgress = true;
+    lastMs = nowMs;
+    lastTrainings = _nTrainings.load(std::memory_order_relaxed);
+    csl.EarlyRelease();
+
+    uint64_t nBytes = 0;
+    bool bIncremental = false;
+    PqaError err = TakeCheckpoint(policy, bTryIncremental, nBytes, bIncremental);
+    const double durationSec = (GetTickCount64() - nowMs) * 1e-3;
+    if (err.IsOk()) {
+      BELOG(Info) << "Checkpoint scheduler: saved " << (bIncremental ? "incrementally " : "in full ") << nBytes
+        << " bytes to " << path << " in " << durationSec << " seconds.";
+    }
+    else {
+      BELOG(Error) << SR_FILE_LINE << "Checkpoint scheduler: " << err.ToString(true);
+    }
+
+    csl.Init(_csCheckpointer);
+    _cpStats._bInProgress = false;
+    if (err.IsOk()) {
+      _cpStats._lastTimeSec = int64_t(std::time(nullptr));
+      _cpStats._lastBytes = nBytes;
+      _cpStats._lastDurationSec = durationSec;
+      _cpStats._bLastIncremental = bIncremental;
+      _cpStats._nCheckpoints++;
+    }
+    else {
+      _cpStats._nFailures++;
+    }
+    // Counted from the last full save attempted, so that a failed one doesn't leave the scheduler retrying full
+    //   saves only.
+    _nIncrementalInRow = bIncremental ? (_nIncrementalInRow + 1) : 0;
+  }
+}
+
+void BaseEngine::StopCheckpointer(const bool bShutdown) {
+  std::thread checkpointer;
+  {
+    SRLock<SRCriticalSection> csl(_csCheckpointer);
+    if (bShutdown) {
+      _bCheckpointerShutdown = true;
+    }
+    if (!_checkpointer.joinable()) {
+      return;
+    }
+    _checkpointerEpoch++;
+    checkpointer = std::move(_checkpointer);
+  }
+  _checkpointerWake.WakeAll();
+  checkpointer.join();
+}
+
+PqaError BaseEngine::TakeCheckpoint(const CheckpointPolicy &policy, const bool bTryIncremental, uint64_t &nBytes,
+  bool &bIncremental)
+{
+  std::unique_ptr<IoThrottle> pThrottle;
+  if (policy._maxBytesPerSec > 0) {
+    pThrottle.reset(new IoThrottle(policy._maxBytesPerSec));
+  }
+  const SRThreadCount maxWorkers = SRThreadCount(policy._maxWorkers);
+  std::string writtenPath;
+  bIncremental = false;
+  if (bTryIncremental) {
+    // Keep the base from changing between the check and the save.
+    SRLock<SRCriticalSection> cpl(_csCheckpoint);
+    if (_checkpointBase == policy._filePath) {
+      PqaError err = SaveDelta(pThrottle.get(), maxWorkers);
+      if (err.IsOk()) {
+        bIncremental = true;
+        writtenPath = KBDeltaHeader::PathFor(policy._filePath);
+      }
+      // The dimensions have changed since the base, so save in full.
+      else if (err.GetCode() != PqaErrorCode::WrongMode) {
+        return err;
+      }
+    }
+  }
+  if (!bIncremental) {
+    PqaError err = SaveFullKB(policy._filePath, false, pThrottle.get(), maxWorkers);
+    if (!err.IsOk()) {
+      return err;
+    }
+    writtenPath = policy._filePath;
+  }
+  WIN32_FILE_ATTRIBUTE_DATA wfad;
+  nBytes = GetFileAttributesExA(writtenPath.c_str(), GetFileExInfoStandard, &wfad)
+    ? ((uint64_t(wfad.nFileSizeHigh) << 32) | wfad.nFileSizeLow) : 0;
+  return PqaError();
+}
+
+
+PqaError BaseEngine::StartMaintenance(const bool forceQuizzes) {
+  try {
+    constexpr auto cOrigMode = MaintenanceSwitch::Mode::Regular;
+    constexpr auto cTargMode = MaintenanceSwitch::Mode::Maintenance;
+    AggregateErrorParams aep;
+    MaintenanceSwitch::SpecificLeaver<cTargMode> mssl;
+    SRRWLock<true> rwl; // block every read and write until we are clear about quizzes
+    SRLock<SRCriticalSection> csl;
+    mssl = _maintSwitch.SwitchMode<cTargMode>([&]() {
+      rwl.Init(_rws);
+      csl.Init(_csQuizPim);
+    });
+    // No regular-mode operations can run now, so the registry doesn't change concurrently.
+    const TPqaId nQuizzes = _quizReg.GetNLive();
+    assert(nQuizzes >= 0);
+    if (nQuizzes != 0) {
+      if (forceQuizzes) {
+        _quizReg.ForEachLive([&](const TPqaId iQuiz, BaseQuiz*) {
+          BaseQuiz *pQuiz = _quizReg.Invalidate(iQuiz);
+          aep.Add(DestroyQuiz(pQuiz));
+          if (!_pimQuizzes.RemoveComp(QuizRegistry::SlotFromId(iQuiz))) {
+            aep.Add(PqaError(PqaErrorCode::Internal, new InternalErrorParams(__FILE__, __LINE__),
               SRString::MakeUnowned("Failed to remove quiz compact ID.")));
           }
-        }
-        assert(TPqaId(_quizzes.size()) == _quizGaps.GetNGaps());
+          _quizReg.Recycle(QuizRegistry::SlotFromId(iQuiz));
+        });
+        assert(_quizReg.GetNLive() == 0);
       }
       else {
         csl.EarlyRelease();
@@ -704,111 +1809,375 @@ PqaError BaseEngine::FinishMaintenance() {
 PqaError BaseEngine::AddQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
   AddTargetParam *pAtps)
 {
+  // Wait for a save in progress: the snapshot doesn't track the changes of the layout.
+  SRLock<SRCriticalSection> cpl(_csCheckpoint);
   constexpr auto msMode = MaintenanceSwitch::Mode::Maintenance;
   if (!_maintSwitch.TryEnterSpecific<msMode>()) {
-    return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform"
-      " maintenance-only mode operation - add questions/targets - because current mode is not maintenance (but"
-      " regular/shutdown?)."));
+    // The quizzes in progress may refer to the targets at the gaps, so in regular mode they are only appended.
+    return AppendQsTs(nQuestions, pAqps, nTargets, pAtps);
   }
-  MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
-  // Exclusive lock is needed because we are going to change the number of questions/targets in the KB, and also write
-  //   the initial amounts.
-  SRRWLock<true> rwl(_rws);
+  {
+    MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+    // Exclusive lock is needed because we are going to change the number of questions/targets in the KB, and also
+    //   write the initial amounts.
+    SRRWLock<true> rwl(_rws);
+    PqaError err = LockedAddQsTs(nQuestions, pAqps, nTargets, pAtps, /*bReuseGaps*/ true);
+    if (!err.IsOk()) {
+      return err;
+    }
+  }
+  return AwaitWalCommit();
+}
+
+PqaError BaseEngine::AppendQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
+  AddTargetParam *pAtps)
+{
+  try {
+    PqaError err;
+    // The quizzes read the dimensions without a lock, so no operation may be in progress while they change. The
+    //   quizzes grow to the new dimensions when they are used next time.
+    _maintSwitch.Pause<MaintenanceSwitch::Mode::Regular>([&]() {
+      try {
+        {
+          SRRWLock<true> rwl(_rws);
+          err = LockedAddQsTs(nQuestions, pAqps, nTargets, pAtps, /*bReuseGaps*/ false);
+        }
+        if (err.IsOk()) {
+          // Adjust workers' stack size for the new dimensions, and drop the priors of fresh quizzes for the old ones.
+          UpdateWithDimensions();
+        }
+      }
+      CATCH_TO_ERR_SET(err);
+    });
+    if (!err.IsOk()) {
+      return err;
+    }
+    return AwaitWalCommit();
+  }
+  CATCH_TO_ERR_RETURN;
+}
 
-  return AddQsTsSpec(nQuestions, pAqps, nTargets, pAtps);
+PqaError BaseEngine::LockedAddQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
+  AddTargetParam *pAtps, const bool bReuseGaps)
+{
+  const EngineDimensions oldDims = _dims;
+  PqaError err = AddQsTsSpec(nQuestions, pAqps, nTargets, pAtps, bReuseGaps);
+  if (!err.IsOk()) {
+    return err;
+  }
+  if (_dims._nQuestions != oldDims._nQuestions || _dims._nTargets != oldDims._nTargets) {
+    _dirtyQuestions.GrowTo(_dims._nQuestions);
+    _bKbLayoutChanged = true;
+  }
+  else {
+    // Only the gaps have been reused: the rows of the questions, and the columns of the targets in all the rows.
+    if (nTargets > 0) {
+      _dirtyQuestions.SetRange(0, _dims._nQuestions);
+    }
+    for (TPqaId i = 0; i < nQuestions; i++) {
+      _dirtyQuestions.SetOne(pAqps[i]._iQuestion);
+    }
+  }
+
+  // Only the initial amounts are logged: in the replay the engine assigns the same IDs.
+  std::vector<TPqaAmount> amounts(SRCast::ToSizeT(nQuestions + nTargets));
+  for (TPqaId i = 0; i < nQuestions; i++) {
+    amounts[SRCast::ToSizeT(i)] = pAqps[i]._initialAmount;
+  }
+  for (TPqaId i = 0; i < nTargets; i++) {
+    amounts[SRCast::ToSizeT(nQuestions + i)] = pAtps[i]._initialAmount;
+  }
+  const WalAddHead wah = { nQuestions, nTargets };
+  LogOperation(bReuseGaps ? WalOp::AddQsTs : WalOp::AppendQsTs, { { &wah, sizeof(wah) },
+    { amounts.data(), sizeof(TPqaAmount) * amounts.size() } });
+  return PqaError();
 }
 
 PqaError BaseEngine::RemoveQuestions(const TPqaId nQuestions, const TPqaId *pQIds)
 {
+  // Wait for a save in progress: the snapshot doesn't track the changes of the layout.
+  SRLock<SRCriticalSection> cpl(_csCheckpoint);
   constexpr auto msMode = MaintenanceSwitch::Mode::Maintenance;
   if (!_maintSwitch.TryEnterSpecific<msMode>()) {
     return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform"
       " maintenance-only mode operation - remove questions - because current mode is not maintenance (but"
       " regular/shutdown?)."));
   }
-  MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
-  // Exclusive lock is needed because we are going to change the number of questions in the KB.
-  SRRWLock<true> rwl(_rws);
+  {
+    MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+    // Exclusive lock is needed because we are going to change the number of questions in the KB.
+    SRRWLock<true> rwl(_rws);
+    PqaError err = LockedRemoveQuestions(nQuestions, pQIds);
+    if (!err.IsOk()) {
+      return err;
+    }
+  }
+  return AwaitWalCommit();
+}
 
-  for (TPqaId i = 0; i < nQuestions; i++) {
+PqaError BaseEngine::LockedRemoveQuestions(const TPqaId nQuestions, const TPqaId *pQIds) {
+  PqaError err;
+  TPqaId i = 0;
+  for (; i < nQuestions; i++) {
     const TPqaId iQuestion = pQIds[i];
     if (iQuestion >= _dims._nQuestions || _questionGaps.IsGap(iQuestion)) {
-      return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iQuestion), SRString::MakeUnowned(SR_FILE_LINE
+      err = PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iQuestion), SRString::MakeUnowned(SR_FILE_LINE
         "Question index is not in KB."));
+      break;
     }
     _questionGaps.Release(iQuestion);
     _pimQuestions.RemoveComp(iQuestion);
   }
-  return PqaError();
+  // Log the questions removed before an error, if any.
+  if (i > 0) {
+    LogOperation(WalOp::RemoveQuestions, { { &i, sizeof(i) }, { pQIds, sizeof(TPqaId) * SRCast::ToSizeT(i) } });
+  }
+  return err;
 }
 
 PqaError BaseEngine::RemoveTargets(const TPqaId nTargets, const TPqaId *pTIds) {
+  // Wait for a save in progress: the snapshot doesn't track the changes of the layout.
+  SRLock<SRCriticalSection> cpl(_csCheckpoint);
   constexpr auto msMode = MaintenanceSwitch::Mode::Maintenance;
   if (!_maintSwitch.TryEnterSpecific<msMode>()) {
     return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform"
       " maintenance-only mode operation - remove targets - because current mode is not maintenance (but"
       " regular/shutdown?)."));
   }
-  MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
-  // Exclusive lock is needed because we are going to change the number of targets in the KB.
-  SRRWLock<true> rwl(_rws);
+  {
+    MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+    // Exclusive lock is needed because we are going to change the number of targets in the KB.
+    SRRWLock<true> rwl(_rws);
+    PqaError err = LockedRemoveTargets(nTargets, pTIds);
+    if (!err.IsOk()) {
+      return err;
+    }
+  }
+  return AwaitWalCommit();
+}
 
-  for (TPqaId i = 0; i < nTargets; i++) {
+PqaError BaseEngine::LockedRemoveTargets(const TPqaId nTargets, const TPqaId *pTIds) {
+  PqaError err;
+  TPqaId i = 0;
+  for (; i < nTargets; i++) {
     const TPqaId iTarget = pTIds[i];
     if (iTarget >= _dims._nTargets || _targetGaps.IsGap(iTarget)) {
-      return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iTarget), SRString::MakeUnowned(SR_FILE_LINE
+      err = PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iTarget), SRString::MakeUnowned(SR_FILE_LINE
         "Target index is not in KB (but rather at a gap)."));
+      break;
     }
     _targetGaps.Release(iTarget);
     _pimTargets.RemoveComp(iTarget);
   }
-  return PqaError();
+  // Log the targets removed before an error, if any.
+  if (i > 0) {
+    LogOperation(WalOp::RemoveTargets, { { &i, sizeof(i) }, { pTIds, sizeof(TPqaId) * SRCast::ToSizeT(i) } });
+  }
+  return err;
+}
+
+PqaError BaseEngine::Compact(CompactionResult &cr, const bool bOrderByWeight) {
+  return RunCompact(cr, cInvalidPqaId, bOrderByWeight);
+}
+
+PqaError BaseEngine::CompactSlice(CompactionResult &cr, const TPqaId maxMoves) {
+  if (maxMoves < 0) {
+    return PqaError(PqaErrorCode::NegativeCount, new NegativeCountErrorParams(maxMoves), SRString::MakeUnowned(
+      SR_FILE_LINE "The number of targets to move cannot be less than 0."));
+  }
+  return RunCompact(cr, maxMoves, false);
 }
 
-PqaError BaseEngine::Compact(CompactionResult &cr) {
+PqaError BaseEngine::RunCompact(CompactionResult &cr, const TPqaId maxMoves, const bool bOrderByWeight) {
+  // Wait for a save in progress: the snapshot doesn't track the changes of the layout.
+  SRLock<SRCriticalSection> cpl(_csCheckpoint);
   constexpr auto msMode = MaintenanceSwitch::Mode::Maintenance;
   if (!_maintSwitch.TryEnterSpecific<msMode>()) {
     return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform"
       " maintenance-only mode operation - compact the KB - because current mode is not maintenance (but"
       " regular/shutdown?)."));
   }
-  MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
-  // Exclusive lock is needed because we are going to change the number of targets and questions in the KB.
-  SRRWLock<true> rwl(_rws);
-  return CompactSpec(cr);
+  {
+    MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+    // Exclusive lock is needed because we are going to change the number of targets and questions in the KB.
+    SRRWLock<true> rwl(_rws);
+    PqaError err = LockedCompact(cr, maxMoves, bOrderByWeight);
+    if (!err.IsOk()) {
+      return err;
+    }
+  }
+  return AwaitWalCommit();
 }
 
-TPqaId BaseEngine::AssignQuiz(BaseQuiz *pQuiz) {
-  SRLock<SRCriticalSection> csl(_csQuizReg);
-  const TPqaId quizId = _quizGaps.Acquire();
-  if (quizId >= TPqaId(_quizzes.size())) {
-    assert(quizId == TPqaId(_quizzes.size()));
-    _quizzes.emplace_back(nullptr);
-    _pimQuizzes.GrowTo(_quizzes.size());
+PqaError BaseEngine::LockedCompact(CompactionResult &cr, const TPqaId maxMoves, const bool bOrderByWeight) {
+  const EngineDimensions oldDims = _dims;
+  PqaError err = CompactSpec(cr, maxMoves, bOrderByWeight);
+  if (!err.IsOk()) {
+    return err;
+  }
+  if (_dims._nQuestions != oldDims._nQuestions || _dims._nTargets != oldDims._nTargets) {
+    _dirtyQuestions.ReduceTo(_dims._nQuestions);
+    _bKbLayoutChanged = true;
+  }
+  // The compaction is determined by the gaps, which the replay reproduces.
+  if (maxMoves == cInvalidPqaId) {
+    // The weights in B, by which the targets are ordered, are also reproduced by the replay.
+    const uint8_t orderByWeight = bOrderByWeight ? 1 : 0;
+    LogOperation(WalOp::Compact, { { &orderByWeight, sizeof(orderByWeight) } });
   }
   else {
-    _pimQuizzes.RenewComp(quizId);
+    LogOperation(WalOp::CompactSlice, { { &maxMoves, sizeof(maxMoves) } });
+  }
+  return PqaError();
+}
+
+PqaError BaseEngine::DecayStatistics(const TPqaAmount factor, const TPqaId maxSliceQuestions) {
+  if (!(factor > 0) || !std::isfinite(factor)) {
+    return PqaError(PqaErrorCode::NonPositiveAmount, new NonPositiveAmountErrorParams(factor), SRString::MakeUnowned(
+      SR_FILE_LINE "The decay factor must be positive and finite."));
+  }
+  try {
+    // B is decayed with the first slice. Decaying the rows of a question together doesn't change its probabilities,
+    //   and the priors don't change with B scaled, so the KB is consistent between the slices.
+    bool bDecayB = true;
+    TPqaId iFirst = 0;
+    for (;;) {
+      MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+      SRRWLock<true> rwl(_rws);
+      // The number of questions may change between the slices.
+      const TPqaId nQuestions = _dims._nQuestions;
+      iFirst = std::min(iFirst, nQuestions);
+      if (!bDecayB && iFirst == nQuestions) {
+        break;
+      }
+      const TPqaId iLim = ((maxSliceQuestions <= 0 || nQuestions - iFirst <= maxSliceQuestions) ? nQuestions
+        : iFirst + maxSliceQuestions);
+      PqaError err = LockedDecay(factor, iFirst, iLim, bDecayB);
+      if (!err.IsOk()) {
+        return err;
+      }
+      bDecayB = false;
+      iFirst = iLim;
+    }
+    return AwaitWalCommit();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+PqaError BaseEngine::LockedDecay(const TPqaAmount factor, const TPqaId iFirstQuestion, const TPqaId iLimQuestion,
+  const bool bDecayB)
+{
+  PqaError err = DecaySpec(factor, iFirstQuestion, iLimQuestion, bDecayB);
+  if (!err.IsOk()) {
+    return err;
+  }
+  MarkQuestionsDirty(iFirstQuestion, iLimQuestion);
+  WalDecayHead wdh;
+  std::memset(&wdh, 0, sizeof(wdh));
+  wdh._factor = factor;
+  wdh._iFirstQuestion = iFirstQuestion;
+  wdh._iLimQuestion = iLimQuestion;
+  wdh._bDecayB = (bDecayB ? 1 : 0);
+  LogOperation(WalOp::Decay, { { &wdh, sizeof(wdh) } });
+  return PqaError();
+}
+
+PqaError BaseEngine::RecomputeD(TPqaAmount &maxDrift, const TPqaId maxSliceQuestions) {
+  maxDrift = 0;
+  try {
+    TPqaId iFirst = 0;
+    for (;;) {
+      MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+      SRRWLock<true> rwl(_rws);
+      // The number of questions may change between the slices.
+      const TPqaId nQuestions = _dims._nQuestions;
+      if (iFirst >= nQuestions) {
+        break;
+      }
+      const TPqaId iLim = ((maxSliceQuestions <= 0 || nQuestions - iFirst <= maxSliceQuestions) ? nQuestions
+        : iFirst + maxSliceQuestions);
+      TPqaAmount sliceDrift;
+      PqaError err = LockedRecomputeD(iFirst, iLim, sliceDrift);
+      if (!err.IsOk()) {
+        return err;
+      }
+      maxDrift = std::max(maxDrift, sliceDrift);
+      iFirst = iLim;
+    }
+    return AwaitWalCommit();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+PqaError BaseEngine::LockedRecomputeD(const TPqaId iFirstQuestion, const TPqaId iLimQuestion, TPqaAmount &maxDrift) {
+  PqaError err = RecomputeDSpec(iFirstQuestion, iLimQuestion, maxDrift);
+  if (!err.IsOk()) {
+    return err;
+  }
+  MarkQuestionsDirty(iFirstQuestion, iLimQuestion);
+  // The recomputation is deterministic, so the replay gets the same D from the same A.
+  const WalQuestionRange wqr{ iFirstQuestion, iLimQuestion };
+  LogOperation(WalOp::RecomputeD, { { &wqr, sizeof(wqr) } });
+  return PqaError();
+}
+
+TPqaId BaseEngine::AssignQuiz(BaseQuiz *pQuiz) {
+  // The quiz is published only after its permanent ID is assigned, so that no release can remove the permanent ID of
+  //   the slot meanwhile.
+  const uint32_t iSlot = _quizReg.Reserve();
+  {
+    SRLock<SRCriticalSection> csl(_csQuizPim);
+    const TPqaId nComp = _pimQuizzes.GetNComp();
+    if (TPqaId(iSlot) >= nComp) {
+      _pimQuizzes.GrowTo(TPqaId(iSlot) + 1);
+      // The fresh slots skipped here are reserved by concurrent assignments, which will renew their compact IDs. They
+      //   are neither live nor recycled till then.
+      for (TPqaId i = nComp; i < TPqaId(iSlot); i++) {
+        _pimQuizzes.RemoveComp(i);
+      }
+    }
+    else {
+      _pimQuizzes.RenewComp(iSlot);
+    }
+  }
+  const TPqaId quizId = _quizReg.Publish(iSlot, pQuiz);
+  // Otherwise the wheel would only grow, because the quizzes leave it only when reaped.
+  if (IsQuizExpiryOn()) {
+    _quizExpiry.Schedule(quizId, QuizRegistry::CoarseNowSec() + GetExpiryAgeSec());
   }
-  _quizzes[SRCast::ToSizeT(quizId)] = pQuiz;
   return quizId;
 }
 
 void BaseEngine::UnassignQuiz(const TPqaId iQuiz) {
-  SRLock<SRCriticalSection> csl(_csQuizReg);
-  _quizzes[SRCast::ToSizeT(iQuiz)] = nullptr;
-  _quizGaps.Release(iQuiz);
-  _pimQuizzes.RemoveComp(iQuiz);
+  if (_quizReg.Invalidate(iQuiz) == nullptr) {
+    return; // released concurrently
+  }
+  RetireQuizSlot(iQuiz);
 }
 
-void BaseEngine::LockedReleaseQuiz(const TPqaId iQuiz, AggregateErrorParams &aep) {
-  BaseQuiz *pQuiz = _quizzes[iQuiz];
-  _quizzes[iQuiz] = nullptr; // avoid double-free problems
-
-  _quizGaps.Release(iQuiz);
-  if (!_pimQuizzes.RemoveComp(iQuiz)) {
+void BaseEngine::RemoveQuizPermId(const TPqaId iQuiz) {
+  if (!_pimQuizzes.RemoveComp(QuizRegistry::SlotFromId(iQuiz))) {
     BELOG(Error) << SR_FILE_LINE << "Failed to remove quiz " << iQuiz << " from permanent-compact ID mapper.";
   }
+}
+
+void BaseEngine::RetireQuizSlot(const TPqaId iQuiz) {
+  {
+    SRLock<SRCriticalSection> csl(_csQuizPim);
+    RemoveQuizPermId(iQuiz);
+  }
+  _quizReg.Recycle(QuizRegistry::SlotFromId(iQuiz));
+}
+
+bool BaseEngine::DiscardQuiz(const TPqaId iQuiz, AggregateErrorParams &aep) {
+  BaseQuiz *pQuiz = _quizReg.InvalidateIfUnused(iQuiz);
+  if (pQuiz == nullptr) {
+    // Released concurrently, or in use
+    return _quizReg.Lookup(iQuiz) == nullptr;
+  }
+  RetireQuizSlot(iQuiz);
   aep.Add(DestroyQuiz(pQuiz));
+  return true;
 }
 
 PqaError BaseEngine::ClearOldQuizzes(const TPqaId maxCount, const double maxAgeSec) {
@@ -832,8 +2201,6 @@ PqaError BaseEngine::ClearOldQuizzes(const TPqaId maxCount, const double maxAgeS
     return PqaError(PqaErrorCode::UnhandledCase, nullptr, mb.GetOwnedSRString());
   }
   }
-  SRLock<SRCriticalSection> csl(_csQuizReg);
-
   struct QuizAge {
     TPqaId _iQuiz;
     double _ageSec;
@@ -841,30 +2208,28 @@ PqaError BaseEngine::ClearOldQuizzes(const TPqaId maxCount, const double maxAgeS
       return _ageSec < fellow._ageSec;
     }
   };
-  SRSmartMPP<QuizAge> quizAges(_memPool, _quizzes.size() - _quizGaps.GetNGaps());
+  // Quizzes may be created and released concurrently: the ones created after the scan starts are young anyway.
+  const TPqaId capacity = _quizReg.GetSlotRange();
+  SRSmartMPP<QuizAge> quizAges(_memPool, capacity);
   TPqaId nInHeap = 0;
-  time_t callTime = time(nullptr);
-  for (TPqaId i = 0; i < TPqaId(_quizzes.size()); i++) {
-    if (_quizGaps.IsGap(i)) {
-      continue;
-    }
-    BaseQuiz *pQuiz = _quizzes[i];
-    if (pQuiz == nullptr) {
-      continue;
-    }
-    const double ageSec = difftime(callTime, pQuiz->GetLastUsage());
+  const uint32_t callSec = QuizRegistry::CoarseNowSec();
+  _quizReg.ForEachLive([&](const TPqaId iQuiz, BaseQuiz*) {
+    const double ageSec = double(int64_t(callSec) - int64_t(_quizReg.GetLastUsageSec(iQuiz)));
     if (ageSec > maxAgeSec) {
-      LockedReleaseQuiz(i, aep);
-      continue;
+      DiscardQuiz(iQuiz, aep);
+      return;
+    }
+    if (nInHeap >= capacity) {
+      return;
     }
-    quizAges.Get()[nInHeap]._iQuiz = i;
+    quizAges.Get()[nInHeap]._iQuiz = iQuiz;
     quizAges.Get()[nInHeap]._ageSec = ageSec;
     nInHeap++;
-  }
+  });
   if (nInHeap > maxCount) {
     std::make_heap(quizAges.Get(), quizAges.Get()+nInHeap);
     while (nInHeap > maxCount) {
-      LockedReleaseQuiz(quizAges.Get()[0]._iQuiz, aep);
+      DiscardQuiz(quizAges.Get()[0]._iQuiz, aep);
       std::pop_heap(quizAges.Get(), quizAges.Get() + nInHeap);
       nInHeap--;
     }
@@ -872,6 +2237,159 @@ PqaError BaseEngine::ClearOldQuizzes(const TPqaId maxCount, const double maxAgeS
   return aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Error(s) occurred during clearing old quizzes."));
 }
 
+bool BaseEngine::IsQuizExpiryOn() const {
+  return _quizMaxCount.load(std::memory_order_seq_cst) >= 0 || _quizMaxAgeSec.load(std::memory_order_seq_cst) != 0;
+}
+
+uint32_t BaseEngine::GetExpiryAgeSec() {
+  const uint32_t maxAgeSec = _quizMaxAgeSec.load(std::memory_order_relaxed);
+  return (maxAgeSec != 0) ? maxAgeSec : _quizExpiry.GetHorizonSec();
+}
+
+PqaError BaseEngine::SetQuizExpiry(const TPqaId maxCount, const double maxAgeSec, const bool bBackgroundReaper) {
+  try {
+    MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+    {
+      SRLock<SRCriticalSection> rl(_csReap);
+      // Quiz usage is tracked with a resolution of a second.
+      const uint32_t ageSec = (maxAgeSec <= 0) ? 0 : uint32_t(std::min(std::ceil(maxAgeSec),
+        double(UINT32_MAX >> 1)));
+      // Published before the live quizzes are scheduled below, so that the quizzes assigned meanwhile are scheduled
+      //   either here or by AssignQuiz().
+      _quizMaxCount.store(std::max(maxCount, TPqaId(-1)), std::memory_order_seq_cst);
+      _quizMaxAgeSec.store(ageSec, std::memory_order_seq_cst);
+      // Rehash the quizzes for the granularity of the new age limit. The quizzes started while the expiry was off
+      //   haven't been scheduled at all.
+      _quizExpiry.Reset(ageSec, QuizRegistry::CoarseNowSec());
+      if (IsQuizExpiryOn()) {
+        const uint32_t ageEff = GetExpiryAgeSec();
+        _quizReg.ForEachLive([&](const TPqaId iQuiz, BaseQuiz*) {
+          _quizExpiry.Schedule(iQuiz, _quizReg.GetLastUsageSec(iQuiz) + ageEff);
+        });
+      }
+    }
+    if (!bBackgroundReaper) {
+      StopQuizReaper(false);
+      return PqaError();
+    }
+    SRLock<SRCriticalSection> csl(_csReaper);
+    if (_bReaperShutdown) {
+      return PqaError(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
+        "BaseEngine::SetQuizExpiry()")), SRString::MakeUnowned(SR_FILE_LINE "Can't start the quiz reaper."));
+    }
+    if (!_quizReaper.joinable()) {
+      _reaperEpoch++;
+      _quizReaper = std::thread(&BaseEngine::RunQuizReaper, this, _reaperEpoch);
+    }
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+PqaError BaseEngine::ReapQuizzes() {
+  try {
+    constexpr auto msMode = MaintenanceSwitch::Mode::Regular;
+    if (!_maintSwitch.TryEnterSpecific<msMode>()) {
+      return PqaError(PqaErrorCode::WrongMode, nullptr, SRString::MakeUnowned(SR_FILE_LINE "Can't perform"
+        " regular-only mode operation (reap quizzes) because current mode is not regular (but"
+        " maintenance/shutdown?)."));
+    }
+    MaintenanceSwitch::SpecificLeaver<msMode> mssl(_maintSwitch);
+
+    AggregateErrorParams aep;
+    SRLock<SRCriticalSection> rl(_csReap);
+    const uint32_t nowSec = QuizRegistry::CoarseNowSec();
+    const uint32_t maxAgeSec = _quizMaxAgeSec.load(std::memory_order_relaxed);
+    const uint32_t ageEff = GetExpiryAgeSec();
+    std::vector<TPqaId> batch;
+
+    //// Expire by age
+    _quizExpiry.TakeDue(nowSec, batch);
+    for (const TPqaId iQuiz : batch) {
+      if (_quizReg.Lookup(iQuiz) == nullptr) {
+        continue; // released already
+      }
+      const uint32_t deadlineSec = _quizReg.GetLastUsageSec(iQuiz) + ageEff;
+      if (deadlineSec > nowSec) {
+        // Used since it was scheduled
+        _quizExpiry.Schedule(iQuiz, deadlineSec);
+      }
+      else if (maxAgeSec != 0) {
+        if (!DiscardQuiz(iQuiz, aep)) {
+          // In use: its usage time is updated, so it's revisited after the age limit.
+          _quizExpiry.Schedule(iQuiz, nowSec + ageEff);
+        }
+      }
+      else {
+        // Without the age limit, revisit it once per revolution of the wheel.
+        _quizExpiry.Schedule(iQuiz, nowSec + ageEff);
+      }
+    }
+
+    //// Expire by count, the least recently used first
+    const TPqaId maxCount = _quizMaxCount.load(std::memory_order_relaxed);
+    if (maxCount >= 0 && _quizReg.GetNLive() > maxCount) {
+      uint32_t iBucket, iLim;
+      _quizExpiry.GetBucketRange(iBucket, iLim);
+      for (; _quizReg.GetNLive() > maxCount; iBucket++) {
+        batch.clear();
+        iBucket = _quizExpiry.TakeEarliest(iBucket, iLim, batch);
+        if (iBucket >= iLim) {
+          break;
+        }
+        const uint32_t bucketEndSec = _quizExpiry.GetBucketEndSec(iBucket);
+        for (const TPqaId iQuiz : batch) {
+          if (_quizReg.Lookup(iQuiz) == nullptr) {
+            continue; // released already
+          }
+          const uint32_t deadlineSec = _quizReg.GetLastUsageSec(iQuiz) + ageEff;
+          // If it was used since scheduled, it moves to a later bucket, which this loop visits later.
+          if (deadlineSec >= bucketEndSec || _quizReg.GetNLive() <= maxCount || !DiscardQuiz(iQuiz, aep)) {
+            // The quizzes in use are skipped too: they are not the least recently used ones.
+            _quizExpiry.Schedule(iQuiz, deadlineSec);
+          }
+        }
+      }
+    }
+    return aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Error(s) occurred during reaping quizzes."));
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+void BaseEngine::RunQuizReaper(const uint64_t epoch) {
+  SRLock<SRCriticalSection> csl(_csReaper);
+  while (_reaperEpoch == epoch) {
+    _reaperWake.Wait(_csReaper, _quizExpiry.GetBucketSec() * 1000);
+    if (_reaperEpoch != epoch) {
+      break;
+    }
+    csl.EarlyRelease();
+    PqaError err = ReapQuizzes();
+    // In maintenance mode there are no quizzes to reap.
+    if (!err.IsOk() && err.GetCode() != PqaErrorCode::WrongMode) {
+      BELOG(Error) << SR_FILE_LINE << "Quiz reaper: " << err.ToString(true);
+    }
+    csl.Init(_csReaper);
+  }
+}
+
+void BaseEngine::StopQuizReaper(const bool bShutdown) {
+  std::thread reaper;
+  {
+    SRLock<SRCriticalSection> csl(_csReaper);
+    if (bShutdown) {
+      _bReaperShutdown = true;
+    }
+    if (!_quizReaper.joinable()) {
+      return;
+    }
+    _reaperEpoch++;
+    reaper = std::move(_quizReaper);
+  }
+  _reaperWake.WakeAll();
+  reaper.join();
+}
+
 PqaError BaseEngine::CopyATargets(const TPqaId iQuestion, const TPqaId iAnswer, const TPqaId maxTargets,
   TPqaAmount *pFreqs)
 {
@@ -10,6 +10,9 @@
 #include "../PqaCore/Interface/PqaCommon.h"
 #include "../PqaCore/KBFileInfo.h"
 #include "../PqaCore/PermanentIdManager.h"
+#include "../PqaCore/QuizExpiryWheel.h"
+#include "../PqaCore/QuizRegistry.h"
+#include "../PqaCore/WriteAheadLog.h"
 #include "../PqaCore/Interface/PqaErrorParams.h"
 
 namespace ProbQA {
@@ -20,6 +23,8 @@ class BaseEngine : public IPqaEngine {
 public: // constants
   static constexpr size_t _cMemPoolMaxSimds = size_t(1) << 10;
   static constexpr size_t _cFileBufSize = size_t(1024) * 1024;
+  // The number of answered questions in the training records of the write-ahead log replayed at once.
+  static constexpr size_t _cWalReplayBatchAQs = size_t(1) << 20;
 
 public: // types
   typedef SRPlat::SRMemPool<SRPlat::SRSimd::_cLogNBits, _cMemPoolMaxSimds> TMemPool;
@@ -29,28 +34,78 @@ protected: // variables
 
   PermanentIdManager _pimQuestions; // Guarded by _rws in maintenance mode. Read-only in regular mode.
   PermanentIdManager _pimTargets; // Guarded by _rws in maintenance mode. Read-only in regular mode.
-  PermanentIdManager _pimQuizzes; // Guarded by _csQuizReg . No need to obtain _rws.
+  PermanentIdManager _pimQuizzes; // Indexed by quiz slots. Guarded by _csQuizPim . No need to obtain _rws.
 
   const PrecisionDefinition _precDef;
   EngineDimensions _dims; // Guarded by _rws in maintenance mode. Read-only in regular mode.
   std::atomic<uint64_t> _nQuestionsAsked = 0;
+  std::atomic<uint64_t> _nTrainings = 0; // Train() and RecordQuizTarget() calls, for the checkpoint scheduler
 
   //// Don't violate the order of obtaining these locks, so to avoid a deadlock.
   //// Actually the locks form directed acyclic graph indicating which locks must be obtained one after another.
   //// However, to simplify the code we list them here topologically sorted.
+  // Serializes the saves of KB files, both full and incremental. The operations changing the layout of the KB take it
+  //   too, because the statistics are saved out of _rws from a snapshot, which only tracks the changes of rows.
+  SRPlat::SRCriticalSection _csCheckpoint;
   mutable MaintenanceSwitch _maintSwitch; // regular/maintenance mode switch
   mutable SRPlat::SRReaderWriterSync _rws; // KB read-write
-  SRPlat::SRCriticalSection _csQuizReg; // quiz registry
+  SRPlat::SRCriticalSection _csReap; // serializes quiz expiry passes and their reconfiguration
+  SRPlat::SRCriticalSection _csQuizPim; // quiz permanent IDs
 
-  std::vector<BaseQuiz*> _quizzes; // Guarded by _csQuizReg
-  GapTracker<TPqaId> _quizGaps; // Guarded by _csQuizReg
+  QuizRegistry _quizReg; // thread-safe itself
+  QuizExpiryWheel _quizExpiry; // thread-safe itself
+  std::atomic<TPqaId> _quizMaxCount; // negative means no limit
+  std::atomic<uint32_t> _quizMaxAgeSec; // 0 means no limit
 
   GapTracker<TPqaId> _questionGaps; // Guarded by _rws in maintenance mode. Read-only in regular mode.
   GapTracker<TPqaId> _targetGaps; // Guarded by _rws in maintenance mode. Read-only in regular mode.
 
+  //// Incremental checkpoints: the changes since the base KB file, i.e. the last one saved in full in file format
+  ////   version 2, or loaded from such a file.
+  std::string _checkpointBase; // Guarded by _csCheckpoint . Empty if there is no base.
+  uint64_t _checkpointId = 0; // Guarded by _csCheckpoint
+  // The questions whose rows of statistics have changed since the base. Written under exclusive _rws, read and reset
+  //   under shared _rws and _csCheckpoint .
+  SRPlat::SRBitArray _dirtyQuestions;
+  // Whether the dimensions have changed since the base, so that the regions of statistics don't match it anymore.
+  bool _bKbLayoutChanged = false; // Guarded in the same way as _dirtyQuestions
+
+  //// Write-ahead log of the changes since the base
+  // Replaced under _csCheckpoint and exclusive _rws . Loaded atomically when waiting for the commit out of the locks.
+  std::shared_ptr<WriteAheadLog> _pWal;
+  std::atomic<bool> _bWalWaitCommit = false;
+  uint64_t _walLsn = 0; // LSN of the last change logged. Guarded in the same way as _dirtyQuestions
+  // The number of changes made without the log, so that the log is not continued over them. Guarded in the same way
+  //   as _dirtyQuestions .
+  uint64_t _nUnloggedChanges = 0;
+  uint64_t _nUnloggedSaved = 0; // The value of _nUnloggedChanges as of the last save. Guarded by _csCheckpoint
+  // The size of the valid part of the log of the base, from which the log is continued. 0 to start a new log.
+  uint64_t _walValidBytes = 0; // Guarded by _csCheckpoint
+  bool _bWalLost = false; // Whether records have been lost since the last save. Guarded by _csCheckpoint
+  // Whether to save the KB in the compressed file format, if the engine supports it.
+  std::atomic<bool> _bCompressKB = false;
+
   //// Cache-insensitive data
   std::atomic<SRPlat::ISRLogger*> _pLogger;
 
+  //// Background quiz reaper
+  SRPlat::SRCriticalSection _csReaper;
+  SRPlat::SRConditionVariable _reaperWake;
+  std::thread _quizReaper; // Guarded by _csReaper
+  uint64_t _reaperEpoch = 0; // Guarded by _csReaper . The reaper of an older epoch must exit.
+  bool _bReaperShutdown = false; // Guarded by _csReaper
+
+  //// Background checkpoint scheduler
+  SRPlat::SRCriticalSection _csCheckpointer;
+  SRPlat::SRConditionVariable _checkpointerWake;
+  std::thread _checkpointer; // Guarded by _csCheckpointer
+  uint64_t _checkpointerEpoch = 0; // Guarded by _csCheckpointer . The scheduler of an older epoch must exit.
+  bool _bCheckpointerShutdown = false; // Guarded by _csCheckpointer
+  CheckpointPolicy _cpPolicy; // Guarded by _csCheckpointer . |_filePath| points to |_cpPath|.
+  std::string _cpPath; // Guarded by _csCheckpointer
+  CheckpointStats _cpStats; // Guarded by _csCheckpointer
+  uint32_t _nIncrementalInRow = 0; // Guarded by _csCheckpointer
+
 protected: // methods
   explicit BaseEngine(const EngineDefinition& engDef, KBFileInfo *pKbFi);
 
@@ -61,12 +116,96 @@ protected: // methods
   bool WriteGaps(const GapTracker<TPqaId> &gt, KBFileInfo &kbfi);
 
   PqaError LockedSaveKB(KBFileInfo &kbfi, const bool bDoubleBuffer);
-  BaseQuiz* UseQuiz(PqaError& err, const TPqaId iQuiz);
+  // Takes the snapshot of the statistics and writes the meta section. The statistics and the header are written by
+  //   SaveSectionedSnapshot() then, which doesn't need _rws .
+  PqaError LockedSaveSectionedKB(KBFileInfo &kbfi, const uint64_t nQuestionsAsked);
+  // Must be called after LockedSaveSectionedKB() has succeeded, while the layout of the KB can't change. Releases the
+  //   snapshot even on failure.
+  PqaError SaveSectionedSnapshot(KBFileInfo &kbfi);
+  PqaError LockedSaveDelta(KBFileInfo &kbfi, const uint64_t nQuestionsAsked);
+  // Must be called with |_rws| locked exclusively.
+  void MarkQuestionsDirty(const TPqaId nAnswered, const AnsweredQuestion* const pAQs);
+  void MarkQuestionsDirty(const TPqaId iFirstQuestion, const TPqaId iLimQuestion);
+  // Appends the operation to the write-ahead log if it's on. Must be called with |_rws| locked exclusively, after the
+  //   operation has been applied.
+  void LogOperation(const WalOp op, std::initializer_list<WriteAheadLog::Chunk> chunks);
+  void LogTraining(const WalOp op, const TPqaId nAnswered, const AnsweredQuestion* const pAQs, const TPqaId iTarget,
+    const TPqaAmount amount);
+  // Waits till the operations done so far are flushed to the write-ahead log, if requested in StartWal().
+  PqaError AwaitWalCommit();
+  // Applies the operations from the write-ahead log of the base after the LSN of the KB files loaded. Throws on
+  //   failure.
+  void ReplayWal(KBFileInfo &kbfi);
+
+  //// The maintenance operations proper, also used in the replay. Must be called with |_rws| locked exclusively.
+  // Unless |bReuseGaps|, the questions and targets are appended after the existing ones.
+  PqaError LockedAddQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
+    AddTargetParam *pAtps, const bool bReuseGaps);
+  PqaError LockedRemoveQuestions(const TPqaId nQuestions, const TPqaId *pQIds);
+  PqaError LockedRemoveTargets(const TPqaId nTargets, const TPqaId *pTIds);
+  // With |maxMoves|=cInvalidPqaId, the targets are compacted completely, and then ordered by weight if
+  //   |bOrderByWeight|.
+  PqaError LockedCompact(CompactionResult &cr, const TPqaId maxMoves, const bool bOrderByWeight);
+  // Decays the questions in [iFirstQuestion; iLimQuestion), and vector B if |bDecayB|. Unlike the above, can be called
+  //   in both regular and maintenance modes.
+  PqaError LockedDecay(const TPqaAmount factor, const TPqaId iFirstQuestion, const TPqaId iLimQuestion,
+    const bool bDecayB);
+  // Recomputes D of the questions in [iFirstQuestion; iLimQuestion). Can be called in both modes too.
+  PqaError LockedRecomputeD(const TPqaId iFirstQuestion, const TPqaId iLimQuestion, TPqaAmount &maxDrift);
+  // Writes the gaps and the permanent-compact ID mappings.
+  PqaError SaveMeta(KBFileInfo &kbfi);
+  // Appends the questions and targets in regular mode, pausing the operations meanwhile. Must be called with
+  //   |_csCheckpoint| locked.
+  PqaError AppendQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
+    AddTargetParam *pAtps);
+  // Enters maintenance mode and compacts the KB, moving at most |maxMoves| targets unless it's cInvalidPqaId.
+  PqaError RunCompact(CompactionResult &cr, const TPqaId maxMoves, const bool bOrderByWeight);
+  // Looks the quiz up and grows it to the questions and targets appended since it was used last time. The quiz is not
+  //   expired till |qul| is destroyed.
+  BaseQuiz* UseQuiz(PqaError& err, const TPqaId iQuiz, QuizRegistry::UsageLock &qul);
+  PqaError MakeQuizLookupError(const TPqaId iQuiz);
 
   TPqaId AssignQuiz(BaseQuiz *pQuiz);
   void UnassignQuiz(const TPqaId iQuiz);
 
-  void LockedReleaseQuiz(const TPqaId iQuiz, AggregateErrorParams &aep);
+  // The quizzes are scheduled in the expiry wheel only if there is a limit on their count or age.
+  bool IsQuizExpiryOn() const;
+  // The age after which the quizzes are considered for expiry. Without the age limit, it's the horizon of the wheel.
+  uint32_t GetExpiryAgeSec();
+  void RunQuizReaper(const uint64_t epoch);
+  void StopQuizReaper(const bool bShutdown);
+
+  //// The saves proper, limited to |maxWorkers| worker threads (0 for all) and the write rate of |pThrottle| (nullptr
+  ////   for no limit).
+  PqaError SaveFullKB(const char* const filePath, const bool bDoubleBuffer, IoThrottle *pThrottle,
+    const SRPlat::SRThreadCount maxWorkers);
+  PqaError SaveDelta(IoThrottle *pThrottle, const SRPlat::SRThreadCount maxWorkers);
+  // Moves the KB file saved at |tempPath| over |filePath|, which must not be mapped by the engine anymore.
+  PqaError ReplaceKBFile(const std::string &tempPath, const char* const filePath);
+  void RunCheckpointer(const uint64_t epoch);
+  void StopCheckpointer(const bool bShutdown);
+  // Saves incrementally if the policy allows and the base is the file of the policy, otherwise in full. Sets the
+  //   size of the file written and whether the save was incremental.
+  PqaError TakeCheckpoint(const CheckpointPolicy &policy, const bool bTryIncremental, uint64_t &nBytes,
+    bool &bIncremental);
+
+  // Runs a quiz through the kernels of the engine: starting a quiz, the choice of the next question, recording an
+  //   answer and both algorithms listing the top targets. The question asked doesn't count in GetTotalQuestionsAsked().
+  PqaError RunWarmupQuiz();
+  // Must be called in a pause of the regular mode.
+  PqaError PausedSaveQuizzes(const char* const filePath);
+  TPqaId PausedLoadQuizzes(PqaError& err, const char* const filePath);
+  // Selects the next question like NextQuestion(), but counts it in GetTotalQuestionsAsked() only if |bCount|.
+  TPqaId PickNextQuestion(PqaError& err, const TPqaId iQuiz, const bool bCount);
+
+  // Releases the quiz if it's still live and no operation is using it, and destroys it. Returns |false| if the quiz
+  //   is in use, and |true| otherwise.
+  bool DiscardQuiz(const TPqaId iQuiz, AggregateErrorParams &aep);
+  // Must be called with |_csQuizPim| locked.
+  void RemoveQuizPermId(const TPqaId iQuiz);
+  // Must be called after the quiz is invalidated in the registry. Removes the permanent ID of the quiz, and only then
+  //   lets the slot be reused, so that a concurrent assignment doesn't get the slot while it's still mapped.
+  void RetireQuizSlot(const TPqaId iQuiz);
 
 protected: // Specific methods for this engine
   virtual PqaError TrainSpec(const TPqaId nQuestions, const AnsweredQuestion* const pAQs, const TPqaId iTarget,
@@ -75,15 +214,53 @@ protected: // Specific methods for this engine
   virtual TPqaId NextQuestionSpec(PqaError& err, BaseQuiz *pBaseQuiz) = 0;
   virtual TPqaId ListTopTargetsSpec(PqaError& err, BaseQuiz *pBaseQuiz, const TPqaId maxCount,
     RatedTarget *pDest) = 0;
+  virtual TPqaId AnalyzeQuestionsSpec(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) = 0;
   virtual PqaError RecordQuizTargetSpec(BaseQuiz *pBaseQuiz, const TPqaId iTarget, const TPqaAmount amount) = 0;
   virtual PqaError AddQsTsSpec(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
-    AddTargetParam *pAtps) = 0;
-  virtual PqaError CompactSpec(CompactionResult &cr) = 0;
+    AddTargetParam *pAtps, const bool bReuseGaps) = 0;
+  // Moves at most |maxMoves| targets to the gaps, or all of them if it's cInvalidPqaId. |bOrderByWeight| is only
+  //   passed with the latter.
+  virtual PqaError CompactSpec(CompactionResult &cr, const TPqaId maxMoves, const bool bOrderByWeight) = 0;
+  // Multiplies the amounts of the questions in [iFirstQuestion; iLimQuestion), and of vector B if |bDecayB|, by
+  //   |factor|. The squares of amounts in A and D are thus multiplied by the square of |factor|.
+  virtual PqaError DecaySpec(const TPqaAmount factor, const TPqaId iFirstQuestion, const TPqaId iLimQuestion,
+    const bool bDecayB) = 0;
+  // Sets D of the questions in [iFirstQuestion; iLimQuestion) to the sums of A over the answers, returning in
+  //   |maxDrift| the maximum relative difference between the old and the new D.
+  virtual PqaError RecomputeDSpec(const TPqaId iFirstQuestion, const TPqaId iLimQuestion, TPqaAmount &maxDrift) = 0;
 
   virtual size_t NumberSize() = 0;
+  // The version of KB file format the engine writes.
+  virtual uint32_t KBFormatVersion() = 0;
+  // Lays out the statistics for the KB file format version 2 and keeps them as of this moment for SaveStatistics(),
+  //   which is called out of the KB lock then. Must be called under shared _rws and _csCheckpoint .
+  virtual void TakeSnapshot(KBFileInfo &kbfi) = 0;
+  // Must be called under shared _rws and _csCheckpoint .
+  virtual void ReleaseSnapshot() = 0;
+  // Touches each page of the statistics in parallel, so that they are resident. Must be called under shared _rws .
+  virtual void PrefaultStatistics() = 0;
   virtual PqaError SaveStatistics(KBFileInfo &kbfi) = 0;
+  // Writes the regions of statistics having rows of the questions in |_dirtyQuestions| into the delta file, and lays
+  //   out the index and the meta section of the delta.
+  virtual PqaError SaveDeltaStatistics(KBFileInfo &kbfi) = 0;
+  // Applies the training records of the write-ahead log when loading the KB, i.e. without concurrency. Throws on
+  //   failure.
+  virtual void ReplayTrainingSpec(const WalTraining *pTrainings, const size_t nTrainings) = 0;
+  // Returns the prior mantissas of the quiz, or nullptr if the quiz refers to the shared priors or hasn't grown to the
+  //   targets appended yet. The priors of the latter are recomputed on restore.
+  virtual const void* QuizOwnPriors(BaseQuiz *pBaseQuiz) = 0;
+  // Grows the buffers of the quiz to the current dimensions, which only grow in regular mode. The new targets get the
+  //   priors of a fresh quiz.
+  virtual PqaError GrowQuizSpec(BaseQuiz *pBaseQuiz) = 0;
+  // Creates a quiz with the answers given and the prior mantissas saved by SaveQuizzes(). If |pPriors| is nullptr,
+  //   recomputes the priors as ResumeQuizSpec() does.
+  virtual TPqaId RestoreQuizSpec(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs,
+    const void *pPriors) = 0;
   virtual PqaError DestroyQuiz(BaseQuiz *pQuiz) = 0;
   virtual PqaError DestroyStatistics() = 0;
+  // If the statistics are mapped from the file at |filePath|, copies them into the memory of the engine and unmaps the
+  //   file, so that it can be overwritten. Must be called with |_rws| locked exclusively.
+  virtual PqaError UnmapKBFile(const char* const filePath) = 0;
   virtual PqaError ShutdownWorkers() = 0;
   virtual void UpdateWithDimensions() = 0;
 
@@ -102,9 +279,17 @@ public: // Internal interface methods
   // Can't be used externally because the dimensions may change when not under a lock
   const EngineDimensions& GetDims() const { return _dims; }
 
+  //// For HotSwapEngine
+  TPqaId GetNLiveQuizzes() const { return _quizReg.GetNLive(); }
+  TPqaId GetNextPermQuizId();
+  // Copies the answers given in the quiz, with the compact IDs of the questions.
+  PqaError CopyQuizAnswers(const TPqaId iQuiz, std::vector<AnsweredQuestion> &answers);
+
 public:
   PqaError Train(const TPqaId nQuestions, const AnsweredQuestion* const pAQs, const TPqaId iTarget,
     const TPqaAmount amount = 1) override final;
+  PqaError DecayStatistics(const TPqaAmount factor, const TPqaId maxSliceQuestions = 0) override final;
+  PqaError RecomputeD(TPqaAmount &maxDrift, const TPqaId maxSliceQuestions = 0) override final;
 
   bool QuestionPermFromComp(const TPqaId count, TPqaId *pIds) override final;
   bool QuestionCompFromPerm(const TPqaId count, TPqaId *pIds) override final;
@@ -124,12 +309,27 @@ public:
   TPqaId GetActiveQuestionId(PqaError &err, const TPqaId iQuiz) override final;
   PqaError SetActiveQuestion(const TPqaId iQuiz, const TPqaId iQuestion) override final;
   TPqaId ListTopTargets(PqaError& err, const TPqaId iQuiz, const TPqaId maxCount, RatedTarget *pDest) override final;
+  TPqaId AnalyzeQuestions(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) override final;
   PqaError RecordQuizTarget(const TPqaId iQuiz, const TPqaId iTarget, const TPqaAmount amount = 1) override final;
   PqaError ReleaseQuiz(const TPqaId iQuiz) override final;
 
   virtual PqaError ClearOldQuizzes(const TPqaId maxCount, const double maxAgeSec) override final;
+  PqaError SetQuizExpiry(const TPqaId maxCount, const double maxAgeSec, const bool bBackgroundReaper) override final;
+  PqaError ReapQuizzes() override final;
+
+  PqaError SaveQuizzes(const char* const filePath) override final;
+  TPqaId LoadQuizzes(PqaError& err, const char* const filePath) override final;
 
   PqaError SaveKB(const char* const filePath, const bool bDoubleBuffer) override final;
+  PqaError SaveIncremental() override final;
+  PqaError StartWal(const bool bWaitCommit) override final;
+  PqaError StopWal() override final;
+  PqaError SetCompressKB(const bool bCompress) override final;
+  PqaError StartCheckpointer(const CheckpointPolicy &policy) override final;
+  PqaError StopCheckpointer() override final;
+  PqaError GetCheckpointStats(CheckpointStats &stats) override final;
+  PqaError HotSwapKB(const char* const filePath) override final;
+  PqaError Warmup() override final;
 
   virtual PqaError StartMaintenance(const bool forceQuizes) override final;
   virtual PqaError FinishMaintenance() override final;
@@ -139,7 +339,8 @@ public:
   PqaError RemoveQuestions(const TPqaId nQuestions, const TPqaId *pQIds) override final;
   PqaError RemoveTargets(const TPqaId nTargets, const TPqaId *pTIds) override final;
 
-  PqaError Compact(CompactionResult &cr) override final;
+  PqaError Compact(CompactionResult &cr, const bool bOrderByWeight = false) override final;
+  PqaError CompactSlice(CompactionResult &cr, const TPqaId maxMoves) override final;
 
   PqaError Shutdown(const char* const saveFilePath = nullptr) override final;
   PqaError SetLogger(SRPlat::ISRLogger *pLogger) override final;
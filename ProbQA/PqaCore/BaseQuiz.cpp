@@ -9,7 +9,9 @@ using namespace SRPlat;
 
 namespace ProbQA {
 
-BaseQuiz::BaseQuiz(BaseEngine *pEngine) : _pEngine(pEngine) {
+BaseQuiz::BaseQuiz(BaseEngine *pEngine) : _pEngine(pEngine), _nQuestions(pEngine->GetDims()._nQuestions),
+  _nTargets(pEngine->GetDims()._nTargets)
+{
 }
 
 BaseQuiz::~BaseQuiz() {
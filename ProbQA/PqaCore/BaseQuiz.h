@@ -18,7 +18,10 @@ protected: // variables
   std::vector<AnsweredQuestion> _answers;
   TPqaId _activeQuestion = cInvalidPqaId;
   BaseEngine *_pEngine;
-  time_t _lastUsage = time(nullptr);
+  // The numbers of questions and targets the buffers of the quiz are sized for. They lag behind the dimensions of the
+  //   engine after questions or targets are appended in regular mode, till the quiz is used next time.
+  TPqaId _nQuestions;
+  TPqaId _nTargets;
 
 protected: // methods
   BaseEngine * GetBaseEngine() const { return _pEngine; }
@@ -31,8 +34,8 @@ public: // methods
   const std::vector<AnsweredQuestion>& GetAnswers() const { return _answers; }
   void SetActiveQuestion(TPqaId iQuestion) { _activeQuestion = iQuestion; }
   TPqaId GetActiveQuestion() const { return _activeQuestion; }
-  void OnUsage() { _lastUsage = time(nullptr); }
-  time_t GetLastUsage() const { return _lastUsage; }
+  TPqaId GetNQuestions() const { return _nQuestions; }
+  TPqaId GetNTargets() const { return _nTargets; }
 };
 
 } // namespace ProbQA
@@ -0,0 +1,39 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEAddTargetsSubtaskGrow.h"
+#include "../PqaCore/CEAddTargetsTask.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template<typename taNumber> void CEAddTargetsSubtaskGrow<taNumber>::Run() {
+  auto &task = static_cast<TTask&>(*GetTask());
+  auto &engine = static_cast<CpuEngine<taNumber>&>(task.GetBaseEngine());
+  const size_t nOldTargets = task.GetNOldTargets();
+  const size_t nNewBytes = (task.GetNTargets() - nOldTargets) * sizeof(taNumber);
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const size_t iRow = size_t(iItem);
+    const bool bA = (iRow < task.GetNARows());
+    SRFastArray<taNumber, false> &row = bA ? engine.ModStatRow(KBSection::A, iRow)
+      : engine.ModStatRow(KBSection::D, iRow - task.GetNARows());
+    try {
+      // A reallocation stores without caching, because the row is not accessed again in this operation.
+      row.GrowTo<false>(task.GetNTargets(), task.GetHeadroom());
+    }
+    catch (SRException &ex) {
+      task.AddError(std::move(PqaError().SetFromException(std::move(ex))));
+      continue;
+    }
+    // The source is a few cache lines shared by all the rows of the section, so it stays in cache.
+    std::memcpy(row.Get() + nOldTargets, bA ? task.GetInitA() : task.GetInitD(), nNewBytes);
+  }
+}
+
+template class CEAddTargetsSubtaskGrow<SRDoubleNumber>;
+
+} // namespace ProbQA
@@ -0,0 +1,22 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEAddTargetsTask.fwd.h"
+
+namespace ProbQA {
+
+// Grows each row to the targets appended, reallocating it only if its capacity is exceeded, and copies the initial
+//   values of the new targets into it.
+template<typename taNumber> class CEAddTargetsSubtaskGrow : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CEAddTargetsTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
@@ -0,0 +1,40 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEAddTargetsTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CETask.h"
+
+namespace ProbQA {
+
+// Extends the rows of A and D of the questions that were in the KB to the targets appended. The items processed are the
+//   rows in the order of the KB file sections: first the rows of A, then the rows of D.
+template<typename taNumber> class CEAddTargetsTask : public CETask {
+private: // variables
+  const size_t _nOldTargets;
+  const size_t _nTargets; // after the addition
+  const size_t _headroom; // the targets to make room for when a row is reallocated
+  const size_t _nARows;
+  // The initial values of the new targets, which are the same in each row of a section.
+  const taNumber *const _pInitA;
+  const taNumber *const _pInitD;
+
+public: // methods
+  CEAddTargetsTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers, const size_t nOldTargets,
+    const size_t nTargets, const size_t headroom, const size_t nARows, const taNumber *pInitA,
+    const taNumber *pInitD) : CETask(engine, nWorkers), _nOldTargets(nOldTargets), _nTargets(nTargets),
+    _headroom(headroom), _nARows(nARows), _pInitA(pInitA), _pInitD(pInitD)
+  { }
+
+  size_t GetNOldTargets() const { return _nOldTargets; }
+  size_t GetNTargets() const { return _nTargets; }
+  size_t GetHeadroom() const { return _headroom; }
+  size_t GetNARows() const { return _nARows; }
+  const taNumber* GetInitA() const { return _pInitA; }
+  const taNumber* GetInitD() const { return _pInitD; }
+};
+
+} // namespace ProbQA
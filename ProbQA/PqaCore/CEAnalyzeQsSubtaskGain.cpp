@@ -0,0 +1,102 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEAnalyzeQsSubtaskGain.h"
+#include "../PqaCore/CEAnalyzeQsTask.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template class CEAnalyzeQsSubtaskGain<SRDoubleNumber>;
+
+namespace {
+  // FNV-1a
+  constexpr uint64_t gcHashOffset = 0xcbf29ce484222325ULL;
+  constexpr uint64_t gcHashPrime = 0x100000001b3ULL;
+}
+
+template<> void CEAnalyzeQsSubtaskGain<SRDoubleNumber>::Run() {
+  auto &PTR_RESTRICT task = static_cast<const TTask&>(*GetTask());
+  auto &PTR_RESTRICT engine = static_cast<const CpuEngine<SRDoubleNumber>&>(task.GetBaseEngine());
+  const TPqaId nAnswers = engine.GetDims()._nAnswers;
+  const TPqaId nTargets = engine.GetDims()._nTargets;
+  const TPqaId nTargVects = SRMath::RShiftRoundUp(nTargets, SRSimd::_cLogNComps64);
+  const __m256d *const PTR_RESTRICT pPriors = SRCast::CPtr<__m256d>(task.GetPriors());
+  __m256d *const PTR_RESTRICT pBestA = SRCast::Ptr<__m256d>(task.GetBuffer(_iWorker));
+  __m256d *const PTR_RESTRICT pBestK = pBestA + nTargVects;
+  TPqaId *const PTR_RESTRICT pLabels = task.GetLabels(_iWorker);
+  SRDoubleNumber *const PTR_RESTRICT pGains = task.GetGains();
+  uint64_t *const PTR_RESTRICT pPartHashes = task.GetPartHashes();
+  const double priorH = task.GetPriorEntropy();
+
+  for (TPqaId i = _iFirst; i < _iLimit; i++) {
+    if (engine.GetQuestionGaps().IsGap(i)) {
+      pGains[i].SetValue(0);
+      pPartHashes[i] = 0;
+      continue;
+    }
+    const __m256d *const PTR_RESTRICT pmDi = SRCast::CPtr<__m256d>(&(engine.GetD(i, 0)));
+    // The expected entropy of the posteriors: sum over k of W[k]*H[k], where W[k] is the probability of answer k and
+    //   H[k] is the entropy of the posteriors given answer k. With likelihoods L[t]=P(k|t)*P(t) summing to W[k],
+    //   W[k]*H[k] = W[k]*log2(W[k]) - sum over t of L[t]*log2(L[t]).
+    SRAccumulator<SRDoubleNumber> accPostH(SRDoubleNumber(0.0));
+    for (TPqaId k = 0; k < nAnswers; k++) {
+      const __m256d *const PTR_RESTRICT psAik = SRCast::CPtr<__m256d>(&(engine.GetA(i, k, 0)));
+      const __m256d curK = _mm256_set1_pd(double(k));
+      SRAccumVectDbl256 accW, accLL;
+      for (TPqaId j = 0; j < nTargVects; j++) {
+        const uint8_t gaps = engine.GetTargetGaps().GetQuad(j);
+        const __m256d gapMask = _mm256_castsi256_pd(SRSimd::SetToBitQuadHot(gaps));
+        const __m256d vA = SRSimd::Load<false>(psAik + j);
+        const __m256d likelihood = _mm256_andnot_pd(gapMask, _mm256_mul_pd(_mm256_div_pd(vA,
+          SRSimd::Load<false>(pmDi + j)), SRSimd::Load<true>(pPriors + j)));
+        accW.Add(likelihood);
+        // The zero likelihoods contribute nothing, rather than 0*log2(0).
+        const __m256d nonZero = _mm256_cmp_pd(likelihood, _mm256_setzero_pd(), _CMP_GT_OQ);
+        accLL.Add(_mm256_and_pd(nonZero, _mm256_mul_pd(likelihood, SRVectMath::Log2Hot(likelihood))));
+
+        // The greatest count is the most likely answer, because D[i][t] is the same for all the answers. The lowest
+        //   answer wins a tie.
+        if (k == 0) {
+          SRSimd::Store<true>(pBestA + j, vA);
+          SRSimd::Store<true>(pBestK + j, curK);
+        }
+        else {
+          const __m256d oldBestA = SRSimd::Load<true>(pBestA + j);
+          const __m256d greater = _mm256_cmp_pd(vA, oldBestA, _CMP_GT_OQ);
+          SRSimd::Store<true>(pBestA + j, _mm256_blendv_pd(oldBestA, vA, greater));
+          SRSimd::Store<true>(pBestK + j, _mm256_blendv_pd(SRSimd::Load<true>(pBestK + j), curK, greater));
+        }
+      }
+      double sumLL;
+      const double Wk = accW.PairSum(accLL, sumLL);
+      if (Wk > 0) {
+        accPostH.Add(SRDoubleNumber::FromDouble(Wk * std::log2(Wk) - sumLL));
+      }
+    }
+    pGains[i].SetValue(priorH - accPostH.Get().GetValue());
+
+    std::fill(pLabels, pLabels + nAnswers, cInvalidPqaId);
+    TPqaId nLabels = 0;
+    uint64_t hash = gcHashOffset;
+    const double *const PTR_RESTRICT pBestKs = SRCast::CPtr<double>(pBestK);
+    for (TPqaId j = 0; j < nTargets; j++) {
+      if (engine.GetTargetGaps().IsGap(j)) {
+        continue;
+      }
+      const TPqaId k = TPqaId(pBestKs[j]);
+      if (pLabels[k] == cInvalidPqaId) {
+        pLabels[k] = nLabels;
+        nLabels++;
+      }
+      hash = (hash ^ uint64_t(pLabels[k])) * gcHashPrime;
+    }
+    pPartHashes[i] = hash;
+  }
+}
+
+} // namespace ProbQA
@@ -0,0 +1,22 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEAnalyzeQsTask.fwd.h"
+
+namespace ProbQA {
+
+// For each question, computes the expected information gain and hashes the partition of the targets by their most
+//   likely answer, with the answers labeled in the order of their first appearance.
+template<typename taNumber> class CEAnalyzeQsSubtaskGain : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CEAnalyzeQsTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
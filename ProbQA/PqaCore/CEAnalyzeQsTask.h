@@ -0,0 +1,45 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEAnalyzeQsTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CETask.h"
+
+namespace ProbQA {
+
+// Evaluates each question against the priors of a fresh quiz: the expected information gain, and the hash of the
+//   partition of the targets by their most likely answer.
+template<typename taNumber> class CEAnalyzeQsTask : public CETask {
+private: // variables
+  const taNumber *const _pPriors;
+  const TPqaAmount _priorEntropy;
+  taNumber *const _pGains;
+  uint64_t *const _pPartHashes;
+  // Per worker: the greatest answer counts and their answers over the targets, each row SIMD-padded, |_bufStride|
+  //   items apart.
+  taNumber *const _pBufs;
+  const size_t _bufStride;
+  // Per worker: the labels of the answers in the order of their first appearance over the targets.
+  TPqaId *const _pLabels;
+  const TPqaId _nAnswers;
+
+public: // methods
+  CEAnalyzeQsTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers, const taNumber *pPriors,
+    const TPqaAmount priorEntropy, taNumber *pGains, uint64_t *pPartHashes, taNumber *pBufs, const size_t bufStride,
+    TPqaId *pLabels, const TPqaId nAnswers) : CETask(engine, nWorkers), _pPriors(pPriors),
+    _priorEntropy(priorEntropy), _pGains(pGains), _pPartHashes(pPartHashes), _pBufs(pBufs), _bufStride(bufStride),
+    _pLabels(pLabels), _nAnswers(nAnswers)
+  { }
+
+  const taNumber* GetPriors() const { return _pPriors; }
+  TPqaAmount GetPriorEntropy() const { return _priorEntropy; }
+  taNumber* GetGains() const { return _pGains; }
+  uint64_t* GetPartHashes() const { return _pPartHashes; }
+  taNumber* GetBuffer(const SRPlat::SRSubtaskCount iWorker) const { return _pBufs + iWorker * _bufStride; }
+  TPqaId* GetLabels(const SRPlat::SRSubtaskCount iWorker) const { return _pLabels + iWorker * _nAnswers; }
+};
+
+} // namespace ProbQA
@@ -0,0 +1,56 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CECompactSubtaskMove.h"
+#include "../PqaCore/CECompactTask.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template class CECompactSubtaskMove<SRDoubleNumber>;
+
+template<> void CECompactSubtaskMove<SRDoubleNumber>::Run() {
+  auto &task = static_cast<const TTask&>(*GetTask());
+  auto &engine = static_cast<CpuEngine<SRDoubleNumber>&>(task.GetBaseEngine());
+  const TPqaId *const PTR_RESTRICT pSrcs = task.GetSrcs();
+  const TPqaId *const PTR_RESTRICT pDests = task.GetDests();
+  const TPqaId nMoves = task.GetNMoves();
+  const TPqaId nVectMoves = nMoves & ~TPqaId(SRSimd::_cNComps64 - 1);
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const size_t iRow = size_t(iItem);
+    SRFastArray<SRDoubleNumber, false> &row = (iRow < task.GetNARows()) ? engine.ModStatRow(KBSection::A, iRow)
+      : engine.ModStatRow(KBSection::D, iRow - task.GetNARows());
+    // All the destinations precede all the sources, so the order of the moves doesn't matter.
+    double *const pRow = SRCast::Ptr<double>(row.Get());
+    TPqaId i = 0;
+    for (; i < nVectMoves; i += SRSimd::_cNComps64) {
+      const __m256i srcs = _mm256_load_si256(SRCast::CPtr<__m256i>(pSrcs + i));
+      const __m256d vals = _mm256_i64gather_pd(pRow, srcs, /*number of bytes per item*/ 8);
+      const TPqaId iDest = pDests[i];
+      if (pDests[i + SRSimd::_cNComps64 - 1] - iDest == SRSimd::_cNComps64 - 1
+        && (iDest & (SRSimd::_cNComps64 - 1)) == 0)
+      {
+        // A run of gaps, e.g. after a bulk removal: the destination is not accessed again in this operation.
+        _mm256_stream_pd(pRow + iDest, vals);
+        continue;
+      }
+      // AVX2 has no scatter.
+      const __m128d lo = _mm256_castpd256_pd128(vals);
+      const __m128d hi = _mm256_extractf128_pd(vals, 1);
+      _mm_storel_pd(pRow + iDest, lo);
+      _mm_storeh_pd(pRow + pDests[i + 1], lo);
+      _mm_storel_pd(pRow + pDests[i + 2], hi);
+      _mm_storeh_pd(pRow + pDests[i + 3], hi);
+    }
+    for (; i < nMoves; i++) {
+      pRow[pDests[i]] = pRow[pSrcs[i]];
+    }
+  }
+  _mm_sfence();
+}
+
+} // namespace ProbQA
@@ -0,0 +1,21 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CECompactTask.fwd.h"
+
+namespace ProbQA {
+
+// Gathers the values of the targets moved in each row and stores them to the gaps.
+template<typename taNumber> class CECompactSubtaskMove : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CECompactTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
@@ -0,0 +1,11 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+namespace ProbQA {
+
+template<typename taNumber> class CECompactTask;
+
+} // namespace ProbQA
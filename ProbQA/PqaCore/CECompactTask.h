@@ -0,0 +1,35 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CECompactTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CETask.h"
+
+namespace ProbQA {
+
+// Moves the targets to the gaps in the rows of A and D. The items processed are the rows in the order of the KB file
+//   sections: first the rows of A, then the rows of D.
+template<typename taNumber> class CECompactTask : public CETask {
+private: // variables
+  // The moves: the value of target _pSrcs[i] goes to target _pDests[i]. Both arrays are SIMD-aligned and ascending.
+  const TPqaId *const _pSrcs;
+  const TPqaId *const _pDests;
+  const TPqaId _nMoves;
+  const size_t _nARows;
+
+public: // methods
+  CECompactTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers, const TPqaId *pSrcs,
+    const TPqaId *pDests, const TPqaId nMoves, const size_t nARows) : CETask(engine, nWorkers), _pSrcs(pSrcs),
+    _pDests(pDests), _nMoves(nMoves), _nARows(nARows)
+  { }
+
+  const TPqaId* GetSrcs() const { return _pSrcs; }
+  const TPqaId* GetDests() const { return _pDests; }
+  TPqaId GetNMoves() const { return _nMoves; }
+  size_t GetNARows() const { return _nARows; }
+};
+
+} // namespace ProbQA
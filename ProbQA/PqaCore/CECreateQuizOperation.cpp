@@ -3,9 +3,6 @@
 // This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
 
 #include "stdafx.h"
-#include "../PqaCore/CEDivTargPriorsSubtask.h"
-#include "../PqaCore/CESetPriorsSubtaskSum.h"
-#include "../PqaCore/CESetPriorsTask.h"
 #include "../PqaCore/CECreateQuizOperation.h"
 #include "../PqaCore/CEUpdatePriorsTask.h"
 #include "../PqaCore/CEUpdatePriorsSubtaskMul.h"
@@ -18,38 +15,15 @@ namespace ProbQA {
 
 template class CECreateQuizStart<SRDoubleNumber>;
 template class CECreateQuizResume<SRDoubleNumber>;
+template class CECreateQuizRestore<SRDoubleNumber>;
 
 template<typename taNumber> void CECreateQuizStart<taNumber>::UpdateLikelihoods(BaseCpuEngine &baseCe,
   CEBaseQuiz &baseQuiz)
 {
   auto &PTR_RESTRICT engine = static_cast<CpuEngine<taNumber>&>(baseCe);
   auto &PTR_RESTRICT quiz = static_cast<CEQuiz<taNumber>&>(baseQuiz);
-
-  const EngineDimensions& dims = engine.GetDims();
-  const SRThreadCount nWorkers = engine.GetWorkers().GetWorkerCount();
-
-  SRMemTotal mtCommon;
-  const SRByteMem miSubtasks(nWorkers * SRMaxSizeof<CESetPriorsSubtaskSum<taNumber>, 
-    CEDivTargPriorsSubtask<CESetPriorsTask<taNumber>>>::value, SRMemPadding::None, mtCommon);
-  const SRByteMem miSplit(SRPoolRunner::CalcSplitMemReq(nWorkers), SRMemPadding::Both, mtCommon);
-
-  SRSmartMPP<uint8_t> commonBuf(engine.GetMemPool(), mtCommon._nBytes);
-  SRPoolRunner pr(engine.GetWorkers(), miSubtasks.BytePtr(commonBuf));
-
-  const TPqaId nTargetVects = SRSimd::VectsFromComps<taNumber>(dims._nTargets);
-  const SRPoolRunner::Split targSplit = SRPoolRunner::CalcSplit(miSplit.BytePtr(commonBuf), nTargetVects, nWorkers);
-
-  CESetPriorsTask<taNumber> spTask(engine, quiz);
-  {
-    SRRWLock<false> rwl(engine.GetRws());
-    // Zero out exponents, copy mantissas, prepare for summing
-    typedef CESetPriorsSubtaskSum<taNumber> TSubtask;
-    SRPoolRunner::Keeper<TSubtask> kp = pr.RunPreSplit<TSubtask>(spTask, targSplit);
-    rwl.EarlyRelease();
-    Summator<taNumber>::ForPriors(kp, spTask);
-  }
-  // Divide the likelihoods by their sum so to get probabilities
-  pr.RunPreSplit<CEDivTargPriorsSubtask<CESetPriorsTask<taNumber>>>(spTask, targSplit);
+  // All the fresh quizzes have the same priors, so just refer to them till the first answer is recorded.
+  quiz.SharePriors(engine.AcquireSharedPriors());
 }
 
 template<typename taNumber> void CECreateQuizResume<taNumber>::UpdateLikelihoods(BaseCpuEngine &baseCe,
@@ -66,20 +40,42 @@ template<typename taNumber> void CECreateQuizResume<taNumber>::UpdateLikelihoods
   const SRByteMem miSubtasks(nWorkers * std::max(CpuEngine<taNumber>::_cNormPriorsMemReqPerSubtask,
     SRMaxSizeof<CEUpdatePriorsSubtaskMul<taNumber>>::value), SRMemPadding::None, mtCommon);
   const SRByteMem miSplit(SRPoolRunner::CalcSplitMemReq(nWorkers), SRMemPadding::Both, mtCommon);
+  // The exponents are only needed until the priors are normalized, so they are not kept in the quiz.
+  const SRMemItem<CEBaseQuiz::TExponent> miExps(SRCast::ToSizeT(dims._nTargets), SRMemPadding::Both, mtCommon);
 
   SRSmartMPP<uint8_t> commonBuf(engine.GetMemPool(), mtCommon._nBytes);
   SRPoolRunner pr(engine.GetWorkers(), miSubtasks.BytePtr(commonBuf));
+  CEBaseQuiz::TExponent *pExps = miExps.Ptr(commonBuf);
+  quiz.AllocPriors();
 
   const TPqaId nTargetVects = SRSimd::VectsFromComps<taNumber>(dims._nTargets);
   const SRPoolRunner::Split targSplit = SRPoolRunner::CalcSplit(miSplit.BytePtr(commonBuf), nTargetVects, nWorkers);
   {
-    CEUpdatePriorsTask<taNumber> task(engine, quiz, _nAnswered, _pAQs, CalcVectsInCache());
+    CEUpdatePriorsTask<taNumber> task(engine, quiz, pExps, _nAnswered, _pAQs, CalcVectsInCache());
     SRRWLock<false> rwl(engine.GetRws());
     // Copy from B and update the likelihoods with the questions answered.
     pr.RunPreSplit<CEUpdatePriorsSubtaskMul<taNumber>>(task, targSplit);
   }
   // Normalize to probabilities
-  _err = engine.NormalizePriors(quiz, pr, targSplit);
+  _err = engine.NormalizePriors(quiz, pExps, pr, targSplit);
+}
+
+template<typename taNumber> void CECreateQuizRestore<taNumber>::UpdateLikelihoods(BaseCpuEngine &baseCe,
+  CEBaseQuiz &baseQuiz)
+{
+  auto &PTR_RESTRICT engine = static_cast<CpuEngine<taNumber>&>(baseCe);
+  auto &PTR_RESTRICT quiz = static_cast<CEQuiz<taNumber>&>(baseQuiz);
+  if (_pPriors == nullptr) {
+    if (this->_nAnswered == 0) {
+      quiz.SharePriors(engine.AcquireSharedPriors());
+      return;
+    }
+    CECreateQuizResume<taNumber>::UpdateLikelihoods(baseCe, baseQuiz);
+    return;
+  }
+  // The priors were saved normalized, so they don't depend on the KB anymore.
+  quiz.AllocPriors();
+  std::memcpy(quiz.ModPriorMants(), _pPriors, sizeof(taNumber) * SRCast::ToSizeT(engine.GetDims()._nTargets));
 }
 
 } // namespace ProbQA
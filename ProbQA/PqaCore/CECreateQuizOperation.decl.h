@@ -45,8 +45,19 @@ private: //methods
 
 public: //methods
   explicit CECreateQuizResume(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs);
-  void UpdateLikelihoods(BaseCpuEngine &baseCe, CEBaseQuiz &baseQuiz) override final;
+  void UpdateLikelihoods(BaseCpuEngine &baseCe, CEBaseQuiz &baseQuiz) override;
   bool IsResume() const override final { return true; }
 };
 
+// Restores a quiz saved to a file: the answers are applied as in resuming, but the priors are copied from the file.
+template<typename taNumber> class CECreateQuizRestore : public CECreateQuizResume<taNumber> {
+public: // variables
+  const taNumber* const _pPriors;
+
+public: //methods
+  explicit CECreateQuizRestore(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs,
+    const taNumber* const pPriors);
+  void UpdateLikelihoods(BaseCpuEngine &baseCe, CEBaseQuiz &baseQuiz) override final;
+};
+
 } // namespace ProbQA
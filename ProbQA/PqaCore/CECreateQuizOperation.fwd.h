@@ -9,5 +9,6 @@ namespace ProbQA {
 class CECreateQuizOpBase;
 template<typename taNumber> class CECreateQuizStart;
 template<typename taNumber> class CECreateQuizResume;
+template<typename taNumber> class CECreateQuizRestore;
 
 } // namespace ProbQA
@@ -19,6 +19,11 @@ template<typename taNumber> inline CECreateQuizResume<taNumber>::CECreateQuizRes
   : CECreateQuizOpBase(err), _nAnswered(nAnswered), _pAQs(pAQs)
 { }
 
+template<typename taNumber> inline CECreateQuizRestore<taNumber>::CECreateQuizRestore(PqaError& err,
+  const TPqaId nAnswered, const AnsweredQuestion* const pAQs, const taNumber* const pPriors)
+  : CECreateQuizResume<taNumber>(err, nAnswered, pAQs), _pPriors(pPriors)
+{ }
+
 template<typename taNumber> inline std::enable_if_t<SRPlat::SRSimd::_cNBytes % sizeof(taNumber) == 0, uint32_t>
 CECreateQuizResume<taNumber>::CalcVectsInCache()
 {
@@ -0,0 +1,42 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEDecaySubtaskMul.h"
+#include "../PqaCore/CEDecayTask.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template class CEDecaySubtaskMul<SRDoubleNumber>;
+
+template<> void CEDecaySubtaskMul<SRDoubleNumber>::Run() {
+  auto &task = static_cast<const TTask&>(*GetTask());
+  auto &engine = static_cast<CpuEngine<SRDoubleNumber>&>(task.GetBaseEngine());
+  const size_t nAnswers = SRCast::ToSizeT(engine.GetDims()._nAnswers);
+  const TPqaId nTargets = engine.GetDims()._nTargets;
+  const TPqaId nVects = nTargets >> SRSimd::_cLogNComps64;
+  const double factor = task.GetFactor().GetValue();
+  const __m256d vFactor = _mm256_set1_pd(factor);
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const size_t iQuestion = SRCast::ToSizeT(task.GetFirstQuestion()) + size_t(iItem) / (nAnswers + 1);
+    const size_t iAnswer = size_t(iItem) % (nAnswers + 1);
+    SRFastArray<SRDoubleNumber, false> &row = (iAnswer < nAnswers)
+      ? engine.ModStatRow(KBSection::A, iQuestion * nAnswers + iAnswer) : engine.ModStatRow(KBSection::D, iQuestion);
+    double *const PTR_RESTRICT pRow = SRCast::Ptr<double>(row.Get());
+    // The whole KB is passed once, so don't evict the rows needed by the other operations.
+    for (TPqaId i = 0; i < nVects; i++) {
+      const TPqaId j = i << SRSimd::_cLogNComps64;
+      _mm256_stream_pd(pRow + j, _mm256_mul_pd(_mm256_load_pd(pRow + j), vFactor));
+    }
+    for (TPqaId j = nVects << SRSimd::_cLogNComps64; j < nTargets; j++) {
+      pRow[j] *= factor;
+    }
+  }
+  _mm_sfence();
+}
+
+} // namespace ProbQA
@@ -0,0 +1,20 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEDecayTask.fwd.h"
+
+namespace ProbQA {
+
+template<typename taNumber> class CEDecaySubtaskMul : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CEDecayTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
@@ -0,0 +1,29 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEDecayTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CETask.h"
+
+namespace ProbQA {
+
+// Multiplies the rows of A and D of a range of questions by a factor. The items processed are the rows of the questions
+//   in order, each question having the rows of A in the order of answers, followed by the row of D.
+template<typename taNumber> class CEDecayTask : public CETask {
+private: // variables
+  const TPqaId _iFirstQuestion;
+  const taNumber _factor;
+
+public: // methods
+  CEDecayTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers, const TPqaId iFirstQuestion,
+    const taNumber factor) : CETask(engine, nWorkers), _iFirstQuestion(iFirstQuestion), _factor(factor)
+  { }
+
+  TPqaId GetFirstQuestion() const { return _iFirstQuestion; }
+  const taNumber& GetFactor() const { return _factor; }
+};
+
+} // namespace ProbQA
@@ -5,14 +5,12 @@
 #pragma once
 
 #include "../PqaCore/CEDivTargPriorsSubtask.fwd.h"
-#include "../PqaCore/CEQuiz.fwd.h"
 
 namespace ProbQA {
 
 template<typename taNumber> class CEBaseDivTargPriorsSubtask : public SRPlat::SRStandardSubtask {
 public:
-  inline void __vectorcall RunInternal(const CEQuiz<taNumber> &PTR_RESTRICT quiz,
-    const SRPlat::SRNumPack<taNumber> sumPriors);
+  inline void __vectorcall RunInternal(taNumber *PTR_RESTRICT pPriors, const SRPlat::SRNumPack<taNumber> sumPriors);
   using SRPlat::SRStandardSubtask::SRStandardSubtask;
 };
 
@@ -10,9 +10,9 @@
 namespace ProbQA {
 
 template<> inline void __vectorcall CEBaseDivTargPriorsSubtask<SRPlat::SRDoubleNumber>::RunInternal(
-  const CEQuiz<SRPlat::SRDoubleNumber> &PTR_RESTRICT quiz, const SRPlat::SRNumPack<SRPlat::SRDoubleNumber> sumPriors)
+  SRPlat::SRDoubleNumber *PTR_RESTRICT pPriors, const SRPlat::SRNumPack<SRPlat::SRDoubleNumber> sumPriors)
 {
-  auto *PTR_RESTRICT pMants = SRPlat::SRCast::Ptr<__m256d>(quiz.GetPriorMants());
+  auto *PTR_RESTRICT pMants = SRPlat::SRCast::Ptr<__m256d>(pPriors);
   for (TPqaId i = _iFirst; i < _iLimit; i++) {
     const __m256d original = SRPlat::SRSimd::Load<false>(pMants + i);
     //TODO: divide once, then replace division with multiplication
@@ -24,8 +24,7 @@ template<> inline void __vectorcall CEBaseDivTargPriorsSubtask<SRPlat::SRDoubleN
 
 template<typename taTask> inline void CEDivTargPriorsSubtask<taTask>::Run() {
   auto &PTR_RESTRICT task = static_cast<const TTask&>(*GetTask());
-  const CEQuiz<SRDoubleNumber> &PTR_RESTRICT quiz = task.GetQuiz();
-  RunInternal(quiz, task._sumPriors);
+  RunInternal(task.GetDestPriors(), task._sumPriors);
 }
 
 } // namespace ProbQA
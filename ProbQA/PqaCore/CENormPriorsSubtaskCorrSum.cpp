@@ -50,8 +50,8 @@ template<> void CENormPriorsSubtaskCorrSum<SRDoubleNumber>::Run() {
   auto &PTR_RESTRICT engine = static_cast<const CpuEngine<SRDoubleNumber>&>(ctx._pTask->GetBaseEngine());
   const CEQuiz<SRDoubleNumber> &PTR_RESTRICT quiz = ctx._pTask->GetQuiz();
   ctx._pGt = &engine.GetTargetGaps();
-  ctx._pExps = SRCast::Ptr<__m256i>(quiz.GetTlhExps());
-  ctx._pMants = SRCast::Ptr<__m256d>(quiz.GetPriorMants());
+  ctx._pExps = SRCast::Ptr<__m256i>(ctx._pTask->GetTlhExps());
+  ctx._pMants = SRCast::Ptr<__m256d>(quiz.ModPriorMants());
 
   SRAccumVectDbl256 acc;
   for (TPqaId i = _iFirst, iEn = _iLimit; i < iEn; i++) {
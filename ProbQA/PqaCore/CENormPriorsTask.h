@@ -16,9 +16,12 @@ namespace ProbQA {
 template<typename taNumber> class CENormPriorsTask : public CEBaseTask {
 public: // types
   typedef taNumber TNumber;
+  typedef int64_t TExponent; // the same as CEBaseQuiz::TExponent
 
 private: // variables
   const CEQuiz<taNumber> *const _pQuiz;
+  // Exponents for the target likelihoods, which are zeroed out by the normalization.
+  TExponent *const _pExps;
 
 public:
   // The number to add to the exponent so to get it within the representable range or to cut off if corrected exponent
@@ -27,14 +30,16 @@ public:
   SRPlat::SRNumPack<taNumber> _sumPriors;
 
 public:
-  explicit inline CENormPriorsTask(CpuEngine<taNumber> &engine, CEQuiz<taNumber> &quiz);
+  explicit inline CENormPriorsTask(CpuEngine<taNumber> &engine, CEQuiz<taNumber> &quiz, TExponent *pExps);
 
   const CEQuiz<taNumber>& GetQuiz() const { return *_pQuiz; }
+  taNumber* GetDestPriors() const { return _pQuiz->ModPriorMants(); }
+  TExponent* GetTlhExps() const { return _pExps; }
 };
 #pragma warning( pop )
 
 template<typename taNumber> inline CENormPriorsTask<taNumber>::CENormPriorsTask(CpuEngine<taNumber> &engine,
-  CEQuiz<taNumber> &quiz) : CEBaseTask(engine), _pQuiz(&quiz)
+  CEQuiz<taNumber> &quiz, TExponent *pExps) : CEBaseTask(engine), _pQuiz(&quiz), _pExps(pExps)
 { }
 
 } // namespace ProbQA
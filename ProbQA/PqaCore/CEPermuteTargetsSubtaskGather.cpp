@@ -0,0 +1,49 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEPermuteTargetsSubtaskGather.h"
+#include "../PqaCore/CEPermuteTargetsTask.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template class CEPermuteTargetsSubtaskGather<SRDoubleNumber>;
+
+template<> void CEPermuteTargetsSubtaskGather<SRDoubleNumber>::Run() {
+  auto &task = static_cast<const TTask&>(*GetTask());
+  auto &engine = static_cast<CpuEngine<SRDoubleNumber>&>(task.GetBaseEngine());
+  const TPqaId nTargets = task.GetNTargets();
+  const TPqaId nVects = nTargets >> SRSimd::_cLogNComps64;
+  const TPqaId *const PTR_RESTRICT pOrder = task.GetOrder();
+  // The buffer is reused for each row, so it stays in cache.
+  double *const PTR_RESTRICT pBuf = SRCast::Ptr<double>(task.GetBuffer(_iWorker));
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const size_t iRow = size_t(iItem);
+    SRFastArray<SRDoubleNumber, false> &row = (iRow < task.GetNARows()) ? engine.ModStatRow(KBSection::A, iRow)
+      : engine.ModStatRow(KBSection::D, iRow - task.GetNARows());
+    double *const PTR_RESTRICT pRow = SRCast::Ptr<double>(row.Get());
+    for (TPqaId i = 0; i < nVects; i++) {
+      const __m256i srcs = _mm256_load_si256(SRCast::CPtr<__m256i>(pOrder) + i);
+      _mm256_store_pd(pBuf + (i << SRSimd::_cLogNComps64), _mm256_i64gather_pd(pRow, srcs,
+        /*number of bytes per item*/ 8));
+    }
+    for (TPqaId j = nVects << SRSimd::_cLogNComps64; j < nTargets; j++) {
+      pBuf[j] = pRow[pOrder[j]];
+    }
+    // The row is not accessed again in this operation.
+    for (TPqaId i = 0; i < nVects; i++) {
+      const TPqaId j = i << SRSimd::_cLogNComps64;
+      _mm256_stream_pd(pRow + j, _mm256_load_pd(pBuf + j));
+    }
+    for (TPqaId j = nVects << SRSimd::_cLogNComps64; j < nTargets; j++) {
+      pRow[j] = pBuf[j];
+    }
+  }
+  _mm_sfence();
+}
+
+} // namespace ProbQA
@@ -0,0 +1,21 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEPermuteTargetsTask.fwd.h"
+
+namespace ProbQA {
+
+// Gathers each row in the new order of the targets into the buffer of the worker, and writes it back.
+template<typename taNumber> class CEPermuteTargetsSubtaskGather : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CEPermuteTargetsTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
@@ -0,0 +1,37 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEPermuteTargetsTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CETask.h"
+
+namespace ProbQA {
+
+// Permutes the targets in the rows of A and D. The items processed are the rows in the order of the KB file sections:
+//   first the rows of A, then the rows of D.
+template<typename taNumber> class CEPermuteTargetsTask : public CETask {
+private: // variables
+  // The old position of the target at each new position. SIMD-aligned.
+  const TPqaId *const _pOrder;
+  const TPqaId _nTargets;
+  const size_t _nARows;
+  // A row-sized buffer per worker, |_bufStride| items apart.
+  taNumber *const _pBufs;
+  const size_t _bufStride;
+
+public: // methods
+  CEPermuteTargetsTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers, const TPqaId *pOrder,
+    const TPqaId nTargets, const size_t nARows, taNumber *pBufs, const size_t bufStride) : CETask(engine, nWorkers),
+    _pOrder(pOrder), _nTargets(nTargets), _nARows(nARows), _pBufs(pBufs), _bufStride(bufStride)
+  { }
+
+  const TPqaId* GetOrder() const { return _pOrder; }
+  TPqaId GetNTargets() const { return _nTargets; }
+  size_t GetNARows() const { return _nARows; }
+  taNumber* GetBuffer(const SRPlat::SRSubtaskCount iWorker) const { return _pBufs + iWorker * _bufStride; }
+};
+
+} // namespace ProbQA
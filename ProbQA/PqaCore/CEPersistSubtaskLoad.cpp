@@ -0,0 +1,72 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEPersistSubtaskLoad.h"
+#include "../PqaCore/CEPersistTask.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template<typename taNumber> void CEPersistSubtaskLoad<taNumber>::Run() {
+  auto &task = static_cast<TTask&>(*GetTask());
+  auto &engine = static_cast<CpuEngine<taNumber>&>(task.GetBaseEngine());
+  const KBFileHeader &header = task.GetHeader();
+  SRPositionalFile &file = *task.GetFile();
+  const size_t rowStride = SRCast::ToSizeT(header._rowStride);
+  const size_t rowBytes = sizeof(taNumber) * SRCast::ToSizeT(header._dims._nTargets);
+  const KBCompressedRegion *pCompressed = task.GetCompressed();
+
+  // A compressed region is read into |packed|, decompressed into |shuffled|, then unshuffled back into |packed|.
+  const size_t regionBytes = SRCast::ToSizeT(header._rowsPerRegion) * rowStride;
+  SRSmartMPP<uint8_t> packed(engine.GetMemPool(), (pCompressed == nullptr) ? regionBytes
+    : SRCompression::MaxCompressedBytes(regionBytes));
+  SRSmartMPP<uint8_t> shuffled(engine.GetMemPool(), (pCompressed == nullptr) ? 0 : regionBytes);
+
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const uint64_t iRegion = task.GetRegion(iItem);
+    KBSection ks;
+    uint64_t iFirstRow, iLimRow;
+    header.LocateRegion(iRegion, ks, iFirstRow, iLimRow);
+    const size_t nBytes = SRCast::ToSizeT((iLimRow - iFirstRow) * header._rowStride);
+    uint32_t expectedCrc;
+    if (pCompressed == nullptr) {
+      if (!file.Read(packed.Get(), nBytes, task.GetFileOffset(iItem, ks, iFirstRow))) {
+        task.AddError(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(task.GetFilePath()), SRMessageBuilder(
+          SR_FILE_LINE "Can't read KB delta region #")(iRegion).GetOwnedSRString()));
+        continue;
+      }
+      expectedCrc = task.GetCrcs()[iItem];
+    }
+    else {
+      const KBCompressedRegion &kcr = pCompressed[iRegion];
+      if (kcr._nBytes > SRCompression::MaxCompressedBytes(nBytes)
+        || !file.Read(packed.Get(), SRCast::ToSizeT(kcr._nBytes), kcr._offset)
+        || !SRCompression::Decompress(packed.Get(), SRCast::ToSizeT(kcr._nBytes), shuffled.Get(), nBytes))
+      {
+        task.AddError(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(task.GetFilePath()), SRMessageBuilder(
+          SR_FILE_LINE "Can't read or decompress KB region #")(iRegion).GetOwnedSRString()));
+        continue;
+      }
+      SRCompression::Unshuffle(shuffled.Get(), nBytes, sizeof(taNumber), packed.Get());
+      expectedCrc = kcr._checksum;
+    }
+    if (SRChecksum::Crc32c(packed.Get(), nBytes) != expectedCrc) {
+      task.AddError(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(task.GetFilePath()), SRMessageBuilder(
+        SR_FILE_LINE "Checksum mismatch in KB region #")(iRegion)(" of section #")(uint32_t(ks)).GetOwnedSRString()));
+      continue;
+    }
+    // The regions are distinct, so are the rows written by different subtasks.
+    const uint8_t *pSrc = packed.Get();
+    for (uint64_t i = iFirstRow; i < iLimRow; i++, pSrc += rowStride) {
+      memcpy(engine.ModStatRow(ks, SRCast::ToSizeT(i)).Get(), pSrc, rowBytes);
+    }
+  }
+}
+
+template class CEPersistSubtaskLoad<SRDoubleNumber>;
+
+} // namespace ProbQA
@@ -0,0 +1,23 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEPersistTask.fwd.h"
+
+namespace ProbQA {
+
+// Reads each region, decompressing it in case of KB file format version 3, checks its checksum and scatters its rows
+//   into the statistics of the engine. Used when the statistics are not memory-mapped, i.e. for a compressed KB file
+//   and the delta file applied on top of it.
+template<typename taNumber> class CEPersistSubtaskLoad : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CEPersistTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
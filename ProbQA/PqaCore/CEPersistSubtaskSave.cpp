@@ -0,0 +1,100 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEPersistSubtaskSave.h"
+#include "../PqaCore/CEPersistTask.h"
+#include "../PqaCore/CpuEngine.h"
+#include "../PqaCore/IoThrottle.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template<typename taNumber> void CEPersistSubtaskSave<taNumber>::Run() {
+  static const uint8_t zeros[SRSimd::_cNBytes] = { 0 };
+  auto &task = static_cast<TTask&>(*GetTask());
+  auto &engine = static_cast<CpuEngine<taNumber>&>(task.GetBaseEngine());
+  const KBFileHeader &header = task.GetHeader();
+  SRPositionalFile &file = *task.GetFile();
+  IoThrottle *pThrottle = task.GetThrottle();
+  const size_t rowStride = SRCast::ToSizeT(header._rowStride);
+  const size_t rowBytes = sizeof(taNumber) * SRCast::ToSizeT(header._dims._nTargets);
+  const size_t padBytes = rowStride - rowBytes;
+  assert(padBytes < sizeof(zeros));
+
+  // A region of multiple rows is gathered into a buffer, so to be written at once. A single-row region is written
+  //   right from the row, unless it's saved from a snapshot: then the row can change during the write, or compressed.
+  CESnapshot<taNumber> *pSnapshot = task.GetSnapshot();
+  KBCompressedRegion *pCompressed = task.GetCompressed();
+  const bool bGather = (header._rowsPerRegion > 1) || (pSnapshot != nullptr) || (pCompressed != nullptr);
+  const size_t regionBytes = SRCast::ToSizeT(header._rowsPerRegion) * rowStride;
+  SRSmartMPP<uint8_t> buf(engine.GetMemPool(), bGather ? regionBytes : 0);
+  SRSmartMPP<uint8_t> shuffled(engine.GetMemPool(), (pCompressed != nullptr) ? regionBytes : 0);
+  SRSmartMPP<uint8_t> packed(engine.GetMemPool(), (pCompressed != nullptr)
+    ? SRCompression::MaxCompressedBytes(regionBytes) : 0);
+
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const uint64_t iRegion = task.GetRegion(iItem);
+    KBSection ks;
+    uint64_t iFirstRow, iLimRow;
+    header.LocateRegion(iRegion, ks, iFirstRow, iLimRow);
+    const uint64_t offset = task.GetFileOffset(iItem, ks, iFirstRow);
+    uint32_t crc;
+    bool bOk;
+    size_t nWritten;
+    if (bGather) {
+      uint8_t *pDest = buf.Get();
+      if (pSnapshot == nullptr) {
+        for (uint64_t i = iFirstRow; i < iLimRow; i++, pDest += rowStride) {
+          memcpy(pDest, engine.GetStatRow(ks, SRCast::ToSizeT(i)).Get(), rowBytes);
+          memset(pDest + rowBytes, 0, padBytes);
+        }
+      }
+      else {
+        // Only gathering is locked, not the write.
+        SRRWLock<false> rwl(pSnapshot->GetSync());
+        for (uint64_t i = iFirstRow; i < iLimRow; i++, pDest += rowStride) {
+          memcpy(pDest, engine.GetSnapshotRow(*pSnapshot, ks, SRCast::ToSizeT(i)), rowBytes);
+          memset(pDest + rowBytes, 0, padBytes);
+        }
+      }
+      const size_t nBytes = pDest - buf.Get();
+      crc = SRChecksum::Crc32c(buf.Get(), nBytes);
+      if (pCompressed == nullptr) {
+        bOk = file.Write(buf.Get(), nBytes, offset);
+        nWritten = nBytes;
+      }
+      else {
+        SRCompression::Shuffle(buf.Get(), nBytes, sizeof(taNumber), shuffled.Get());
+        const size_t nPacked = SRCompression::Compress(shuffled.Get(), nBytes, packed.Get());
+        KBCompressedRegion &kcr = pCompressed[iRegion];
+        kcr._offset = task.ReserveFileBytes(nPacked);
+        kcr._nBytes = nPacked;
+        bOk = file.Write(packed.Get(), nPacked, kcr._offset);
+        nWritten = nPacked;
+      }
+    }
+    else {
+      assert(iLimRow == iFirstRow + 1);
+      const taNumber *pRow = engine.GetStatRow(ks, SRCast::ToSizeT(iFirstRow)).Get();
+      crc = SRChecksum::Crc32c(zeros, padBytes, SRChecksum::Crc32c(pRow, rowBytes));
+      bOk = file.Write(pRow, rowBytes, offset) && (padBytes == 0 || file.Write(zeros, padBytes, offset + rowBytes));
+      nWritten = rowStride;
+    }
+    if (!bOk) {
+      task.AddError(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(task.GetFilePath()), SRMessageBuilder(
+        SR_FILE_LINE "Can't write KB region #")(iRegion).GetOwnedSRString()));
+      return;
+    }
+    task.GetCrcs()[iItem] = crc;
+    if (pThrottle != nullptr) {
+      pThrottle->Consume(nWritten);
+    }
+  }
+}
+
+template class CEPersistSubtaskSave<SRDoubleNumber>;
+
+} // namespace ProbQA
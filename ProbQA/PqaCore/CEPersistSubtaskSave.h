@@ -0,0 +1,22 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEPersistTask.fwd.h"
+
+namespace ProbQA {
+
+// Gathers the rows of each region with their padding, computes the checksum of the region and writes it to the file,
+//   compressing it first for KB file format version 3.
+template<typename taNumber> class CEPersistSubtaskSave : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CEPersistTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
@@ -0,0 +1,41 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEPersistSubtaskVerify.h"
+#include "../PqaCore/CEPersistTask.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template<typename taNumber> void CEPersistSubtaskVerify<taNumber>::Run() {
+  auto &task = static_cast<TTask&>(*GetTask());
+  const KBFileHeader &header = task.GetHeader();
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const uint64_t iRegion = task.GetRegion(iItem);
+    KBSection ks;
+    uint64_t iFirstRow, iLimRow;
+    header.LocateRegion(iRegion, ks, iFirstRow, iLimRow);
+    uint8_t *pRegion = task.GetMapped() + header.Section(ks)._offset + iFirstRow * header._rowStride;
+    const size_t nBytes = SRCast::ToSizeT((iLimRow - iFirstRow) * header._rowStride);
+    // A region of a delta file overwrites the copy-on-write mapping of the base.
+    if (task.GetFile() != nullptr && !task.GetFile()->Read(pRegion, nBytes, task.GetFileOffset(iItem, ks, iFirstRow)))
+    {
+      task.AddError(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(task.GetFilePath()), SRMessageBuilder(
+        SR_FILE_LINE "Can't read KB delta region #")(iRegion).GetOwnedSRString()));
+      continue;
+    }
+    // Reading the mapping faults the pages in, so this is also the parallel load of the region.
+    const uint32_t crc = SRChecksum::Crc32c(pRegion, nBytes);
+    if (crc != task.GetCrcs()[iItem]) {
+      task.AddError(PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(task.GetFilePath()), SRMessageBuilder(
+        SR_FILE_LINE "Checksum mismatch in KB region #")(iRegion)(" of section #")(uint32_t(ks)).GetOwnedSRString()));
+    }
+  }
+}
+
+template class CEPersistSubtaskVerify<SRDoubleNumber>;
+
+} // namespace ProbQA
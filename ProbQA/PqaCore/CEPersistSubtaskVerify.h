@@ -0,0 +1,22 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEPersistTask.fwd.h"
+
+namespace ProbQA {
+
+// Checks the checksum of each region in the memory-mapped file. With a delta file, reads each region listed in it into
+//   the mapping first.
+template<typename taNumber> class CEPersistSubtaskVerify : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CEPersistTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
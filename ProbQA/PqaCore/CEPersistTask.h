@@ -0,0 +1,67 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEPersistTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CESnapshot.fwd.h"
+#include "../PqaCore/CETask.h"
+#include "../PqaCore/KBFileInfo.h"
+
+namespace ProbQA {
+
+// Saves, verifies or loads the regions of the statistics sections of a KB file, see KBFileHeader. The items processed
+//   are either all the regions in the order of the KB file, or the regions listed in the index of a delta file, see
+//   KBDeltaHeader.
+template<typename taNumber> class CEPersistTask : public CETask {
+public: // types
+  typedef taNumber TNumber;
+
+private: // variables
+  const KBFileInfo &_kbfi;
+  uint32_t *const _pCrcs; // One per item
+  SRPlat::SRPositionalFile *const _pFile; // The file to save to, or the delta file to load from
+  uint8_t *const _pMapped; // The mapping to verify
+  const KBDeltaRegion *const _pDelta; // The index of the delta file, if any
+  CESnapshot<taNumber> *const _pSnapshot; // The rows to save instead of the current ones, if any
+  // The region index of KB file format version 3, if it's saved or loaded, see KBCompressedRegion.
+  KBCompressedRegion *const _pCompressed;
+  // The compressed regions are appended at the end of the file in the order they are ready.
+  std::atomic<uint64_t> _fileEnd;
+
+public: // methods
+  CEPersistTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers, const KBFileInfo &kbfi,
+    uint32_t *pCrcs, SRPlat::SRPositionalFile *pFile, uint8_t *pMapped, const KBDeltaRegion *pDelta = nullptr,
+    CESnapshot<taNumber> *pSnapshot = nullptr, KBCompressedRegion *pCompressed = nullptr) : CETask(engine, nWorkers),
+    _kbfi(kbfi), _pCrcs(pCrcs), _pFile(pFile), _pMapped(pMapped), _pDelta(pDelta), _pSnapshot(pSnapshot),
+    _pCompressed(pCompressed), _fileEnd(0)
+  { }
+
+  const KBFileHeader& GetHeader() const { return _kbfi._header; }
+  const char* GetFilePath() const { return _kbfi._filePath; }
+  IoThrottle* GetThrottle() const { return _kbfi._pThrottle; }
+  uint32_t* GetCrcs() const { return _pCrcs; }
+  SRPlat::SRPositionalFile* GetFile() const { return _pFile; }
+  uint8_t* GetMapped() const { return _pMapped; }
+  CESnapshot<taNumber>* GetSnapshot() const { return _pSnapshot; }
+  KBCompressedRegion* GetCompressed() const { return _pCompressed; }
+
+  void SetFileEnd(const uint64_t fileEnd) { _fileEnd.store(fileEnd, std::memory_order_relaxed); }
+  uint64_t GetFileEnd() const { return _fileEnd.load(std::memory_order_relaxed); }
+  // Returns the offset for a compressed region of |nBytes|.
+  uint64_t ReserveFileBytes(const uint64_t nBytes) { return _fileEnd.fetch_add(nBytes, std::memory_order_relaxed); }
+
+  // The index of the region processed as item |iItem|, over all the sections of statistics.
+  uint64_t GetRegion(const int64_t iItem) const {
+    return (_pDelta == nullptr) ? uint64_t(iItem) : _pDelta[iItem]._iRegion;
+  }
+  // The offset of the region processed as item |iItem| in the file: in the delta file if any, otherwise in the KB.
+  uint64_t GetFileOffset(const int64_t iItem, const KBSection ks, const uint64_t iFirstRow) const {
+    return (_pDelta == nullptr) ? (GetHeader().Section(ks)._offset + iFirstRow * GetHeader()._rowStride)
+      : _pDelta[iItem]._offset;
+  }
+};
+
+} // namespace ProbQA
@@ -6,6 +6,7 @@
 
 #include "../PqaCore/CEQuiz.fwd.h"
 #include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CESharedPriors.fwd.h"
 #include "../PqaCore/BaseCpuEngine.h"
 #include "../PqaCore/BaseQuiz.h"
 
@@ -16,31 +17,56 @@ public: // types
   typedef int64_t TExponent;
 
 private:
-  // Exponents for the target likelyhoods: x[i] = _pTlhs[i] * pow(2, _pExps[i])
-  TExponent *_pTlhExps;
   // For each question, the corresponding bit indicates whether it has already been asked in this quiz
   __m256i *_isQAsked;
+  size_t _nQAskedVects; // the capacity of |_isQAsked|
+
+private: // methods
+  static inline size_t CalcQAskedBytes(const size_t nVects);
 
 protected: // methods
   inline explicit CEBaseQuiz(BaseCpuEngine *pEngine);
   inline ~CEBaseQuiz() override;
 
 public: // methods
-  TExponent* GetTlhExps() const { return _pTlhExps; }
   __m256i* GetQAsked() const { return _isQAsked; }
+  // Extends the bits of the questions asked to |nQuestions|, the new questions not asked.
+  inline void GrowQuestions(const TPqaId nQuestions);
 };
 
 template<typename taNumber> class CEQuiz : public CEBaseQuiz {
-  // For precision and to avoid underflow, mantissas and exponents are stored separately.
-  // Priors must be usually normalized, except for short periods of updating them.
+  // Priors must be usually normalized, except for short periods of updating them. Normalized priors are representable
+  //   in taNumber, so the quiz keeps only the mantissas. The exponents needed for precision and to avoid underflow
+  //   while the priors are recomputed from many answers (when resuming a quiz) are held in a temporary buffer of that
+  //   operation.
+  // Until the first answer is recorded, the priors are the same for all the quizzes, so they point to the shared ones.
   taNumber *_pPriorMants;
+  // Not null while the quiz refers to the shared priors, in which case the quiz holds a reference to them.
+  CESharedPriors<taNumber> *_pSharedPriors;
+  size_t _nOwnPriorsCap; // the capacity of the own priors, if the quiz doesn't share them
+
+private: // methods
+  void ReleasePriors();
 
 public: // methods
   explicit CEQuiz(CpuEngine<taNumber> *pEngine);
   ~CEQuiz() override final;
-  taNumber* GetPriorMants() const { return _pPriorMants; }
+  const taNumber* GetPriorMants() const { return _pPriorMants; }
+  // Only for the quiz that owns its priors, i.e. doesn't share them.
+  taNumber* ModPriorMants() const {
+    assert(_pSharedPriors == nullptr);
+    return _pPriorMants;
+  }
+  bool IsSharingPriors() const { return _pSharedPriors != nullptr; }
   CpuEngine<taNumber>* GetEngine() const;
 
+  // Takes over the reference to the shared priors held by the caller.
+  void SharePriors(CESharedPriors<taNumber> *pSharedPriors);
+  // Allocates the quiz's own buffer for the priors, not initialized.
+  void AllocPriors();
+  // Extends the own priors to |nTargets|, keeping the old ones. The priors of the new targets are not initialized.
+  void GrowOwnPriors(const TPqaId nTargets);
+
   PqaError RecordAnswer(const TPqaId iAnswer) override final;
 };
 
@@ -8,6 +8,7 @@
 #include "../PqaCore/CEDivTargPriorsSubtask.h"
 #include "../PqaCore/CERecordAnswerTask.h"
 #include "../PqaCore/CERecordAnswerSubtaskMul.h"
+#include "../PqaCore/CESharedPriors.h"
 #include "../PqaCore/CpuEngine.h"
 #include "../PqaCore/Summator.h"
 
@@ -15,36 +16,52 @@ namespace ProbQA {
 
 //////////////////////////////// CEBaseQuiz implementation /////////////////////////////////////////////////////////////
 
+inline size_t CEBaseQuiz::CalcQAskedBytes(const size_t nVects) {
+  using namespace SRPlat;
+  SRMemTotal mtCommon;
+  SRMemItem<__m256i> miIsQAsked(nVects, SRPlat::SRMemPadding::Both, mtCommon);
+  return mtCommon._nBytes;
+}
+
 inline CEBaseQuiz::CEBaseQuiz(BaseCpuEngine *pEngine) : BaseQuiz(pEngine) {
   using namespace SRPlat;
-  const EngineDimensions& dims = _pEngine->GetDims();
-  const size_t nQuestions = SRPlat::SRCast::ToSizeT(dims._nQuestions);
-  const size_t nTargets = SRPlat::SRCast::ToSizeT(dims._nTargets);
+  const size_t nQuestions = SRPlat::SRCast::ToSizeT(_nQuestions);
 
   SRMemTotal mtCommon;
   SRMemItem<__m256i> miIsQAsked(SRPlat::SRSimd::VectsFromBits(nQuestions), SRPlat::SRMemPadding::Both, mtCommon);
-  SRMemItem<TExponent> miExponents(nTargets, SRPlat::SRMemPadding::Both, mtCommon);
   // First allocate all the memory so to revert if anything fails.
   SRSmartMPP<uint8_t> commonBuf(_pEngine->GetMemPool(), mtCommon._nBytes);
   // Must be the first memory block, because it's used for releasing the memory
   _isQAsked = miIsQAsked.Ptr(commonBuf);
-  _pTlhExps = miExponents.Ptr(commonBuf);
+  _nQAskedVects = SRPlat::SRSimd::VectsFromBits(nQuestions);
   // As all the memory is allocated, safely proceed with finishing construction of CEBaseQuiz object.
   commonBuf.Detach();
 }
 
 inline CEBaseQuiz::~CEBaseQuiz() {
-  using namespace SRPlat;
-  //NOTE: engine dimensions must not change during lifetime of the quiz because below we must provide the same number
-  //  of targets and questions.
-  const EngineDimensions& dims = _pEngine->GetDims();
-  const size_t nQuestions = SRPlat::SRCast::ToSizeT(dims._nQuestions);
-  const size_t nTargets = SRPlat::SRCast::ToSizeT(dims._nTargets);
+  // The capacity is released rather than the engine dimensions, which may have grown during the lifetime of the quiz.
+  _pEngine->GetMemPool().ReleaseMem(_isQAsked, CalcQAskedBytes(_nQAskedVects));
+}
 
-  SRMemTotal mtCommon;
-  SRMemItem<__m256i> miIsQAsked(SRPlat::SRSimd::VectsFromBits(nQuestions), SRPlat::SRMemPadding::Both, mtCommon);
-  SRMemItem<TExponent> miExponents(nTargets, SRPlat::SRMemPadding::Both, mtCommon);
-  _pEngine->GetMemPool().ReleaseMem(_isQAsked, mtCommon._nBytes);
+inline void CEBaseQuiz::GrowQuestions(const TPqaId nQuestions) {
+  using namespace SRPlat;
+  assert(nQuestions >= _nQuestions);
+  // The bits beyond the questions are zero up to the capacity, so they only need to be added if it's exceeded.
+  const size_t nNeededVects = SRSimd::VectsFromBits(SRCast::ToSizeT(nQuestions));
+  if (nNeededVects > _nQAskedVects) {
+    const size_t nNewVects = nNeededVects + BaseCpuEngine::GrowthHeadroom(nNeededVects);
+    SRMemTotal mtCommon;
+    SRMemItem<__m256i> miIsQAsked(nNewVects, SRPlat::SRMemPadding::Both, mtCommon);
+    SRSmartMPP<uint8_t> commonBuf(_pEngine->GetMemPool(), mtCommon._nBytes);
+    __m256i *pNewQAsked = miIsQAsked.Ptr(commonBuf);
+    SRUtils::Copy256<true, true>(pNewQAsked, _isQAsked, _nQAskedVects);
+    SRUtils::FillZeroVects<true>(pNewQAsked + _nQAskedVects, nNewVects - _nQAskedVects);
+    _pEngine->GetMemPool().ReleaseMem(_isQAsked, CalcQAskedBytes(_nQAskedVects));
+    _isQAsked = pNewQAsked;
+    _nQAskedVects = nNewVects;
+    commonBuf.Detach();
+  }
+  _nQuestions = nQuestions;
 }
 
 //////////////////////////////// CEQuiz implementation /////////////////////////////////////////////////////////////////
@@ -53,25 +70,57 @@ template<typename taNumber> inline CpuEngine<taNumber>* CEQuiz<taNumber>::GetEng
   return static_cast<CpuEngine<taNumber>*>(GetBaseEngine());
 }
 
-template<typename taNumber> CEQuiz<taNumber>::CEQuiz(CpuEngine<taNumber> *pEngine) : CEBaseQuiz(pEngine) {
-  const EngineDimensions& dims = pEngine->GetDims();
-  const size_t nTargets = SRPlat::SRCast::ToSizeT(dims._nTargets);
-  auto& memPool = pEngine->GetMemPool();
+template<typename taNumber> CEQuiz<taNumber>::CEQuiz(CpuEngine<taNumber> *pEngine) : CEBaseQuiz(pEngine),
+  _pPriorMants(nullptr), _pSharedPriors(nullptr), _nOwnPriorsCap(0)
+{ }
 
-  // First allocate all the memory so to revert if anything fails.
-  SRPlat::SRSmartMPP<taNumber> smppMantissas(memPool, nTargets);
+template<typename taNumber> CEQuiz<taNumber>::~CEQuiz() {
+  ReleasePriors();
+}
 
-  // As all the memory is allocated, safely proceed with finishing construction of CEQuiz object.
+template<typename taNumber> void CEQuiz<taNumber>::ReleasePriors() {
+  if (_pSharedPriors != nullptr) {
+    _pSharedPriors->Release();
+    _pSharedPriors = nullptr;
+  }
+  else if (_pPriorMants != nullptr) {
+    GetBaseEngine()->GetMemPool().ReleaseMem(_pPriorMants, sizeof(*_pPriorMants) * _nOwnPriorsCap);
+  }
+  _pPriorMants = nullptr;
+  _nOwnPriorsCap = 0;
+}
+
+template<typename taNumber> void CEQuiz<taNumber>::SharePriors(CESharedPriors<taNumber> *pSharedPriors) {
+  assert(pSharedPriors->GetNTargets() == SRPlat::SRCast::ToSizeT(GetBaseEngine()->GetDims()._nTargets));
+  ReleasePriors();
+  _pSharedPriors = pSharedPriors;
+  _nTargets = TPqaId(pSharedPriors->GetNTargets());
+  // The shared priors are read-only. Only ModPriorMants() returns a writable pointer, and it's not allowed for sharing.
+  _pPriorMants = const_cast<taNumber*>(pSharedPriors->GetPriors());
+}
+
+template<typename taNumber> void CEQuiz<taNumber>::AllocPriors() {
+  const size_t nTargets = SRPlat::SRCast::ToSizeT(GetBaseEngine()->GetDims()._nTargets);
+  // First allocate the memory so to keep the old priors if the allocation fails.
+  SRPlat::SRSmartMPP<taNumber> smppMantissas(GetBaseEngine()->GetMemPool(), nTargets);
+  ReleasePriors();
   _pPriorMants = smppMantissas.Detach();
+  _nOwnPriorsCap = nTargets;
+  _nTargets = TPqaId(nTargets);
 }
 
-template<typename taNumber> CEQuiz<taNumber>::~CEQuiz() {
-  const EngineDimensions& dims = GetBaseEngine()->GetDims();
-  const size_t nTargets = SRPlat::SRCast::ToSizeT(dims._nTargets);
-  auto& memPool = GetBaseEngine()->GetMemPool();
-  //NOTE: engine dimensions must not change during lifetime of the quiz because below we must provide the same number
-  //  of targets.
-  memPool.ReleaseMem(_pPriorMants, sizeof(*_pPriorMants) * nTargets);
+template<typename taNumber> void CEQuiz<taNumber>::GrowOwnPriors(const TPqaId nTargets) {
+  assert(_pSharedPriors == nullptr && nTargets >= _nTargets);
+  const size_t nNeeded = SRPlat::SRCast::ToSizeT(nTargets);
+  if (nNeeded > _nOwnPriorsCap) {
+    const size_t nNewCap = nNeeded + BaseCpuEngine::GrowthHeadroom(nNeeded);
+    SRPlat::SRSmartMPP<taNumber> smppMantissas(GetBaseEngine()->GetMemPool(), nNewCap);
+    std::memcpy(smppMantissas.Get(), _pPriorMants, sizeof(taNumber) * SRPlat::SRCast::ToSizeT(_nTargets));
+    ReleasePriors();
+    _pPriorMants = smppMantissas.Detach();
+    _nOwnPriorsCap = nNewCap;
+  }
+  _nTargets = nTargets;
 }
 
 template<typename taNumber> inline PqaError CEQuiz<taNumber>::RecordAnswer(const TPqaId iAnswer) {
@@ -109,15 +158,38 @@ template<typename taNumber> inline PqaError CEQuiz<taNumber>::RecordAnswer(const
   const TPqaId nTargetVects = SRSimd::VectsFromComps<taNumber>(dims._nTargets);
   const SRPoolRunner::Split targSplit = SRPoolRunner::CalcSplit(miSplit.BytePtr(commonBuf), nTargetVects, nWorkers);
 
-  CERecordAnswerTask<taNumber> raTask(engine, *this, _answers.back());
-  {
-    SRRWLock<false> rwl(engine.GetRws());
-    typedef CERecordAnswerSubtaskMul<taNumber> TSubtask;
-    SRPoolRunner::Keeper<TSubtask> kp = pr.RunPreSplit<TSubtask>(raTask, targSplit);
-    Summator<taNumber>::ForPriors(kp, raTask);
+  // On the first answer, the quiz gets its own priors: the multiplication reads the shared priors and writes the own
+  //   ones, so there is no separate copying pass.
+  const taNumber *pSrcPriors = _pPriorMants;
+  CESharedPriors<taNumber> *pSharedPriors = _pSharedPriors;
+  if (pSharedPriors != nullptr) {
+    SRSmartMPP<taNumber> smppOwnPriors(engine.GetMemPool(), SRCast::ToSizeT(dims._nTargets));
+    // The reference to the shared priors is moved to |pSharedPriors| till the multiplication is over.
+    _pSharedPriors = nullptr;
+    _pPriorMants = smppOwnPriors.Detach();
+    _nOwnPriorsCap = SRCast::ToSizeT(dims._nTargets);
+  }
+  try {
+    CERecordAnswerTask<taNumber> raTask(engine, *this, _answers.back(), pSrcPriors, _pPriorMants);
+    {
+      SRRWLock<false> rwl(engine.GetRws());
+      typedef CERecordAnswerSubtaskMul<taNumber> TSubtask;
+      SRPoolRunner::Keeper<TSubtask> kp = pr.RunPreSplit<TSubtask>(raTask, targSplit);
+      Summator<taNumber>::ForPriors(kp, raTask);
+    }
+    // Divide the likelihoods by their sum calculated above
+    pr.RunPreSplit<CEDivTargPriorsSubtask<CERecordAnswerTask<taNumber>>>(raTask, targSplit);
+  }
+  catch (...) {
+    if (pSharedPriors != nullptr) {
+      // The own priors are not computed, so the quiz gets the reference to the shared priors back.
+      SharePriors(pSharedPriors);
+    }
+    throw;
+  }
+  if (pSharedPriors != nullptr) {
+    pSharedPriors->Release();
   }
-  // Divide the likelihoods by their sum calculated above
-  pr.RunPreSplit<CEDivTargPriorsSubtask<CERecordAnswerTask<taNumber>>>(raTask, targSplit);
   return PqaError();
 }
 
@@ -0,0 +1,62 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CERecomputeDSubtaskSum.h"
+#include "../PqaCore/CERecomputeDTask.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template class CERecomputeDSubtaskSum<SRDoubleNumber>;
+
+template<> void CERecomputeDSubtaskSum<SRDoubleNumber>::Run() {
+  auto &task = static_cast<const TTask&>(*GetTask());
+  auto &engine = static_cast<CpuEngine<SRDoubleNumber>&>(task.GetBaseEngine());
+  const size_t nAnswers = SRCast::ToSizeT(engine.GetDims()._nAnswers);
+  const TPqaId nTargets = engine.GetDims()._nTargets;
+  const TPqaId nVects = nTargets >> SRSimd::_cLogNComps64;
+  // The drift of the targets in the gaps may be 0/0, which _mm256_max_pd() skips as it returns the second operand.
+  __m256d vMaxDrift = _mm256_setzero_pd();
+  double maxDrift = 0;
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    const size_t iQuestion = SRCast::ToSizeT(task.GetFirstQuestion()) + size_t(iItem);
+    double *const PTR_RESTRICT pD = SRCast::Ptr<double>(engine.ModStatRow(KBSection::D, iQuestion).Get());
+    for (TPqaId i = 0; i < nVects; i++) {
+      const TPqaId j = i << SRSimd::_cLogNComps64;
+      SRAccumVectDbl256 acc;
+      for (size_t k = 0; k < nAnswers; k++) {
+        const double *const PTR_RESTRICT pA = SRCast::CPtr<double>(
+          engine.GetStatRow(KBSection::A, iQuestion * nAnswers + k).Get());
+        acc.Add(_mm256_load_pd(pA + j));
+      }
+      const __m256d sum = acc.GetComponents();
+      const __m256d diff = SRSimd::AbsF64(_mm256_sub_pd(_mm256_load_pd(pD + j), sum));
+      vMaxDrift = _mm256_max_pd(_mm256_div_pd(diff, sum), vMaxDrift);
+      // The whole of D is passed once, so don't evict the rows needed by the other operations.
+      _mm256_stream_pd(pD + j, sum);
+    }
+    for (TPqaId j = nVects << SRSimd::_cLogNComps64; j < nTargets; j++) {
+      SRAccumulator<SRDoubleNumber> acc(SRDoubleNumber(0.0));
+      for (size_t k = 0; k < nAnswers; k++) {
+        acc.Add(engine.GetA(TPqaId(iQuestion), TPqaId(k), j));
+      }
+      const double sum = acc.Get().GetValue();
+      const double drift = std::fabs(pD[j] - sum) / sum;
+      if (drift > maxDrift) {
+        maxDrift = drift;
+      }
+      pD[j] = sum;
+    }
+  }
+  _mm_sfence();
+  for (int i = 0; i < SRSimd::_cNComps64; i++) {
+    maxDrift = std::max(maxDrift, vMaxDrift.m256d_f64[i]);
+  }
+  _maxDrift.SetValue(maxDrift);
+}
+
+} // namespace ProbQA
@@ -0,0 +1,24 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CERecomputeDTask.fwd.h"
+
+namespace ProbQA {
+
+template<typename taNumber> class CERecomputeDSubtaskSum : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CERecomputeDTask<taNumber> TTask;
+
+public: // variables
+  // The maximum relative difference between the old and the recomputed D over the questions of this subtask.
+  taNumber _maxDrift;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
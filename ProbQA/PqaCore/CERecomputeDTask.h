@@ -0,0 +1,26 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CERecomputeDTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CETask.h"
+
+namespace ProbQA {
+
+// Recomputes the rows of D of a range of questions as the sums of the rows of A. The items processed are the questions.
+template<typename taNumber> class CERecomputeDTask : public CETask {
+private: // variables
+  const TPqaId _iFirstQuestion;
+
+public: // methods
+  CERecomputeDTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers, const TPqaId iFirstQuestion)
+    : CETask(engine, nWorkers), _iFirstQuestion(iFirstQuestion)
+  { }
+
+  TPqaId GetFirstQuestion() const { return _iFirstQuestion; }
+};
+
+} // namespace ProbQA
@@ -15,10 +15,10 @@ template class CERecordAnswerSubtaskMul<SRDoubleNumber>;
 template<> void CERecordAnswerSubtaskMul<SRDoubleNumber>::Run() {
   auto &PTR_RESTRICT  task = static_cast<const TTask&>(*GetTask());
   auto &PTR_RESTRICT engine = static_cast<const CpuEngine<SRDoubleNumber>&>(task.GetBaseEngine());
-  const CEQuiz<SRDoubleNumber> &PTR_RESTRICT quiz = task.GetQuiz();
   const GapTracker<TPqaId>& targGaps = engine.GetTargetGaps();
 
-  __m256d *PTR_RESTRICT pMants = SRCast::Ptr<__m256d>(quiz.GetPriorMants());
+  const __m256d *PTR_RESTRICT pSrcMants = SRCast::CPtr<__m256d>(task.GetSrcPriors());
+  __m256d *PTR_RESTRICT pDestMants = SRCast::Ptr<__m256d>(task.GetDestPriors());
 
   SRAccumVectDbl256 accMants;
   const AnsweredQuestion &PTR_RESTRICT aq = task.GetAQ();
@@ -30,11 +30,11 @@ template<> void CERecordAnswerSubtaskMul<SRDoubleNumber>::Run() {
     // P(answer(aq._iQuestion)==aq._iAnswer GIVEN target==(j0,j1,j2,j3))
     const __m256d P_qa_given_t = _mm256_div_pd(adjMuls, adjDivs);
 
-    const __m256d oldMants = SRSimd::Load<false>(pMants + i);
+    const __m256d oldMants = SRSimd::Load<false>(pSrcMants + i);
     const __m256d product = _mm256_mul_pd(oldMants, P_qa_given_t);
     const uint8_t gaps = targGaps.GetQuad(i);
     const __m256d newMants = _mm256_andnot_pd(_mm256_castsi256_pd(SRSimd::SetToBitQuadHot(gaps)), product);
-    SRSimd::Store<false>(pMants + i, newMants);
+    SRSimd::Store<false>(pDestMants + i, newMants);
 
     accMants.Add(newMants);
   }
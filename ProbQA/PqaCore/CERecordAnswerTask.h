@@ -18,15 +18,22 @@ public: // types
 private: // variables
   const AnsweredQuestion _aq;
   CEQuiz<taNumber> *_pQuiz;
+  // The priors before the answer, and the buffer for the priors after the answer. They are the same buffer unless the
+  //   quiz is materializing its own priors from the shared ones.
+  const taNumber *_pSrcPriors;
+  taNumber *_pDestPriors;
 public: // variables
   SRPlat::SRNumPack<taNumber> _sumPriors;
 
 public:
-  explicit CERecordAnswerTask(CpuEngine<taNumber> &engine, CEQuiz<taNumber> &quiz, const AnsweredQuestion& aq)
-    : CEBaseTask(engine), _pQuiz(&quiz), _aq(aq) { }
+  explicit CERecordAnswerTask(CpuEngine<taNumber> &engine, CEQuiz<taNumber> &quiz, const AnsweredQuestion& aq,
+    const taNumber *pSrcPriors, taNumber *pDestPriors) : CEBaseTask(engine), _pQuiz(&quiz), _aq(aq),
+    _pSrcPriors(pSrcPriors), _pDestPriors(pDestPriors) { }
 
   const AnsweredQuestion& GetAQ() const { return _aq; }
   CEQuiz<taNumber>& GetQuiz() const { return *_pQuiz; }
+  const taNumber* GetSrcPriors() const { return _pSrcPriors; }
+  taNumber* GetDestPriors() const { return _pDestPriors; }
 };
 
 } // namespace ProbQA
@@ -6,7 +6,6 @@
 #include "../PqaCore/CESetPriorsSubtaskSum.h"
 #include "../PqaCore/CESetPriorsTask.h"
 #include "../PqaCore/CpuEngine.h"
-#include "../PqaCore/CEQuiz.h"
 
 using namespace SRPlat;
 
@@ -17,13 +16,9 @@ template class CESetPriorsSubtaskSum<SRDoubleNumber>;
 template<> void CESetPriorsSubtaskSum<SRDoubleNumber>::Run() {
   auto &PTR_RESTRICT task = static_cast<const TTask&>(*GetTask());
   auto &PTR_RESTRICT engine = static_cast<const CpuEngine<SRDoubleNumber>&>(task.GetBaseEngine());
-  const CEQuiz<SRDoubleNumber> &PTR_RESTRICT quiz = task.GetQuiz();
   const GapTracker<TPqaId> &PTR_RESTRICT targGaps = engine.GetTargetGaps();
 
-  static_assert(std::is_same<int64_t, CEQuiz<SRDoubleNumber>::TExponent>::value, "The code below assumes TExponent is"
-    " 64-bit integer.");
-  auto *PTR_RESTRICT pExps = SRCast::Ptr<__m256i>(quiz.GetTlhExps());
-  auto *PTR_RESTRICT pMants = SRCast::Ptr<__m256d>(quiz.GetPriorMants());
+  auto *PTR_RESTRICT pMants = SRCast::Ptr<__m256d>(task.GetDestPriors());
   auto *PTR_RESTRICT pvB = SRCast::CPtr<__m256d>(&(engine.GetB(0)));
 
   SRAccumVectDbl256 acc;
@@ -32,7 +27,6 @@ template<> void CESetPriorsSubtaskSum<SRDoubleNumber>::Run() {
     const uint8_t gaps = targGaps.GetQuad(i);
     const __m256d activeMants = _mm256_andnot_pd(_mm256_castsi256_pd(SRSimd::SetToBitQuadHot(gaps)), allMants);
     SRSimd::Store<false>(pMants + i, activeMants);
-    SRSimd::Store<false>(pExps + i, _mm256_setzero_si256());
     acc.Add(activeMants);
   }
   _sumPriors.SetValue(acc.PreciseSum());
@@ -16,15 +16,15 @@ public: // types
   typedef taNumber TNumber;
 
 private:
-  const CEQuiz<taNumber> *const _pQuiz;
+  taNumber *const _pPriors;
 
 public: // variables
   SRPlat::SRNumPack<taNumber> _sumPriors;
 
 public:
-  CESetPriorsTask(CpuEngine<taNumber> &engine, CEQuiz<taNumber> &quiz) : CEBaseTask(engine), _pQuiz(&quiz) { }
+  CESetPriorsTask(CpuEngine<taNumber> &engine, taNumber *pPriors) : CEBaseTask(engine), _pPriors(pPriors) { }
 
-  const CEQuiz<taNumber>& GetQuiz() const { return *_pQuiz; }
+  taNumber* GetDestPriors() const { return _pPriors; }
 };
 
 } // namespace ProbQA
@@ -0,0 +1,56 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CESharedPriors.fwd.h"
+
+namespace ProbQA {
+
+// The priors normalized from vector B at a certain version of it. All the quizzes that haven't recorded any answer yet
+//   have identical priors, so they refer to this read-only object rather than to a copy of their own. The object is
+//   reference-counted: the engine holds a reference to the latest version, and each quiz sharing it holds another one.
+template<typename taNumber> class CESharedPriors {
+  SRPlat::SRBaseMemPool *_pMp;
+  taNumber *_pPriors;
+  const size_t _nTargets;
+  const uint64_t _version;
+  std::atomic<uint64_t> _nRefs;
+
+private: // methods
+  explicit CESharedPriors(SRPlat::SRBaseMemPool &mp, const size_t nTargets, const uint64_t version);
+  ~CESharedPriors();
+
+public: // methods
+  // The object returned has one reference, owned by the caller. The priors are not initialized.
+  static CESharedPriors* Create(SRPlat::SRBaseMemPool &mp, const size_t nTargets, const uint64_t version) {
+    return new CESharedPriors(mp, nTargets, version);
+  }
+
+  void AddRef() { _nRefs.fetch_add(1, std::memory_order_relaxed); }
+  void Release() {
+    if (_nRefs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  const taNumber* GetPriors() const { return _pPriors; }
+  // Only for filling the priors in before the object is shared.
+  taNumber* ModPriors() { return _pPriors; }
+  size_t GetNTargets() const { return _nTargets; }
+  uint64_t GetVersion() const { return _version; }
+};
+
+template<typename taNumber> inline CESharedPriors<taNumber>::CESharedPriors(SRPlat::SRBaseMemPool &mp,
+  const size_t nTargets, const uint64_t version) : _pMp(&mp), _nTargets(nTargets), _version(version), _nRefs(1)
+{
+  SRPlat::SRSmartMPP<taNumber> smppPriors(mp, nTargets);
+  _pPriors = smppPriors.Detach();
+}
+
+template<typename taNumber> inline CESharedPriors<taNumber>::~CESharedPriors() {
+  _pMp->ReleaseMem(_pPriors, sizeof(*_pPriors) * _nTargets);
+}
+
+} // namespace ProbQA
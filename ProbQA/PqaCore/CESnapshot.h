@@ -0,0 +1,56 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CESnapshot.fwd.h"
+
+namespace ProbQA {
+
+// The statistics of the CPU engine as of the moment the snapshot is taken, so that they can be saved without the KB
+//   lock. Rather than copying the whole KB, the rows of a question are copied just before they are first changed while
+//   the snapshot exists, so the additional memory is only for the questions trained during the save. Vector B changes
+//   with each training, so it's copied upfront.
+// The operations changing the statistics copy the rows under exclusive lock of the snapshot, and then change them out
+//   of this lock. The writer gathers the rows under shared lock, thus it reads either the copy, or the row before any
+//   change.
+template<typename taNumber> class CESnapshot {
+  SRPlat::SRReaderWriterSync _rws;
+  // Changed under exclusive _rws . The operations changing the statistics are serialized by the KB lock, so they can
+  //   check the bits without _rws .
+  SRPlat::SRBitArray _preserved;
+  // [iQuestion] -> the rows of A in the order of answers, followed by the row of D. Guarded by _rws
+  std::vector<SRPlat::SRFastArray<taNumber, false>> _rows;
+  const SRPlat::SRFastArray<taNumber, false> _vB;
+  const size_t _nAnswers;
+  const size_t _nTargets;
+
+public: // methods
+  explicit CESnapshot(const EngineDimensions &dims, const SRPlat::SRFastArray<taNumber, false> &vB)
+    : _preserved(uint64_t(dims._nQuestions)), _rows(SRPlat::SRCast::ToSizeT(dims._nQuestions)), _vB(vB),
+    _nAnswers(SRPlat::SRCast::ToSizeT(dims._nAnswers)), _nTargets(SRPlat::SRCast::ToSizeT(dims._nTargets))
+  { }
+  CESnapshot(const CESnapshot&) = delete;
+  CESnapshot& operator=(const CESnapshot&) = delete;
+
+  SRPlat::SRReaderWriterSync& GetSync() { return _rws; }
+  bool IsPreserved(const TPqaId iQuestion) const { return _preserved.GetOne(uint64_t(iQuestion)); }
+
+  // Must be called under exclusive lock of GetSync(). Returns the memory to copy the rows of the question to, see
+  //   |_rows|.
+  taNumber* Preserve(const TPqaId iQuestion) {
+    SRPlat::SRFastArray<taNumber, false> &rows = _rows[SRPlat::SRCast::ToSizeT(iQuestion)];
+    rows = SRPlat::SRFastArray<taNumber, false>((_nAnswers + 1) * _nTargets);
+    _preserved.SetOne(uint64_t(iQuestion));
+    return rows.Get();
+  }
+
+  // Row |iRow| of a preserved question: of A for |iRow| < nAnswers, otherwise of D.
+  const taNumber* GetRow(const TPqaId iQuestion, const size_t iRow) const {
+    return _rows[SRPlat::SRCast::ToSizeT(iQuestion)].Get() + iRow * _nTargets;
+  }
+  const SRPlat::SRFastArray<taNumber, false>& GetB() const { return _vB; }
+};
+
+} // namespace ProbQA
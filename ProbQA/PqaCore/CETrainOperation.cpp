@@ -25,6 +25,47 @@ void CETrainOperation<SRDoubleNumber>::ProcessOne(const AnsweredQuestion& aq, co
   _engine.ModD(aq._iQuestion, _iTarget).SetValue(sum.m128d_f64[1]);
 }
 
+template<> void CETrainOperation<SRDoubleNumber>::Perform4(const AnsweredQuestion& aq0, const AnsweredQuestion& aq1,
+  const AnsweredQuestion& aq2, const AnsweredQuestion& aq3)
+{
+  // Compare each question with the next one and with the one over, cyclically, which covers all the 6 pairs.
+  const __m256i questions = _mm256_set_epi64x(aq3._iQuestion, aq2._iQuestion, aq1._iQuestion, aq0._iQuestion);
+  const __m256i eqNext = _mm256_cmpeq_epi64(questions, _mm256_permute4x64_epi64(questions, _MM_SHUFFLE(0, 3, 2, 1)));
+  const __m256i eqOver = _mm256_cmpeq_epi64(questions, _mm256_permute4x64_epi64(questions, _MM_SHUFFLE(1, 0, 3, 2)));
+  const __m256i anyEq = _mm256_or_si256(eqNext, eqOver);
+  if (!_mm256_testz_si256(anyEq, anyEq)) {
+    // The same D, and maybe the same A, would be updated in several lanes. Leave the collisions to Perform2().
+    Perform2(aq0, aq1);
+    Perform2(aq2, aq3);
+    return;
+  }
+  SRDoubleNumber &a0 = _engine.ModA(aq0._iQuestion, aq0._iAnswer, _iTarget);
+  SRDoubleNumber &a1 = _engine.ModA(aq1._iQuestion, aq1._iAnswer, _iTarget);
+  SRDoubleNumber &a2 = _engine.ModA(aq2._iQuestion, aq2._iAnswer, _iTarget);
+  SRDoubleNumber &a3 = _engine.ModA(aq3._iQuestion, aq3._iAnswer, _iTarget);
+  SRDoubleNumber &d0 = _engine.ModD(aq0._iQuestion, _iTarget);
+  SRDoubleNumber &d1 = _engine.ModD(aq1._iQuestion, _iTarget);
+  SRDoubleNumber &d2 = _engine.ModD(aq2._iQuestion, _iTarget);
+  SRDoubleNumber &d3 = _engine.ModD(aq3._iQuestion, _iTarget);
+
+  // (a+b)**2 = a**2 + 2*a*b + b**2 , the same operations as in Perform2() so that the results are identical.
+  const __m256d aSquare = _mm256_set_pd(a3.GetValue(), a2.GetValue(), a1.GetValue(), a0.GetValue());
+  const __m256d ab2 = _mm256_mul_pd(_mm256_sqrt_pd(aSquare), _mm256_set1_pd(_numSpec._inc2B));
+  const __m256d addend = _mm256_add_pd(ab2, _mm256_set1_pd(_numSpec._incBSquare));
+  const __m256d sumA = _mm256_add_pd(aSquare, addend);
+  const __m256d sumD = _mm256_add_pd(_mm256_set_pd(d3.GetValue(), d2.GetValue(), d1.GetValue(), d0.GetValue()),
+    addend);
+
+  a0.SetValue(sumA.m256d_f64[0]);
+  a1.SetValue(sumA.m256d_f64[1]);
+  a2.SetValue(sumA.m256d_f64[2]);
+  a3.SetValue(sumA.m256d_f64[3]);
+  d0.SetValue(sumD.m256d_f64[0]);
+  d1.SetValue(sumD.m256d_f64[1]);
+  d2.SetValue(sumD.m256d_f64[2]);
+  d3.SetValue(sumD.m256d_f64[3]);
+}
+
 template<> void CETrainOperation<SRDoubleNumber>::Perform1(const AnsweredQuestion& aq) {
   ProcessOne(aq, _numSpec._inc2B, _numSpec._incBSquare);
 }
@@ -61,7 +102,7 @@ template<> void CETrainOperation<SRDoubleNumber>::Perform2(const AnsweredQuestio
 
     const __m128d aSquare = _mm_set_pd(_engine.GetA(aqSecond._iQuestion, aqSecond._iAnswer, _iTarget).GetValue(),
       _engine.GetA(aqFirst._iQuestion, aqFirst._iAnswer, _iTarget).GetValue());
-    //TODO: These SSE could be improved to AVX if extended to 4 answered questions at once
+    // Perform4() does these in AVX for 4 answered questions at once.
     const __m128d a = _mm_sqrt_pd(aSquare);
     const __m128d ab2 = _mm_mul_pd(a, _mm256_castpd256_pd128(vInc2B));
     const __m128d sseAddend = _mm_add_pd(ab2, _mm256_castpd256_pd128(vIncBSquare));
@@ -23,6 +23,9 @@ public:
     : _engine(engine), _iTarget(iTarget), _numSpec(numSpec) { }
 
   // Inputs must have been verified. Maintenance switch and reader-writer sync must be locked.
+  // If any questions coincide, it's the same as Perform2() for the first and the last two answered questions.
+  void Perform4(const AnsweredQuestion& aq0, const AnsweredQuestion& aq1, const AnsweredQuestion& aq2,
+    const AnsweredQuestion& aq3);
   void Perform2(const AnsweredQuestion& aqFirst, const AnsweredQuestion& aqSecond);
   void Perform1(const AnsweredQuestion& aq);
 };
@@ -0,0 +1,34 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CETrainReplayTask.fwd.h"
+#include "../PqaCore/CpuEngine.fwd.h"
+#include "../PqaCore/CETask.h"
+#include "../PqaCore/WriteAheadLog.h"
+
+namespace ProbQA {
+
+// Replays a run of training records from the write-ahead log. The questions are partitioned among the workers, so
+//   that each worker updates only its own rows of the KB, applying the trainings in the order of the log.
+template<typename taNumber> class CETrainReplayTask : public CETask {
+public: // types
+  typedef taNumber TNumber;
+
+private: // variables
+  const WalTraining *const _pTrainings;
+  const size_t _nTrainings;
+
+public: // methods
+  CETrainReplayTask(CpuEngine<taNumber> &engine, const SRPlat::SRSubtaskCount nWorkers,
+    const WalTraining *pTrainings, const size_t nTrainings)
+    : CETask(engine, nWorkers), _pTrainings(pTrainings), _nTrainings(nTrainings)
+  { }
+
+  const WalTraining* GetTrainings() const { return _pTrainings; }
+  size_t GetNTrainings() const { return _nTrainings; }
+};
+
+} // namespace ProbQA
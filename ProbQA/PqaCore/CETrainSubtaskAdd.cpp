@@ -17,24 +17,22 @@ template class CETrainSubtaskAdd<SRDoubleNumber>;
 template<> void CETrainSubtaskAdd<SRDoubleNumber>::Run() {
   auto& cTask = static_cast<const TTask&>(*GetTask()); // enable optimizations with const
   auto& engine = static_cast<CpuEngine<SRDoubleNumber>&>(cTask.GetBaseEngine());
-  TPqaId iLast = cTask._last[_iWorker];
-  if (iLast == cInvalidPqaId) {
-    return;
-  }
-  const TPqaId *const cPrev = cTask._prev;
+  const TPqaId *const cOrder = cTask._pOrder;
+  const TPqaId iEn = cTask._pBucketStarts[_iWorker + 1];
+  TPqaId i = cTask._pBucketStarts[_iWorker];
 
   CETrainOperation<SRDoubleNumber> trainOp(engine, cTask._iTarget, cTask._numSpec);
-  do {
-    const AnsweredQuestion& aqFirst = cTask._pAQs[iLast];
-    iLast = cPrev[iLast];
-    if (iLast == cInvalidPqaId) {
-      trainOp.Perform1(aqFirst);
-      return;
-    }
-    const AnsweredQuestion& aqSecond = cTask._pAQs[iLast];
-    trainOp.Perform2(aqFirst, aqSecond);
-    iLast = cPrev[iLast];
-  } while (iLast != cInvalidPqaId);
+  for (; i + 3 < iEn; i += 4) {
+    trainOp.Perform4(cTask._pAQs[cOrder[i]], cTask._pAQs[cOrder[i + 1]], cTask._pAQs[cOrder[i + 2]],
+      cTask._pAQs[cOrder[i + 3]]);
+  }
+  if (i + 1 < iEn) {
+    trainOp.Perform2(cTask._pAQs[cOrder[i]], cTask._pAQs[cOrder[i + 1]]);
+    i += 2;
+  }
+  if (i < iEn) {
+    trainOp.Perform1(cTask._pAQs[cOrder[i]]);
+  }
 }
 
 } // namespace ProbQA
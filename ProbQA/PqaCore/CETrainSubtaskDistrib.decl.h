@@ -9,6 +9,8 @@
 
 namespace ProbQA {
 
+// The first pass of the distribution: validates the answered questions in the range of the source worker and counts
+//   them per bucket.
 template<typename taNumber> class CETrainSubtaskDistrib : public SRPlat::SRBaseSubtask {
 public: // types
   typedef CETrainTask<taNumber> TTask;
@@ -16,9 +18,11 @@ public: // types
 private: // variables
   const AnsweredQuestion *_pFirst;
   const AnsweredQuestion *_pLim;
+  TPqaId *_pCounts; // of the source worker
 
 public: // methods
-  CETrainSubtaskDistrib(TTask *pTask, const AnsweredQuestion *pFirst, const AnsweredQuestion *pLim);
+  CETrainSubtaskDistrib(TTask *pTask, const SRPlat::SRSubtaskCount iSource, const AnsweredQuestion *pFirst,
+    const AnsweredQuestion *pLim);
   virtual void Run() override final;
 };
 
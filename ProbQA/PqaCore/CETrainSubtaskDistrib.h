@@ -11,8 +11,9 @@
 namespace ProbQA {
 
 template<typename taNumber> CETrainSubtaskDistrib<taNumber>::CETrainSubtaskDistrib(TTask *pTask,
-  const AnsweredQuestion *pFirst, const AnsweredQuestion *pLim)
-  : SRPlat::SRBaseSubtask(pTask), _pFirst(pFirst), _pLim(pLim)
+  const SRPlat::SRSubtaskCount iSource, const AnsweredQuestion *pFirst, const AnsweredQuestion *pLim)
+  : SRPlat::SRBaseSubtask(pTask), _pFirst(pFirst), _pLim(pLim),
+  _pCounts(pTask->_pCounts + iSource * pTask->_bucketStride)
 {
 }
 
@@ -43,12 +44,7 @@ template<typename taNumber> void CETrainSubtaskDistrib<taNumber>::Run() {
       return;
     }
     // Sort questions into buckets so that workers in the next phase do not race for data.
-    const TPqaId iBucket = iQuestion % nWorkers;
-    const TPqaId iPrev = task._iPrev.fetch_add(1);
-    TPqaId expected = task._last[iBucket].load(std::memory_order_acquire);
-    while (!task._last[iBucket].compare_exchange_weak(expected, iPrev, std::memory_order_acq_rel,
-      std::memory_order_acquire));
-    task._prev[iPrev] = expected;
+    _pCounts[iQuestion % nWorkers]++;
   }
 }
 
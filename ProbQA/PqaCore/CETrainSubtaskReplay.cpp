@@ -0,0 +1,47 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CETrainSubtaskReplay.h"
+#include "../PqaCore/CETrainReplayTask.h"
+#include "../PqaCore/CpuEngine.h"
+#include "../PqaCore/CETrainOperation.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template<typename taNumber> void CETrainSubtaskReplay<taNumber>::Run() {
+  auto& cTask = static_cast<const TTask&>(*GetTask()); // enable optimizations with const
+  auto& engine = static_cast<CpuEngine<taNumber>&>(cTask.GetBaseEngine());
+  const TPqaId nWorkers = cTask.GetWorkerCount();
+  const WalTraining *const pTrainings = cTask.GetTrainings();
+
+  for (size_t i = 0, iEn = cTask.GetNTrainings(); i < iEn; i++) {
+    const WalTraining &wt = pTrainings[i];
+    const CETrainTaskNumSpec<taNumber> numSpec(wt._amount);
+    CETrainOperation<taNumber> trainOp(engine, wt._iTarget, numSpec);
+    // Pair up the answered questions of this worker, like CETrainSubtaskAdd does.
+    const AnsweredQuestion *pPending = nullptr;
+    for (TPqaId j = 0; j < wt._nAQs; j++) {
+      const AnsweredQuestion &aq = wt._pAQs[j];
+      if (aq._iQuestion % nWorkers != TPqaId(_iWorker)) {
+        continue;
+      }
+      if (pPending == nullptr) {
+        pPending = &aq;
+        continue;
+      }
+      trainOp.Perform2(*pPending, aq);
+      pPending = nullptr;
+    }
+    if (pPending != nullptr) {
+      trainOp.Perform1(*pPending);
+    }
+  }
+}
+
+template class CETrainSubtaskReplay<SRDoubleNumber>;
+
+} // namespace ProbQA
@@ -0,0 +1,21 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CETrainReplayTask.fwd.h"
+
+namespace ProbQA {
+
+// Applies the answered questions whose question index modulo the number of workers is the index of this worker.
+template<typename taNumber> class CETrainSubtaskReplay : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CETrainReplayTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
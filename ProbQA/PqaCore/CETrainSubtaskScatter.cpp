@@ -0,0 +1,26 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CETrainSubtaskScatter.h"
+#include "../PqaCore/CETrainTask.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template class CETrainSubtaskScatter<SRDoubleNumber>;
+
+template<> void CETrainSubtaskScatter<SRDoubleNumber>::Run() {
+  auto& cTask = static_cast<const TTask&>(*GetTask()); // enable optimizations with const
+  const TPqaId nWorkers = cTask.GetWorkerCount();
+  TPqaId *const PTR_RESTRICT pPositions = cTask._pCounts + _iWorker * cTask._bucketStride;
+  TPqaId *const PTR_RESTRICT pOrder = cTask._pOrder;
+  const AnsweredQuestion *const PTR_RESTRICT pAQs = cTask._pAQs;
+  for (int64_t i = _iFirst; i < _iLimit; i++) {
+    pOrder[pPositions[pAQs[i]._iQuestion % nWorkers]++] = i;
+  }
+}
+
+} // namespace ProbQA
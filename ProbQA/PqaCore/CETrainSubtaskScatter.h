@@ -0,0 +1,22 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CETrainTask.fwd.h"
+
+namespace ProbQA {
+
+// The second pass of the distribution: puts the answered questions in the range of the source worker to their
+//   positions in the buckets. Must be split among the workers the same way as CETrainSubtaskDistrib.
+template<typename taNumber> class CETrainSubtaskScatter : public SRPlat::SRStandardSubtask {
+public: // types
+  typedef CETrainTask<taNumber> TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
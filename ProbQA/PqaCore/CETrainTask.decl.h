@@ -12,16 +12,27 @@
 
 namespace ProbQA {
 
+// The answered questions are put into buckets by question, one bucket per worker, so that the workers don't race for
+//   the rows of the KB. The distribution is a counting sort in two passes over the ranges of the source workers: the
+//   counting and the scattering, so that the workers write only to their own counters.
 template<typename taNumber> class CETrainTask : public CETask {
 public: // variables
-  std::atomic<TPqaId> *_last;
-  TPqaId *_prev;
+  // [iSource * _bucketStride + iBucket]: the number of the answered questions of the bucket in the range of the source
+  //   worker, then the position in _pOrder to scatter its next answered question of the bucket to.
+  TPqaId *_pCounts;
+  // [iBucket]: the position of the first answered question of the bucket in _pOrder. The last item is the total.
+  TPqaId *_pBucketStarts;
+  // The indices of the answered questions in _pAQs grouped by bucket.
+  TPqaId *_pOrder;
   const AnsweredQuestion* const _pAQs;
-  std::atomic<TPqaId> _iPrev;
   TPqaId _iTarget;
   CETrainTaskNumSpec<taNumber> _numSpec;
+  // In items of _pCounts. The counters of each source worker take whole cache lines.
+  const size_t _bucketStride;
 
 public: // methods
+  static size_t CalcBucketStride(const SRPlat::SRSubtaskCount nWorkers);
+
   explicit CETrainTask(CpuEngine<taNumber> &ce, const SRPlat::SRSubtaskCount nWorkers,
     const TPqaId iTarget, const AnsweredQuestion* const pAQs, const TPqaAmount amount);
   CETrainTask(const CETrainTask&) = delete;
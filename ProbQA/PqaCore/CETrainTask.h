@@ -8,9 +8,17 @@
 
 namespace ProbQA {
 
+template<typename taNumber> inline size_t CETrainTask<taNumber>::CalcBucketStride(
+  const SRPlat::SRSubtaskCount nWorkers)
+{
+  constexpr size_t cCountsPerLine = SRPlat::SRCpuInfo::_cacheLineBytes / sizeof(TPqaId);
+  return (nWorkers + cCountsPerLine - 1) / cCountsPerLine * cCountsPerLine;
+}
+
 template<typename taNumber> inline CETrainTask<taNumber>::CETrainTask(CpuEngine<taNumber> &ce,
   const SRPlat::SRSubtaskCount nWorkers, const TPqaId iTarget, const AnsweredQuestion* const pAQs,
-  const TPqaAmount amount) : CETask(ce, nWorkers), _iPrev(0), _iTarget(iTarget), _pAQs(pAQs), _numSpec(amount)
+  const TPqaAmount amount) : CETask(ce, nWorkers), _pAQs(pAQs), _iTarget(iTarget), _numSpec(amount),
+  _bucketStride(CalcBucketStride(nWorkers))
 { }
 
 } // namespace ProbQA
@@ -20,8 +20,8 @@ template<> template<bool taCache> void CEUpdatePriorsSubtaskMul<SRDoubleNumber>:
   static_assert(std::is_same<int64_t, CEQuiz<SRDoubleNumber>::TExponent>::value, "The code below assumes TExponent is"
     " 64-bit integer.");
 
-  auto *PTR_RESTRICT pExps = SRCast::Ptr<__m256i>(quiz.GetTlhExps());
-  auto *PTR_RESTRICT pMants = SRCast::Ptr<__m256d>(quiz.GetPriorMants());
+  auto *PTR_RESTRICT pExps = SRCast::Ptr<__m256i>(task._pExps);
+  auto *PTR_RESTRICT pMants = SRCast::Ptr<__m256d>(quiz.ModPriorMants());
   auto *PTR_RESTRICT pvB = SRCast::CPtr<__m256d>( &(engine.GetB(0)) );
 
   //TODO: consider replacing this with an assert(), because CpuEngine checks for nAnswered==0 and resorts to StartQuiz()
@@ -12,20 +12,26 @@
 namespace ProbQA {
 
 template<typename taNumber> class CEUpdatePriorsTask : public CEBaseTask {
+public: // types
+  typedef int64_t TExponent; // the same as CEBaseQuiz::TExponent
+
 public: // variables
   const CEQuiz<taNumber> *const _pQuiz;
+  // Exponents for the target likelihoods: x[i] = mantissa[i] * pow(2, _pExps[i])
+  TExponent *const _pExps;
   const AnsweredQuestion* const _pAQs;
   const TPqaId _nAnswered;
   const uint32_t _nVectsInCache;
 
 public: // methods
-  CEUpdatePriorsTask(CpuEngine<taNumber> &engine, CEQuiz<taNumber> &quiz, const TPqaId nAnswered,
-    const AnsweredQuestion* const pAQs, const uint32_t nVectsInCache);
+  CEUpdatePriorsTask(CpuEngine<taNumber> &engine, CEQuiz<taNumber> &quiz, TExponent *pExps,
+    const TPqaId nAnswered, const AnsweredQuestion* const pAQs, const uint32_t nVectsInCache);
 };
 
 template<typename taNumber> inline CEUpdatePriorsTask<taNumber>::CEUpdatePriorsTask(CpuEngine<taNumber> &engine,
-  CEQuiz<taNumber> &quiz, const TPqaId nAnswered, const AnsweredQuestion* const pAQs, const uint32_t nVectsInCache)
-  : CEBaseTask(engine), _pQuiz(&quiz), _nAnswered(nAnswered), _pAQs(pAQs), _nVectsInCache(nVectsInCache)
+  CEQuiz<taNumber> &quiz, TExponent *pExps, const TPqaId nAnswered, const AnsweredQuestion* const pAQs,
+  const uint32_t nVectsInCache) : CEBaseTask(engine), _pQuiz(&quiz), _pExps(pExps), _nAnswered(nAnswered),
+  _pAQs(pAQs), _nVectsInCache(nVectsInCache)
 { }
 
 } // namespace ProbQA
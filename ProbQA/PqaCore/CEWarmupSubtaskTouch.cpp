@@ -0,0 +1,48 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/CEWarmupSubtaskTouch.h"
+#include "../PqaCore/CpuEngine.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+template<typename taNumber> void CEWarmupSubtaskTouch<taNumber>::Run() {
+  auto &task = static_cast<const TTask&>(*GetTask());
+  auto &engine = static_cast<const CpuEngine<taNumber>&>(task.GetBaseEngine());
+  const EngineDimensions &dims = engine.GetDims();
+  const size_t nARows = SRCast::ToSizeT(dims._nQuestions) * SRCast::ToSizeT(dims._nAnswers);
+  const size_t nDRows = SRCast::ToSizeT(dims._nQuestions);
+  const size_t nRowBytes = SRCast::ToSizeT(dims._nTargets) * sizeof(taNumber);
+  if (nRowBytes == 0) {
+    return;
+  }
+  for (int64_t iItem = _iFirst; iItem < _iLimit; iItem++) {
+    size_t iRow = size_t(iItem);
+    KBSection ks;
+    if (iRow < nARows) {
+      ks = KBSection::A;
+    }
+    else if ((iRow -= nARows) < nDRows) {
+      ks = KBSection::D;
+    }
+    else {
+      ks = KBSection::B;
+      iRow = 0;
+    }
+    // The reads are volatile so that the compiler doesn't drop them. A read is enough: the mapped pages are
+    //   copy-on-write, so writing would copy all of them, even those which are never trained.
+    const volatile uint8_t *pRow = SRCast::CPtr<uint8_t>(engine.GetStatRow(ks, iRow).Get());
+    for (size_t j = 0; j < nRowBytes; j += _cPageBytes) {
+      (void)pRow[j];
+    }
+    (void)pRow[nRowBytes - 1];
+  }
+}
+
+template class CEWarmupSubtaskTouch<SRDoubleNumber>;
+
+} // namespace ProbQA
@@ -0,0 +1,26 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/CEBaseTask.h"
+
+namespace ProbQA {
+
+// Reads a byte from each page of the rows of statistics, in the order of the KB file sections, so that the pages are
+//   faulted in and the TLB entries are warm before the first quiz.
+template<typename taNumber> class CEWarmupSubtaskTouch : public SRPlat::SRStandardSubtask {
+public: // constants
+  // The smallest page size on x86-64. Touching more often costs little, while touching less often misses pages.
+  static constexpr size_t _cPageBytes = 4096;
+
+public: // types
+  typedef CEBaseTask TTask;
+
+public: // methods
+  using SRPlat::SRStandardSubtask::SRStandardSubtask;
+  virtual void Run() override final;
+};
+
+} // namespace ProbQA
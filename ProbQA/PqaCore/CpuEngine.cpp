@@ -10,14 +10,37 @@
 #include "../PqaCore/CETask.h"
 #include "../PqaCore/CETrainSubtaskDistrib.h"
 #include "../PqaCore/CETrainSubtaskAdd.h"
+#include "../PqaCore/CETrainSubtaskScatter.h"
 #include "../PqaCore/CETrainTaskNumSpec.h"
 #include "../PqaCore/CEQuiz.h"
 #include "../PqaCore/CECreateQuizOperation.h"
+#include "../PqaCore/CESetPriorsTask.h"
+#include "../PqaCore/CESetPriorsSubtaskSum.h"
+#include "../PqaCore/CESharedPriors.h"
 #include "../PqaCore/CEEvalQsTask.h"
 #include "../PqaCore/CEEvalQsSubtaskConsider.h"
 #include "../PqaCore/CEListTopTargetsAlgorithm.h"
 #include "../PqaCore/CETrainOperation.h"
 #include "../PqaCore/TargetRowPersistence.h"
+#include "../PqaCore/CEPersistTask.h"
+#include "../PqaCore/CEPersistSubtaskSave.h"
+#include "../PqaCore/CEPersistSubtaskLoad.h"
+#include "../PqaCore/CEPersistSubtaskVerify.h"
+#include "../PqaCore/CETrainReplayTask.h"
+#include "../PqaCore/CETrainSubtaskReplay.h"
+#include "../PqaCore/CEWarmupSubtaskTouch.h"
+#include "../PqaCore/CEAddTargetsTask.h"
+#include "../PqaCore/CEAddTargetsSubtaskGrow.h"
+#include "../PqaCore/CECompactTask.h"
+#include "../PqaCore/CECompactSubtaskMove.h"
+#include "../PqaCore/CEPermuteTargetsTask.h"
+#include "../PqaCore/CEPermuteTargetsSubtaskGather.h"
+#include "../PqaCore/CEAnalyzeQsTask.h"
+#include "../PqaCore/CEAnalyzeQsSubtaskGain.h"
+#include "../PqaCore/CEDecayTask.h"
+#include "../PqaCore/CEDecaySubtaskMul.h"
+#include "../PqaCore/CERecomputeDTask.h"
+#include "../PqaCore/CERecomputeDSubtaskSum.h"
 
 using namespace SRPlat;
 
@@ -32,12 +55,27 @@ template<typename taNumber> size_t CpuEngine<taNumber>::CalcWorkerStackSize(cons
 }
 
 template<typename taNumber> CpuEngine<taNumber>::CpuEngine(const EngineDefinition& engDef, KBFileInfo *pKbFi)
-  : BaseCpuEngine(engDef, CalcWorkerStackSize(engDef._dims), pKbFi)
+  : BaseCpuEngine(engDef, CalcWorkerStackSize(engDef._dims), pKbFi), _versionB(0), _pSharedPriors(nullptr),
+  _bComputingSharedPriors(false)
 {
   const size_t nQuestions = SRCast::ToSizeT(_dims._nQuestions);
   const size_t nAnswers = SRCast::ToSizeT(_dims._nAnswers);
   const size_t nTargets = SRCast::ToSizeT(_dims._nTargets);
 
+  if (pKbFi != nullptr && pKbFi->IsSectioned()) {
+    if (pKbFi->IsCompressed()) {
+      LoadCompressedStatistics(*pKbFi);
+    }
+    else {
+      MapStatistics(*pKbFi);
+    }
+    AfterStatisticsInit(pKbFi);
+    if (pKbFi->_bReplayWal) {
+      ReplayWal(*pKbFi);
+    }
+    return;
+  }
+
   TargetRowPersistence<taNumber> trp = ((pKbFi == nullptr) ? TargetRowPersistence<taNumber>()
     : TargetRowPersistence<taNumber>(pKbFi->_sf, nTargets));
 
@@ -92,15 +130,217 @@ template<typename taNumber> CpuEngine<taNumber>::CpuEngine(const EngineDefinitio
   AfterStatisticsInit(pKbFi);
 }
 
+template<typename taNumber> void CpuEngine<taNumber>::MapStatistics(KBFileInfo &kbfi) {
+  const size_t nQuestions = SRCast::ToSizeT(_dims._nQuestions);
+  const size_t nAnswers = SRCast::ToSizeT(_dims._nAnswers);
+  const size_t nTargets = SRCast::ToSizeT(_dims._nTargets);
+  const size_t rowStride = RowStride(_dims._nTargets);
+  const KBFileHeader &header = kbfi._header;
+  if (header._rowStride != rowStride || header._rowsPerRegion == 0) {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRMessageBuilder(SR_FILE_LINE
+      "Unexpected row stride in the KB file: ")(header._rowStride)(" instead of ")(rowStride)(", or region size: ")
+      (header._rowsPerRegion).GetOwnedSRString())
+      .ThrowMoving();
+  }
+
+  _pKbMapping.reset(new SRMemMappedFile(kbfi._filePath, SRMemMappedFile::Mode::CopyOnWrite));
+  // Returns the start of the section after checking that it lies within the file.
+  auto&& fnLocate = [&](const KBSection ks, const uint64_t nRows) -> uint8_t* {
+    const KBFileSection &section = header.Section(ks);
+    if (section._offset % KBFileHeader::_cSectionAlign != 0 || section._nBytes != nRows * rowStride
+      || section._offset + section._nBytes > _pKbMapping->Size())
+    {
+      PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRMessageBuilder(SR_FILE_LINE
+        "Section #")(uint32_t(ks))(" of the KB file is misplaced or truncated.").GetOwnedSRString()).ThrowMoving();
+    }
+    return _pKbMapping->Get() + section._offset;
+  };
+  uint8_t *pA = fnLocate(KBSection::A, uint64_t(nQuestions) * nAnswers);
+  uint8_t *pD = fnLocate(KBSection::D, nQuestions);
+  uint8_t *pB = fnLocate(KBSection::B, 1);
+  VerifyMappedStatistics(kbfi);
+  if (kbfi.HasDelta()) {
+    ApplyDelta(kbfi);
+  }
+
+  _sA.resize(nQuestions);
+  for (size_t i = 0; i < nQuestions; i++) {
+    _sA[i].resize(nAnswers);
+    for (size_t k = 0; k < nAnswers; k++) {
+      _sA[i][k].Borrow(SRCast::Ptr<taNumber>(pA + (i * nAnswers + k) * rowStride), nTargets);
+    }
+  }
+  _mD.resize(nQuestions);
+  for (size_t i = 0; i < nQuestions; i++) {
+    _mD[i].Borrow(SRCast::Ptr<taNumber>(pD + i * rowStride), nTargets);
+  }
+  _vB.Borrow(SRCast::Ptr<taNumber>(pB), nTargets);
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::VerifyMappedStatistics(KBFileInfo &kbfi) {
+  const KBFileHeader &header = kbfi._header;
+  const KBFileSection &checksums = header.Section(KBSection::Checksums);
+  const uint64_t nRegions = header.NTotalRegions();
+  if (checksums._nBytes != nRegions * sizeof(uint32_t) || checksums._offset + checksums._nBytes > _pKbMapping->Size())
+  {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "The checksums section of the KB file is misplaced or truncated.")).ThrowMoving();
+  }
+  uint32_t *pCrcs = SRCast::Ptr<uint32_t>(_pKbMapping->Get() + checksums._offset);
+  if (SRChecksum::Crc32c(pCrcs, SRCast::ToSizeT(checksums._nBytes)) != checksums._checksum) {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Checksum mismatch in the checksums section of the KB file.")).ThrowMoving();
+  }
+
+  const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+  SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEPersistSubtaskVerify<taNumber>));
+  SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+  CEPersistTask<taNumber> task(*this, nWorkers, kbfi, pCrcs, nullptr, _pKbMapping->Get());
+  pr.SplitAndRunSubtasks<CEPersistSubtaskVerify<taNumber>>(task, SRCast::ToSizeT(nRegions), nWorkers);
+  PqaError err = task.TakeAggregateError(SRString::MakeUnowned(SR_FILE_LINE "The KB file is corrupt."));
+  if (!err.IsOk()) {
+    PqaException(err.GetCode(), err.DetachParams(), SRString(err.GetMessage())).ThrowMoving();
+  }
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::LoadCompressedStatistics(KBFileInfo &kbfi) {
+  const size_t nQuestions = SRCast::ToSizeT(_dims._nQuestions);
+  const size_t nAnswers = SRCast::ToSizeT(_dims._nAnswers);
+  const size_t nTargets = SRCast::ToSizeT(_dims._nTargets);
+  const size_t rowStride = RowStride(_dims._nTargets);
+  const KBFileHeader &header = kbfi._header;
+  if (header._rowStride != rowStride || header._rowsPerRegion == 0) {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRMessageBuilder(SR_FILE_LINE
+      "Unexpected row stride in the KB file: ")(header._rowStride)(" instead of ")(rowStride)(", or region size: ")
+      (header._rowsPerRegion).GetOwnedSRString())
+      .ThrowMoving();
+  }
+  const KBFileSection &indexSection = header.Section(KBSection::Checksums);
+  const uint64_t nRegions = header.NTotalRegions();
+  if (indexSection._nBytes != nRegions * sizeof(KBCompressedRegion)) {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "The region index of the KB file doesn't match its dimensions.")).ThrowMoving();
+  }
+
+  _sA.resize(nQuestions);
+  for (size_t i = 0; i < nQuestions; i++) {
+    _sA[i].resize(nAnswers);
+    for (size_t k = 0; k < nAnswers; k++) {
+      _sA[i][k].Resize<false>(nTargets);
+    }
+  }
+  _mD.resize(nQuestions);
+  for (size_t i = 0; i < nQuestions; i++) {
+    _mD[i].Resize<false>(nTargets);
+  }
+  _vB.Resize<false>(nTargets);
+
+  SRPositionalFile file(kbfi._filePath, SRPositionalFile::Mode::Read);
+  SRSmartMPP<KBCompressedRegion> index(_memPool, SRCast::ToSizeT(nRegions));
+  if (!file.Read(index.Get(), SRCast::ToSizeT(indexSection._nBytes), indexSection._offset)
+    || SRChecksum::Crc32c(index.Get(), SRCast::ToSizeT(indexSection._nBytes)) != indexSection._checksum)
+  {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't read the region index of the KB file, or it's corrupt.")).ThrowMoving();
+  }
+
+  const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+  {
+    SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEPersistSubtaskLoad<taNumber>));
+    SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+    CEPersistTask<taNumber> task(*this, nWorkers, kbfi, nullptr, &file, nullptr, nullptr, nullptr, index.Get());
+    pr.SplitAndRunSubtasks<CEPersistSubtaskLoad<taNumber>>(task, SRCast::ToSizeT(nRegions), nWorkers);
+    PqaError err = task.TakeAggregateError(SRString::MakeUnowned(SR_FILE_LINE "The KB file is corrupt."));
+    if (!err.IsOk()) {
+      PqaException(err.GetCode(), err.DetachParams(), SRString(err.GetMessage())).ThrowMoving();
+    }
+  }
+  if (kbfi.HasDelta()) {
+    ApplyDelta(kbfi);
+  }
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::ApplyDelta(KBFileInfo &kbfi) {
+  const KBFileHeader &header = kbfi._header;
+  const KBDeltaHeader &delta = kbfi._delta;
+  const std::string deltaPath = KBDeltaHeader::PathFor(kbfi._filePath);
+  const size_t nItems = SRCast::ToSizeT(delta._nRegions);
+  SRPositionalFile file(deltaPath.c_str(), SRPositionalFile::Mode::Read);
+  SRSmartMPP<KBDeltaRegion> index(_memPool, nItems);
+  if (!file.Read(index.Get(), SRCast::ToSizeT(delta._index._nBytes), delta._index._offset)
+    || SRChecksum::Crc32c(index.Get(), SRCast::ToSizeT(delta._index._nBytes)) != delta._index._checksum)
+  {
+    PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRString::MakeUnowned(SR_FILE_LINE
+      "Can't read the region index of the KB delta file, or it's corrupt.")).ThrowMoving();
+  }
+  // The regions must be distinct, so that the subtasks don't write the same memory.
+  const uint64_t nTotalRegions = header.NTotalRegions();
+  SRSmartMPP<uint32_t> crcs(_memPool, nItems);
+  for (size_t i = 0; i < nItems; i++) {
+    const KBDeltaRegion &dr = index.Get()[i];
+    if (dr._iRegion >= nTotalRegions || (i > 0 && dr._iRegion <= index.Get()[i - 1]._iRegion)) {
+      PqaException(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRMessageBuilder(SR_FILE_LINE
+        "Wrong region #")(dr._iRegion)(" in the KB delta file.").GetOwnedSRString()).ThrowMoving();
+    }
+    crcs.Get()[i] = dr._checksum;
+  }
+
+  const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+  {
+    SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * SRMaxSizeof<CEPersistSubtaskVerify<taNumber>,
+      CEPersistSubtaskLoad<taNumber> >::value);
+    SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+    // The statistics of a compressed KB file are not mapped, so the regions are read into them directly.
+    CEPersistTask<taNumber> task(*this, nWorkers, kbfi, crcs.Get(), &file,
+      (_pKbMapping == nullptr) ? nullptr : _pKbMapping->Get(), index.Get());
+    if (kbfi.IsCompressed()) {
+      pr.SplitAndRunSubtasks<CEPersistSubtaskLoad<taNumber>>(task, nItems, nWorkers);
+    }
+    else {
+      pr.SplitAndRunSubtasks<CEPersistSubtaskVerify<taNumber>>(task, nItems, nWorkers);
+    }
+    PqaError err = task.TakeAggregateError(SRString::MakeUnowned(SR_FILE_LINE "The KB delta file is corrupt."));
+    if (!err.IsOk()) {
+      PqaException(err.GetCode(), err.DetachParams(), SRString(err.GetMessage())).ThrowMoving();
+    }
+  }
+
+  // The next incremental save rewrites the delta file, so it must include these regions again.
+  for (size_t i = 0; i < nItems; i++) {
+    KBSection ks;
+    uint64_t iFirstRow, iLimRow, iFirstQ, iLimQ;
+    header.LocateRegion(index.Get()[i]._iRegion, ks, iFirstRow, iLimRow);
+    header.QuestionsOfRows(ks, iFirstRow, iLimRow, iFirstQ, iLimQ);
+    if (iFirstQ < iLimQ) {
+      _dirtyQuestions.SetRange(iFirstQ, iLimQ);
+    }
+  }
+}
+
 template<typename taNumber> CpuEngine<taNumber>::~CpuEngine() {
   PqaError pqaErr = Shutdown();
   if (!pqaErr.IsOk() && pqaErr.GetCode() != PqaErrorCode::ObjectShutDown) {
     CELOG(Error) << "Failed CpuEngine::Shutdown(): " << pqaErr.ToString(true);
   }
+  // The quizzes sharing the priors have been released by the shutdown.
+  DropSharedPriors();
 }
 
 template<typename taNumber> PqaError CpuEngine<taNumber>::TrainSpec(const TPqaId nQuestions,
   const AnsweredQuestion* const pAQs, const TPqaId iTarget, const TPqaAmount amount)
+{
+  MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
+  PqaError resErr = TrainWithWorkers(WalOp::Train, nQuestions, pAQs, iTarget, amount);
+  if (!resErr.IsOk()) {
+    return resErr;
+  }
+  // This method should increase the counter of questions asked by the number of questions in this training.
+  _nQuestionsAsked.fetch_add(nQuestions, std::memory_order_relaxed);
+  return PqaError();
+}
+
+template<typename taNumber> PqaError CpuEngine<taNumber>::TrainWithWorkers(const WalOp op, const TPqaId nQuestions,
+  const AnsweredQuestion* const pAQs, const TPqaId iTarget, const TPqaAmount amount)
 {
   PqaError resErr;
   const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
@@ -108,78 +348,134 @@ template<typename taNumber> PqaError CpuEngine<taNumber>::TrainSpec(const TPqaId
   // For proper alignment, the data must be laid out in the decreasing order of item alignments.
   SRMemTotal mtCommon;
   const SRByteMem miSubtasks(nWorkers * SRMaxSizeof<CETrainSubtaskDistrib<taNumber>,
-    CETrainSubtaskAdd<taNumber> >::value, SRMemPadding::None, mtCommon);
-  const SRMemItem<std::atomic<TPqaId>> miTtLast(nWorkers, SRMemPadding::None, mtCommon);
-  const SRMemItem<TPqaId> miTtPrev(SRCast::ToSizeT(nQuestions), SRMemPadding::None, mtCommon);
+    CETrainSubtaskScatter<taNumber>, CETrainSubtaskAdd<taNumber> >::value, SRMemPadding::None, mtCommon);
+  const size_t bucketStride = CETrainTask<taNumber>::CalcBucketStride(nWorkers);
+  // The memory pool only aligns to SIMD width, so take a cache line more to start the counts at a cache line boundary,
+  //   otherwise the buckets of different workers straddle cache lines and share them (false sharing).
+  const SRByteMem miTtCounts(nWorkers * bucketStride * sizeof(TPqaId) + SRCpuInfo::_cacheLineBytes,
+    SRMemPadding::Both, mtCommon);
+  const SRMemItem<TPqaId> miTtBucketStarts(nWorkers + 1, SRMemPadding::None, mtCommon);
+  const SRMemItem<TPqaId> miTtOrder(SRCast::ToSizeT(nQuestions), SRMemPadding::None, mtCommon);
   SRSmartMPP<uint8_t> commonBuf(_memPool, mtCommon._nBytes);
 
   CETrainTask<taNumber> trainTask(*this, nWorkers, iTarget, pAQs, amount);
-  //TODO: these are slow because threads share a cache line. It's not clear yet how to workaround this: the data is not
-  //  per-source thread, but rather per target thread (after distribution).
-  trainTask._prev = miTtPrev.Ptr(commonBuf);
-  trainTask._last = miTtLast.Ptr(commonBuf);
-  //TODO: vectorize/parallelize
-  for (size_t i = 0; i < nWorkers; i++) {
-    new(trainTask._last + i) std::atomic<TPqaId>(cInvalidPqaId);
-  }
-  // &trainTask, &nWorkers
-  auto&& ttLastFinally = SRMakeFinally([&pLast = trainTask._last, &nWorkers]{
-    //TODO: vectorize/parallelize
-    for (size_t i = 0; i < nWorkers; i++) {
-      pLast[i].~atomic();
-    }
-  }); (void)ttLastFinally; // prevent warning C4189
-
-  { // Scope for the locks
-    MaintenanceSwitch::AgnosticLock msal(_maintSwitch);
-    
-    //// The further code must be reader-writer locked, because we are validating the input before modifying the KB,
-    ////   so noone must change or read the KB in between.
-    SRRWLock<true> rwl(_rws);
+  trainTask._pCounts = reinterpret_cast<TPqaId*>((reinterpret_cast<uintptr_t>(miTtCounts.BytePtr(commonBuf))
+    + SRCpuInfo::_cacheLineMask) & ~SRCpuInfo::_cacheLineMask);
+  assert((reinterpret_cast<uintptr_t>(trainTask._pCounts) & SRCpuInfo::_cacheLineMask) == 0);
+  trainTask._pBucketStarts = miTtBucketStarts.Ptr(commonBuf);
+  trainTask._pOrder = miTtOrder.Ptr(commonBuf);
+  std::memset(trainTask._pCounts, 0, nWorkers * bucketStride * sizeof(TPqaId));
+
+  //// The further code must be reader-writer locked, because we are validating the input before modifying the KB,
+  ////   so noone must change or read the KB in between.
+  SRRWLock<true> rwl(_rws);
+
+  // Can't move dimensions-related code out of SRW lock because this operation can be run in maintenance mode too.
+  if (iTarget < 0 || iTarget >= _dims._nTargets) {
+    const TPqaId nKB = _dims._nTargets;
+    rwl.EarlyRelease();
+    return PqaError(PqaErrorCode::IndexOutOfRange, new IndexOutOfRangeErrorParams(iTarget, 0, nKB - 1),
+      SRString::MakeUnowned("Target index is not in KB range."));
+  }
 
-    // Can't move dimensions-related code out of SRW lock because this operation can be run in maintenance mode too.
-    if (iTarget < 0 || iTarget >= _dims._nTargets) {
-      const TPqaId nKB = _dims._nTargets;
-      rwl.EarlyRelease();
-      return PqaError(PqaErrorCode::IndexOutOfRange, new IndexOutOfRangeErrorParams(iTarget, 0, nKB - 1),
-        SRString::MakeUnowned("Target index is not in KB range."));
-    }
+  if (_targetGaps.IsGap(iTarget)) {
+    rwl.EarlyRelease();
+    return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iTarget), SRString::MakeUnowned(SR_FILE_LINE
+      "Target index is not in KB (but rather at a gap)."));
+  }
 
-    if (_targetGaps.IsGap(iTarget)) {
-      rwl.EarlyRelease();
-      return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iTarget), SRString::MakeUnowned(SR_FILE_LINE
-        "Target index is not in KB (but rather at a gap)."));
+  SRPoolRunner pr(_tpWorkers, miSubtasks.BytePtr(commonBuf));
+
+  //// Distribute the AQs into buckets with the number of buckets divisable by the number of workers. Count them first.
+  const SRSubtaskCount nSources = pr.SplitAndRunSubtasks<CETrainSubtaskDistrib<taNumber>>(trainTask, nQuestions,
+    trainTask.GetWorkerCount(), [&](void *pStMem, SRSubtaskCount iWorker, int64_t iFirst, int64_t iLimit) {
+      new (pStMem) CETrainSubtaskDistrib<taNumber>(&trainTask, iWorker, pAQs + iFirst, pAQs + iLimit);
+    }
+  ).GetNSubtasks();
+  resErr = trainTask.TakeAggregateError(SRString::MakeUnowned("Failed " SR_FILE_LINE));
+  if (!resErr.IsOk()) {
+    return resErr;
+  }
+  // Turn the counts into the positions to scatter to: the buckets go in order, and the sources in order within each
+  //   bucket, so that the questions of a bucket are trained in the order given.
+  TPqaId nPlaced = 0;
+  for (size_t iBucket = 0; iBucket < nWorkers; iBucket++) {
+    trainTask._pBucketStarts[iBucket] = nPlaced;
+    for (size_t iSource = 0; iSource < nSources; iSource++) {
+      TPqaId &count = trainTask._pCounts[iSource * bucketStride + iBucket];
+      const TPqaId nInBucket = count;
+      count = nPlaced;
+      nPlaced += nInBucket;
     }
+  }
+  trainTask._pBucketStarts[nWorkers] = nPlaced;
+  // The split is the same as above, so each source worker scatters its own range.
+  pr.SplitAndRunSubtasks<CETrainSubtaskScatter<taNumber>>(trainTask, nQuestions, trainTask.GetWorkerCount());
+
+  // The questions have been validated by the distribution.
+  PreserveRows(nQuestions, pAQs);
+  //// Update the KB with the given training data.
+  pr.RunPerWorkerSubtasks<CETrainSubtaskAdd<taNumber>>(trainTask, trainTask.GetWorkerCount());
+  resErr = trainTask.TakeAggregateError(SRString::MakeUnowned("Failed " SR_FILE_LINE));
+  if (!resErr.IsOk()) {
+    return resErr;
+  }
 
-    SRPoolRunner pr(_tpWorkers, miSubtasks.BytePtr(commonBuf));
+  MarkQuestionsDirty(nQuestions, pAQs);
+  LogTraining(op, nQuestions, pAQs, iTarget, amount);
+  _vB[iTarget] += amount;
+  _versionB.fetch_add(1, std::memory_order_release);
+  return PqaError();
+}
 
-    //// Distribute the AQs into buckets with the number of buckets divisable by the number of workers.
-    pr.SplitAndRunSubtasks<CETrainSubtaskDistrib<taNumber>>(trainTask, nQuestions, trainTask.GetWorkerCount(),
-      [&](void *pStMem, SRSubtaskCount iWorker, int64_t iFirst, int64_t iLimit) {
-        new (pStMem) CETrainSubtaskDistrib<taNumber>(&trainTask, pAQs + iFirst, pAQs + iLimit);
-        (void)iWorker;
-      }
-    );
-    resErr = trainTask.TakeAggregateError(SRString::MakeUnowned("Failed " SR_FILE_LINE));
-    if (!resErr.IsOk()) {
-      return resErr;
+template<typename taNumber> void CpuEngine<taNumber>::ReplayTrainingSpec(const WalTraining *pTrainings,
+  const size_t nTrainings)
+{
+  //// Validate all the records before changing the KB, because they come from a file.
+  auto&& fnCheck = [](const TPqaId index, const TPqaId limit, const GapTracker<TPqaId> *pGaps, const char* const what) {
+    if (index < 0 || index >= limit) {
+      PqaException(PqaErrorCode::IndexOutOfRange, new IndexOutOfRangeErrorParams(index, 0, limit - 1),
+        SRMessageBuilder(SR_FILE_LINE "The write-ahead log refers to ")(what)(" not in KB range.").GetOwnedSRString())
+        .ThrowMoving();
     }
-
-    //// Update the KB with the given training data.
-    pr.RunPerWorkerSubtasks<CETrainSubtaskAdd<taNumber>>(trainTask, trainTask.GetWorkerCount());
-    resErr = trainTask.TakeAggregateError(SRString::MakeUnowned("Failed " SR_FILE_LINE));
-    if (!resErr.IsOk()) {
-      return resErr;
+    if (pGaps != nullptr && pGaps->IsGap(index)) {
+      PqaException(PqaErrorCode::AbsentId, new AbsentIdErrorParams(index), SRMessageBuilder(SR_FILE_LINE
+        "The write-ahead log refers to ")(what)(" at a gap.").GetOwnedSRString()).ThrowMoving();
     }
+  };
+  for (size_t i = 0; i < nTrainings; i++) {
+    const WalTraining &wt = pTrainings[i];
+    fnCheck(wt._iTarget, _dims._nTargets, &_targetGaps, "a target");
+    for (TPqaId j = 0; j < wt._nAQs; j++) {
+      fnCheck(wt._pAQs[j]._iQuestion, _dims._nQuestions, &_questionGaps, "a question");
+      fnCheck(wt._pAQs[j]._iAnswer, _dims._nAnswers, nullptr, "an answer");
+    }
+  }
 
-    _vB[iTarget] += amount;
-
-    //TODO: why is this inside the locks?
-    // This method should increase the counter of questions asked by the number of questions in this training.
-    _nQuestionsAsked.fetch_add(nQuestions, std::memory_order_relaxed);
+  //// Each worker applies the trainings to its own questions, in the order of the log.
+  const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+  {
+    SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CETrainSubtaskReplay<taNumber>));
+    SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+    CETrainReplayTask<taNumber> task(*this, nWorkers, pTrainings, nTrainings);
+    pr.RunPerWorkerSubtasks<CETrainSubtaskReplay<taNumber>>(task, nWorkers);
+    PqaError err = task.TakeAggregateError(SRString::MakeUnowned(SR_FILE_LINE "Failed to replay the trainings."));
+    if (!err.IsOk()) {
+      PqaException(err.GetCode(), err.DetachParams(), SRString(err.GetMessage())).ThrowMoving();
+    }
   }
 
-  return PqaError();
+  uint64_t nQuestionsAsked = 0;
+  for (size_t i = 0; i < nTrainings; i++) {
+    const WalTraining &wt = pTrainings[i];
+    MarkQuestionsDirty(wt._nAQs, wt._pAQs);
+    _vB[wt._iTarget] += wt._amount;
+    if (wt._bCountAsked) {
+      nQuestionsAsked += wt._nAQs;
+    }
+  }
+  _versionB.fetch_add(1, std::memory_order_release);
+  _nQuestionsAsked.fetch_add(nQuestionsAsked, std::memory_order_relaxed);
 }
 
 template<typename taNumber> TPqaId CpuEngine<taNumber>::CreateQuizInternal(CECreateQuizOpBase &op) {
@@ -281,10 +577,149 @@ template<typename taNumber> TPqaId CpuEngine<taNumber>::ResumeQuizSpec(PqaError&
   return CreateQuizInternal(resumeOp);
 }
 
-template<typename taNumber> PqaError CpuEngine<taNumber>::NormalizePriors(CEQuiz<taNumber> &quiz, SRPoolRunner &pr,
-  const SRPoolRunner::Split& targSplit)
+template<typename taNumber> TPqaId CpuEngine<taNumber>::RestoreQuizSpec(PqaError& err, const TPqaId nAnswered,
+  const AnsweredQuestion* const pAQs, const void *pPriors)
+{
+  CECreateQuizRestore<taNumber> restoreOp(err, nAnswered, pAQs, static_cast<const taNumber*>(pPriors));
+  return CreateQuizInternal(restoreOp);
+}
+
+template<typename taNumber> const void* CpuEngine<taNumber>::QuizOwnPriors(BaseQuiz *pBaseQuiz) {
+  CEQuiz<taNumber> *pQuiz = static_cast<CEQuiz<taNumber>*>(pBaseQuiz);
+  if (pQuiz->IsSharingPriors() || pQuiz->GetNTargets() != _dims._nTargets) {
+    return nullptr;
+  }
+  return pQuiz->GetPriorMants();
+}
+
+template<typename taNumber> PqaError CpuEngine<taNumber>::GrowQuizSpec(BaseQuiz *pBaseQuiz) {
+  try {
+    CEQuiz<taNumber> *pQuiz = static_cast<CEQuiz<taNumber>*>(pBaseQuiz);
+    pQuiz->GrowQuestions(_dims._nQuestions);
+    const TPqaId nOldTargets = pQuiz->GetNTargets();
+    if (nOldTargets == _dims._nTargets) {
+      return PqaError();
+    }
+    CESharedPriors<taNumber> *pInitPriors = AcquireSharedPriors();
+    if (pQuiz->IsSharingPriors()) {
+      // No answer has been recorded yet, so the quiz just gets the priors of a fresh quiz.
+      pQuiz->SharePriors(pInitPriors);
+      return PqaError();
+    }
+    auto&& initFinally = SRMakeFinally([pInitPriors] { pInitPriors->Release(); }); (void)initFinally;
+    pQuiz->GrowOwnPriors(_dims._nTargets);
+    // The new targets get the priors of a fresh quiz, and the old targets share the rest of the probability in the
+    //   same proportions as before. The new targets are appended, so they are not at gaps.
+    taNumber *pPriors = pQuiz->ModPriorMants();
+    const taNumber *pInit = pInitPriors->GetPriors();
+    taNumber newMass(0.0);
+    for (TPqaId i = nOldTargets; i < _dims._nTargets; i++) {
+      pPriors[i] = pInit[i];
+      newMass += pInit[i];
+    }
+    const taNumber oldScale = taNumber(1.0) - newMass;
+    for (TPqaId i = 0; i < nOldTargets; i++) {
+      pPriors[i].Mul(oldScale);
+    }
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+template<typename taNumber> CESharedPriors<taNumber>* CpuEngine<taNumber>::AcquireSharedPriors() {
+  // The version is read before _vB, so the priors computed are not older than the version they are marked with.
+  const uint64_t version = _versionB.load(std::memory_order_acquire);
+  bool bClaimed;
+  {
+    SRLock<TSharedPriorsSync> sl(_syncSharedPriors);
+    CESharedPriors<taNumber> *pCur = _pSharedPriors;
+    // Under training load, only one thread at a time recomputes the priors, and the others take the latest ones: such
+    //   a quiz is considered started before the changes of B the recomputation is catching up with.
+    if (pCur != nullptr && (pCur->GetVersion() == version || _bComputingSharedPriors)) {
+      pCur->AddRef();
+      return pCur;
+    }
+    bClaimed = !_bComputingSharedPriors;
+    _bComputingSharedPriors = true;
+  }
+  CESharedPriors<taNumber> *pNew = nullptr;
+  try {
+    pNew = CESharedPriors<taNumber>::Create(_memPool, SRCast::ToSizeT(_dims._nTargets), version);
+    ComputeSharedPriors(*pNew);
+  }
+  catch (...) {
+    if (pNew != nullptr) {
+      pNew->Release();
+    }
+    if (bClaimed) {
+      SRLock<TSharedPriorsSync> sl(_syncSharedPriors);
+      _bComputingSharedPriors = false;
+    }
+    throw;
+  }
+  CESharedPriors<taNumber> *pOld = nullptr;
+  {
+    SRLock<TSharedPriorsSync> sl(_syncSharedPriors);
+    // A concurrent computation may have published newer priors meanwhile.
+    if (_pSharedPriors == nullptr || _pSharedPriors->GetVersion() < version) {
+      pOld = _pSharedPriors;
+      pNew->AddRef(); // for the engine
+      _pSharedPriors = pNew;
+    }
+    if (bClaimed) {
+      _bComputingSharedPriors = false;
+    }
+  }
+  if (pOld != nullptr) {
+    // The quizzes still sharing the old version keep it alive.
+    pOld->Release();
+  }
+  return pNew;
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::ComputeSharedPriors(CESharedPriors<taNumber> &sharedPriors) {
+  const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+
+  SRMemTotal mtCommon;
+  const SRByteMem miSubtasks(nWorkers * SRMaxSizeof<CESetPriorsSubtaskSum<taNumber>,
+    CEDivTargPriorsSubtask<CESetPriorsTask<taNumber>>>::value, SRMemPadding::None, mtCommon);
+  const SRByteMem miSplit(SRPoolRunner::CalcSplitMemReq(nWorkers), SRMemPadding::Both, mtCommon);
+
+  SRSmartMPP<uint8_t> commonBuf(_memPool, mtCommon._nBytes);
+  SRPoolRunner pr(_tpWorkers, miSubtasks.BytePtr(commonBuf));
+
+  const TPqaId nTargetVects = SRSimd::VectsFromComps<taNumber>(_dims._nTargets);
+  const SRPoolRunner::Split targSplit = SRPoolRunner::CalcSplit(miSplit.BytePtr(commonBuf), nTargetVects, nWorkers);
+
+  CESetPriorsTask<taNumber> spTask(*this, sharedPriors.ModPriors());
+  {
+    SRRWLock<false> rwl(_rws);
+    // Copy mantissas, prepare for summing. The priors are normalized right from B, so no exponents are needed.
+    typedef CESetPriorsSubtaskSum<taNumber> TSubtask;
+    SRPoolRunner::Keeper<TSubtask> kp = pr.RunPreSplit<TSubtask>(spTask, targSplit);
+    rwl.EarlyRelease();
+    Summator<taNumber>::ForPriors(kp, spTask);
+  }
+  // Divide the likelihoods by their sum so to get probabilities
+  pr.RunPreSplit<CEDivTargPriorsSubtask<CESetPriorsTask<taNumber>>>(spTask, targSplit);
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::DropSharedPriors() {
+  CESharedPriors<taNumber> *pOld;
+  {
+    SRLock<TSharedPriorsSync> sl(_syncSharedPriors);
+    pOld = _pSharedPriors;
+    _pSharedPriors = nullptr;
+  }
+  if (pOld != nullptr) {
+    pOld->Release();
+  }
+}
+
+template<typename taNumber> PqaError CpuEngine<taNumber>::NormalizePriors(CEQuiz<taNumber> &quiz, int64_t *pExps,
+  SRPoolRunner &pr, const SRPoolRunner::Split& targSplit)
 {
-  CENormPriorsTask<taNumber> normPriorsTask(*this, quiz);
+  CENormPriorsTask<taNumber> normPriorsTask(*this, quiz, pExps);
 
   { // The lifetime for maximum selection subtasks
     SRPoolRunner::Keeper<CENormPriorsSubtaskMax<taNumber>> kp = pr.RunPreSplit<CENormPriorsSubtaskMax<taNumber>>(
@@ -410,7 +845,6 @@ template<typename taNumber> TPqaId CpuEngine<taNumber>::NextQuestionSpec(PqaErro
     return cInvalidPqaId;
   }
   pQuiz->SetActiveQuestion(selQuestion);
-  _nQuestionsAsked.fetch_add(1, std::memory_order_relaxed);
   return selQuestion;
 }
 
@@ -439,37 +873,212 @@ template<typename taNumber> TPqaId CpuEngine<taNumber>::ListTopTargetsSpec(PqaEr
   }
 }
 
+template<typename taNumber> TPqaId CpuEngine<taNumber>::AnalyzeQuestionsSpec(PqaError& err, const TPqaId maxCount,
+  QuestionInfo *pDest)
+{
+  try {
+    // The dimensions don't change while in regular mode.
+    const TPqaId nQuestions = _dims._nQuestions;
+    const TPqaId nTargets = _dims._nTargets;
+    if (nQuestions == 0) {
+      err.Release();
+      return 0;
+    }
+    const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+    const SRSubtaskCount nEvalSubtasks = nWorkers * 8;
+    const size_t bufStride = 2 * SRSimd::PaddedBytesFromItems<sizeof(taNumber)>(SRCast::ToSizeT(nTargets))
+      / sizeof(taNumber);
+
+    SRMemTotal mtCommon;
+    const SRByteMem miSubtasks(nEvalSubtasks * SRMaxSizeof<CEEvalQsSubtaskConsider<taNumber>,
+      CEAnalyzeQsSubtaskGain<taNumber>>::value, SRMemPadding::None, mtCommon);
+    const SRByteMem miSplit(SRPoolRunner::CalcSplitMemReq(nEvalSubtasks), SRMemPadding::Both, mtCommon);
+    const SRMemItem<taNumber> miRunLength(nQuestions, SRMemPadding::Both, mtCommon);
+    const SRMemItem<taNumber> miGains(nQuestions, SRMemPadding::Both, mtCommon);
+    const SRMemItem<uint64_t> miPartHashes(nQuestions, SRMemPadding::Both, mtCommon);
+    const SRMemItem<taNumber> miBufs(nWorkers * bufStride, SRMemPadding::Both, mtCommon);
+    const SRMemItem<TPqaId> miLabels(nWorkers * _dims._nAnswers, SRMemPadding::Both, mtCommon);
+    const SRMemItem<TPqaId> miOrder(nQuestions, SRMemPadding::Both, mtCommon);
+    const SRMemItem<QuestionInfo> miInfos(nQuestions, SRMemPadding::Both, mtCommon);
+
+    SRSmartMPP<uint8_t> commonBuf(_memPool, mtCommon._nBytes);
+    SRPoolRunner pr(_tpWorkers, miSubtasks.BytePtr(commonBuf));
+
+    // A quiz that is never registered, so to evaluate the questions as for the first question of a fresh quiz.
+    SRObjectMPP<CEQuiz<taNumber>> spQuiz(_memPool, this);
+    CEQuiz<taNumber> &quiz = *spQuiz.Get();
+    SRUtils::FillZeroVects<true>(quiz.GetQAsked(), SRSimd::VectsFromBits(nQuestions));
+    quiz.SharePriors(AcquireSharedPriors());
+    const taNumber *const pPriors = quiz.GetPriorMants();
+
+    SRAccumulator<taNumber> accPriorH(taNumber(0.0));
+    for (TPqaId j = 0; j < nTargets; j++) {
+      const TPqaAmount prior = pPriors[j].ToAmount();
+      if (!_targetGaps.IsGap(j) && prior > 0) {
+        accPriorH.Add(taNumber(-prior * std::log2(prior)));
+      }
+    }
+
+    const taNumber *const pRunLength = miRunLength.Ptr(commonBuf);
+    const taNumber *const pGains = miGains.Ptr(commonBuf);
+    const uint64_t *const pPartHashes = miPartHashes.Ptr(commonBuf);
+    TPqaId *const pOrder = miOrder.Ptr(commonBuf);
+    QuestionInfo *const pInfos = miInfos.Ptr(commonBuf);
+    const SRPoolRunner::Split questionSplit = SRPoolRunner::CalcSplit(miSplit.BytePtr(commonBuf), nQuestions,
+      nEvalSubtasks);
+    TPqaId nValid = 0;
+    {
+      SRRWLock<false> rwl(_rws);
+      {
+        CEEvalQsTask<taNumber> evalQsTask(*this, quiz, nTargets - _targetGaps.GetNGaps(),
+          miRunLength.Ptr(commonBuf));
+        typedef CEEvalQsSubtaskConsider<taNumber> TSubtask;
+        SRPoolRunner::Keeper<TSubtask> kp = pr.RunPreSplit<TSubtask>(evalQsTask, questionSplit);
+      }
+      {
+        CEAnalyzeQsTask<taNumber> analyzeTask(*this, nWorkers, pPriors, accPriorH.Get().ToAmount(),
+          miGains.Ptr(commonBuf), miPartHashes.Ptr(commonBuf), miBufs.Ptr(commonBuf), bufStride,
+          miLabels.Ptr(commonBuf), _dims._nAnswers);
+        pr.SplitAndRunSubtasks<CEAnalyzeQsSubtaskGain<taNumber>>(analyzeTask, nQuestions, nWorkers);
+      }
+
+      // The run length of each subtask of question evaluation starts from 0.
+      SRAccumulator<taNumber> accTotPriority(taNumber(0.0));
+      for (SRSubtaskCount i = 0; i < questionSplit._nSubtasks; i++) {
+        accTotPriority.Add(pRunLength[questionSplit._pBounds[i] - 1]);
+      }
+      const TPqaAmount totPriority = accTotPriority.Get().ToAmount();
+      for (SRSubtaskCount i = 0; i < questionSplit._nSubtasks; i++) {
+        const TPqaId iFirst = ((i == 0) ? 0 : questionSplit._pBounds[i - 1]);
+        for (TPqaId j = iFirst; j < TPqaId(questionSplit._pBounds[i]); j++) {
+          if (_questionGaps.IsGap(j)) {
+            continue;
+          }
+          const taNumber priority = pRunLength[j] - ((j == iFirst) ? taNumber(0.0) : pRunLength[j - 1]);
+          QuestionInfo &qi = pInfos[j];
+          qi._iQuestion = j;
+          qi._infoGain = pGains[j].ToAmount();
+          qi._selectionProb = ((totPriority > 0) ? priority.ToAmount() / totPriority : 0);
+          qi._iRedundantWith = cInvalidPqaId;
+          pOrder[nValid] = j;
+          nValid++;
+        }
+      }
+
+      // The questions with the same partition hash are adjacent, the most informative first.
+      std::sort(pOrder, pOrder + nValid, [pPartHashes, pInfos](const TPqaId iFirst, const TPqaId iSecond) {
+        if (pPartHashes[iFirst] != pPartHashes[iSecond]) {
+          return pPartHashes[iFirst] < pPartHashes[iSecond];
+        }
+        if (pInfos[iFirst]._infoGain != pInfos[iSecond]._infoGain) {
+          return pInfos[iSecond]._infoGain < pInfos[iFirst]._infoGain;
+        }
+        return iFirst < iSecond;
+      });
+      SRSmartMPP<TPqaId> answerMap(_memPool, 2 * SRCast::ToSizeT(_dims._nAnswers));
+      for (TPqaId i = 0; i < nValid; ) {
+        const TPqaId iBest = pOrder[i];
+        TPqaId j = i + 1;
+        for (; j < nValid && pPartHashes[pOrder[j]] == pPartHashes[iBest]; j++) {
+          // Rule out hash collisions.
+          if (SamePartition(iBest, pOrder[j], answerMap.Get())) {
+            pInfos[pOrder[j]]._iRedundantWith = iBest;
+          }
+        }
+        i = j;
+      }
+    }
+
+    const TPqaId nListed = std::min(maxCount, nValid);
+    std::partial_sort(pOrder, pOrder + nListed, pOrder + nValid, [pInfos](const TPqaId iFirst, const TPqaId iSecond) {
+      if (pInfos[iFirst]._infoGain != pInfos[iSecond]._infoGain) {
+        return pInfos[iFirst]._infoGain < pInfos[iSecond]._infoGain;
+      }
+      return iFirst < iSecond;
+    });
+    for (TPqaId i = 0; i < nListed; i++) {
+      pDest[i] = pInfos[pOrder[i]];
+    }
+    err.Release();
+    return nListed;
+  }
+  CATCH_TO_ERR_SET(err);
+  return cInvalidPqaId;
+}
+
+template<typename taNumber> bool CpuEngine<taNumber>::SamePartition(const TPqaId iFirst, const TPqaId iSecond,
+  TPqaId *pAnswerMap) const
+{
+  const TPqaId nAnswers = _dims._nAnswers;
+  TPqaId *const pFirstToSecond = pAnswerMap;
+  TPqaId *const pSecondToFirst = pAnswerMap + nAnswers;
+  std::fill(pAnswerMap, pAnswerMap + 2 * nAnswers, cInvalidPqaId);
+  for (TPqaId j = 0; j < _dims._nTargets; j++) {
+    if (_targetGaps.IsGap(j)) {
+      continue;
+    }
+    // The lowest answer wins a tie, as in the partition hashing.
+    TPqaId kFirst = 0, kSecond = 0;
+    for (TPqaId k = 1; k < nAnswers; k++) {
+      if (GetA(iFirst, kFirst, j) < GetA(iFirst, k, j)) {
+        kFirst = k;
+      }
+      if (GetA(iSecond, kSecond, j) < GetA(iSecond, k, j)) {
+        kSecond = k;
+      }
+    }
+    if (pFirstToSecond[kFirst] == cInvalidPqaId && pSecondToFirst[kSecond] == cInvalidPqaId) {
+      pFirstToSecond[kFirst] = kSecond;
+      pSecondToFirst[kSecond] = kFirst;
+    }
+    else if (pFirstToSecond[kFirst] != kSecond || pSecondToFirst[kSecond] != kFirst) {
+      return false;
+    }
+  }
+  return true;
+}
+
 template<typename taNumber> PqaError CpuEngine<taNumber>::RecordQuizTargetSpec(BaseQuiz *pBaseQuiz,
   const TPqaId iTarget, const TPqaAmount amount)
 {
   CEQuiz<taNumber> *pQuiz = static_cast<CEQuiz<taNumber>*>(pBaseQuiz);
   const std::vector<AnsweredQuestion>& answers = pQuiz->GetAnswers();
+  if (TPqaId(answers.size()) >= _cMinParallelTrainAnswers) {
+    // A long quiz would hold the exclusive lock for long on a single core.
+    return TrainWithWorkers(WalOp::QuizTarget, TPqaId(answers.size()), answers.data(), iTarget, amount);
+  }
   const CETrainTaskNumSpec<taNumber> numSpec(amount);
   CETrainOperation<taNumber> trainOp(*this, iTarget, numSpec);
   {
     SRRWLock<true> rwl(_rws);
+    PreserveRows(TPqaId(answers.size()), answers.data());
     TPqaId i = 0;
-    const TPqaId iEn = TPqaId(answers.size()) - 1;
-    for (; i < iEn; i += 2) {
-      const AnsweredQuestion& aqFirst = answers[i];
-      const AnsweredQuestion& aqSecond = answers[i + 1];
-      trainOp.Perform2(aqFirst, aqSecond);
-    }
-    assert(TPqaId(answers.size()) - 1 <= i && i <= TPqaId(answers.size()));
-    if (i == iEn) {
+    const TPqaId iEn = TPqaId(answers.size());
+    for (; i + 3 < iEn; i += 4) {
+      trainOp.Perform4(answers[i], answers[i + 1], answers[i + 2], answers[i + 3]);
+    }
+    if (i + 1 < iEn) {
+      trainOp.Perform2(answers[i], answers[i + 1]);
+      i += 2;
+    }
+    assert(iEn - 1 <= i && i <= iEn);
+    if (i < iEn) {
       trainOp.Perform1(answers[i]);
     }
+    MarkQuestionsDirty(TPqaId(answers.size()), answers.data());
+    LogTraining(WalOp::QuizTarget, TPqaId(answers.size()), answers.data(), iTarget, amount);
     _vB[iTarget] += amount;
+    _versionB.fetch_add(1, std::memory_order_release);
   }
 
   return PqaError();
 }
 
 template<typename taNumber> PqaError CpuEngine<taNumber>::AddQsTsSpec(const TPqaId nQuestions, AddQuestionParam *pAqps,
-  const TPqaId nTargets, AddTargetParam *pAtps)
+  const TPqaId nTargets, AddTargetParam *pAtps, const bool bReuseGaps)
 {
   try {
-    const TPqaId nQReuse = std::min(nQuestions, _questionGaps.GetNGaps());
+    const TPqaId nQReuse = bReuseGaps ? std::min(nQuestions, _questionGaps.GetNGaps()) : 0;
     const TPqaId nQNew = nQuestions - nQReuse;
     const TPqaId nQOld = _dims._nQuestions;
     const TPqaId totQ = nQOld + nQNew;
@@ -482,10 +1091,13 @@ template<typename taNumber> PqaError CpuEngine<taNumber>::AddQsTsSpec(const TPqa
       reusedQs.SetOne(curQ);
     }
 
-    const TPqaId nTReuse = std::min(nTargets, _targetGaps.GetNGaps());
+    const TPqaId nTReuse = bReuseGaps ? std::min(nTargets, _targetGaps.GetNGaps()) : 0;
     const TPqaId nTNew = nTargets - nTReuse;
     const TPqaId nTOld = _dims._nTargets;
     const TPqaId totT = nTOld + nTNew;
+    // The rows reallocated get room for more targets, so that appending a few targets at a time doesn't copy the
+    //   whole KB each time.
+    const size_t rowHeadroom = GrowthHeadroom(SRCast::ToSizeT(totT));
     for (TPqaId i = 0; i < nTReuse; i++) {
       const TPqaId curT = _targetGaps.Acquire();
       _pimTargets.RenewComp(curT);
@@ -502,36 +1114,44 @@ template<typename taNumber> PqaError CpuEngine<taNumber>::AddQsTsSpec(const TPqa
         const taNumber initSqr = taNumber(pAqps[nQReuse + i]._initialAmount).Sqr();
         _sA[curQ].resize(_dims._nAnswers);
         for (TPqaId k = 0; k < _dims._nAnswers; k++) {
-          _sA[curQ][k].Resize<false>(totT);
+          _sA[curQ][k].GrowTo<false>(totT, rowHeadroom);
           _sA[curQ][k].FillAll<false>(initSqr);
         }
         const taNumber initMD = initSqr * _dims._nAnswers;
-        _mD[curQ].Resize<false>(totT);
+        _mD[curQ].GrowTo<false>(totT, rowHeadroom);
         _mD[curQ].FillAll<false>(initMD);
       }
     }
-    if (nTNew > 0) {
-      for (TPqaId i = 0; i < nQOld; i++) {
-        for (TPqaId k = 0; k < _dims._nAnswers; k++) {
-          _sA[i][k].Resize<false>(totT);
-          for (TPqaId j = 0; j < nTNew; j++) {
-            const taNumber initSqr = taNumber(pAtps[nQReuse + j]._initialAmount).Sqr();
-            _sA[i][k][j + nTOld] = initSqr; //TODO: vectorize and stream without caching
-          }
-        }
-        _mD[i].Resize<false>(totT);
-        for (TPqaId j = 0; j < nTNew; j++) {
-          const taNumber initMD = taNumber(pAtps[nQReuse + j]._initialAmount).Sqr() * _dims._nAnswers;
-          _mD[i][j + nTOld] = initMD; //TODO: vectorize and stream without caching
-        }
+    if (nTNew > 0 && nQOld > 0) {
+      SRSmartMPP<taNumber> initA(_memPool, SRCast::ToSizeT(nTNew));
+      SRSmartMPP<taNumber> initD(_memPool, SRCast::ToSizeT(nTNew));
+      for (TPqaId j = 0; j < nTNew; j++) {
+        initA.Get()[j] = taNumber(pAtps[nTReuse + j]._initialAmount).Sqr();
+        initD.Get()[j] = initA.Get()[j] * _dims._nAnswers;
       }
-      _vB.Resize<false>(totT);
+      // The rows are independent, so they are grown in parallel. Within the capacity, this only writes the new
+      //   targets, otherwise the row is copied too.
+      const size_t nARows = SRCast::ToSizeT(nQOld) * SRCast::ToSizeT(_dims._nAnswers);
+      const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+      SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEAddTargetsSubtaskGrow<taNumber>));
+      SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+      CEAddTargetsTask<taNumber> task(*this, nWorkers, SRCast::ToSizeT(nTOld), SRCast::ToSizeT(totT), rowHeadroom,
+        nARows, initA.Get(), initD.Get());
+      pr.SplitAndRunSubtasks<CEAddTargetsSubtaskGrow<taNumber>>(task, nARows + SRCast::ToSizeT(nQOld), nWorkers);
+      PqaError err = task.TakeAggregateError(SRString::MakeUnowned(SR_FILE_LINE "Failed to grow the rows of"
+        " statistics to the targets added."));
+      if (!err.IsOk()) {
+        return err;
+      }
+    }
+    if (nTNew > 0) {
+      _vB.GrowTo<false>(totT, rowHeadroom);
       for (TPqaId j = 0; j < nTNew; j++) {
-        const TPqaId parPos = nQReuse + j;
+        const TPqaId parPos = nTReuse + j;
         const TPqaId curT = nTOld + j;
         pAtps[parPos]._iTarget = curT;
         const taNumber init1(pAtps[parPos]._initialAmount);
-        _vB[curT] = init1; //TODO: vectorize and stream without caching
+        _vB[curT] = init1;
       }
     }
 
@@ -575,86 +1195,215 @@ template<typename taNumber> PqaError CpuEngine<taNumber>::AddQsTsSpec(const TPqa
   } CATCH_TO_ERR_RETURN;
 }
 
-template<typename taNumber> PqaError CpuEngine<taNumber>::CompactSpec(CompactionResult &cr) {
-  cr._nQuestions = _dims._nQuestions - _questionGaps.GetNGaps();
-  const TPqaId nTargetGaps = _targetGaps.GetNGaps();
-  cr._nTargets = _dims._nTargets - nTargetGaps;
-  cr._pOldQuestions = static_cast<TPqaId*>(SRUtils::ThrowingSimdAlloc(SRSimd::PaddedBytesFromItems<sizeof(TPqaId)>(
-    cr._nQuestions)));
-  cr._pOldTargets = static_cast<TPqaId*>(SRUtils::ThrowingSimdAlloc(SRSimd::PaddedBytesFromItems<sizeof(TPqaId)>(
-    cr._nTargets)));
-  TPqaId iFirst, iLast;
-  for (iFirst = 0, iLast = _dims._nQuestions - 1; iFirst <= iLast; iFirst++) {
-    if (!_questionGaps.IsGap(iFirst)) {
-      cr._pOldQuestions[iFirst] = iFirst;
-      continue;
+template<typename taNumber> PqaError CpuEngine<taNumber>::CompactSpec(CompactionResult &cr,
+  const TPqaId maxMoves)
+{
+  try {
+    // The result of the previous slice, if any, is replaced.
+    _mm_free(cr._pOldQuestions);
+    cr._pOldQuestions = nullptr;
+    _mm_free(cr._pOldTargets);
+    cr._pOldTargets = nullptr;
+    cr._nTargetGaps = 0;
+
+    // The gaps at the end are cut off without moves.
+    const TPqaId nFullTargets = _dims._nTargets - _targetGaps.GetNGaps();
+    TPqaId nMoves = 0;
+    for (TPqaId i = 0, iLim = _targetGaps.GetNGaps(); i < iLim; i++) {
+      if (_targetGaps.ListGaps()[i] < nFullTargets) {
+        nMoves++;
+      }
+    }
+    if (maxMoves != cInvalidPqaId) {
+      nMoves = std::min(nMoves, maxMoves);
     }
-    while (_questionGaps.IsGap(iLast) && iLast > iFirst) {
+    // The lowest gaps are filled with the highest targets. Both are listed ascending for sequential access.
+    SRSmartMPP<TPqaId> srcs(_memPool, SRCast::ToSizeT(nMoves));
+    SRSmartMPP<TPqaId> dests(_memPool, SRCast::ToSizeT(nMoves));
+    const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+    SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CECompactSubtaskMove<taNumber>));
+
+    cr._nQuestions = _dims._nQuestions - _questionGaps.GetNGaps();
+    cr._pOldQuestions = static_cast<TPqaId*>(SRUtils::ThrowingSimdAlloc(
+      SRSimd::PaddedBytesFromItems<sizeof(TPqaId)>(cr._nQuestions)));
+    // The new number of targets isn't known till the moves are listed, but it doesn't exceed the current one.
+    cr._pOldTargets = static_cast<TPqaId*>(SRUtils::ThrowingSimdAlloc(
+      SRSimd::PaddedBytesFromItems<sizeof(TPqaId)>(_dims._nTargets)));
+    TPqaId iFirst, iLast;
+    for (iFirst = 0, iLast = _dims._nQuestions - 1; iFirst <= iLast; iFirst++) {
+      if (!_questionGaps.IsGap(iFirst)) {
+        cr._pOldQuestions[iFirst] = iFirst;
+        continue;
+      }
+      while (_questionGaps.IsGap(iLast) && iLast > iFirst) {
+        iLast--;
+      }
+      if (iFirst == iLast) {
+        break;
+      }
+      cr._pOldQuestions[iFirst] = iLast;
+      _sA[iFirst].swap(_sA[iLast]);
+      _mD[iFirst].Swap(_mD[iLast]);
       iLast--;
     }
-    if (iFirst == iLast) {
-      break;
+    assert(iFirst == cr._nQuestions);
+    _questionGaps.Compact(cr._nQuestions);
+    _dims._nQuestions = cr._nQuestions;
+    _pimQuestions.OnCompact(cr._nQuestions, cr._pOldQuestions);
+
+    TPqaId iMove = 0;
+    for (iFirst = 0, iLast = _dims._nTargets - 1; iFirst <= iLast; iFirst++) {
+      if (!_targetGaps.IsGap(iFirst)) {
+        cr._pOldTargets[iFirst] = iFirst;
+        continue;
+      }
+      while (_targetGaps.IsGap(iLast) && iLast > iFirst) {
+        iLast--;
+      }
+      if (iFirst == iLast || iMove == nMoves) {
+        break;
+      }
+      dests.Get()[iMove] = iFirst;
+      iMove++;
+      srcs.Get()[nMoves - iMove] = iLast;
+      iLast--;
+    }
+    assert(iMove == nMoves);
+    if (iFirst < iLast) {
+      // The slice is over: the targets up to the last one not moved stay with the gaps among them.
+      cr._nTargets = iLast + 1;
+      for (; iFirst < cr._nTargets; iFirst++) {
+        if (_targetGaps.IsGap(iFirst)) {
+          cr._pOldTargets[iFirst] = cInvalidPqaId;
+          cr._nTargetGaps++;
+        }
+        else {
+          cr._pOldTargets[iFirst] = iFirst;
+        }
+      }
+    }
+    else {
+      cr._nTargets = iFirst;
+      assert(cr._nTargets == nFullTargets);
     }
-    cr._pOldQuestions[iFirst] = iLast;
-    _sA[iFirst].swap(_sA[iLast]);
-    _mD[iFirst].Swap(_mD[iLast]);
-    iLast--;
-  }
-  assert(iFirst == cr._nQuestions);
-  _questionGaps.Compact(cr._nQuestions);
-  _dims._nQuestions = cr._nQuestions;
-  _pimQuestions.OnCompact(cr._nQuestions, cr._pOldQuestions);
 
-  struct Move {
-    TPqaId _iSrc;
-    TPqaId _iDest;
-  };
-  SRSmartMPP<Move> moves(_memPool, nTargetGaps);
-  TPqaId iGap = 0;
-  for (iFirst = 0, iLast = _dims._nTargets - 1; iFirst <= iLast; iFirst++) {
-    if (!_targetGaps.IsGap(iFirst)) {
-      cr._pOldTargets[iFirst] = iFirst;
-      continue;
+    for (iMove = 0; iMove < nMoves; iMove++) {
+      const TPqaId iSrc = srcs.Get()[iMove];
+      const TPqaId iDest = dests.Get()[iMove];
+      cr._pOldTargets[iDest] = iSrc;
+      _vB[iDest] = _vB[iSrc];
     }
-    while (_targetGaps.IsGap(iLast) && iLast > iFirst) {
-      iLast--;
+    if (nMoves > 0 && cr._nQuestions > 0) {
+      // The rows are independent, so the moves are done in parallel.
+      const size_t nARows = SRCast::ToSizeT(cr._nQuestions) * SRCast::ToSizeT(_dims._nAnswers);
+      SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+      CECompactTask<taNumber> task(*this, nWorkers, srcs.Get(), dests.Get(), nMoves, nARows);
+      pr.SplitAndRunSubtasks<CECompactSubtaskMove<taNumber>>(task, nARows + SRCast::ToSizeT(cr._nQuestions),
+        nWorkers);
     }
-    if (iFirst == iLast) {
-      break;
+
+    if (cr._nTargetGaps == 0) {
+      _targetGaps.Compact(cr._nTargets);
     }
-    moves.Get()[iGap]._iDest = iFirst;
-    iGap++;
-    moves.Get()[nTargetGaps - iGap]._iSrc = iLast;
-    iLast--;
+    else {
+      _targetGaps.Compact(cr._nTargets, nMoves, dests.Get());
+    }
+    _dims._nTargets = cr._nTargets;
+    if (bOrderByWeight) {
+      assert(maxMoves == cInvalidPqaId);
+      OrderTargetsByWeight(cr);
+    }
+    _pimTargets.OnCompact(cr._nTargets, cr._pOldTargets);
+
+    return PqaError();
+  } CATCH_TO_ERR_RETURN;
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::OrderTargetsByWeight(CompactionResult &cr) {
+  const TPqaId nTargets = _dims._nTargets;
+  if (nTargets <= 1) {
+    return;
   }
-  assert(iFirst == cr._nTargets);
-  assert(iGap == nTargetGaps);
+  const size_t nRowItems = SRCast::ToSizeT(nTargets);
+  SRSmartMPP<TPqaId> order(_memPool, nRowItems);
+  std::iota(order.Get(), order.Get() + nTargets, TPqaId(0));
+  // The sort is stable, so that the replay of the log orders the targets of equal weight the same way.
+  std::stable_sort(order.Get(), order.Get() + nTargets, [this](const TPqaId iFirst, const TPqaId iSecond) {
+    return _vB[iSecond] < _vB[iFirst];
+  });
 
-  for (iGap = 0; iGap < nTargetGaps; iGap++) {
-    const Move &cm = moves.Get()[iGap];
-    cr._pOldTargets[cm._iDest] = cm._iSrc;
-    _vB[cm._iDest] = _vB[cm._iSrc];
+  const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+  const size_t bufStride = SRSimd::PaddedBytesFromItems<sizeof(taNumber)>(nRowItems) / sizeof(taNumber);
+  SRSmartMPP<taNumber> bufs(_memPool, nWorkers * bufStride);
+  SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEPermuteTargetsSubtaskGather<taNumber>));
+
+  // The workers permute the rows of A and D. B and the old IDs are permuted on this thread after they finish.
+  const size_t nARows = SRCast::ToSizeT(_dims._nQuestions) * SRCast::ToSizeT(_dims._nAnswers);
+  const size_t nRows = nARows + SRCast::ToSizeT(_dims._nQuestions);
+  if (nRows > 0) {
+    SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+    CEPermuteTargetsTask<taNumber> task(*this, nWorkers, order.Get(), nTargets, nARows, bufs.Get(), bufStride);
+    pr.SplitAndRunSubtasks<CEPermuteTargetsSubtaskGather<taNumber>>(task, nRows, nWorkers);
   }
-  for (TPqaId iQuestion = 0; iQuestion < cr._nQuestions; iQuestion++) {
-    for (iGap = 0; iGap < nTargetGaps; iGap++) {
-      const Move &cm = moves.Get()[iGap];
-      _mD[iQuestion][cm._iDest] = _mD[iQuestion][cm._iSrc];
-    }
+  SRSmartMPP<taNumber> newB(_memPool, nRowItems);
+  SRSmartMPP<TPqaId> newOldTargets(_memPool, nRowItems);
+  for (TPqaId i = 0; i < nTargets; i++) {
+    const TPqaId iOld = order.Get()[i];
+    newB.Get()[i] = _vB[iOld];
+    newOldTargets.Get()[i] = cr._pOldTargets[iOld];
   }
-  for (TPqaId iQuestion = 0; iQuestion < cr._nQuestions; iQuestion++) {
-    for (TPqaId iAnswer = 0; iAnswer < _dims._nAnswers; iAnswer++) {
-      for (iGap = 0; iGap < nTargetGaps; iGap++) {
-        const Move &cm = moves.Get()[iGap];
-        _sA[iQuestion][iAnswer][cm._iDest] = _sA[iQuestion][iAnswer][cm._iSrc];
+  std::memcpy(_vB.Get(), newB.Get(), nRowItems * sizeof(taNumber));
+  std::memcpy(cr._pOldTargets, newOldTargets.Get(), nRowItems * sizeof(TPqaId));
+}
+
+template<typename taNumber> PqaError CpuEngine<taNumber>::DecaySpec(const TPqaAmount factor,
+  const TPqaId iFirstQuestion, const TPqaId iLimQuestion, const bool bDecayB)
+{
+  try {
+    PreserveRows(iFirstQuestion, iLimQuestion);
+    // The rows of A and D hold the squares of the amounts.
+    const size_t nRows = SRCast::ToSizeT(iLimQuestion - iFirstQuestion) * (SRCast::ToSizeT(_dims._nAnswers) + 1);
+    if (nRows > 0) {
+      const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+      SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEDecaySubtaskMul<taNumber>));
+      SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+      CEDecayTask<taNumber> task(*this, nWorkers, iFirstQuestion, taNumber(factor * factor));
+      pr.SplitAndRunSubtasks<CEDecaySubtaskMul<taNumber>>(task, nRows, nWorkers);
+    }
+    if (bDecayB) {
+      const taNumber tnFactor(factor);
+      for (TPqaId i = 0; i < _dims._nTargets; i++) {
+        _vB[i].Mul(tnFactor);
       }
+      _versionB.fetch_add(1, std::memory_order_release);
     }
+    return PqaError();
   }
+  CATCH_TO_ERR_RETURN;
+}
 
-  _targetGaps.Compact(cr._nTargets);
-  _dims._nTargets = cr._nTargets;
-  _pimTargets.OnCompact(cr._nTargets, cr._pOldTargets);
-
-  return PqaError();
+template<typename taNumber> PqaError CpuEngine<taNumber>::RecomputeDSpec(const TPqaId iFirstQuestion,
+  const TPqaId iLimQuestion, TPqaAmount &maxDrift)
+{
+  try {
+    maxDrift = 0;
+    const TPqaId nQuestions = iLimQuestion - iFirstQuestion;
+    if (nQuestions <= 0) {
+      return PqaError();
+    }
+    PreserveRows(iFirstQuestion, iLimQuestion);
+    const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+    SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CERecomputeDSubtaskSum<taNumber>));
+    SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+    CERecomputeDTask<taNumber> task(*this, nWorkers, iFirstQuestion);
+    SRPoolRunner::Keeper<CERecomputeDSubtaskSum<taNumber>> kp = pr.SplitAndRunSubtasks<
+      CERecomputeDSubtaskSum<taNumber>>(task, SRCast::ToSizeT(nQuestions), nWorkers);
+    for (SRSubtaskCount i = 0; i < kp.GetNSubtasks(); i++) {
+      maxDrift = std::max(maxDrift, kp.GetSubtask(i)->_maxDrift.ToAmount());
+    }
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
 }
 
 template<typename taNumber> size_t CpuEngine<taNumber>::NumberSize() {
@@ -662,6 +1411,9 @@ template<typename taNumber> size_t CpuEngine<taNumber>::NumberSize() {
 }
 
 template<typename taNumber> PqaError CpuEngine<taNumber>::SaveStatistics(KBFileInfo &kbfi) {
+  if (kbfi.IsSectioned()) {
+    return SaveSectionedStatistics(kbfi);
+  }
   TargetRowPersistence<taNumber> trp(kbfi._sf, _dims._nTargets);
   for (TPqaId i = 0; i < _dims._nQuestions; i++) {
     for (TPqaId k = 0; k < _dims._nAnswers; k++) {
@@ -687,6 +1439,193 @@ template<typename taNumber> PqaError CpuEngine<taNumber>::SaveStatistics(KBFileI
   return PqaError();
 }
 
+template<typename taNumber> PqaError CpuEngine<taNumber>::SaveSectionedStatistics(KBFileInfo &kbfi) {
+  // The statistics have been laid out when taking the snapshot.
+  KBFileHeader &header = kbfi._header;
+  assert(_pSnapshot != nullptr);
+  const uint64_t nRegions = header.NTotalRegions();
+  const bool bCompressed = header.IsCompressed();
+  const SRThreadCount nWorkers = kbfi.SaveWorkers(_tpWorkers.GetWorkerCount());
+  try {
+    SRPositionalFile file(kbfi._filePath, SRPositionalFile::Mode::Write);
+    SRSmartMPP<uint32_t> crcs(_memPool, SRCast::ToSizeT(nRegions));
+    SRSmartMPP<KBCompressedRegion> index(_memPool, bCompressed ? SRCast::ToSizeT(nRegions) : 0);
+    KBFileSection &checksums = header.Section(KBSection::Checksums);
+    {
+      SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEPersistSubtaskSave<taNumber>));
+      SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+      CEPersistTask<taNumber> task(*this, nWorkers, kbfi, crcs.Get(), &file, nullptr, nullptr, _pSnapshot.get(),
+        index.Get());
+      if (bCompressed) {
+        // The compressed regions follow the meta section, which has been written already.
+        const KBFileSection &meta = header.Section(KBSection::Meta);
+        task.SetFileEnd(meta._offset + meta._nBytes);
+      }
+      pr.SplitAndRunSubtasks<CEPersistSubtaskSave<taNumber>>(task, SRCast::ToSizeT(nRegions), nWorkers);
+      PqaError err = task.TakeAggregateError(SRString::MakeUnowned(SR_FILE_LINE "Failed to save KB regions."));
+      if (!err.IsOk()) {
+        return err;
+      }
+      if (bCompressed) {
+        // The region index is at the end.
+        checksums._offset = task.GetFileEnd();
+      }
+    }
+    const void *pChecksums = crcs.Get();
+    if (bCompressed) {
+      for (size_t i = 0; i < SRCast::ToSizeT(nRegions); i++) {
+        index.Get()[i]._checksum = crcs.Get()[i];
+        index.Get()[i]._reserved = 0;
+      }
+      pChecksums = index.Get();
+    }
+    checksums._checksum = SRChecksum::Crc32c(pChecksums, SRCast::ToSizeT(checksums._nBytes));
+    if (!file.Write(pChecksums, SRCast::ToSizeT(checksums._nBytes), checksums._offset)) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't write the checksums of KB regions."));
+    }
+  }
+  CATCH_TO_ERR_RETURN;
+  return PqaError();
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::TakeSnapshot(KBFileInfo &kbfi) {
+  kbfi._header.LayOutStatistics(RowStride(_dims._nTargets));
+  _pSnapshot.reset(new CESnapshot<taNumber>(_dims, _vB));
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::ReleaseSnapshot() {
+  _pSnapshot.reset();
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::PrefaultStatistics() {
+  const size_t nRows = SRCast::ToSizeT(_dims._nQuestions) * (SRCast::ToSizeT(_dims._nAnswers) + 1) + 1;
+  const SRThreadCount nWorkers = _tpWorkers.GetWorkerCount();
+  SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEWarmupSubtaskTouch<taNumber>));
+  SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+  CEBaseTask task(*this);
+  pr.SplitAndRunSubtasks<CEWarmupSubtaskTouch<taNumber>>(task, nRows, nWorkers);
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::PreserveRows(const TPqaId nAnswered,
+  const AnsweredQuestion* const pAQs)
+{
+  if (_pSnapshot == nullptr) {
+    return;
+  }
+  CESnapshot<taNumber> &snapshot = *_pSnapshot;
+  // Lock the snapshot only if there is anything to copy: usually the questions are copied early in the save.
+  SRRWLock<true> rwl;
+  bool bLocked = false;
+  for (TPqaId i = 0; i < nAnswered; i++) {
+    const TPqaId iQuestion = pAQs[i]._iQuestion;
+    if (snapshot.IsPreserved(iQuestion)) {
+      continue;
+    }
+    if (!bLocked) {
+      rwl.Init(snapshot.GetSync());
+      bLocked = true;
+    }
+    PreserveQuestion(snapshot, iQuestion);
+  }
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::PreserveRows(const TPqaId iFirstQuestion,
+  const TPqaId iLimQuestion)
+{
+  if (_pSnapshot == nullptr) {
+    return;
+  }
+  CESnapshot<taNumber> &snapshot = *_pSnapshot;
+  SRRWLock<true> rwl;
+  bool bLocked = false;
+  for (TPqaId i = iFirstQuestion; i < iLimQuestion; i++) {
+    if (snapshot.IsPreserved(i)) {
+      continue;
+    }
+    if (!bLocked) {
+      rwl.Init(snapshot.GetSync());
+      bLocked = true;
+    }
+    PreserveQuestion(snapshot, i);
+  }
+}
+
+template<typename taNumber> void CpuEngine<taNumber>::PreserveQuestion(CESnapshot<taNumber> &snapshot,
+  const TPqaId iQuestion)
+{
+  const size_t nAnswers = SRCast::ToSizeT(_dims._nAnswers);
+  const size_t nTargets = SRCast::ToSizeT(_dims._nTargets);
+  const size_t rowBytes = sizeof(taNumber) * nTargets;
+  taNumber *pDest = snapshot.Preserve(iQuestion);
+  for (size_t k = 0; k < nAnswers; k++, pDest += nTargets) {
+    memcpy(pDest, _sA[SRCast::ToSizeT(iQuestion)][k].Get(), rowBytes);
+  }
+  memcpy(pDest, _mD[SRCast::ToSizeT(iQuestion)].Get(), rowBytes);
+}
+
+template<typename taNumber> PqaError CpuEngine<taNumber>::SaveDeltaStatistics(KBFileInfo &kbfi) {
+  KBFileHeader &header = kbfi._header;
+  header.LayOutStatistics(RowStride(_dims._nTargets));
+  KBDeltaHeader &delta = kbfi._delta;
+  const SRThreadCount nWorkers = kbfi.SaveWorkers(_tpWorkers.GetWorkerCount());
+  try {
+    //// Select the regions having rows of dirty questions. B changes with each training, so it's always selected.
+    std::vector<KBDeltaRegion> index;
+    const uint64_t nTotalRegions = header.NTotalRegions();
+    for (uint64_t iRegion = 0; iRegion < nTotalRegions; iRegion++) {
+      KBSection ks;
+      uint64_t iFirstRow, iLimRow, iFirstQ, iLimQ;
+      header.LocateRegion(iRegion, ks, iFirstRow, iLimRow);
+      header.QuestionsOfRows(ks, iFirstRow, iLimRow, iFirstQ, iLimQ);
+      bool bDirty = (ks == KBSection::B);
+      for (uint64_t i = iFirstQ; i < iLimQ && !bDirty; i++) {
+        bDirty = _dirtyQuestions.GetOne(i);
+      }
+      if (bDirty) {
+        index.push_back(KBDeltaRegion{ iRegion, 0, 0, 0 });
+      }
+    }
+
+    //// Lay out the delta file: the index follows the header, then the regions, then the meta section.
+    delta._nRegions = index.size();
+    delta._index._offset = sizeof(KBDeltaHeader);
+    delta._index._nBytes = index.size() * sizeof(KBDeltaRegion);
+    uint64_t offset = delta._index._offset + delta._index._nBytes;
+    for (KBDeltaRegion &dr : index) {
+      KBSection ks;
+      uint64_t iFirstRow, iLimRow;
+      header.LocateRegion(dr._iRegion, ks, iFirstRow, iLimRow);
+      dr._offset = offset;
+      offset += (iLimRow - iFirstRow) * header._rowStride;
+    }
+    delta._meta._offset = offset;
+
+    SRPositionalFile file(kbfi._filePath, SRPositionalFile::Mode::Write);
+    SRSmartMPP<uint32_t> crcs(_memPool, index.size());
+    {
+      SRSmartMPP<uint8_t> subtasksMem(_memPool, nWorkers * sizeof(CEPersistSubtaskSave<taNumber>));
+      SRPoolRunner pr(_tpWorkers, subtasksMem.Get());
+      CEPersistTask<taNumber> task(*this, nWorkers, kbfi, crcs.Get(), &file, nullptr, index.data());
+      pr.SplitAndRunSubtasks<CEPersistSubtaskSave<taNumber>>(task, index.size(), nWorkers);
+      PqaError err = task.TakeAggregateError(SRString::MakeUnowned(SR_FILE_LINE "Failed to save KB delta regions."));
+      if (!err.IsOk()) {
+        return err;
+      }
+    }
+    for (size_t i = 0; i < index.size(); i++) {
+      index[i]._checksum = crcs.Get()[i];
+    }
+    delta._index._checksum = SRChecksum::Crc32c(index.data(), SRCast::ToSizeT(delta._index._nBytes));
+    if (!file.Write(index.data(), SRCast::ToSizeT(delta._index._nBytes), delta._index._offset)) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(kbfi._filePath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't write the region index of the KB delta file."));
+    }
+  }
+  CATCH_TO_ERR_RETURN;
+  return PqaError();
+}
+
 template<typename taNumber> PqaError CpuEngine<taNumber>::DestroyQuiz(BaseQuiz *pQuiz) {
   // Report error if the object is not of type CEQuiz<taNumber>
   CEQuiz<taNumber> *pSpecQuiz = dynamic_cast<CEQuiz<taNumber>*>(pQuiz);
@@ -705,10 +1644,32 @@ template<typename taNumber> PqaError CpuEngine<taNumber>::DestroyStatistics() {
   _sA.clear();
   _mD.clear();
   _vB.Clear();
+  _pKbMapping.reset();
   return PqaError();
 }
 
+template<typename taNumber> PqaError CpuEngine<taNumber>::UnmapKBFile(const char* const filePath) {
+  try {
+    if (_pKbMapping == nullptr || !_pKbMapping->IsOf(filePath)) {
+      return PqaError();
+    }
+    // If the copying fails midway, the rows not copied keep borrowing the mapping, which thus stays.
+    for (size_t i = 0; i < _sA.size(); i++) {
+      for (size_t k = 0; k < _sA[i].size(); k++) {
+        _sA[i][k].Own<false>();
+      }
+      _mD[i].Own<false>();
+    }
+    _vB.Own<false>();
+    _pKbMapping.reset();
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
 template<typename taNumber> void CpuEngine<taNumber>::UpdateWithDimensions() {
+  // The dimensions, gaps or B may have changed in maintenance mode. There are no quizzes to share the old priors.
+  DropSharedPriors();
   const size_t newStackSize = CalcWorkerStackSize(_dims);
   if (newStackSize > _tpWorkers.GetStackSize()) {
     _tpWorkers.ChangeStackSize(newStackSize);
@@ -7,6 +7,8 @@
 #include "../PqaCore/CpuEngine.fwd.h"
 #include "../PqaCore/CEQuiz.fwd.h"
 #include "../PqaCore/CECreateQuizOperation.fwd.h"
+#include "../PqaCore/CESharedPriors.fwd.h"
+#include "../PqaCore/CESnapshot.fwd.h"
 
 #include "../PqaCore/BaseCpuEngine.h"
 #include "../PqaCore/CENormPriorsTask.h"
@@ -26,8 +28,15 @@ public: // constants
   static constexpr size_t _cNormPriorsMemReqPerSubtask = std::max({ SRMaxSizeof<CENormPriorsSubtaskMax<taNumber>,
     CENormPriorsSubtaskCorrSum<taNumber>, CEDivTargPriorsSubtask<CENormPriorsTask<taNumber>>>::value,
     SRPlat::SRBucketSummatorPar<taNumber>::_cSubtaskMemReq });
+  // The number of answers in a quiz from which its target is recorded by the workers in parallel, like in Train().
+  static constexpr TPqaId _cMinParallelTrainAnswers = 64;
+
+private: // types
+  typedef SRPlat::SRSpinSync<1 << 5> TSharedPriorsSync;
 
 private: // variables
+  // The KB file the statistics are mapped from, if loaded from the sectioned format. Must be destroyed after them.
+  std::unique_ptr<SRPlat::SRMemMappedFile> _pKbMapping;
   //// N questions, K answers, M targets
   // space A: [iQuestion][iAnswer][iTarget] . Guarded by _rws
   std::vector<std::vector<SRPlat::SRFastArray<taNumber, false>>> _sA;
@@ -35,6 +44,20 @@ private: // variables
   std::vector<SRPlat::SRFastArray<taNumber, false>> _mD;
   // vector B: [iTarget] . Guarded by _rws
   SRPlat::SRFastArray<taNumber, false> _vB;
+  // Incremented after each change of _vB in regular mode. In maintenance mode there are no quizzes, and the shared
+  //   priors are dropped when the mode is switched back to regular.
+  std::atomic<uint64_t> _versionB;
+
+  // The priors of fresh quizzes, normalized from _vB at some version of it. They are recomputed out of the lock and
+  //   then published by swapping the pointer, so the lock is only held for taking a reference.
+  TSharedPriorsSync _syncSharedPriors;
+  //// Guarded by _syncSharedPriors
+  CESharedPriors<taNumber> *_pSharedPriors;
+  bool _bComputingSharedPriors; // a thread is recomputing the priors for a newer version of _vB
+
+  // The statistics being saved by SaveKB() out of the KB lock, if any. Set and reset under shared _rws and
+  //   _csCheckpoint , so that the operations changing the statistics under exclusive _rws can read it.
+  std::unique_ptr<CESnapshot<taNumber>> _pSnapshot;
 
 private: // methods
 
@@ -44,6 +67,44 @@ private: // methods
   TPqaId CreateQuizInternal(CECreateQuizOpBase &op);
 #pragma endregion
 
+  static size_t RowStride(const TPqaId nTargets) {
+    return SRPlat::SRSimd::PaddedBytesFromItems<sizeof(taNumber)>(SRPlat::SRCast::ToSizeT(nTargets));
+  }
+  // Points the statistics to the copy-on-write mapping of the KB file, so that nothing is read until it's accessed.
+  void MapStatistics(KBFileInfo &kbfi);
+  // Checks the region checksums of the mapped KB file in parallel, which also faults the pages in.
+  void VerifyMappedStatistics(KBFileInfo &kbfi);
+  // Reads and decompresses the regions of KB file format version 3 into the statistics and checks them in parallel.
+  void LoadCompressedStatistics(KBFileInfo &kbfi);
+  // Reads the regions of the delta file into the mapping, or into the statistics loaded from a compressed KB file, and
+  //   checks them in parallel. Marks their questions dirty.
+  void ApplyDelta(KBFileInfo &kbfi);
+  // Writes the sections of statistics and the region checksums at their offsets, or the compressed regions and their
+  //   index, in parallel.
+  PqaError SaveSectionedStatistics(KBFileInfo &kbfi);
+  // Copies the rows of the answered questions to the snapshot being saved, if any, unless copied already. Must be
+  //   called under exclusive _rws before changing the rows.
+  void PreserveRows(const TPqaId nAnswered, const AnsweredQuestion* const pAQs);
+  // Same as above, for the questions in [iFirstQuestion; iLimQuestion).
+  void PreserveRows(const TPqaId iFirstQuestion, const TPqaId iLimQuestion);
+  // Copies the rows of the question to the snapshot. Must be called under exclusive lock of the snapshot.
+  void PreserveQuestion(CESnapshot<taNumber> &snapshot, const TPqaId iQuestion);
+  // Orders the targets by descending weight in B, permuting the rows of statistics in parallel, and maps the old IDs in
+  //   |cr| accordingly. There must be no gaps among the targets.
+  void OrderTargetsByWeight(CompactionResult &cr);
+  // Tells whether the two questions split the targets by their most likely answer identically, up to the labels of the
+  //   answers. |pAnswerMap| must have room for 2*nAnswers items. Must be called under shared _rws.
+  bool SamePartition(const TPqaId iFirst, const TPqaId iSecond, TPqaId *pAnswerMap) const;
+
+  // Adds the answered questions to A and D by the workers, distributing the questions among them so that they don't
+  //   race for the rows, then adds to B and logs the training as |op|. The memory is allocated before |_rws| is locked
+  //   exclusively.
+  PqaError TrainWithWorkers(const WalOp op, const TPqaId nQuestions, const AnsweredQuestion* const pAQs,
+    const TPqaId iTarget, const TPqaAmount amount);
+
+  void ComputeSharedPriors(CESharedPriors<taNumber> &sharedPriors);
+  void DropSharedPriors();
+
 protected: // Specific methods for this kind of engine
   PqaError TrainSpec(const TPqaId nQuestions, const AnsweredQuestion* const pAQs, const TPqaId iTarget,
     const TPqaAmount amount) override final;
@@ -51,15 +112,33 @@ protected: // Specific methods for this kind of engine
   TPqaId NextQuestionSpec(PqaError& err, BaseQuiz *pBaseQuiz) override final;
   TPqaId ListTopTargetsSpec(PqaError& err, BaseQuiz *pBaseQuiz, const TPqaId maxCount,
     RatedTarget *pDest) override final;
+  TPqaId AnalyzeQuestionsSpec(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) override final;
   PqaError RecordQuizTargetSpec(BaseQuiz *pBaseQuiz, const TPqaId iTarget, const TPqaAmount amount) override final;
   PqaError AddQsTsSpec(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
-    AddTargetParam *pAtps) override final;
-  PqaError CompactSpec(CompactionResult &cr) override final;
+    AddTargetParam *pAtps, const bool bReuseGaps) override final;
+  PqaError CompactSpec(CompactionResult &cr, const TPqaId maxMoves, const bool bOrderByWeight) override final;
+  PqaError DecaySpec(const TPqaAmount factor, const TPqaId iFirstQuestion, const TPqaId iLimQuestion,
+    const bool bDecayB) override final;
+  PqaError RecomputeDSpec(const TPqaId iFirstQuestion, const TPqaId iLimQuestion, TPqaAmount &maxDrift) override final;
 
   size_t NumberSize() override final;
+  uint32_t KBFormatVersion() override final {
+    return _bCompressKB.load(std::memory_order_relaxed) ? KBFileHeader::_cCompressedVersion
+      : KBFileHeader::_cSectionedVersion;
+  }
   PqaError SaveStatistics(KBFileInfo &kbfi) override final;
+  PqaError SaveDeltaStatistics(KBFileInfo &kbfi) override final;
+  void TakeSnapshot(KBFileInfo &kbfi) override final;
+  void ReleaseSnapshot() override final;
+  void PrefaultStatistics() override final;
+  void ReplayTrainingSpec(const WalTraining *pTrainings, const size_t nTrainings) override final;
+  const void* QuizOwnPriors(BaseQuiz *pBaseQuiz) override final;
+  PqaError GrowQuizSpec(BaseQuiz *pBaseQuiz) override final;
+  TPqaId RestoreQuizSpec(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs,
+    const void *pPriors) override final;
   PqaError DestroyQuiz(BaseQuiz *pQuiz) override final;
   PqaError DestroyStatistics() override final;
+  PqaError UnmapKBFile(const char* const filePath) override final;
   void UpdateWithDimensions() override final;
 
   TPqaAmount LockedGetA(const TPqaId iQuestion, const TPqaId iAnswer, const TPqaId iTarget) override final {
@@ -83,8 +162,19 @@ public: // Internal interface methods
   const taNumber& GetB(const TPqaId iTarget) const;
   taNumber& ModB(const TPqaId iTarget);
 
-  PqaError NormalizePriors(CEQuiz<taNumber> &quiz, SRPlat::SRPoolRunner &pr,
+  // Row |iRow| in the order of the KB file section of the statistics.
+  const SRPlat::SRFastArray<taNumber, false>& GetStatRow(const KBSection ks, const size_t iRow) const;
+  SRPlat::SRFastArray<taNumber, false>& ModStatRow(const KBSection ks, const size_t iRow);
+  // Same as GetStatRow(), but as of the snapshot. Must be called under shared lock of the snapshot.
+  const taNumber* GetSnapshotRow(const CESnapshot<taNumber> &snapshot, const KBSection ks, const size_t iRow) const;
+
+  // Normalizes the priors given by the mantissas in the quiz and the exponents in |pExps|, zeroing out the latter.
+  PqaError NormalizePriors(CEQuiz<taNumber> &quiz, int64_t *pExps, SRPlat::SRPoolRunner &pr,
     const SRPlat::SRPoolRunner::Split& targSplit);
+  // Returns a reference to the priors for a fresh quiz, computing them only if _vB has changed since the last time.
+  //   While another thread is computing them, the latest priors published are returned instead of waiting. The
+  //   caller must release the reference.
+  CESharedPriors<taNumber>* AcquireSharedPriors();
 
 public: // Client interface methods
   explicit CpuEngine(const EngineDefinition& engDef, KBFileInfo *pKbFi);
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "../PqaCore/CpuEngine.decl.h"
+#include "../PqaCore/CESnapshot.h"
 
 namespace ProbQA {
 
@@ -35,4 +36,48 @@ CpuEngine<taNumber>::ModB(const TPqaId iTarget) {
   return _vB[SRPlat::SRCast::ToSizeT(iTarget)];
 }
 
+template<typename taNumber> inline const SRPlat::SRFastArray<taNumber, false>&
+CpuEngine<taNumber>::GetStatRow(const KBSection ks, const size_t iRow) const {
+  const size_t nAnswers = SRPlat::SRCast::ToSizeT(_dims._nAnswers);
+  switch (ks) {
+  case KBSection::A:
+    return _sA[iRow / nAnswers][iRow % nAnswers];
+  case KBSection::D:
+    return _mD[iRow];
+  default:
+    assert(ks == KBSection::B && iRow == 0);
+    return _vB;
+  }
+}
+
+template<typename taNumber> inline SRPlat::SRFastArray<taNumber, false>&
+CpuEngine<taNumber>::ModStatRow(const KBSection ks, const size_t iRow) {
+  return const_cast<SRPlat::SRFastArray<taNumber, false>&>(GetStatRow(ks, iRow));
+}
+
+template<typename taNumber> inline const taNumber* CpuEngine<taNumber>::GetSnapshotRow(
+  const CESnapshot<taNumber> &snapshot, const KBSection ks, const size_t iRow) const
+{
+  const size_t nAnswers = SRPlat::SRCast::ToSizeT(_dims._nAnswers);
+  TPqaId iQuestion;
+  size_t iQuestionRow;
+  switch (ks) {
+  case KBSection::A:
+    iQuestion = TPqaId(iRow / nAnswers);
+    iQuestionRow = iRow % nAnswers;
+    break;
+  case KBSection::D:
+    iQuestion = TPqaId(iRow);
+    iQuestionRow = nAnswers;
+    break;
+  default:
+    assert(ks == KBSection::B && iRow == 0);
+    return snapshot.GetB().Get();
+  }
+  if (snapshot.IsPreserved(iQuestion)) {
+    return snapshot.GetRow(iQuestion, iQuestionRow);
+  }
+  return GetStatRow(ks, iRow).Get();
+}
+
 } // namespace ProbQA
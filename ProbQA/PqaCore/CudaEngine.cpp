@@ -80,19 +80,61 @@ template<typename taNumber> TPqaId CudaEngine<taNumber>::ResumeQuizSpec(PqaError
   return cInvalidPqaId;
 }
 
+template<typename taNumber> TPqaId CudaEngine<taNumber>::RestoreQuizSpec(PqaError& err, const TPqaId nAnswered,
+  const AnsweredQuestion* const pAQs, const void *pPriors)
+{
+  (void)pPriors;
+  if (nAnswered == 0) {
+    return StartQuiz(err);
+  }
+  return ResumeQuizSpec(err, nAnswered, pAQs);
+}
+
 template<typename taNumber> PqaError CudaEngine<taNumber>::AddQsTsSpec(const TPqaId nQuestions,
-  AddQuestionParam *pAqps, const TPqaId nTargets, AddTargetParam *pAtps)
+  AddQuestionParam *pAqps, const TPqaId nTargets, AddTargetParam *pAtps, const bool bReuseGaps)
 {
   (void)nQuestions;
   (void)pAqps;
   (void)nTargets;
   (void)pAtps;
+  (void)bReuseGaps;
   return PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
     "CUDA engine is being implemented.")));
 }
 
-template<typename taNumber> PqaError CudaEngine<taNumber>::CompactSpec(CompactionResult &cr) {
+template<typename taNumber> PqaError CudaEngine<taNumber>::GrowQuizSpec(BaseQuiz *pBaseQuiz) {
+  (void)pBaseQuiz;
+  return PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "CUDA engine is being implemented.")));
+}
+
+template<typename taNumber> PqaError CudaEngine<taNumber>::CompactSpec(CompactionResult &cr, const TPqaId maxMoves,
+  const bool bOrderByWeight)
+{
   (void)cr;
+  (void)maxMoves;
+  (void)bOrderByWeight;
+  return PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "CUDA engine is being implemented.")));
+}
+
+template<typename taNumber> PqaError CudaEngine<taNumber>::DecaySpec(const TPqaAmount factor,
+  const TPqaId iFirstQuestion, const TPqaId iLimQuestion, const bool bDecayB)
+{
+  (void)factor;
+  (void)iFirstQuestion;
+  (void)iLimQuestion;
+  (void)bDecayB;
+  return PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "CUDA engine is being implemented.")));
+}
+
+template<typename taNumber> PqaError CudaEngine<taNumber>::RecomputeDSpec(const TPqaId iFirstQuestion,
+  const TPqaId iLimQuestion, TPqaAmount &maxDrift)
+{
+  (void)iFirstQuestion;
+  (void)iLimQuestion;
+  maxDrift = 0;
   return PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
     "CUDA engine is being implemented.")));
 }
@@ -242,7 +284,6 @@ template<typename taNumber> TPqaId CudaEngine<taNumber>::NextQuestionSpec(PqaErr
     }
     const TPqaId iQuestion = heap.Get()[0]._iQuestion;
     pQuiz->SetActiveQuestion(iQuestion);
-    _nQuestionsAsked.fetch_add(1, std::memory_order_relaxed);
     return iQuestion;
   } CATCH_TO_ERR_SET(err);
   return cInvalidPqaId;
@@ -288,6 +329,16 @@ template<typename taNumber> TPqaId CudaEngine<taNumber>::ListTopTargetsSpec(PqaE
   return cInvalidPqaId;
 }
 
+template<typename taNumber> TPqaId CudaEngine<taNumber>::AnalyzeQuestionsSpec(PqaError& err, const TPqaId maxCount,
+  QuestionInfo *pDest)
+{
+  (void)maxCount;
+  (void)pDest;
+  err = PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "CUDA engine is being implemented.")));
+  return cInvalidPqaId;
+}
+
 template<typename taNumber> PqaError CudaEngine<taNumber>::RecordQuizTargetSpec(BaseQuiz *pBaseQuiz,
   const TPqaId iTarget, const TPqaAmount amount)
 {
@@ -376,6 +427,30 @@ template<typename taNumber> PqaError CudaEngine<taNumber>::SaveStatistics(KBFile
   CATCH_TO_ERR_RETURN;
 }
 
+template<typename taNumber> PqaError CudaEngine<taNumber>::SaveDeltaStatistics(KBFileInfo &kbfi) {
+  (void)kbfi;
+  //TODO: implement when CUDA engine writes KB file format version 2
+  return PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "Incremental saving of KB by CUDA engine.")));
+}
+
+template<typename taNumber> void CudaEngine<taNumber>::TakeSnapshot(KBFileInfo &kbfi) {
+  (void)kbfi;
+  //TODO: implement when CUDA engine writes KB file format version 2
+  throw PqaException(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "Snapshot of KB by CUDA engine.")));
+}
+
+template<typename taNumber> void CudaEngine<taNumber>::ReplayTrainingSpec(const WalTraining *pTrainings,
+  const size_t nTrainings)
+{
+  (void)pTrainings;
+  (void)nTrainings;
+  //TODO: implement when CUDA engine loads KB file format version 2
+  throw PqaException(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+    "Replay of the write-ahead log by CUDA engine.")));
+}
+
 template<typename taNumber> TPqaAmount CudaEngine<taNumber>::LockedGetA(const TPqaId iQuestion, const TPqaId iAnswer,
   const TPqaId iTarget)
 {
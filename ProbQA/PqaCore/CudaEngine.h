@@ -25,15 +25,32 @@ protected: // methods
   TPqaId NextQuestionSpec(PqaError& err, BaseQuiz *pBaseQuiz) override final;
   TPqaId ListTopTargetsSpec(PqaError& err, BaseQuiz *pBaseQuiz, const TPqaId maxCount,
     RatedTarget *pDest) override final;
+  TPqaId AnalyzeQuestionsSpec(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) override final;
   PqaError RecordQuizTargetSpec(BaseQuiz *pBaseQuiz, const TPqaId iTarget, const TPqaAmount amount) override final;
   PqaError AddQsTsSpec(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
-    AddTargetParam *pAtps)  override final;
-  PqaError CompactSpec(CompactionResult &cr)  override final;
+    AddTargetParam *pAtps, const bool bReuseGaps)  override final;
+  PqaError CompactSpec(CompactionResult &cr, const TPqaId maxMoves, const bool bOrderByWeight) override final;
+  PqaError DecaySpec(const TPqaAmount factor, const TPqaId iFirstQuestion, const TPqaId iLimQuestion,
+    const bool bDecayB) override final;
+  PqaError RecomputeDSpec(const TPqaId iFirstQuestion, const TPqaId iLimQuestion, TPqaAmount &maxDrift) override final;
 
   size_t NumberSize() override final { return sizeof(taNumber); };
+  uint32_t KBFormatVersion() override final { return KBFileHeader::_cLegacyVersion; }
   PqaError SaveStatistics(KBFileInfo &kbfi) override final;
+  PqaError SaveDeltaStatistics(KBFileInfo &kbfi) override final;
+  void TakeSnapshot(KBFileInfo &kbfi) override final;
+  void ReleaseSnapshot() override final { }
+  // The statistics are in the device memory, which isn't paged.
+  void PrefaultStatistics() override final { }
+  void ReplayTrainingSpec(const WalTraining *pTrainings, const size_t nTrainings) override final;
+  // The priors of the quizzes are in the device memory, so they are recomputed on restore.
+  const void* QuizOwnPriors(BaseQuiz *pBaseQuiz) override final { (void)pBaseQuiz; return nullptr; }
+  PqaError GrowQuizSpec(BaseQuiz *pBaseQuiz) override final;
+  TPqaId RestoreQuizSpec(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs,
+    const void *pPriors) override final;
   PqaError DestroyQuiz(BaseQuiz *pQuiz) override final;
   PqaError DestroyStatistics() override final;
+  PqaError UnmapKBFile(const char* const) override final { return PqaError(); }
   void UpdateWithDimensions() override final;
 
   TPqaAmount LockedGetA(const TPqaId iQuestion, const TPqaId iAnswer, const TPqaId iTarget) override final;
@@ -67,6 +67,20 @@ public:
     _isGap.ReduceTo(newLength);
     _gaps.clear();
   }
+
+  // Compacts partially: the gaps at |pFilled| are filled and the items from |newLength| on are cut off, while the
+  //   other gaps remain.
+  void Compact(const taId newLength, const taId nFilled, const taId *pFilled) {
+    assert(newLength <= taId(_isGap.Size()));
+    for (taId i = 0; i < nFilled; i++) {
+      assert(pFilled[i] < newLength);
+      _isGap.ClearOne(SRPlat::SRCast::ToUint64(pFilled[i]));
+    }
+    _isGap.ReduceTo(newLength);
+    _gaps.erase(std::remove_if(_gaps.begin(), _gaps.end(), [&](const taId at) {
+      return at >= newLength || !_isGap.GetOne(SRPlat::SRCast::ToUint64(at));
+    }), _gaps.end());
+  }
 };
 
 } // namespace ProbQA
@@ -0,0 +1,592 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/HotSwapEngine.h"
+#include "../PqaCore/BaseEngine.h"
+#include "../PqaCore/ErrorHelper.h"
+#include "../PqaCore/Interface/IPqaEngineFactory.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+#define HSELOG(severityVar) SRLogStream(ISRLogger::Severity::severityVar, _pLogger.load(std::memory_order_acquire))
+
+HotSwapEngine::HotSwapEngine(IPqaEngine *pInitial, const size_t memPoolMaxBytes) : _memPoolMaxBytes(memPoolMaxBytes),
+  _pDraining(nullptr), _pLogger(SRDefaultLogger::Get())
+{
+  std::unique_ptr<Generation> pGen(new Generation());
+  _generations.reserve(1);
+  // Nothing throws after taking the ownership.
+  pGen->_pOwned.reset(pInitial);
+  pGen->_pEngine = static_cast<BaseEngine*>(pInitial);
+  pGen->_version = 0;
+  _pCurrent.store(pGen.get(), std::memory_order_release);
+  _generations.push_back(std::move(pGen));
+}
+
+HotSwapEngine::~HotSwapEngine() {
+  PqaError pqaErr = Shutdown();
+  if (!pqaErr.IsOk() && pqaErr.GetCode() != PqaErrorCode::ObjectShutDown) {
+    HSELOG(Error) << "Failed HotSwapEngine::Shutdown(): " << pqaErr.ToString(true);
+  }
+}
+
+TPqaId HotSwapEngine::TagQuizId(const Generation &gen, const TPqaId iInner) {
+  if (iInner < 0) {
+    return iInner;
+  }
+  assert((uint64_t(iInner) & ~_cInnerIdMask) == 0);
+  return TPqaId(uint64_t(iInner) | (uint64_t(gen._version & _cVersionMask) << _cVersionShift));
+}
+
+HotSwapEngine::Generation* HotSwapEngine::RouteQuiz(const TPqaId iQuiz, TPqaId &iInner) {
+  Generation *pGen = _pCurrent.load(std::memory_order_acquire);
+  iInner = iQuiz;
+  if (iQuiz < 0) {
+    return pGen;
+  }
+  const uint32_t version = uint32_t(uint64_t(iQuiz) >> _cVersionShift);
+  if (version != (pGen->_version & _cVersionMask)) {
+    Generation *pDraining = _pDraining.load(std::memory_order_acquire);
+    if (pDraining == nullptr || version != (pDraining->_version & _cVersionMask)) {
+      // Set all the version bits, so that the ID doesn't match a quiz of the current engine even for the version 0.
+      iInner = TPqaId(uint64_t(iQuiz) | (uint64_t(_cVersionMask) << _cVersionShift));
+      return pGen;
+    }
+    pGen = pDraining;
+  }
+  iInner = TPqaId(uint64_t(iQuiz) & _cInnerIdMask);
+  return pGen;
+}
+
+HotSwapEngine::Generation* HotSwapEngine::EnterStarting() {
+  for (;;) {
+    Generation *pGen = _pCurrent.load(std::memory_order_seq_cst);
+    pGen->_nStarting.fetch_add(1, std::memory_order_seq_cst);
+    // Either this sees the swap, or the retirer sees this operation.
+    if (pGen == _pCurrent.load(std::memory_order_seq_cst)) {
+      return pGen;
+    }
+    LeaveStarting(pGen);
+  }
+}
+
+void HotSwapEngine::LeaveStarting(Generation *pGen) {
+  pGen->_nStarting.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void HotSwapEngine::CheckDrained() {
+  Generation *pDraining = _pDraining.load(std::memory_order_acquire);
+  if (pDraining != nullptr && pDraining->_pEngine->GetNLiveQuizzes() == 0) {
+    _retirerWake.WakeAll();
+  }
+}
+
+void HotSwapEngine::RunRetirer() {
+  SRLock<SRCriticalSection> csl(_csRetirer);
+  while (!_bRetirerShutdown) {
+    _retirerWake.Wait(_csRetirer, _cRetirerPollMs);
+    if (_bRetirerShutdown) {
+      break;
+    }
+    csl.EarlyRelease();
+    {
+      SRLock<SRCriticalSection> swl(_csSwap);
+      Generation *pDraining = _pDraining.load(std::memory_order_acquire);
+      // The operations starting quizzes increment the number of live quizzes before they leave.
+      if (pDraining != nullptr && pDraining->_nStarting.load(std::memory_order_seq_cst) == 0
+        && pDraining->_pEngine->GetNLiveQuizzes() == 0)
+      {
+        PqaError err = RetireDraining();
+        if (!err.IsOk()) {
+          HSELOG(Error) << SR_FILE_LINE << "Hot swap retirer: " << err.ToString(true);
+        }
+      }
+    }
+    csl.Init(_csRetirer);
+  }
+}
+
+PqaError HotSwapEngine::RetireDraining() {
+  Generation *pGen = _pDraining.load(std::memory_order_relaxed);
+  if (pGen == nullptr) {
+    return PqaError();
+  }
+  {
+    SRLock<SRCriticalSection> gl(_csGens);
+    _pDraining.store(nullptr, std::memory_order_release);
+  }
+  const TPqaId nLive = pGen->_pEngine->GetNLiveQuizzes();
+  if (nLive > 0) {
+    HSELOG(Warning) << "Hot swap: releasing " << nLive << " quizzes of the KB version " << pGen->_version;
+  }
+  // Waits for the operations in progress on the engine. The object stays till this engine is destroyed.
+  PqaError errShutdown = pGen->_pEngine->Shutdown();
+  PqaError err;
+  const uint64_t nAsked = pGen->_pEngine->GetTotalQuestionsAsked(err);
+  if (err.IsOk()) {
+    SRLock<SRCriticalSection> gl(_csGens);
+    _nAskedRetired += nAsked - pGen->_nAskedAtDemotion;
+  }
+  return errShutdown;
+}
+
+PqaError HotSwapEngine::Warmup() {
+  return Current()->Warmup();
+}
+
+PqaError HotSwapEngine::HotSwapKB(const char* const filePath) {
+  try {
+    if (filePath == nullptr) {
+      return PqaError(PqaErrorCode::NullArgument, nullptr, SRString::MakeUnowned(
+        SR_FILE_LINE "Nullptr is passed in place of the file name of the KB to swap in."));
+    }
+    SRLock<SRCriticalSection> swl(_csSwap);
+    if (_bShutdown) {
+      return PqaError(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
+        "HotSwapEngine::HotSwapKB()")), SRString::MakeUnowned(SR_FILE_LINE "Can't swap the KB."));
+    }
+    Generation *pOld = _pCurrent.load(std::memory_order_relaxed);
+
+    //// Load and prepare the new KB while the old one is in service.
+    PqaError err;
+    std::unique_ptr<Generation> pNew(new Generation());
+    pNew->_pOwned.reset(PqaGetEngineFactory().LoadCpuEngine(err, filePath, _memPoolMaxBytes));
+    if (pNew->_pOwned == nullptr) {
+      return err;
+    }
+    pNew->_pEngine = static_cast<BaseEngine*>(pNew->_pOwned.get());
+    pNew->_version = pOld->_version + 1;
+    err = pNew->_pEngine->SetLogger(_pLogger.load(std::memory_order_acquire));
+    if (!err.IsOk()) {
+      return err;
+    }
+    {
+      SRLock<SRCriticalSection> gl(_csGens);
+      err = pNew->_pEngine->SetCompressKB(_bCompressKB);
+      if (err.IsOk() && _bQuizExpirySet) {
+        err = pNew->_pEngine->SetQuizExpiry(_quizMaxCount, _quizMaxAgeSec, _bBackgroundReaper);
+      }
+    }
+    if (!err.IsOk()) {
+      return err;
+    }
+    // The permanent IDs of the quizzes started on the new KB must not clash with those of the old KB.
+    pNew->_pEngine->EnsurePermQuizGreater(pOld->_pEngine->GetNextPermQuizId() - 1);
+    err = pNew->_pEngine->Warmup();
+    if (!err.IsOk()) {
+      HSELOG(Warning) << SR_FILE_LINE << "Hot swap: the warm-up of the new KB has failed: " << err.ToString(true);
+    }
+
+    //// Take the old KB out of service.
+    // Only one old KB is kept, so the one before it is retired even if it still has quizzes.
+    err = RetireDraining();
+    if (!err.IsOk()) {
+      HSELOG(Error) << SR_FILE_LINE << "Hot swap: " << err.ToString(true);
+    }
+    // Nothing is to be written to the files of the old KB anymore.
+    err = pOld->_pEngine->StopCheckpointer();
+    if (err.IsOk()) {
+      err = pOld->_pEngine->StopWal();
+    }
+    if (!err.IsOk()) {
+      HSELOG(Error) << SR_FILE_LINE << "Hot swap: " << err.ToString(true);
+    }
+    Generation *pPublished = pNew.get();
+    _generations.push_back(std::move(pNew));
+    {
+      SRLock<SRCriticalSection> gl(_csGens);
+      pOld->_nAskedAtDemotion = pOld->_pEngine->GetTotalQuestionsAsked(err);
+      _pDraining.store(pOld, std::memory_order_release);
+      _pCurrent.store(pPublished, std::memory_order_seq_cst);
+    }
+    HSELOG(Info) << "Hot swap: the KB version " << pPublished->_version << " from " << filePath << " is in service.";
+
+    {
+      SRLock<SRCriticalSection> rl(_csRetirer);
+      if (!_retirer.joinable() && !_bRetirerShutdown) {
+        _retirer = std::thread(&HotSwapEngine::RunRetirer, this);
+      }
+    }
+    _retirerWake.WakeAll();
+    return PqaError();
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+PqaError HotSwapEngine::Shutdown(const char* const saveFilePath) {
+  std::thread retirer;
+  {
+    SRLock<SRCriticalSection> rl(_csRetirer);
+    _bRetirerShutdown = true;
+    retirer = std::move(_retirer);
+  }
+  _retirerWake.WakeAll();
+  if (retirer.joinable()) {
+    retirer.join();
+  }
+
+  SRLock<SRCriticalSection> swl(_csSwap);
+  if (_bShutdown) {
+    return PqaError(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
+      "HotSwapEngine::Shutdown()")), SRString::MakeUnowned(SR_FILE_LINE "The engine seems already shut down."));
+  }
+  _bShutdown = true;
+  AggregateErrorParams aep;
+  aep.Add(RetireDraining());
+  aep.Add(Current()->Shutdown(saveFilePath));
+  return aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Error(s) occurred during shutdown."));
+}
+
+PqaError HotSwapEngine::SetLogger(ISRLogger *pLogger) {
+  if (pLogger == nullptr) {
+    pLogger = SRDefaultLogger::Get();
+  }
+  _pLogger.store(pLogger, std::memory_order_release);
+  AggregateErrorParams aep;
+  SRLock<SRCriticalSection> gl(_csGens);
+  aep.Add(Current()->SetLogger(pLogger));
+  Generation *pDraining = _pDraining.load(std::memory_order_relaxed);
+  if (pDraining != nullptr) {
+    aep.Add(pDraining->_pEngine->SetLogger(pLogger));
+  }
+  return aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Failed to set the logger."));
+}
+
+//// The operations on the quizzes
+
+TPqaId HotSwapEngine::StartQuiz(PqaError& err) {
+  Generation *pGen = EnterStarting();
+  const TPqaId iInner = pGen->_pEngine->StartQuiz(err);
+  LeaveStarting(pGen);
+  return TagQuizId(*pGen, iInner);
+}
+
+TPqaId HotSwapEngine::ResumeQuiz(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs) {
+  Generation *pGen = EnterStarting();
+  const TPqaId iInner = pGen->_pEngine->ResumeQuiz(err, nAnswered, pAQs);
+  LeaveStarting(pGen);
+  return TagQuizId(*pGen, iInner);
+}
+
+TPqaId HotSwapEngine::LoadQuizzes(PqaError& err, const char* const filePath) {
+  Generation *pGen = EnterStarting();
+  const TPqaId nRestored = pGen->_pEngine->LoadQuizzes(err, filePath);
+  LeaveStarting(pGen);
+  return nRestored;
+}
+
+TPqaId HotSwapEngine::NextQuestion(PqaError& err, const TPqaId iQuiz) {
+  TPqaId iInner;
+  return RouteQuiz(iQuiz, iInner)->_pEngine->NextQuestion(err, iInner);
+}
+
+PqaError HotSwapEngine::RecordAnswer(const TPqaId iQuiz, const TPqaId iAnswer) {
+  TPqaId iInner;
+  return RouteQuiz(iQuiz, iInner)->_pEngine->RecordAnswer(iInner, iAnswer);
+}
+
+TPqaId HotSwapEngine::GetActiveQuestionId(PqaError &err, const TPqaId iQuiz) {
+  TPqaId iInner;
+  return RouteQuiz(iQuiz, iInner)->_pEngine->GetActiveQuestionId(err, iInner);
+}
+
+PqaError HotSwapEngine::SetActiveQuestion(const TPqaId iQuiz, const TPqaId iQuestion) {
+  TPqaId iInner;
+  return RouteQuiz(iQuiz, iInner)->_pEngine->SetActiveQuestion(iInner, iQuestion);
+}
+
+TPqaId HotSwapEngine::ListTopTargets(PqaError& err, const TPqaId iQuiz, const TPqaId maxCount, RatedTarget *pDest) {
+  TPqaId iInner;
+  return RouteQuiz(iQuiz, iInner)->_pEngine->ListTopTargets(err, iInner, maxCount, pDest);
+}
+
+TPqaId HotSwapEngine::AnalyzeQuestions(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) {
+  return Current()->AnalyzeQuestions(err, maxCount, pDest);
+}
+
+PqaError HotSwapEngine::RecordQuizTarget(const TPqaId iQuiz, const TPqaId iTarget, const TPqaAmount amount) {
+  TPqaId iInner;
+  Generation *pGen = RouteQuiz(iQuiz, iInner);
+  Generation *pCurrent = _pCurrent.load(std::memory_order_acquire);
+  if (pGen == pCurrent) {
+    return pGen->_pEngine->RecordQuizTarget(iInner, iTarget, amount);
+  }
+  // The old KB is discarded once drained, so the KB in service is trained instead.
+  return ForwardQuizTarget(*pGen, iInner, *pCurrent, iTarget, amount);
+}
+
+PqaError HotSwapEngine::ForwardQuizTarget(Generation &from, const TPqaId iInner, Generation &to, const TPqaId iTarget,
+  const TPqaAmount amount)
+{
+  try {
+    std::vector<AnsweredQuestion> aqs;
+    PqaError err = from._pEngine->CopyQuizAnswers(iInner, aqs);
+    if (!err.IsOk()) {
+      return err;
+    }
+    // The compact IDs of the KBs differ, so the questions and the target are matched by their permanent IDs.
+    const TPqaId nAnswered = TPqaId(aqs.size());
+    std::vector<TPqaId> ids(aqs.size());
+    for (size_t i = 0; i < aqs.size(); i++) {
+      ids[i] = aqs[i]._iQuestion;
+    }
+    TPqaId idTarget = iTarget;
+    from._pEngine->QuestionPermFromComp(nAnswered, ids.data());
+    from._pEngine->TargetPermFromComp(1, &idTarget);
+    to._pEngine->QuestionCompFromPerm(nAnswered, ids.data());
+    to._pEngine->TargetCompFromPerm(1, &idTarget);
+    for (size_t i = 0; i < aqs.size(); i++) {
+      if (ids[i] == cInvalidPqaId) {
+        return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(aqs[i]._iQuestion), SRString::MakeUnowned(
+          SR_FILE_LINE "A question answered in the quiz of the old KB is not in the KB in service."));
+      }
+      aqs[i]._iQuestion = ids[i];
+    }
+    if (idTarget == cInvalidPqaId) {
+      return PqaError(PqaErrorCode::AbsentId, new AbsentIdErrorParams(iTarget), SRString::MakeUnowned(SR_FILE_LINE
+        "The target of the quiz of the old KB is not in the KB in service."));
+    }
+    return to._pEngine->Train(nAnswered, aqs.data(), idTarget, amount);
+  }
+  CATCH_TO_ERR_RETURN;
+}
+
+PqaError HotSwapEngine::ReleaseQuiz(const TPqaId iQuiz) {
+  TPqaId iInner;
+  Generation *pGen = RouteQuiz(iQuiz, iInner);
+  PqaError err = pGen->_pEngine->ReleaseQuiz(iInner);
+  if (pGen != _pCurrent.load(std::memory_order_acquire)) {
+    CheckDrained();
+  }
+  return err;
+}
+
+bool HotSwapEngine::QuizPermFromComp(const TPqaId count, TPqaId *pIds) {
+  bool bOk = true;
+  for (TPqaId i = 0; i < count; i++) {
+    TPqaId iInner;
+    Generation *pGen = RouteQuiz(pIds[i], iInner);
+    bOk = pGen->_pEngine->QuizPermFromComp(1, &iInner) && bOk;
+    pIds[i] = iInner;
+  }
+  return bOk;
+}
+
+bool HotSwapEngine::QuizCompFromPerm(const TPqaId count, TPqaId *pIds) {
+  bool bOk = true;
+  for (TPqaId i = 0; i < count; i++) {
+    Generation *pGen = _pCurrent.load(std::memory_order_acquire);
+    TPqaId iInner = pIds[i];
+    bOk = pGen->_pEngine->QuizCompFromPerm(1, &iInner) && bOk;
+    if (iInner == cInvalidPqaId) {
+      // The permanent IDs of the KBs don't clash, so the quiz may be draining on the old KB.
+      Generation *pDraining = _pDraining.load(std::memory_order_acquire);
+      if (pDraining != nullptr) {
+        pGen = pDraining;
+        iInner = pIds[i];
+        bOk = pGen->_pEngine->QuizCompFromPerm(1, &iInner) && bOk;
+      }
+    }
+    pIds[i] = TagQuizId(*pGen, iInner);
+  }
+  return bOk;
+}
+
+bool HotSwapEngine::EnsurePermQuizGreater(const TPqaId bound) {
+  return Current()->EnsurePermQuizGreater(bound);
+}
+
+bool HotSwapEngine::RemapQuizPermId(const TPqaId srcPermId, const TPqaId destPermId) {
+  if (Current()->RemapQuizPermId(srcPermId, destPermId)) {
+    return true;
+  }
+  Generation *pDraining = _pDraining.load(std::memory_order_acquire);
+  return pDraining != nullptr && pDraining->_pEngine->RemapQuizPermId(srcPermId, destPermId);
+}
+
+//// The operations applied to both the KB in service and the old KB. The errors of the old KB retired meanwhile are
+////   ignored.
+
+PqaError HotSwapEngine::ClearOldQuizzes(const TPqaId maxCount, const double maxAgeSec) {
+  AggregateErrorParams aep;
+  aep.Add(Current()->ClearOldQuizzes(maxCount, maxAgeSec));
+  Generation *pDraining = _pDraining.load(std::memory_order_acquire);
+  if (pDraining != nullptr) {
+    PqaError err = pDraining->_pEngine->ClearOldQuizzes(maxCount, maxAgeSec);
+    if (pDraining == _pDraining.load(std::memory_order_acquire)) {
+      aep.Add(std::move(err));
+    }
+    CheckDrained();
+  }
+  return aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Error(s) occurred during clearing old quizzes."));
+}
+
+PqaError HotSwapEngine::SetQuizExpiry(const TPqaId maxCount, const double maxAgeSec, const bool bBackgroundReaper) {
+  SRLock<SRCriticalSection> gl(_csGens);
+  PqaError err = Current()->SetQuizExpiry(maxCount, maxAgeSec, bBackgroundReaper);
+  if (!err.IsOk()) {
+    return err;
+  }
+  _bQuizExpirySet = true;
+  _quizMaxCount = maxCount;
+  _quizMaxAgeSec = maxAgeSec;
+  _bBackgroundReaper = bBackgroundReaper;
+  Generation *pDraining = _pDraining.load(std::memory_order_relaxed);
+  if (pDraining != nullptr) {
+    // Under _csGens it can't be retired meanwhile.
+    return pDraining->_pEngine->SetQuizExpiry(maxCount, maxAgeSec, bBackgroundReaper);
+  }
+  return PqaError();
+}
+
+PqaError HotSwapEngine::ReapQuizzes() {
+  AggregateErrorParams aep;
+  aep.Add(Current()->ReapQuizzes());
+  Generation *pDraining = _pDraining.load(std::memory_order_acquire);
+  if (pDraining != nullptr) {
+    PqaError err = pDraining->_pEngine->ReapQuizzes();
+    if (pDraining == _pDraining.load(std::memory_order_acquire)) {
+      aep.Add(std::move(err));
+    }
+    CheckDrained();
+  }
+  return aep.ToError(SRString::MakeUnowned(SR_FILE_LINE "Error(s) occurred during reaping quizzes."));
+}
+
+uint64_t HotSwapEngine::GetTotalQuestionsAsked(PqaError& err) {
+  SRLock<SRCriticalSection> gl(_csGens);
+  uint64_t nAsked = Current()->GetTotalQuestionsAsked(err);
+  if (!err.IsOk()) {
+    return nAsked;
+  }
+  nAsked += _nAskedRetired;
+  Generation *pDraining = _pDraining.load(std::memory_order_relaxed);
+  if (pDraining != nullptr) {
+    nAsked += pDraining->_pEngine->GetTotalQuestionsAsked(err) - pDraining->_nAskedAtDemotion;
+  }
+  return nAsked;
+}
+
+PqaError HotSwapEngine::SetCompressKB(const bool bCompress) {
+  SRLock<SRCriticalSection> gl(_csGens);
+  _bCompressKB = bCompress;
+  return Current()->SetCompressKB(bCompress);
+}
+
+//// The operations on the KB in service
+
+PqaError HotSwapEngine::Train(const TPqaId nQuestions, const AnsweredQuestion* const pAQs, const TPqaId iTarget,
+  const TPqaAmount amount)
+{
+  return Current()->Train(nQuestions, pAQs, iTarget, amount);
+}
+
+PqaError HotSwapEngine::DecayStatistics(const TPqaAmount factor, const TPqaId maxSliceQuestions) {
+  return Current()->DecayStatistics(factor, maxSliceQuestions);
+}
+
+PqaError HotSwapEngine::RecomputeD(TPqaAmount &maxDrift, const TPqaId maxSliceQuestions) {
+  return Current()->RecomputeD(maxDrift, maxSliceQuestions);
+}
+
+bool HotSwapEngine::QuestionPermFromComp(const TPqaId count, TPqaId *pIds) {
+  return Current()->QuestionPermFromComp(count, pIds);
+}
+
+bool HotSwapEngine::QuestionCompFromPerm(const TPqaId count, TPqaId *pIds) {
+  return Current()->QuestionCompFromPerm(count, pIds);
+}
+
+bool HotSwapEngine::TargetPermFromComp(const TPqaId count, TPqaId *pIds) {
+  return Current()->TargetPermFromComp(count, pIds);
+}
+
+bool HotSwapEngine::TargetCompFromPerm(const TPqaId count, TPqaId *pIds) {
+  return Current()->TargetCompFromPerm(count, pIds);
+}
+
+EngineDimensions HotSwapEngine::CopyDims() const {
+  return Current()->CopyDims();
+}
+
+PqaError HotSwapEngine::CopyATargets(const TPqaId iQuestion, const TPqaId iAnswer, const TPqaId maxTargets,
+  TPqaAmount *pFreqs)
+{
+  return Current()->CopyATargets(iQuestion, iAnswer, maxTargets, pFreqs);
+}
+
+PqaError HotSwapEngine::CopyDTargets(const TPqaId iQuestion, const TPqaId maxTargets, TPqaAmount *pFreqs) {
+  return Current()->CopyDTargets(iQuestion, maxTargets, pFreqs);
+}
+
+PqaError HotSwapEngine::CopyBTargets(const TPqaId maxTargets, TPqaAmount *pFreqs) {
+  return Current()->CopyBTargets(maxTargets, pFreqs);
+}
+
+PqaError HotSwapEngine::SaveQuizzes(const char* const filePath) {
+  return Current()->SaveQuizzes(filePath);
+}
+
+PqaError HotSwapEngine::SaveKB(const char* const filePath, const bool bDoubleBuffer) {
+  return Current()->SaveKB(filePath, bDoubleBuffer);
+}
+
+PqaError HotSwapEngine::SaveIncremental() {
+  return Current()->SaveIncremental();
+}
+
+PqaError HotSwapEngine::StartWal(const bool bWaitCommit) {
+  return Current()->StartWal(bWaitCommit);
+}
+
+PqaError HotSwapEngine::StopWal() {
+  return Current()->StopWal();
+}
+
+PqaError HotSwapEngine::StartCheckpointer(const CheckpointPolicy &policy) {
+  return Current()->StartCheckpointer(policy);
+}
+
+PqaError HotSwapEngine::StopCheckpointer() {
+  return Current()->StopCheckpointer();
+}
+
+PqaError HotSwapEngine::GetCheckpointStats(CheckpointStats &stats) {
+  return Current()->GetCheckpointStats(stats);
+}
+
+PqaError HotSwapEngine::StartMaintenance(const bool forceQuizzes) {
+  return Current()->StartMaintenance(forceQuizzes);
+}
+
+PqaError HotSwapEngine::FinishMaintenance() {
+  return Current()->FinishMaintenance();
+}
+
+PqaError HotSwapEngine::AddQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
+  AddTargetParam *pAtps)
+{
+  return Current()->AddQsTs(nQuestions, pAqps, nTargets, pAtps);
+}
+
+PqaError HotSwapEngine::RemoveQuestions(const TPqaId nQuestions, const TPqaId *pQIds) {
+  return Current()->RemoveQuestions(nQuestions, pQIds);
+}
+
+PqaError HotSwapEngine::RemoveTargets(const TPqaId nTargets, const TPqaId *pTIds) {
+  return Current()->RemoveTargets(nTargets, pTIds);
+}
+
+PqaError HotSwapEngine::Compact(CompactionResult &cr, const bool bOrderByWeight) {
+  return Current()->Compact(cr, bOrderByWeight);
+}
+
+PqaError HotSwapEngine::CompactSlice(CompactionResult &cr, const TPqaId maxMoves) {
+  return Current()->CompactSlice(cr, maxMoves);
+}
+
+} // namespace ProbQA
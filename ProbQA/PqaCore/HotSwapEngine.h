@@ -0,0 +1,152 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/Interface/IPqaEngine.h"
+#include "../PqaCore/QuizRegistry.h"
+
+namespace ProbQA {
+
+class BaseEngine;
+
+// Serves the KB through an engine, which is replaced by an engine of a new KB on HotSwapKB(). The engine of the old KB
+//   keeps serving its quizzes (draining) till they are released, then it's shut down (retired) in a background thread.
+// Quiz IDs carry the version of their KB in the bits above the quiz IDs of the engines, so that a quiz operation goes
+//   to the engine of the quiz without a lock. The engine objects are kept till this engine is destroyed, so that a
+//   concurrent operation holding a retired one fails on its shutdown rather than accessing freed memory.
+class HotSwapEngine : public IPqaEngine {
+public: // constants
+  static constexpr uint8_t _cVersionShift = QuizRegistry::_cIdBits;
+  static constexpr uint32_t _cVersionMask = (uint32_t(1) << (63 - _cVersionShift)) - 1;
+  static constexpr uint64_t _cInnerIdMask = (uint64_t(1) << _cVersionShift) - 1;
+  // How often the retirer checks whether the quizzes of the old KB have expired in the engine.
+  static constexpr uint32_t _cRetirerPollMs = 1000;
+
+private: // types
+  struct Generation {
+    std::unique_ptr<IPqaEngine> _pOwned;
+    BaseEngine *_pEngine;
+    uint32_t _version;
+    // The number of operations starting quizzes on the engine. The retirer waits for them, because they may have
+    //   taken the engine just before it was taken out of service.
+    std::atomic<int64_t> _nStarting = 0;
+    uint64_t _nAskedAtDemotion = 0; // the questions asked when the KB was taken out of service. Guarded by _csGens
+  };
+
+private: // variables
+  const size_t _memPoolMaxBytes;
+  std::atomic<Generation*> _pCurrent; // the KB in service. Replaced under _csSwap and _csGens
+  std::atomic<Generation*> _pDraining; // the old KB, if any. Replaced under _csSwap and _csGens
+  std::atomic<SRPlat::ISRLogger*> _pLogger;
+
+  // Serializes the swaps, the retirement and the shutdown, which may take long.
+  SRPlat::SRCriticalSection _csSwap;
+  std::vector<std::unique_ptr<Generation>> _generations; // Guarded by _csSwap
+  bool _bShutdown = false; // Guarded by _csSwap
+
+  // Guards the settings carried over to the new KB and the accounting of the questions asked.
+  SRPlat::SRCriticalSection _csGens;
+  bool _bQuizExpirySet = false; // Guarded by _csGens
+  TPqaId _quizMaxCount = -1; // Guarded by _csGens
+  double _quizMaxAgeSec = 0; // Guarded by _csGens
+  bool _bBackgroundReaper = false; // Guarded by _csGens
+  bool _bCompressKB = false; // Guarded by _csGens
+  // The questions asked on the retired KBs after they were taken out of service. Guarded by _csGens
+  uint64_t _nAskedRetired = 0;
+
+  //// Background retirer of the drained KB
+  SRPlat::SRCriticalSection _csRetirer;
+  SRPlat::SRConditionVariable _retirerWake;
+  std::thread _retirer; // Guarded by _csRetirer
+  bool _bRetirerShutdown = false; // Guarded by _csRetirer
+
+private: // methods
+  BaseEngine* Current() const { return _pCurrent.load(std::memory_order_acquire)->_pEngine; }
+  static TPqaId TagQuizId(const Generation &gen, const TPqaId iInner);
+  // Returns the generation of the quiz and sets the quiz ID in its engine. The IDs of the KBs not in service go to the
+  //   current engine with all the version bits set, which it rejects.
+  Generation* RouteQuiz(const TPqaId iQuiz, TPqaId &iInner);
+  // Returns the generation in service, on which the quizzes can be started till LeaveStarting().
+  Generation* EnterStarting();
+  static void LeaveStarting(Generation *pGen);
+  // Wakes the retirer if the old KB has no quizzes left.
+  void CheckDrained();
+  void RunRetirer();
+  // Shuts down the engine of the old KB, releasing its quizzes if any. Must be called with |_csSwap| locked.
+  PqaError RetireDraining();
+  // Trains the KB of |to| with the answers of the quiz |iInner| of |from| and |iTarget| of |from|.
+  PqaError ForwardQuizTarget(Generation &from, const TPqaId iInner, Generation &to, const TPqaId iTarget,
+    const TPqaAmount amount);
+
+public: // methods
+  // Takes the ownership of the engine, which must be a CPU engine.
+  explicit HotSwapEngine(IPqaEngine *pInitial, const size_t memPoolMaxBytes);
+  virtual ~HotSwapEngine() override;
+  HotSwapEngine(const HotSwapEngine&) = delete;
+  HotSwapEngine& operator=(const HotSwapEngine&) = delete;
+
+  PqaError Train(const TPqaId nQuestions, const AnsweredQuestion* const pAQs, const TPqaId iTarget,
+    const TPqaAmount amount = 1) override final;
+  PqaError DecayStatistics(const TPqaAmount factor, const TPqaId maxSliceQuestions = 0) override final;
+  PqaError RecomputeD(TPqaAmount &maxDrift, const TPqaId maxSliceQuestions = 0) override final;
+
+  bool QuestionPermFromComp(const TPqaId count, TPqaId *pIds) override final;
+  bool QuestionCompFromPerm(const TPqaId count, TPqaId *pIds) override final;
+  bool TargetPermFromComp(const TPqaId count, TPqaId *pIds) override final;
+  bool TargetCompFromPerm(const TPqaId count, TPqaId *pIds) override final;
+  bool QuizPermFromComp(const TPqaId count, TPqaId *pIds) override final;
+  bool QuizCompFromPerm(const TPqaId count, TPqaId *pIds) override final;
+  bool EnsurePermQuizGreater(const TPqaId bound) override final;
+  bool RemapQuizPermId(const TPqaId srcPermId, const TPqaId destPermId) override final;
+
+  uint64_t GetTotalQuestionsAsked(PqaError& err) override final;
+  EngineDimensions CopyDims() const override final;
+  PqaError CopyATargets(const TPqaId iQuestion, const TPqaId iAnswer, const TPqaId maxTargets,
+    TPqaAmount *pFreqs) override final;
+  PqaError CopyDTargets(const TPqaId iQuestion, const TPqaId maxTargets, TPqaAmount *pFreqs) override final;
+  PqaError CopyBTargets(const TPqaId maxTargets, TPqaAmount *pFreqs) override final;
+
+  TPqaId StartQuiz(PqaError& err) override final;
+  TPqaId ResumeQuiz(PqaError& err, const TPqaId nAnswered, const AnsweredQuestion* const pAQs) override final;
+  TPqaId NextQuestion(PqaError& err, const TPqaId iQuiz) override final;
+  PqaError RecordAnswer(const TPqaId iQuiz, const TPqaId iAnswer) override final;
+  TPqaId GetActiveQuestionId(PqaError &err, const TPqaId iQuiz) override final;
+  PqaError SetActiveQuestion(const TPqaId iQuiz, const TPqaId iQuestion) override final;
+  TPqaId ListTopTargets(PqaError& err, const TPqaId iQuiz, const TPqaId maxCount, RatedTarget *pDest) override final;
+  TPqaId AnalyzeQuestions(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) override final;
+  PqaError RecordQuizTarget(const TPqaId iQuiz, const TPqaId iTarget, const TPqaAmount amount = 1) override final;
+  PqaError ReleaseQuiz(const TPqaId iQuiz) override final;
+
+  PqaError ClearOldQuizzes(const TPqaId maxCount, const double maxAgeSec) override final;
+  PqaError SetQuizExpiry(const TPqaId maxCount, const double maxAgeSec, const bool bBackgroundReaper) override final;
+  PqaError ReapQuizzes() override final;
+  PqaError SaveQuizzes(const char* const filePath) override final;
+  TPqaId LoadQuizzes(PqaError& err, const char* const filePath) override final;
+
+  PqaError SaveKB(const char* const filePath, const bool bDoubleBuffer) override final;
+  PqaError SaveIncremental() override final;
+  PqaError StartWal(const bool bWaitCommit) override final;
+  PqaError StopWal() override final;
+  PqaError SetCompressKB(const bool bCompress) override final;
+  PqaError StartCheckpointer(const CheckpointPolicy &policy) override final;
+  PqaError StopCheckpointer() override final;
+  PqaError GetCheckpointStats(CheckpointStats &stats) override final;
+  PqaError HotSwapKB(const char* const filePath) override final;
+  PqaError Warmup() override final;
+
+  PqaError StartMaintenance(const bool forceQuizzes) override final;
+  PqaError FinishMaintenance() override final;
+  PqaError AddQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
+    AddTargetParam *pAtps) override final;
+  PqaError RemoveQuestions(const TPqaId nQuestions, const TPqaId *pQIds) override final;
+  PqaError RemoveTargets(const TPqaId nTargets, const TPqaId *pTIds) override final;
+  PqaError Compact(CompactionResult &cr, const bool bOrderByWeight = false) override final;
+  PqaError CompactSlice(CompactionResult &cr, const TPqaId maxMoves) override final;
+
+  PqaError Shutdown(const char* const saveFilePath = nullptr) override final;
+  PqaError SetLogger(SRPlat::ISRLogger *pLogger) override final;
+};
+
+} // namespace ProbQA
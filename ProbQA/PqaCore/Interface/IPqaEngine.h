@@ -18,6 +18,15 @@ public:
   // |pAQs| can contain duplicate questions.
   virtual PqaError Train(const TPqaId nQuestions, const AnsweredQuestion* const pAQs, const TPqaId iTarget,
     const TPqaAmount amount = 1) = 0;
+  // Multiplies the amounts accumulated by the trainings so far by |factor|, so that with |factor| < 1 the older
+  //   training fades relative to the newer one. The probabilities the KB gives aren't changed by the decay itself. The
+  //   questions are decayed in slices of |maxSliceQuestions|, each holding the KB lock only for its own rows, or all
+  //   in one slice if |maxSliceQuestions| is not positive. Can be run in both regular and maintenance modes.
+  virtual PqaError DecayStatistics(const TPqaAmount factor, const TPqaId maxSliceQuestions = 0) = 0;
+  // Recomputes matrix D from matrix A with compensated summation, removing the rounding errors accumulated in D by the
+  //   trainings. Returns in |maxDrift| the maximum relative difference found between the old and the recomputed D.
+  //   The slices and the modes are as in DecayStatistics().
+  virtual PqaError RecomputeD(TPqaAmount &maxDrift, const TPqaId maxSliceQuestions = 0) = 0;
 
   //// Permanent-compact ID mappers
   virtual bool QuestionPermFromComp(const TPqaId count, TPqaId *pIds) = 0;
@@ -43,7 +52,8 @@ public:
 
   //// There must be no concurrent requests on the same quiz. This is not thread-safe.
 #pragma region Regular-only mode operations
-  // Returns new quiz ID.
+  // Returns new quiz ID. Quiz IDs are opaque non-negative numbers: a released quiz ID doesn't become valid again when
+  //   the registry reuses its slot for another quiz.
   virtual TPqaId StartQuiz(PqaError& err) = 0;
   // Start a new quiz with the given answers applied.
   // Returns quiz ID.
@@ -62,6 +72,9 @@ public:
   // Returns the number of targets written to the destination.
   // Returns -1 on error.
   virtual TPqaId ListTopTargets(PqaError& err, const TPqaId iQuiz, const TPqaId maxCount, RatedTarget *pDest) = 0;
+  // Evaluates all the questions against the priors of a fresh quiz and writes up to |maxCount| of them, the least
+  //   informative first, so to find the questions to remove. Returns the number of questions written, or -1 on error.
+  virtual TPqaId AnalyzeQuestions(PqaError& err, const TPqaId maxCount, QuestionInfo *pDest) = 0;
 
   // Can be called multiple times for different targets and at different stages in the quiz.
   virtual PqaError RecordQuizTarget(const TPqaId iQuiz, const TPqaId iTarget, const TPqaAmount amount = 1) = 0;
@@ -70,12 +83,82 @@ public:
 
   // Keep no more than |maxCount| most recent quizzes and release quizzes older than |maxAgeSec| seconds.
   virtual PqaError ClearOldQuizzes(const TPqaId maxCount, const double maxAgeSec) = 0;
+  // Set the limits for automatic expiry of quizzes: no more than |maxCount| most recently used quizzes are kept (-1 for
+  //   no limit), and quizzes not used for |maxAgeSec| seconds are released (0 for no limit). Quiz usage is tracked
+  //   with a resolution of about a second. The expiry happens in ReapQuizzes() calls, and when |bBackgroundReaper|
+  //   is true, also periodically in a background thread of the engine.
+  virtual PqaError SetQuizExpiry(const TPqaId maxCount, const double maxAgeSec, const bool bBackgroundReaper) = 0;
+  // Release the quizzes due for expiry according to the limits set in SetQuizExpiry(). The cost is proportional to
+  //   the number of quizzes expired, rather than to the number of all the quizzes.
+  virtual PqaError ReapQuizzes() = 0;
+  // Save the quizzes in progress: their answers, active questions, permanent IDs and prior probabilities of the
+  //   targets. There must be no concurrent operations on the quizzes, except the automatic expiry, which waits.
+  virtual PqaError SaveQuizzes(const char* const filePath) = 0;
+  // Restore the quizzes saved by SaveQuizzes(), e.g. after a restart, under their permanent IDs. Fails if there are any
+  //   quizzes in progress. The priors are taken from the file if the engine has the same precision and dimensions as
+  //   when they were saved, otherwise they are recomputed from the answers, as in ResumeQuiz().
+  // Returns the number of quizzes restored. |err| reports the quizzes that couldn't be restored, if any.
+  virtual TPqaId LoadQuizzes(PqaError& err, const char* const filePath) = 0;
 #pragma endregion
 
   // Save the knowledge base, but not the quizzes in progress.
   // Double buffer uses as much additional memory as the size of the KB, but reduces KB lock duration because the KB
   //   is only locked for the period of copying in memory to the buffer, then saving to disk proceeds without a lock.
+  // The CPU engine writes KB file format version 2, whose statistics sections are aligned for memory mapping on load,
+  //   or version 3 if SetCompressKB() is on.
+  //   Such a file becomes the base for SaveIncremental(). It ignores |bDoubleBuffer|: the KB is locked only for taking
+  //   a snapshot, then the statistics are written while the KB is in use. The rows of a question trained during the
+  //   save are copied before the change, so the additional memory is only for such rows. Maintenance operations wait
+  //   till the save finishes.
   virtual PqaError SaveKB(const char* const filePath, const bool bDoubleBuffer) = 0;
+  // Save only the parts of the KB changed since the base, i.e. the KB file last saved by SaveKB() in format version 2
+  //   or loaded from such a file, into the delta file named as the base with ".delta" appended. The delta is
+  //   cumulative and replaces the previous one. It is applied automatically when the base is loaded, and can be folded
+  //   into a new base with IPqaEngineFactory::FoldKBDelta().
+  // Fails if there is no base, or if the dimensions have changed since it was saved (by adding questions or targets
+  //   beyond the gaps, or by compaction): save the KB in full then.
+  virtual PqaError SaveIncremental() = 0;
+  // Start appending the operations changing the KB to the write-ahead log named as the base with ".wal" appended. The
+  //   operations in the log after the last save are replayed when the base is loaded, so that they survive a crash.
+  //   Training is replayed in parallel, thus the statistics may differ from the original in the last digits. Each
+  //   SaveKB() in format version 2 starts a new log for the new base.
+  // When |bWaitCommit| is true, the operations return only after their records are flushed to disk, otherwise the
+  //   records are flushed in the background shortly after. The records of concurrent operations are flushed at once.
+  // Fails if there is no base, or if the KB has changed since the last save without the log.
+  virtual PqaError StartWal(const bool bWaitCommit) = 0;
+  // Flush the write-ahead log and stop appending to it.
+  virtual PqaError StopWal() = 0;
+  // Make SaveKB() write KB file format version 3, whose regions of statistics are compressed independently in parallel,
+  //   or back format version 2. A compressed file is several times smaller for a sparsely trained KB, and it can be the
+  //   base for SaveIncremental() and StartWal() as well, but it's read into memory on load rather than mapped, and
+  //   IPqaEngineFactory::FoldKBDelta() doesn't support it. The CUDA engine ignores this setting.
+  virtual PqaError SetCompressKB(const bool bCompress) = 0;
+  // Start saving the KB in a background thread of the engine according to the policy, or replace the policy of the
+  //   scheduler already running. The checkpoints are full saves like SaveKB(), or incremental saves like
+  //   SaveIncremental() against the file of the policy. The scheduler uses only |_maxWorkers| of the worker threads, so
+  //   that the rest serve the queries meanwhile, and throttles the writes. The outcomes are logged.
+  // Saving in full to the file the KB was loaded from fails if the file is memory-mapped: make the checkpoints to
+  //   another file then.
+  virtual PqaError StartCheckpointer(const CheckpointPolicy &policy) = 0;
+  // Stop the scheduler, waiting for the checkpoint in progress, if any.
+  virtual PqaError StopCheckpointer() = 0;
+  virtual PqaError GetCheckpointStats(CheckpointStats &stats) = 0;
+
+  // Load the KB from the file and switch the engine to it without interrupting the service: the new quizzes start on
+  //   the new KB once it's loaded and warmed up, while the quizzes in progress continue on the old KB. The old KB is
+  //   released when its last quiz is released or expired, or at the next hot swap, which releases its remaining
+  //   quizzes. The call returns when the new KB is in service.
+  // Only supported by the engines loaded with IPqaEngineFactory::LoadHotSwapCpuEngine(). The operations other than
+  //   the quiz operations concern the KB in service, with these exceptions: the quiz expiry settings, the logger and
+  //   SetCompressKB() carry over to the new KB, while the write-ahead log and the checkpoint scheduler of the old KB
+  //   are stopped. RecordQuizTarget() on a quiz of the old KB trains the old KB, which is then discarded, and
+  //   SaveQuizzes() saves only the quizzes of the KB in service.
+  virtual PqaError HotSwapKB(const char* const filePath) = 0;
+  // Bring the engine to the steady-state latency before the first users come: touch all the pages of the KB in
+  //   parallel, so that they are resident, then run a synthetic quiz through the kernels of the quiz operations, which
+  //   starts the worker threads and primes their stacks and the lookup tables. The synthetic quiz doesn't count in
+  //   GetTotalQuestionsAsked() and doesn't train the KB.
+  virtual PqaError Warmup() = 0;
 
   // When |forceQuizzes|=false, the function fails if there are any quizzes in progress.
   // When |forceQuizzes|=true, the function closes all the open quizzes.
@@ -94,6 +177,9 @@ public:
   //   is used and the initial amount for the target is ignored.
   // In |pAqps| and |pAtps| the client code passes initial amounts and receives back IDs of questions and targets
   //   added.
+  // Unlike the other operations here, this one is allowed in regular mode too. There the questions and targets are
+  //   appended rather than placed at the gaps, while the other operations wait. The quizzes in progress grow to them
+  //   when used next time, the new targets getting the priors of a fresh quiz.
   virtual PqaError AddQsTs(const TPqaId nQuestions, AddQuestionParam *pAqps, const TPqaId nTargets,
     AddTargetParam *pAtps) = 0;
   virtual PqaError RemoveQuestions(const TPqaId nQuestions, const TPqaId *pQIds) = 0;
@@ -103,7 +189,13 @@ public:
   // Fills the CompactionResult structure passed in. A call to ReleaseCompactionResult() is needed to release the
   //   resources after usage of the structure.
   //TODO: make this obligatory before exiting the maintenance mode? So to forbid gaps in regular mode.
-  virtual PqaError Compact(CompactionResult &cr) = 0;
+  // With |bOrderByWeight|, the targets are then ordered by descending weight in B, so that the likely targets of a quiz
+  //   are adjacent in memory.
+  virtual PqaError Compact(CompactionResult &cr, const bool bOrderByWeight = false) = 0;
+  // Same as Compact(), but moves at most |maxMoves| targets to the gaps, so to keep the time in exclusive lock bounded
+  //   on a large KB. The targets are taken from the end, and the trailing gaps are cut off. The questions are compacted
+  //   completely, as it doesn't move the statistics. Call it again till |cr._nTargetGaps| is 0.
+  virtual PqaError CompactSlice(CompactionResult &cr, const TPqaId maxMoves) = 0;
 #pragma endregion
 
   //// Control operations
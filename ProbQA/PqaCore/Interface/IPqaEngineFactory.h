@@ -15,14 +15,27 @@ class PQACORE_API IPqaEngineFactory {
 public:
   // Usual computing on a CPU.
   virtual IPqaEngine* CreateCpuEngine(PqaError& err, const EngineDefinition& engDef) = 0;
+  // A KB in file format version 2 is mapped into memory copy-on-write rather than read, so the file stays open and
+  //   can't be overwritten while the engine is alive. Save the KB to another path then.
+  // With |bWarmup|=true, calls IPqaEngine::Warmup() before returning the engine, and fails if it fails.
   virtual IPqaEngine* LoadCpuEngine(PqaError& err, const char* const filePath,
-    size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes) = 0;
+    size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes, const bool bWarmup = false) = 0;
+
+  // Same as LoadCpuEngine(), but the engine supports IPqaEngine::HotSwapKB(). Each KB loaded into it later uses
+  //   |memPoolMaxBytes| too, and is always warmed up.
+  virtual IPqaEngine* LoadHotSwapCpuEngine(PqaError& err, const char* const filePath,
+    size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes, const bool bWarmup = false) = 0;
 
   // Computing on a graphics card with CUDA technology.
   virtual IPqaEngine* CreateCudaEngine(PqaError& err, const EngineDefinition& engDef) = 0;
   virtual IPqaEngine* LoadCudaEngine(PqaError& err, const char* const filePath,
     size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes) = 0;
 
+  // Writes a new base KB file at |destPath| from the base KB file at |basePath| with its delta file applied, see
+  //   IPqaEngine::SaveIncremental(). The base and the delta files are left intact. An uncompressed base is patched in
+  //   a copy without loading an engine, while a compressed one is loaded into a CPU engine and saved compressed.
+  virtual PqaError FoldKBDelta(const char* const basePath, const char* const destPath) = 0;
+
   // Grid computing over a network
   virtual IPqaEngine* CreateGridEngine(PqaError& err, const EngineDefinition& engDef) = 0;
 };
@@ -34,11 +34,28 @@ typedef struct {
   double _prob; // probability that this target is what the user needs
 } CiRatedTarget;
 
+typedef struct {
+  int64_t _iQuestion;
+  double _infoGain; // expected entropy decrease in bits at the priors of a fresh quiz
+  double _selectionProb; // probability of selecting it as the first question
+  int64_t _iRedundantWith; // a more informative question splitting the targets identically, or -1
+} CiQuestionInfo;
+
 typedef struct {
   int64_t _index;
   double _initAmount;
 } CiAddQorTParam; // The parameter for adding a question or target
 
+typedef struct {
+  int64_t _lastTimeSec;
+  uint64_t _lastBytes;
+  double _lastDurationSec;
+  uint8_t _bLastIncremental;
+  uint8_t _bInProgress;
+  uint64_t _nCheckpoints;
+  uint64_t _nFailures;
+} CiCheckpointStats;
+
 #pragma pack(pop)
 
 #ifdef __cplusplus
@@ -54,6 +71,10 @@ PQACORE_API void* CiGetPqaEngineFactory();
 PQACORE_API void* PqaEngineFactory_CreateCpuEngine(void* pvFactory, void **ppError, const CiEngineDefinition *pEngDef);
 PQACORE_API void* PqaEngineFactory_LoadCpuEngine(void *pvFactory, void **ppError, const char* filePath,
   uint64_t memPoolMaxBytes);
+PQACORE_API void* PqaEngineFactory_LoadHotSwapCpuEngine(void *pvFactory, void **ppError, const char* filePath,
+  uint64_t memPoolMaxBytes);
+PQACORE_API void* PqaEngineFactory_FoldKBDelta(void *pvFactory, const char* const basePath,
+  const char* const destPath);
 
 PQACORE_API void CiReleasePqaError(void *pvErr);
 PQACORE_API void* PqaError_ToString(void *pvError, const uint8_t withParams);
@@ -61,6 +82,9 @@ PQACORE_API void* PqaError_ToString(void *pvError, const uint8_t withParams);
 PQACORE_API void CiReleasePqaEngine(void *pvEngine);
 PQACORE_API void* PqaEngine_Train(void *pvEngine, int64_t nQuestions, const CiAnsweredQuestion* const pAQs,
   const int64_t iTarget, const double amount = 1.0);
+PQACORE_API void* PqaEngine_DecayStatistics(void *pvEngine, const double factor,
+  const int64_t maxSliceQuestions = 0);
+PQACORE_API void* PqaEngine_RecomputeD(void *pvEngine, double *pMaxDrift, const int64_t maxSliceQuestions = 0);
 
 PQACORE_API uint8_t PqaEngine_QuestionPermFromComp(void *pvEngine, const int64_t count, int64_t *pIds);
 PQACORE_API uint8_t PqaEngine_QuestionCompFromPerm(void *pvEngine, const int64_t count, int64_t *pIds);
@@ -83,16 +107,33 @@ PQACORE_API int64_t PqaEngine_NextQuestion(void *pvEngine, void **ppError, const
 PQACORE_API void* PqaEngine_RecordAnswer(void *pvEngine, const int64_t iQuiz, const int64_t iAnswer);
 
 PQACORE_API void* PqaEngine_ClearOldQuizzes(void *pvEngine, const int64_t maxCount, const double maxAgeSec);
+PQACORE_API void* PqaEngine_SetQuizExpiry(void *pvEngine, const int64_t maxCount, const double maxAgeSec,
+  const uint8_t bBackgroundReaper);
+PQACORE_API void* PqaEngine_ReapQuizzes(void *pvEngine);
 
 PQACORE_API int64_t PqaEngine_GetActiveQuestionId(void *pvEngine, void **ppError, const int64_t iQuiz);
 PQACORE_API void* PqaEngine_SetActiveQuestion(void *pvEngine, const int64_t iQuiz, const int64_t iQuestion);
 
 PQACORE_API int64_t PqaEngine_ListTopTargets(void *pvEngine, void **ppError, const int64_t iQuiz,
   const int64_t maxCount, CiRatedTarget *pDest);
+PQACORE_API int64_t PqaEngine_AnalyzeQuestions(void *pvEngine, void **ppError, const int64_t maxCount,
+  CiQuestionInfo *pDest);
 PQACORE_API void* PqaEngine_RecordQuizTarget(void *pvEngine, const int64_t iQuiz, const int64_t iTarget,
   const double amount = 1.0);
 PQACORE_API void* PqaEngine_ReleaseQuiz(void *pvEngine, const int64_t iQuiz);
 PQACORE_API void* PqaEngine_SaveKB(void *pvEngine, const char* const filePath, const uint8_t bDoubleBuffer);
+PQACORE_API void* PqaEngine_SaveIncremental(void *pvEngine);
+PQACORE_API void* PqaEngine_StartWal(void *pvEngine, const bool bWaitCommit);
+PQACORE_API void* PqaEngine_StopWal(void *pvEngine);
+PQACORE_API void* PqaEngine_SetCompressKB(void *pvEngine, const bool bCompress);
+PQACORE_API void* PqaEngine_StartCheckpointer(void *pvEngine, const char* const filePath, const double intervalSec,
+  const uint64_t nTrainings, const uint32_t maxIncremental, const double maxBytesPerSec, const uint32_t maxWorkers);
+PQACORE_API void* PqaEngine_StopCheckpointer(void *pvEngine);
+PQACORE_API void* PqaEngine_GetCheckpointStats(void *pvEngine, CiCheckpointStats *pStats);
+PQACORE_API void* PqaEngine_HotSwapKB(void *pvEngine, const char* const filePath);
+PQACORE_API void* PqaEngine_Warmup(void *pvEngine);
+PQACORE_API void* PqaEngine_SaveQuizzes(void *pvEngine, const char* const filePath);
+PQACORE_API int64_t PqaEngine_LoadQuizzes(void *pvEngine, void **ppError, const char* const filePath);
 
 //// Second batch of interop implementation
 PQACORE_API void* PqaEngine_StartMaintenance(void *pvEngine, const bool forceQuizzes);
@@ -102,7 +143,11 @@ PQACORE_API void* PqaEngine_AddQsTs(void *pvEngine, const int64_t nQuestions, Ci
 PQACORE_API void* PqaEngine_RemoveQuestions(void *pvEngine, const int64_t nQuestions, const int64_t *pQIds);
 PQACORE_API void* PqaEngine_RemoveTargets(void *pvEngine, const int64_t nTargets, const int64_t *pTIds);
 PQACORE_API void* PqaEngine_Compact(void *pvEngine, int64_t *pnQuestions, int64_t const ** const ppOldQuestions,
-  int64_t *pnTargets, int64_t const ** const ppOldTargets);
+  int64_t *pnTargets, int64_t const ** const ppOldTargets, const bool bOrderByWeight = false);
+// The old ID of a target gap left by the slice is -1.
+PQACORE_API void* PqaEngine_CompactSlice(void *pvEngine, const int64_t maxMoves, int64_t *pnQuestions,
+  int64_t const ** const ppOldQuestions, int64_t *pnTargets, int64_t const ** const ppOldTargets,
+  int64_t *pnTargetGaps);
 PQACORE_API void CiReleaseCompaction(const int64_t *p);
 PQACORE_API void* PqaEngine_Shutdown(void *pvEngine, const char* const saveFilePath = nullptr);
 PQACORE_API void* PqaEngine_SetLogger(void *pvEngine, void *pSRLogger);
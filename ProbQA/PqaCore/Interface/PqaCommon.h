@@ -60,6 +60,17 @@ struct RatedTarget {
   }
 };
 
+struct QuestionInfo {
+  TPqaId _iQuestion;
+  // The expected decrease of the entropy (in bits) over the targets on answering this question at the priors of a fresh
+  //   quiz.
+  TPqaAmount _infoGain;
+  // The probability that this question is selected as the first one in a fresh quiz.
+  TPqaAmount _selectionProb;
+  // A more informative question, which splits the targets by their most likely answer identically, or cInvalidPqaId.
+  TPqaId _iRedundantWith;
+};
+
 struct CompactionResult {
   //// New counts of targets and questions
   TPqaId _nTargets = cInvalidPqaId;
@@ -67,6 +78,8 @@ struct CompactionResult {
   //// i-th item contains the old id for the new id=i
   TPqaId *_pOldTargets = nullptr;
   TPqaId *_pOldQuestions = nullptr;
+  // The gaps left among the targets by a compaction in slices. The old id of such a target is cInvalidPqaId.
+  TPqaId _nTargetGaps = 0;
 
   ~CompactionResult() {
     _mm_free(_pOldTargets);
@@ -100,4 +113,25 @@ struct AddTargetParam {
   }
 };
 
+// When the background checkpoint scheduler saves the KB. At least one of the triggers must be set.
+struct CheckpointPolicy {
+  const char *_filePath = nullptr; // the engine keeps a copy of it
+  double _intervalSec = 0; // 0 for no trigger by time
+  uint64_t _nTrainings = 0; // the number of Train() and RecordQuizTarget() calls to trigger, 0 for no such trigger
+  // The number of incremental saves against the base file before saving it in full again, 0 to always save in full.
+  uint32_t _maxIncremental = 0;
+  double _maxBytesPerSec = 0; // the limit of the write rate, 0 for no limit
+  uint32_t _maxWorkers = 1; // the number of worker threads to save with, 0 for all the workers of the engine
+};
+
+struct CheckpointStats {
+  int64_t _lastTimeSec = 0; // the time of the last successful checkpoint since the Unix epoch, 0 if none yet
+  uint64_t _lastBytes = 0; // the size of the file written in the last successful checkpoint
+  double _lastDurationSec = 0;
+  bool _bLastIncremental = false;
+  bool _bInProgress = false;
+  uint64_t _nCheckpoints = 0; // successful ones
+  uint64_t _nFailures = 0;
+};
+
 } // namespace ProbQA
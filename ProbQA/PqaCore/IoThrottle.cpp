@@ -0,0 +1,30 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/IoThrottle.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+IoThrottle::IoThrottle(const double maxBytesPerSec) : _msPerByte(1000 / maxBytesPerSec),
+  _paidUntilMs(double(GetTickCount64()))
+{ }
+
+void IoThrottle::Consume(const uint64_t nBytes) {
+  const double nowMs = double(GetTickCount64());
+  double sleepMs;
+  {
+    SRLock<SRCriticalSection> csl(_cs);
+    // Don't accumulate the credit for the idle time, otherwise a burst would follow it.
+    _paidUntilMs = std::max(_paidUntilMs, nowMs) + nBytes * _msPerByte;
+    sleepMs = _paidUntilMs - nowMs;
+  }
+  if (sleepMs >= 1) {
+    Sleep(DWORD(std::min(sleepMs, double(INFINITE - 1))));
+  }
+}
+
+} // namespace ProbQA
@@ -0,0 +1,26 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+namespace ProbQA {
+
+// Limits the rate of writing by multiple threads: each write is paid off by a sleep of the writer, so that on average
+//   no more than the given number of bytes is written per second. Thread-safe.
+class IoThrottle {
+  SRPlat::SRCriticalSection _cs;
+  const double _msPerByte;
+  double _paidUntilMs; // in terms of GetTickCount64(). Guarded by _cs
+
+public: // methods
+  explicit IoThrottle(const double maxBytesPerSec);
+  IoThrottle(const IoThrottle&) = delete;
+  IoThrottle& operator=(const IoThrottle&) = delete;
+
+  // Sleeps for as long as the writing of |nBytes| just done takes at the rate limit, minus the time the rate has been
+  //   below the limit.
+  void Consume(const uint64_t nBytes);
+};
+
+} // namespace ProbQA
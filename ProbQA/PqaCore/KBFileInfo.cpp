@@ -0,0 +1,151 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/KBFileInfo.h"
+#include "../PqaCore/Interface/PqaErrorParams.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+namespace {
+  uint64_t AlignSectionOffset(const uint64_t offset) {
+    return (offset + KBFileHeader::_cSectionAlign - 1) & ~(KBFileHeader::_cSectionAlign - 1);
+  }
+}
+
+uint64_t KBFileHeader::NRows(const KBSection ks) const {
+  switch (ks) {
+  case KBSection::A:
+    return uint64_t(_dims._nQuestions) * uint64_t(_dims._nAnswers);
+  case KBSection::D:
+    return uint64_t(_dims._nQuestions);
+  case KBSection::B:
+    return 1;
+  default:
+    assert(false);
+    return 0;
+  }
+}
+
+uint64_t KBFileHeader::NTotalRegions() const {
+  uint64_t total = 0;
+  for (uint8_t i = 0; i < uint8_t(KBSection::StatsLim); i++) {
+    total += NRegions(KBSection(i));
+  }
+  return total;
+}
+
+void KBFileHeader::LocateRegion(uint64_t iRegion, KBSection &ks, uint64_t &iFirstRow, uint64_t &iLimRow) const {
+  for (uint8_t i = 0; i < uint8_t(KBSection::StatsLim); i++) {
+    const uint64_t nRegions = NRegions(KBSection(i));
+    if (iRegion < nRegions) {
+      ks = KBSection(i);
+      iFirstRow = iRegion * _rowsPerRegion;
+      iLimRow = std::min(iFirstRow + _rowsPerRegion, NRows(ks));
+      return;
+    }
+    iRegion -= nRegions;
+  }
+  assert(false);
+}
+
+void KBFileHeader::QuestionsOfRows(const KBSection ks, const uint64_t iFirstRow, const uint64_t iLimRow,
+  uint64_t &iFirstQ, uint64_t &iLimQ) const
+{
+  switch (ks) {
+  case KBSection::A:
+    iFirstQ = iFirstRow / uint64_t(_dims._nAnswers);
+    iLimQ = SRMath::PosDivideRoundUp(iLimRow, uint64_t(_dims._nAnswers));
+    break;
+  case KBSection::D:
+    iFirstQ = iFirstRow;
+    iLimQ = iLimRow;
+    break;
+  default:
+    iFirstQ = iLimQ = 0;
+    break;
+  }
+}
+
+void KBFileHeader::LayOutStatistics(const uint64_t rowStride) {
+  _rowStride = rowStride;
+  _rowsPerRegion = std::max<uint64_t>(1, _cRegionBytes / rowStride);
+  if (IsCompressed()) {
+    for (uint8_t i = 0; i < uint8_t(KBSection::StatsLim); i++) {
+      _sections[i]._offset = 0;
+      _sections[i]._nBytes = NRows(KBSection(i)) * rowStride;
+      _sections[i]._checksum = 0;
+    }
+    KBFileSection &index = Section(KBSection::Checksums);
+    index._offset = 0;
+    index._nBytes = NTotalRegions() * sizeof(KBCompressedRegion);
+    index._checksum = 0;
+    return;
+  }
+  uint64_t offset = _cSectionAlign; // after the header
+  for (uint8_t i = 0; i < uint8_t(KBSection::StatsLim); i++) {
+    KBFileSection &section = _sections[i];
+    section._offset = offset;
+    section._nBytes = NRows(KBSection(i)) * rowStride;
+    section._checksum = 0;
+    offset = AlignSectionOffset(offset + section._nBytes);
+  }
+  KBFileSection &checksums = Section(KBSection::Checksums);
+  checksums._offset = offset;
+  checksums._nBytes = NTotalRegions() * sizeof(uint32_t);
+  checksums._checksum = 0;
+}
+
+uint64_t KBFileHeader::MetaOffset() const {
+  if (IsCompressed()) {
+    return sizeof(KBFileHeader);
+  }
+  const KBFileSection &checksums = Section(KBSection::Checksums);
+  return AlignSectionOffset(checksums._offset + checksums._nBytes);
+}
+
+uint64_t KBFileHeader::NewCheckpointId() {
+  std::random_device rd;
+  uint64_t id;
+  do {
+    id = (uint64_t(rd()) << 32) | rd();
+  } while (id == 0);
+  return id;
+}
+
+PqaError KBFileInfo::OpenDelta() {
+  const std::string deltaPath = KBDeltaHeader::PathFor(_filePath);
+  _deltaSf.Set(std::fopen(deltaPath.c_str(), "rb"));
+  if (_deltaSf.Get() == nullptr) {
+    return PqaError(); // no delta file
+  }
+  if (std::fread(&_delta, sizeof(_delta), 1, _deltaSf.Get()) != 1 || _delta._magic != KBDeltaHeader::_cMagic) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRString::MakeUnowned(
+      SR_FILE_LINE "Can't read the header of KB delta file."));
+  }
+  if (_delta._formatVersion != KBDeltaHeader::_cVersion || _delta._headerBytes != sizeof(_delta)) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRMessageBuilder(SR_FILE_LINE
+      "Unsupported KB delta file format version ")(_delta._formatVersion)(" with header size ")(_delta._headerBytes)
+      .GetOwnedSRString());
+  }
+  if (_delta._baseCheckpointId != _header._checkpointId) {
+    // A leftover of an older base saved to the same path.
+    SRDefaultLogger::Get()->Log(ISRLogger::Severity::Warning, SRMessageBuilder(SR_FILE_LINE "Ignoring KB delta file ")
+      (deltaPath)(" made against another base.").GetUnownedSRString());
+    _deltaSf.Set(nullptr);
+    return PqaError();
+  }
+  if (memcmp(&_delta._dims, &_header._dims, sizeof(_header._dims)) != 0
+    || _delta._nRegions > _header.NTotalRegions()
+    || _delta._index._nBytes != _delta._nRegions * sizeof(KBDeltaRegion))
+  {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRString::MakeUnowned(
+      SR_FILE_LINE "KB delta file doesn't match the dimensions of its base."));
+  }
+  return PqaError();
+}
+
+} // namespace ProbQA
@@ -4,12 +4,195 @@
 
 #pragma once
 
+#include "../PqaCore/Interface/PqaCommon.h"
+#include "../PqaCore/Interface/PqaErrors.h"
+
 namespace ProbQA {
 
+class IoThrottle;
+
+// Format version 1 has no header: it's a sequential dump of the precision, dimensions, number of questions asked,
+//   statistics, gaps and ID mappings.
+// Format version 2 starts with this header, followed by the sections aligned to the allocation granularity, so that
+//   the statistics can be memory-mapped and used by the engine in place. Each row of targets is padded with zeros to
+//   the SIMD size. Gaps and ID mappings are stored in the meta section in the same way as in format version 1.
+// The rows of the statistics sections are grouped into regions, which are written, read and checksummed
+//   independently, in parallel. The checksums section holds the CRC-32C of each region, in the order of the sections.
+// Format version 3 has the same header and regions, but each region is shuffled by bytes of the numbers and compressed
+//   independently, see SRCompression, so that the regions are compressed and decompressed in parallel. The meta
+//   section follows the header, then the compressed regions in any order. The sections of statistics have zero offsets
+//   and their uncompressed sizes. The checksums section is replaced by the region index at the end of the file, which
+//   gives the location of each compressed region, thus any region can still be read alone.
+struct KBFileSection {
+  uint64_t _offset;
+  uint64_t _nBytes;
+  // CRC-32C of the checksums section (the region index in format version 3). Zero for the other sections, which are
+  //   either covered by the region checksums, or not checksummed (meta).
+  uint64_t _checksum;
+};
+
+enum class KBSection : uint8_t {
+  A = 0,
+  D = 1,
+  B = 2,
+  Checksums = 3,
+  Meta = 4,
+  Count,
+  StatsLim = Checksums // The sections of statistics precede this one.
+};
+
+struct KBFileHeader {
+  static constexpr uint64_t _cMagic = 0x3276424B41515250; // "PRQAKBv2" in little-endian
+  static constexpr uint32_t _cLegacyVersion = 1;
+  static constexpr uint32_t _cSectionedVersion = 2;
+  static constexpr uint32_t _cCompressedVersion = 3;
+  static constexpr uint64_t _cSectionAlign = SRPlat::SRMemMappedFile::_cAllocGranularity;
+  // Regions are made of the rows fitting this size, but no less than 1 row.
+  static constexpr uint64_t _cRegionBytes = uint64_t(1) << 22;
+
+  uint64_t _magic;
+  uint32_t _formatVersion;
+  uint32_t _headerBytes;
+  PrecisionDefinition _prec;
+  EngineDimensions _dims;
+  uint64_t _nQuestionsAsked;
+  // Random identifier of this save, so that a delta file is only applied to the base it was made against.
+  uint64_t _checkpointId;
+  // LSN of the last record of the write-ahead log included in this file, see WalFileHeader.
+  uint64_t _walLsn;
+  uint64_t _rowStride; // in bytes
+  uint64_t _rowsPerRegion;
+  KBFileSection _sections[size_t(KBSection::Count)];
+
+  KBFileSection& Section(const KBSection ks) { return _sections[size_t(ks)]; }
+  const KBFileSection& Section(const KBSection ks) const { return _sections[size_t(ks)]; }
+
+  // The number of rows in a section of statistics, according to the dimensions.
+  uint64_t NRows(const KBSection ks) const;
+  uint64_t NRegions(const KBSection ks) const {
+    return SRPlat::SRMath::PosDivideRoundUp(NRows(ks), _rowsPerRegion);
+  }
+  uint64_t NTotalRegions() const;
+  // Finds the section and the rows of a region given its index over all the sections of statistics.
+  void LocateRegion(uint64_t iRegion, KBSection &ks, uint64_t &iFirstRow, uint64_t &iLimRow) const;
+  // The range of questions owning the rows of a section of statistics. Empty for B, which is not per question.
+  void QuestionsOfRows(const KBSection ks, const uint64_t iFirstRow, const uint64_t iLimRow, uint64_t &iFirstQ,
+    uint64_t &iLimQ) const;
+  // Sets the row stride, the region size, and the offsets and sizes of the sections except meta. In format version 3,
+  //   the offset of the region index is only known after the regions are written.
+  void LayOutStatistics(const uint64_t rowStride);
+  // The offset of the meta section, which follows the others, or the header in format version 3.
+  uint64_t MetaOffset() const;
+  bool IsCompressed() const { return _formatVersion == _cCompressedVersion; }
+
+  static uint64_t NewCheckpointId();
+};
+
+static_assert(sizeof(KBFileHeader) <= KBFileHeader::_cSectionAlign, "The header must fit before the first section.");
+
+// An entry of the region index of KB file format version 3, in the order of the regions.
+struct KBCompressedRegion {
+  uint64_t _offset;
+  uint64_t _nBytes; // compressed
+  uint32_t _checksum; // CRC-32C of the region uncompressed, as in the checksums section of format version 2
+  uint32_t _reserved;
+};
+
+// A delta file holds the regions of statistics changed since a base KB file in format version 2 was saved, and the
+//   meta section as of the delta. It is cumulative: each incremental save rewrites it with all the regions changed
+//   since the base. The file starts with this header, followed by the region index, the regions in the order of the
+//   index, and the meta section.
+struct KBDeltaRegion {
+  uint64_t _iRegion; // over all the sections of statistics in the base
+  uint64_t _offset; // in the delta file
+  uint32_t _checksum; // CRC-32C of the region
+  uint32_t _reserved;
+};
+
+struct KBDeltaHeader {
+  static constexpr uint64_t _cMagic = 0x6C64424B41515250; // "PRQAKBdl" in little-endian
+  static constexpr uint32_t _cVersion = 1;
+
+  uint64_t _magic;
+  uint32_t _formatVersion;
+  uint32_t _headerBytes;
+  uint64_t _baseCheckpointId;
+  EngineDimensions _dims; // Must match the base.
+  uint64_t _nQuestionsAsked;
+  uint64_t _walLsn; // of the last record included in the delta
+  uint64_t _nRegions;
+  KBFileSection _index; // The checksum is CRC-32C of the index.
+  KBFileSection _meta;
+
+  // The delta file is named after the base file.
+  static std::string PathFor(const char* const basePath) { return std::string(basePath) + ".delta"; }
+};
+
+// A quiz file holds the quizzes in progress, so that they survive a restart of the engine. It starts with this
+//   header, followed by a record per quiz, each followed by its answers and then by its prior mantissas, if the quiz
+//   has its own priors.
+struct QuizFileHeader {
+  static constexpr uint64_t _cMagic = 0x31765A5141515250; // "PRQAQZv1" in little-endian
+  static constexpr uint32_t _cVersion = 1;
+
+  uint64_t _magic;
+  uint32_t _formatVersion;
+  uint32_t _headerBytes;
+  // The priors are only restored from the file if the precision and the dimensions of the engine are the same.
+  PrecisionDefinition _prec;
+  EngineDimensions _dims;
+  uint64_t _priorBytes; // of a quiz having its own priors
+  uint64_t _nQuizzes;
+  TPqaId _nextPermId; // of the quizzes, so that the quizzes started after the restore don't reuse the permanent IDs
+};
+
+struct QuizFileRecord {
+  TPqaId _permId;
+  TPqaId _activeQuestion;
+  TPqaId _nAnswered;
+  // The quizzes that haven't got any answers yet refer to the priors shared by such quizzes.
+  uint8_t _bOwnPriors;
+  uint8_t _reserved[3];
+  // CRC-32C of the answers and the priors, continued from the CRC-32C of this record with zero in place of the
+  //   checksum.
+  uint32_t _checksum;
+};
+
 struct KBFileInfo {
   SRPlat::SRSmartFile &_sf;
   const char* const _filePath;
-  KBFileInfo(SRPlat::SRSmartFile &sf, const char* const filePath) : _sf(sf), _filePath(filePath) { }
+  uint32_t _formatVersion;
+  KBFileHeader _header; // Only for the sectioned format.
+  // The delta file applied on top of the sectioned format, if any.
+  SRPlat::SRSmartFile _deltaSf;
+  KBDeltaHeader _delta;
+  //// The limits of a save by the checkpoint scheduler, so that it takes less from serving the queries.
+  IoThrottle *_pThrottle = nullptr;
+  SRPlat::SRThreadCount _maxWorkers = 0; // 0 for all the workers
+  // Whether an engine loading the KB also replays the write-ahead log, rather than only applying the delta.
+  bool _bReplayWal = true;
+
+  KBFileInfo(SRPlat::SRSmartFile &sf, const char* const filePath,
+    const uint32_t formatVersion = KBFileHeader::_cLegacyVersion)
+    : _sf(sf), _filePath(filePath), _formatVersion(formatVersion), _header(), _delta()
+  { }
+
+  bool IsSectioned() const { return _formatVersion >= KBFileHeader::_cSectionedVersion; }
+  bool IsCompressed() const { return _formatVersion == KBFileHeader::_cCompressedVersion; }
+  bool HasDelta() { return _deltaSf.Get() != nullptr; }
+  // The number of subtasks to save the regions with.
+  SRPlat::SRThreadCount SaveWorkers(const SRPlat::SRThreadCount nAll) const {
+    return (_maxWorkers == 0) ? nAll : std::min(nAll, _maxWorkers);
+  }
+  // The gaps and ID mappings are read from the delta file, if any.
+  FILE* MetaFile() { return HasDelta() ? _deltaSf.Get() : _sf.Get(); }
+
+  // Opens the delta file of this base KB file and reads its header, unless there is no delta file made against this
+  //   base. The header of the base must have been read.
+  PqaError OpenDelta();
+
+  int64_t Tell() { return _ftelli64(_sf.Get()); }
+  bool Seek(const uint64_t pos) { return _fseeki64(_sf.Get(), int64_t(pos), SEEK_SET) == 0; }
 };
 
 } // namespace ProbQA
@@ -10,39 +10,112 @@ using namespace SRPlat;
 
 namespace ProbQA {
 
-MaintenanceSwitch::MaintenanceSwitch(Mode initMode) : _curMode(static_cast<uint64_t>(initMode)), 
-  _nUsing(0), _bModeChangeRequested(0), _bShutdownRequested(0)
+namespace {
+  std::atomic<uint32_t> gNextThreadSlot = 0;
+}
+
+MaintenanceSwitch::MaintenanceSwitch(Mode initMode) : _bGateClosed(false), _curMode(initMode),
+  _bModeChangeRequested(0), _bShutdownRequested(0), _bPauseRequested(0)
 {
+}
+
+uint32_t MaintenanceSwitch::GetThreadSlot() {
+  // Assign slots round-robin on the first use by a thread, so that the threads don't collide till there are more
+  //   of them than the slots.
+  thread_local const uint32_t tlSlot = gNextThreadSlot.fetch_add(1, std::memory_order_relaxed) & (_cNSlots - 1);
+  return tlSlot;
+}
+
+bool MaintenanceSwitch::DecUsing() {
+  _slots[GetThreadSlot()]._nUsing.fetch_sub(1, std::memory_order_seq_cst);
+  // The switcher closes the gate before summing the counters, so either it sees the decrement above, or we see the
+  //   gate closed here.
+  return _bGateClosed.load(std::memory_order_seq_cst);
+}
 
+void MaintenanceSwitch::NotifyCanSwitch() {
+  {
+    // Ensure the switcher is either waiting on the condition variable or hasn't summed the counters yet.
+    SRLock<SRCriticalSection> csl(_cs);
+  }
+  _canSwitch.WakeAll(); // switch and shutdown may be waiting simultaneously
+}
+
+int64_t MaintenanceSwitch::SumUsing() const {
+  int64_t sum = 0;
+  for (uint32_t i = 0; i < _cNSlots; i++) {
+    sum += _slots[i]._nUsing.load(std::memory_order_seq_cst);
+  }
+  return sum;
+}
+
+void MaintenanceSwitch::CloseGate() {
+  _bModeChangeRequested = 1;
+  _bGateClosed.store(true, std::memory_order_seq_cst);
+}
+
+void MaintenanceSwitch::ReopenGate() {
+  {
+    SRLock<SRCriticalSection> csl(_cs);
+    // The operations waiting for a pause to finish are let go even when shutting down, so that they get denied.
+    _bPauseRequested = 0;
+    _pauseOwner = std::thread::id();
+    if (!_bShutdownRequested) {
+      _bModeChangeRequested = 0;
+      _bGateClosed.store(false, std::memory_order_seq_cst);
+    }
+  }
+  _canEnter.WakeAll();
 }
 
 template <MaintenanceSwitch::Mode taMode> bool MaintenanceSwitch::TryEnterSpecific() {
+  if (IsOpenInOtherMode(taMode)) {
+    return false;
+  }
+  IncUsing();
+  if (!_bGateClosed.load(std::memory_order_seq_cst)) {
+    // Fast path: the mode can't change till we leave.
+    if (_curMode.load(std::memory_order_relaxed) == taMode) {
+      return true;
+    }
+  }
+  // The opposite mode is in effect, or a pause, a mode change or shutdown is in progress. Only a pause is waited for,
+  //   otherwise the operation is denied.
+  if (DecUsing()) {
+    NotifyCanSwitch();
+  }
+  // The gate may have been reopened meanwhile in the opposite mode.
+  if (IsOpenInOtherMode(taMode)) {
+    return false;
+  }
   SRLock<SRCriticalSection> csl(_cs);
-  if (static_cast<Mode>(_curMode) == taMode && !_bModeChangeRequested) {
-    _nUsing++;
+  if (IsPausedByThisThread()) {
+    // The operation of the pause, during which the mode can't change.
+    if (_curMode.load(std::memory_order_relaxed) != taMode) {
+      return false;
+    }
+    IncUsing();
     return true;
   }
-  else {
+  while (_bPauseRequested) {
+    _canEnter.Wait(_cs);
+  }
+  if (_bModeChangeRequested || _curMode.load(std::memory_order_relaxed) != taMode) {
     return false;
   }
+  // The gate can't get closed while we hold |_cs|, so the switcher will see this increment.
+  IncUsing();
+  return true;
 }
 
 template bool MaintenanceSwitch::TryEnterSpecific<MaintenanceSwitch::Mode::Maintenance>();
 template bool MaintenanceSwitch::TryEnterSpecific<MaintenanceSwitch::Mode::Regular>();
 
 template <MaintenanceSwitch::Mode taMode> void MaintenanceSwitch::LeaveSpecific() {
-  bool bWake = false;
-  {
-    SRLock<SRCriticalSection> csl(_cs);
-    assert(static_cast<Mode>(_curMode) == taMode);
-    assert(_nUsing >= 1);
-    if ((--_nUsing) == 0 && _bModeChangeRequested) {
-      // Notify of the possibility to switch mode now.
-      bWake = true;
-    }
-  }
-  if (bWake) {
-    _canSwitch.WakeAll(); // switch and shutdown may be waiting simultaneously
+  assert(_curMode.load(std::memory_order_relaxed) == taMode);
+  if (DecUsing()) {
+    // Notify of the possibility to switch mode now.
+    NotifyCanSwitch();
   }
 }
 
@@ -50,32 +123,35 @@ template void MaintenanceSwitch::LeaveSpecific<MaintenanceSwitch::Mode::Maintena
 template void MaintenanceSwitch::LeaveSpecific<MaintenanceSwitch::Mode::Regular>();
 
 MaintenanceSwitch::Mode MaintenanceSwitch::EnterAgnostic() {
+  IncUsing();
+  if (!_bGateClosed.load(std::memory_order_seq_cst)) {
+    return _curMode.load(std::memory_order_relaxed);
+  }
+  // Slow path: back off and wait till mode switch request is fullfilled.
+  if (DecUsing()) {
+    NotifyCanSwitch();
+  }
   SRLock<SRCriticalSection> csl(_cs);
-  // Wait till mode switch request is fullfilled.
   while(_bModeChangeRequested) {
     if (_bShutdownRequested) {
       csl.EarlyRelease();
       throw PqaException(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
         __FUNCTION__ " at enter")));
     }
+    if (IsPausedByThisThread()) {
+      break; // the operation of the pause
+    }
     _canEnter.Wait(_cs);
   }
-  _nUsing++;
-  return static_cast<Mode>(_curMode);
+  // The gate can't get closed while we hold |_cs|, so the switcher will see this increment.
+  IncUsing();
+  return _curMode.load(std::memory_order_relaxed);
 }
 
 void MaintenanceSwitch::LeaveAgnostic() {
-  bool bWake = false;
-  {
-    SRLock<SRCriticalSection> csl(_cs);
-    assert(_nUsing >= 1);
-    if ((--_nUsing) == 0 && _bModeChangeRequested) {
-      // Notify of the possibility to switch mode now.
-      bWake = true;
-    }
-  }
-  if (bWake) {
-    _canSwitch.WakeAll(); // switch and shutdown may be waiting simultaneously
+  if (DecUsing()) {
+    // Notify of the possibility to switch mode now.
+    NotifyCanSwitch();
   }
 }
 
@@ -84,9 +160,9 @@ bool MaintenanceSwitch::Shutdown() {
   if (_bShutdownRequested) {
     return false;
   }
-  _bModeChangeRequested = 1;
   _bShutdownRequested = 1;
-  while (_nUsing > 0) {
+  CloseGate();
+  while (SumUsing() > 0) {
     _canSwitch.Wait(_cs);
   }
   return true;
@@ -90,21 +90,63 @@ public: // types
     }
   };
 
+private: // types
+  // Entry counter of a group of threads. Padded to a cache line so that threads of different groups don't contend.
+  struct alignas(SRPlat::SRCpuInfo::_cacheLineBytes) UsageSlot {
+    // Signed because an operation may be left on a different thread than the one it was entered on. Only the sum
+    //   over all slots is meaningful.
+    std::atomic<int64_t> _nUsing = 0;
+  };
+
+private: // constants
+  static constexpr uint32_t _cLogNSlots = 6;
+  static constexpr uint32_t _cNSlots = uint32_t(1) << _cLogNSlots;
+
 private: // variables
+  UsageSlot _slots[_cNSlots]; // number of users of the current state - regular or maintenance
+  // Closed whenever a mode change or shutdown is requested. While it's open, entering is just an increment of the
+  //   counter in the slot of the current thread.
+  std::atomic<bool> _bGateClosed;
+  std::atomic<Mode> _curMode; // current mode - regular or maintenance. Changes only when the gate is closed.
   SRPlat::SRCriticalSection _cs;
   SRPlat::SRConditionVariable _canSwitch;
   SRPlat::SRConditionVariable _canEnter;
-  uint32_t _nUsing; // number of users of the current state - regular or maintenance
-  uint32_t _curMode : 2; // current mode - regular or maintenance
+  //// Guarded by _cs
   uint32_t _bModeChangeRequested : 1; // must be left |true| after shutdown
   uint32_t _bShutdownRequested : 1;
+  uint32_t _bPauseRequested : 1; // the gate is closed for a pause rather than a mode change
+  std::thread::id _pauseOwner; // the thread performing the operation of the pause, which may enter the mode paused
+
+private: // methods
+  static uint32_t GetThreadSlot();
+  void IncUsing() { _slots[GetThreadSlot()]._nUsing.fetch_add(1, std::memory_order_seq_cst); }
+  // Returns |true| if the caller must notify a pending mode switch or shutdown.
+  bool DecUsing();
+  void NotifyCanSwitch();
+  // Only meaningful when the gate is closed, because then the sum doesn't go to a non-zero value once zero.
+  int64_t SumUsing() const;
+  // Must be called with |_cs| locked.
+  void CloseGate();
+  // Ends a pause, if any, and publishes the current mode to the fast path, unless shut(ting) down. Wakes up the
+  //   waiters.
+  void ReopenGate();
+  // Whether the gate is open in a mode other than |mode|, so that an operation of |mode| can be denied without
+  //   locking |_cs|. Only a mode change can make it |mode|, and that closes the gate first.
+  bool IsOpenInOtherMode(const Mode mode) const {
+    return !_bGateClosed.load(std::memory_order_seq_cst) && _curMode.load(std::memory_order_relaxed) != mode;
+  }
+  // Must be called with |_cs| locked.
+  bool IsPausedByThisThread() const {
+    return _bPauseRequested && !_bShutdownRequested && _pauseOwner == std::this_thread::get_id();
+  }
 
 public: // methods
   static uint8_t ToUInt8(const Mode mode) { return static_cast<uint8_t>(mode); }
 
   explicit MaintenanceSwitch(Mode initMode);
   // Try to acquire the lock for a regular/maintenance-only operation, which delays the opposite mode until finished.
-  // If the opposite mode is in progress, this method fails returning |false|.
+  // If the opposite mode is in progress, this method fails returning |false|. During a pause of the mode requested,
+  //   it waits till the pause is over, unless called from the operation of the pause.
   // NOTE: it dowsn't throw even when shut(ting) down: it returns |false| in this case.
   template <Mode taMode> bool TryEnterSpecific();
   template <Mode taMode> void LeaveSpecific();
@@ -122,6 +164,12 @@ public: // methods
   // |sf| is the operation to perform in intraswitch mode (i.e. when noone else can obtain a lock).
   template <Mode taMode, typename taSimultaneous> SpecificLeaver<taMode> SwitchMode(const taSimultaneous& sf);
   template <Mode taMode> SpecificLeaver<taMode> SwitchMode() { return SwitchMode<taMode>([]() {}); }
+  // Deny new operations of the current mode and wait for current operations to finish, like a mode switch does, then
+  //   perform |sf| in intraswitch mode and stay in the current mode. The operations of the current mode requested
+  //   meanwhile are delayed rather than denied, except those of |sf| itself, i.e. of the calling thread.
+  // Throws if the current mode is not |taMode| or in the process of state change.
+  // Throws when shut(ting) down.
+  template <Mode taMode, typename taSimultaneous> void Pause(const taSimultaneous& sf);
   // Wait for completion of any current operations (except mode switch) and forbid starting any new operations in any
   //   mode. Concurrent switch operations throw and may do this a little later than when this method returns.
   // Returns |true| if shutdown has happened in the current call. Returns |false| if it was already shut down.
@@ -141,34 +189,84 @@ template <MaintenanceSwitch::Mode taMode, typename taSimultaneous> MaintenanceSw
           __FUNCTION__ " at enter")));
       }
       else {
-        uint8_t activeMode = ToUInt8(static_cast<Mode>(_curMode));
+        uint8_t activeMode = ToUInt8(_curMode.load(std::memory_order_relaxed));
         csl.EarlyRelease();
         throw PqaException(PqaErrorCode::MaintenanceModeChangeInProgress, new MaintenanceModeErrorParams(activeMode));
       }
     }
-    if (static_cast<Mode>(_curMode) == taMode) {
+    if (_curMode.load(std::memory_order_relaxed) == taMode) {
       csl.EarlyRelease();
       throw PqaException(PqaErrorCode::MaintenanceModeAlreadyThis, new MaintenanceModeErrorParams(ToUInt8(taMode)));
     }
-    if (_nUsing > 0) {
-      _bModeChangeRequested = 1;
-      do {
-        _canSwitch.Wait(_cs);
-        if (_bShutdownRequested) {
-          csl.EarlyRelease();
-          throw PqaException(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
-            __FUNCTION__ " at wait")));
-        }
-      } while (_nUsing > 0);
-    }
-    _curMode = static_cast<uint64_t>(taMode);
-    _bModeChangeRequested = 0;
-    _nUsing = 1; // Lock simultaneously with switching to the target mode
+    CloseGate();
+    while (SumUsing() > 0) {
+      _canSwitch.Wait(_cs);
+      if (_bShutdownRequested) {
+        csl.EarlyRelease();
+        throw PqaException(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
+          __FUNCTION__ " at wait")));
+      }
+    }
+    _curMode.store(taMode, std::memory_order_relaxed);
+    IncUsing(); // Lock simultaneously with switching to the target mode
     ans._pMs = this;
+  }
+  {
+    // Otherwise the gate stays closed forever if |sf| throws. The lock of the caller is then released by |ans|.
+    auto&& reopenFinally = SRMakeFinally([this] { ReopenGate(); }); (void)reopenFinally;
+    // While the gate is closed, the pending change request keeps the other switches and pauses out.
     sf();
   }
-  _canEnter.WakeAll();
   return std::move(ans);
 }
 
+template <MaintenanceSwitch::Mode taMode, typename taSimultaneous> void MaintenanceSwitch::Pause(
+  const taSimultaneous& sf)
+{
+  {
+    SRLock<SRCriticalSection> csl(_cs);
+    if (_bModeChangeRequested) {
+      if (_bShutdownRequested) {
+        csl.EarlyRelease();
+        throw PqaException(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
+          __FUNCTION__ " at enter")));
+      }
+      else {
+        uint8_t activeMode = ToUInt8(_curMode.load(std::memory_order_relaxed));
+        csl.EarlyRelease();
+        throw PqaException(PqaErrorCode::MaintenanceModeChangeInProgress, new MaintenanceModeErrorParams(activeMode));
+      }
+    }
+    if (_curMode.load(std::memory_order_relaxed) != taMode) {
+      uint8_t activeMode = ToUInt8(_curMode.load(std::memory_order_relaxed));
+      csl.EarlyRelease();
+      throw PqaException(PqaErrorCode::WrongMode, new MaintenanceModeErrorParams(activeMode));
+    }
+    CloseGate();
+    _bPauseRequested = 1;
+    _pauseOwner = std::this_thread::get_id();
+    while (SumUsing() > 0) {
+      _canSwitch.Wait(_cs);
+      if (_bShutdownRequested) {
+        csl.EarlyRelease();
+        // The operations waiting for the pause to finish must be woken up.
+        ReopenGate();
+        throw PqaException(PqaErrorCode::ObjectShutDown, new ObjectShutDownErrorParams(SRString::MakeUnowned(
+          __FUNCTION__ " at wait")));
+      }
+    }
+    // Like the lock returned by SwitchMode(), this keeps shutdown waiting till |sf| is over.
+    IncUsing();
+  }
+  // As in SwitchMode(), |sf| runs without |_cs|: the pending pause keeps the other switches and pauses out, and
+  //   the gate is reopened whatever way |sf| finishes.
+  auto&& leaveFinally = SRMakeFinally([this] {
+    ReopenGate();
+    if (DecUsing()) {
+      NotifyCanSwitch();
+    }
+  }); (void)leaveFinally;
+  sf();
+}
+
 } // namespace ProbQA
@@ -123,12 +123,21 @@ bool PermanentIdManager::OnCompact(const TPqaId nNew, const TPqaId *pOldIds) {
     SRUtils::RequestDebug();
     return false;
   }
-  if (nNew != TPqaId(_perm2comp.size())) {
+  TPqaId nGaps = 0;
+  for (TPqaId i = 0; i < nNew; i++) {
+    if (pOldIds[i] == cInvalidPqaId) {
+      nGaps++;
+    }
+  }
+  if (nNew - nGaps != TPqaId(_perm2comp.size())) {
     SRUtils::RequestDebug();
     return false;
   }
   for (TPqaId i = 0; i < nNew; i++) {
     const TPqaId oldComp = pOldIds[i];
+    if (oldComp == cInvalidPqaId) {
+      continue;
+    }
     if (oldComp < 0 || oldComp >= TPqaId(_comp2perm.size())) {
       SRUtils::RequestDebug();
       return false;
@@ -23,10 +23,14 @@ public: // methods
 
   // Grow, allocating permanent IDs
   bool GrowTo(const TPqaId nComp);
+  // The old ID of a gap left by the compaction is cInvalidPqaId.
   bool OnCompact(const TPqaId nNew, const TPqaId *pOldIds);
 
   bool RemapPermId(const TPqaId srcPermId, const TPqaId destPermId);
 
+  TPqaId GetNComp() const { return _comp2perm.size(); }
+  TPqaId GetNextPermId() const { return _nextPermId; }
+
 private: // variables
   std::unordered_map<TPqaId, TPqaId> _perm2comp;
   std::vector<TPqaId> _comp2perm;
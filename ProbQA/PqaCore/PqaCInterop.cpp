@@ -23,6 +23,12 @@ static_assert(sizeof(CiRatedTarget) == sizeof(RatedTarget)
   && offsetof(CiRatedTarget, _iTarget) == offsetof(RatedTarget, _iTarget)
   && offsetof(CiRatedTarget, _prob) == offsetof(RatedTarget, _prob));
 
+static_assert(sizeof(CiQuestionInfo) == sizeof(QuestionInfo)
+  && offsetof(CiQuestionInfo, _iQuestion) == offsetof(QuestionInfo, _iQuestion)
+  && offsetof(CiQuestionInfo, _infoGain) == offsetof(QuestionInfo, _infoGain)
+  && offsetof(CiQuestionInfo, _selectionProb) == offsetof(QuestionInfo, _selectionProb)
+  && offsetof(CiQuestionInfo, _iRedundantWith) == offsetof(QuestionInfo, _iRedundantWith));
+
 namespace {
 
 char *PrepareSRString(const SRString &s) {
@@ -126,6 +132,32 @@ PQACORE_API void* PqaEngineFactory_LoadCpuEngine(void *pvFactory, void **ppError
   return pEngine;
 }
 
+PQACORE_API void* PqaEngineFactory_LoadHotSwapCpuEngine(void *pvFactory, void **ppError, const char* filePath,
+  uint64_t memPoolMaxBytes)
+{
+  IPqaEngineFactory *pEf = static_cast<IPqaEngineFactory *>(pvFactory);
+  if (pEf == nullptr) {
+    *ppError = new PqaError(PqaErrorCode::NullArgument, nullptr, SRString::MakeUnowned(
+      SR_FILE_LINE "Nullptr is passed in place of IPqaEngineFactory."));
+    return nullptr;
+  }
+  PqaError err;
+  IPqaEngine *pEngine = pEf->LoadHotSwapCpuEngine(err, filePath, memPoolMaxBytes);
+  AssignPqaError(ppError, err);
+  return pEngine;
+}
+
+PQACORE_API void* PqaEngineFactory_FoldKBDelta(void *pvFactory, const char* const basePath,
+  const char* const destPath)
+{
+  IPqaEngineFactory *pEf = static_cast<IPqaEngineFactory *>(pvFactory);
+  if (pEf == nullptr) {
+    return new PqaError(PqaErrorCode::NullArgument, nullptr, SRString::MakeUnowned(
+      SR_FILE_LINE "Nullptr is passed in place of IPqaEngineFactory."));
+  }
+  return ReturnPqaError(pEf->FoldKBDelta(basePath, destPath));
+}
+
 PQACORE_API void CiReleasePqaError(void *pvErr) {
   PqaError *pPe = static_cast<PqaError*>(pvErr);
   delete pPe;
@@ -183,6 +215,19 @@ PQACORE_API void* PqaEngine_Train(void *pvEngine, int64_t nQuestions, const CiAn
   return ReturnPqaError(pEng->Train(nQuestions, reinterpret_cast<const AnsweredQuestion*>(pAQs), iTarget, amount));
 }
 
+PQACORE_API void* PqaEngine_DecayStatistics(void *pvEngine, const double factor, const int64_t maxSliceQuestions) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->DecayStatistics(factor, maxSliceQuestions));
+}
+
+PQACORE_API void* PqaEngine_RecomputeD(void *pvEngine, double *pMaxDrift, const int64_t maxSliceQuestions) {
+  GET_ENGINE_OR_RET_ERR;
+  TPqaAmount maxDrift;
+  PqaError err = pEng->RecomputeD(maxDrift, maxSliceQuestions);
+  *pMaxDrift = maxDrift;
+  return ReturnPqaError(std::move(err));
+}
+
 PQACORE_API uint8_t PqaEngine_QuestionPermFromComp(void *pvEngine, const int64_t count, int64_t *pIds) {
   GET_ENGINE_OR_LOG_ERR(0);
   return pEng->QuestionPermFromComp(count, pIds) ? 1 : 0;
@@ -281,6 +326,16 @@ PQACORE_API int64_t PqaEngine_ListTopTargets(void *pvEngine, void **ppError, con
   return nListed;
 }
 
+PQACORE_API int64_t PqaEngine_AnalyzeQuestions(void *pvEngine, void **ppError, const int64_t maxCount,
+  CiQuestionInfo *pDest)
+{
+  GET_ENGINE_OR_ASSIGN_ERR(cInvalidPqaId);
+  PqaError err;
+  const TPqaId nListed = pEng->AnalyzeQuestions(err, maxCount, reinterpret_cast<QuestionInfo*>(pDest));
+  AssignPqaError(ppError, err);
+  return nListed;
+}
+
 PQACORE_API void* PqaEngine_RecordQuizTarget(void *pvEngine, const int64_t iQuiz, const int64_t iTarget,
   const double amount)
 {
@@ -298,6 +353,82 @@ PQACORE_API void* PqaEngine_SaveKB(void *pvEngine, const char* const filePath, c
   return ReturnPqaError(pEng->SaveKB(filePath, bDoubleBuffer != 0));
 }
 
+PQACORE_API void* PqaEngine_SaveIncremental(void *pvEngine) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->SaveIncremental());
+}
+
+PQACORE_API void* PqaEngine_StartWal(void *pvEngine, const bool bWaitCommit) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->StartWal(bWaitCommit));
+}
+
+PQACORE_API void* PqaEngine_StopWal(void *pvEngine) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->StopWal());
+}
+
+PQACORE_API void* PqaEngine_SetCompressKB(void *pvEngine, const bool bCompress) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->SetCompressKB(bCompress));
+}
+
+PQACORE_API void* PqaEngine_StartCheckpointer(void *pvEngine, const char* const filePath, const double intervalSec,
+  const uint64_t nTrainings, const uint32_t maxIncremental, const double maxBytesPerSec, const uint32_t maxWorkers)
+{
+  GET_ENGINE_OR_RET_ERR;
+  CheckpointPolicy policy;
+  policy._filePath = filePath;
+  policy._intervalSec = intervalSec;
+  policy._nTrainings = nTrainings;
+  policy._maxIncremental = maxIncremental;
+  policy._maxBytesPerSec = maxBytesPerSec;
+  policy._maxWorkers = maxWorkers;
+  return ReturnPqaError(pEng->StartCheckpointer(policy));
+}
+
+PQACORE_API void* PqaEngine_StopCheckpointer(void *pvEngine) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->StopCheckpointer());
+}
+
+PQACORE_API void* PqaEngine_GetCheckpointStats(void *pvEngine, CiCheckpointStats *pStats) {
+  GET_ENGINE_OR_RET_ERR;
+  CheckpointStats stats;
+  PqaError err = pEng->GetCheckpointStats(stats);
+  pStats->_lastTimeSec = stats._lastTimeSec;
+  pStats->_lastBytes = stats._lastBytes;
+  pStats->_lastDurationSec = stats._lastDurationSec;
+  pStats->_bLastIncremental = stats._bLastIncremental ? 1 : 0;
+  pStats->_bInProgress = stats._bInProgress ? 1 : 0;
+  pStats->_nCheckpoints = stats._nCheckpoints;
+  pStats->_nFailures = stats._nFailures;
+  return ReturnPqaError(std::move(err));
+}
+
+PQACORE_API void* PqaEngine_HotSwapKB(void *pvEngine, const char* const filePath) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->HotSwapKB(filePath));
+}
+
+PQACORE_API void* PqaEngine_Warmup(void *pvEngine) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->Warmup());
+}
+
+PQACORE_API void* PqaEngine_SaveQuizzes(void *pvEngine, const char* const filePath) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->SaveQuizzes(filePath));
+}
+
+PQACORE_API int64_t PqaEngine_LoadQuizzes(void *pvEngine, void **ppError, const char* const filePath) {
+  GET_ENGINE_OR_ASSIGN_ERR(cInvalidPqaId);
+  PqaError err;
+  const TPqaId nRestored = pEng->LoadQuizzes(err, filePath);
+  AssignPqaError(ppError, err);
+  return nRestored;
+}
+
 PQACORE_API int64_t PqaEngine_GetActiveQuestionId(void *pvEngine, void **ppError, const int64_t iQuiz) {
   GET_ENGINE_OR_ASSIGN_ERR(cInvalidPqaId);
   PqaError err;
@@ -344,11 +475,11 @@ PQACORE_API void* PqaEngine_RemoveTargets(void *pvEngine, const int64_t nTargets
 }
 
 PQACORE_API void* PqaEngine_Compact(void *pvEngine, int64_t *pnQuestions, int64_t const ** const ppOldQuestions,
-  int64_t *pnTargets, int64_t const ** const ppOldTargets)
+  int64_t *pnTargets, int64_t const ** const ppOldTargets, const bool bOrderByWeight)
 {
   GET_ENGINE_OR_RET_ERR;
   CompactionResult cr;
-  PqaError err = pEng->Compact(cr);
+  PqaError err = pEng->Compact(cr, bOrderByWeight);
   if (err.IsOk()) {
     *pnQuestions = cr._nQuestions;
     *pnTargets = cr._nTargets;
@@ -361,6 +492,26 @@ PQACORE_API void* PqaEngine_Compact(void *pvEngine, int64_t *pnQuestions, int64_
   return ReturnPqaError(std::move(err));
 }
 
+PQACORE_API void* PqaEngine_CompactSlice(void *pvEngine, const int64_t maxMoves, int64_t *pnQuestions,
+  int64_t const ** const ppOldQuestions, int64_t *pnTargets, int64_t const ** const ppOldTargets,
+  int64_t *pnTargetGaps)
+{
+  GET_ENGINE_OR_RET_ERR;
+  CompactionResult cr;
+  PqaError err = pEng->CompactSlice(cr, maxMoves);
+  if (err.IsOk()) {
+    *pnQuestions = cr._nQuestions;
+    *pnTargets = cr._nTargets;
+    *pnTargetGaps = cr._nTargetGaps;
+    *ppOldQuestions = cr._pOldQuestions;
+    *ppOldTargets = cr._pOldTargets;
+    //// Prevent them from getting _mm_free()'d
+    cr._pOldQuestions = nullptr;
+    cr._pOldTargets = nullptr;
+  }
+  return ReturnPqaError(std::move(err));
+}
+
 PQACORE_API void CiReleaseCompaction(const int64_t *p) {
   _mm_free(const_cast<int64_t*>(p)); // It's const for the client code, but not for us
 }
@@ -380,3 +531,15 @@ PQACORE_API void* PqaEngine_ClearOldQuizzes(void *pvEngine, const int64_t maxCou
   GET_ENGINE_OR_RET_ERR;
   return ReturnPqaError(pEng->ClearOldQuizzes(maxCount, maxAgeSec));
 }
+
+PQACORE_API void* PqaEngine_SetQuizExpiry(void *pvEngine, const int64_t maxCount, const double maxAgeSec,
+  const uint8_t bBackgroundReaper)
+{
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->SetQuizExpiry(maxCount, maxAgeSec, bBackgroundReaper != 0));
+}
+
+PQACORE_API void* PqaEngine_ReapQuizzes(void *pvEngine) {
+  GET_ENGINE_OR_RET_ERR;
+  return ReturnPqaError(pEng->ReapQuizzes());
+}
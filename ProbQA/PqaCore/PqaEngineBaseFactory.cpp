@@ -8,6 +8,7 @@
 #include "../PqaCore/CpuEngine.h"
 #include "../PqaCore/ErrorHelper.h"
 #include "../PqaCore/CudaEngine.h"
+#include "../PqaCore/HotSwapEngine.h"
 
 using namespace SRPlat;
 
@@ -41,21 +42,187 @@ IPqaEngine* PqaEngineBaseFactory::CreateCpuEngine(PqaError& err, const EngineDef
   return MakeCpuEngine(err, engDef, nullptr);
 }
 
-IPqaEngine* PqaEngineBaseFactory::LoadCpuEngine(PqaError& err, const char* const filePath, size_t memPoolMaxBytes) {
+IPqaEngine* PqaEngineBaseFactory::LoadCpuEngine(PqaError& err, const char* const filePath, size_t memPoolMaxBytes,
+  const bool bWarmup)
+{
   SRSmartFile sf;
   EngineDefinition engDef;
-  err = LoadEngineDefinition(sf, filePath, engDef);
+  KBFileInfo kbFi(sf, filePath);
+  err = LoadEngineDefinition(kbFi, engDef);
   if (!err.IsOk()) {
     return nullptr;
   }
+  if (kbFi.IsSectioned()) {
+    err = kbFi.OpenDelta();
+    if (!err.IsOk()) {
+      return nullptr;
+    }
+  }
   engDef._memPoolMaxBytes = memPoolMaxBytes;
-  KBFileInfo kbFi(sf, filePath);
-  return MakeCpuEngine(err, engDef, &kbFi);
+  std::unique_ptr<IPqaEngine> pEngine(MakeCpuEngine(err, engDef, &kbFi));
+  if (pEngine == nullptr || !bWarmup) {
+    return pEngine.release();
+  }
+  err = pEngine->Warmup();
+  if (!err.IsOk()) {
+    return nullptr;
+  }
+  return pEngine.release();
 }
 
-PqaError PqaEngineBaseFactory::LoadEngineDefinition(SRSmartFile &sf, const char* const filePath,
-  EngineDefinition& engDef)
+IPqaEngine* PqaEngineBaseFactory::LoadHotSwapCpuEngine(PqaError& err, const char* const filePath,
+  size_t memPoolMaxBytes, const bool bWarmup)
 {
+  std::unique_ptr<IPqaEngine> pInitial(LoadCpuEngine(err, filePath, memPoolMaxBytes, bWarmup));
+  if (pInitial == nullptr) {
+    return nullptr;
+  }
+  try {
+    IPqaEngine *pEngine = new HotSwapEngine(pInitial.get(), memPoolMaxBytes);
+    pInitial.release();
+    err.Release();
+    return pEngine;
+  }
+  CATCH_TO_ERR_SET(err);
+  return nullptr;
+}
+
+PqaError PqaEngineBaseFactory::FoldKBDelta(const char* const basePath, const char* const destPath) {
+  if (destPath == nullptr) {
+    return PqaError(PqaErrorCode::NullArgument, nullptr, SRString::MakeUnowned(
+      SR_FILE_LINE "Nullptr is passed in place of the file name for the folded KB."));
+  }
+  SRSmartFile sf;
+  EngineDefinition engDef;
+  KBFileInfo kbFi(sf, basePath);
+  PqaError err = LoadEngineDefinition(kbFi, engDef);
+  if (!err.IsOk()) {
+    return err;
+  }
+  if (!kbFi.IsSectioned()) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(basePath), SRString::MakeUnowned(SR_FILE_LINE
+      "Only KB file format version 2 or 3 can have a delta file."));
+  }
+  err = kbFi.OpenDelta();
+  if (!err.IsOk()) {
+    return err;
+  }
+  if (!kbFi.HasDelta()) {
+    return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(basePath), SRString::MakeUnowned(SR_FILE_LINE
+      "There is no delta file made against this base KB file."));
+  }
+  if (kbFi.IsCompressed()) {
+    return FoldCompressedKBDelta(kbFi, engDef, destPath);
+  }
+  KBFileHeader &header = kbFi._header;
+  const KBDeltaHeader &delta = kbFi._delta;
+  const std::string deltaPath = KBDeltaHeader::PathFor(basePath);
+
+  try {
+    SRPositionalFile baseFile(basePath, SRPositionalFile::Mode::Read);
+    SRPositionalFile deltaFile(deltaPath.c_str(), SRPositionalFile::Mode::Read);
+    //// Read the region index of the delta and the region checksums of the base.
+    std::vector<KBDeltaRegion> index(SRCast::ToSizeT(delta._nRegions));
+    if (!deltaFile.Read(index.data(), SRCast::ToSizeT(delta._index._nBytes), delta._index._offset)
+      || SRChecksum::Crc32c(index.data(), SRCast::ToSizeT(delta._index._nBytes)) != delta._index._checksum)
+    {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRString::MakeUnowned(
+        SR_FILE_LINE "Can't read the region index of the KB delta file, or it's corrupt."));
+    }
+    KBFileSection &checksums = header.Section(KBSection::Checksums);
+    const uint64_t nTotalRegions = header.NTotalRegions();
+    std::vector<uint32_t> crcs(SRCast::ToSizeT(nTotalRegions));
+    if (checksums._nBytes != nTotalRegions * sizeof(uint32_t)
+      || !baseFile.Read(crcs.data(), SRCast::ToSizeT(checksums._nBytes), checksums._offset)
+      || SRChecksum::Crc32c(crcs.data(), SRCast::ToSizeT(checksums._nBytes)) != checksums._checksum)
+    {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(basePath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't read the checksums section of the base KB file, or it's corrupt."));
+    }
+
+    if (!CopyFileA(basePath, destPath, FALSE)) {
+      const uint32_t le = GetLastError();
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(destPath), SRMessageBuilder(SR_FILE_LINE
+        "Can't copy the base KB file, GetLastError=")(le).GetOwnedSRString());
+    }
+    SRPositionalFile destFile(destPath, SRPositionalFile::Mode::Write);
+
+    //// Overwrite the regions of the base with the regions of the delta.
+    std::vector<uint8_t> buf;
+    for (const KBDeltaRegion &dr : index) {
+      if (dr._iRegion >= nTotalRegions) {
+        return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRMessageBuilder(
+          SR_FILE_LINE "Wrong region #")(dr._iRegion)(" in the KB delta file.").GetOwnedSRString());
+      }
+      KBSection ks;
+      uint64_t iFirstRow, iLimRow;
+      header.LocateRegion(dr._iRegion, ks, iFirstRow, iLimRow);
+      buf.resize(SRCast::ToSizeT((iLimRow - iFirstRow) * header._rowStride));
+      if (!deltaFile.Read(buf.data(), buf.size(), dr._offset)
+        || SRChecksum::Crc32c(buf.data(), buf.size()) != dr._checksum)
+      {
+        return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRMessageBuilder(
+          SR_FILE_LINE "Can't read KB delta region #")(dr._iRegion)(", or it's corrupt.").GetOwnedSRString());
+      }
+      if (!destFile.Write(buf.data(), buf.size(), header.Section(ks)._offset + iFirstRow * header._rowStride)) {
+        return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(destPath), SRMessageBuilder(SR_FILE_LINE
+          "Can't write KB region #")(dr._iRegion).GetOwnedSRString());
+      }
+      crcs[SRCast::ToSizeT(dr._iRegion)] = dr._checksum;
+    }
+    checksums._checksum = SRChecksum::Crc32c(crcs.data(), SRCast::ToSizeT(checksums._nBytes));
+    if (!destFile.Write(crcs.data(), SRCast::ToSizeT(checksums._nBytes), checksums._offset)) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(destPath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't write the checksums of KB regions."));
+    }
+
+    //// The meta section of the delta replaces that of the base. A longer tail of the base meta is left unused.
+    KBFileSection &meta = header.Section(KBSection::Meta);
+    buf.resize(SRCast::ToSizeT(delta._meta._nBytes));
+    if (!deltaFile.Read(buf.data(), buf.size(), delta._meta._offset)) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(deltaPath.c_str()), SRString::MakeUnowned(
+        SR_FILE_LINE "Can't read the meta section of the KB delta file."));
+    }
+    meta._offset = header.MetaOffset();
+    meta._nBytes = buf.size();
+    if (!destFile.Write(buf.data(), buf.size(), meta._offset)) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(destPath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't write the meta section."));
+    }
+
+    header._nQuestionsAsked = delta._nQuestionsAsked;
+    header._walLsn = delta._walLsn;
+    header._checkpointId = KBFileHeader::NewCheckpointId();
+    if (!destFile.Write(&header, sizeof(header), 0) || !destFile.Flush()) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(destPath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't write KB file header."));
+    }
+  }
+  CATCH_TO_ERR_RETURN;
+  return PqaError();
+}
+
+PqaError PqaEngineBaseFactory::FoldCompressedKBDelta(KBFileInfo &kbFi, const EngineDefinition& engDef,
+  const char* const destPath)
+{
+  // The regions compress to other sizes once changed, so they can't be overwritten in the copy of the base. Instead,
+  //   the statistics are decompressed with the delta applied, and compressed again.
+  kbFi._bReplayWal = false;
+  PqaError err;
+  std::unique_ptr<IPqaEngine> pEngine(MakeCpuEngine(err, engDef, &kbFi));
+  if (pEngine == nullptr) {
+    return err;
+  }
+  err = pEngine->SetCompressKB(true);
+  if (!err.IsOk()) {
+    return err;
+  }
+  return pEngine->SaveKB(destPath, false);
+}
+
+PqaError PqaEngineBaseFactory::LoadEngineDefinition(KBFileInfo &kbFi, EngineDefinition& engDef) {
+  SRSmartFile &sf = kbFi._sf;
+  const char* const filePath = kbFi._filePath;
   if (filePath == nullptr) {
     return PqaError(PqaErrorCode::NullArgument, nullptr, SRString::MakeUnowned(
       SR_FILE_LINE "Nullptr is passed in place of KB file name."));
@@ -70,6 +237,33 @@ PqaError PqaEngineBaseFactory::LoadEngineDefinition(SRSmartFile &sf, const char*
       "Can't set file buffer size to ")(BaseCpuEngine::_cFileBufSize).GetOwnedSRString());
   }
 
+  uint64_t magic;
+  if (std::fread(&magic, sizeof(magic), 1, sf.Get()) != 1 || magic != KBFileHeader::_cMagic) {
+    // Format version 1 doesn't have the magic number.
+    if (!kbFi.Seek(0)) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't rewind the KB file."));
+    }
+  }
+  else {
+    KBFileHeader &header = kbFi._header;
+    if (!kbFi.Seek(0) || std::fread(&header, sizeof(header), 1, sf.Get()) != 1) {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRString::MakeUnowned(SR_FILE_LINE
+        "Can't read KB file header."));
+    }
+    if ((header._formatVersion != KBFileHeader::_cSectionedVersion
+      && header._formatVersion != KBFileHeader::_cCompressedVersion) || header._headerBytes != sizeof(header))
+    {
+      return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRMessageBuilder(SR_FILE_LINE
+        "Unsupported KB file format version ")(header._formatVersion)(" with header size ")(header._headerBytes)
+        .GetOwnedSRString());
+    }
+    kbFi._formatVersion = header._formatVersion;
+    engDef._prec = header._prec;
+    engDef._dims = header._dims;
+    return PqaError();
+  }
+
   if (std::fread(&engDef._prec, sizeof(engDef._prec), 1, sf.Get()) != 1) {
     return PqaError(PqaErrorCode::FileOp, new FileOpErrorParams(filePath), SRString::MakeUnowned(SR_FILE_LINE
       "Can't read precision definition header."));
@@ -101,12 +295,18 @@ IPqaEngine* PqaEngineBaseFactory::CreateCudaEngine(PqaError& err, const EngineDe
 IPqaEngine* PqaEngineBaseFactory::LoadCudaEngine(PqaError& err, const char* const filePath, size_t memPoolMaxBytes) {
   SRSmartFile sf;
   EngineDefinition engDef;
-  err = LoadEngineDefinition(sf, filePath, engDef);
+  KBFileInfo kbFi(sf, filePath);
+  err = LoadEngineDefinition(kbFi, engDef);
   if (!err.IsOk()) {
     return nullptr;
   }
+  if (kbFi.IsSectioned()) {
+    //TODO: implement when CUDA engine loads KB file format version 2
+    err = PqaError(PqaErrorCode::NotImplemented, new NotImplementedErrorParams(SRString::MakeUnowned(SR_FILE_LINE
+      "Loading KB file format version 2 or 3 into ProbQA Engine on CUDA.")));
+    return nullptr;
+  }
   engDef._memPoolMaxBytes = memPoolMaxBytes;
-  KBFileInfo kbFi(sf, filePath);
   return MakeCudaEngine(err, engDef, &kbFi);
 }
 
@@ -20,17 +20,24 @@ private: // methods
   IPqaEngine* MakeCpuEngine(PqaError& err, const EngineDefinition& engDef, KBFileInfo *pKbFi);
   IPqaEngine* MakeCudaEngine(PqaError& err, const EngineDefinition& engDef, KBFileInfo *pKbFi);
   PqaError CheckDimensions(const EngineDefinition& engDef);
-  PqaError LoadEngineDefinition(SRPlat::SRSmartFile &sf, const char* const filePath, EngineDefinition& engDef);
+  // Detects the KB file format version and reads the header.
+  PqaError LoadEngineDefinition(KBFileInfo &kbFi, EngineDefinition& engDef);
+  // Loads the compressed base with its delta into a CPU engine and saves it compressed to |destPath|.
+  PqaError FoldCompressedKBDelta(KBFileInfo &kbFi, const EngineDefinition& engDef, const char* const destPath);
 
 public: // methods
   IPqaEngine* CreateCpuEngine(PqaError& err, const EngineDefinition& engDef) override final;
   IPqaEngine* LoadCpuEngine(PqaError& err, const char* const filePath,
-    size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes) override final;
+    size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes, const bool bWarmup = false) override final;
+  IPqaEngine* LoadHotSwapCpuEngine(PqaError& err, const char* const filePath,
+    size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes, const bool bWarmup = false) override final;
 
   IPqaEngine* CreateCudaEngine(PqaError& err, const EngineDefinition& engDef) override final;
   IPqaEngine* LoadCudaEngine(PqaError& err, const char* const filePath,
     size_t memPoolMaxBytes = EngineDefinition::_cDefaultMemPoolMaxBytes) override final;
 
+  PqaError FoldKBDelta(const char* const basePath, const char* const destPath) override final;
+
   IPqaEngine* CreateGridEngine(PqaError& err, const EngineDefinition& engDef) override final;
 };
 
@@ -0,0 +1,124 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/QuizExpiryWheel.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+namespace {
+  std::atomic<uint32_t> gNextThreadInbox = 0;
+}
+
+QuizExpiryWheel::QuizExpiryWheel(const uint32_t nowSec) : _cursor(nowSec), _nScheduled(0), _bucketSec(1) {
+}
+
+uint32_t QuizExpiryWheel::GetThreadInbox() {
+  thread_local const uint32_t tlInbox = gNextThreadInbox.fetch_add(1, std::memory_order_relaxed) & (_cNInboxes - 1);
+  return tlInbox;
+}
+
+uint32_t QuizExpiryWheel::ClampedBucket(const uint32_t deadlineSec) const {
+  const uint32_t iBucket = deadlineSec / _bucketSec.load(std::memory_order_relaxed);
+  if (iBucket <= _cursor) {
+    return _cursor;
+  }
+  // One bucket is reserved for the current time, which is in the bucket before the cursor.
+  return std::min(iBucket, _cursor + _cNBuckets - 1);
+}
+
+void QuizExpiryWheel::DrainInboxes() {
+  for (uint32_t i = 0; i < _cNInboxes; i++) {
+    {
+      SRLock<TSync> sl(_inboxes[i]._sync);
+      _inboxes[i]._pending.swap(_draining);
+    }
+    for (const Deadline& dl : _draining) {
+      _buckets[ClampedBucket(dl._sec) & (_cNBuckets - 1)].push_back(dl._iQuiz);
+    }
+    _nScheduled += _draining.size();
+    _draining.clear();
+  }
+}
+
+uint32_t QuizExpiryWheel::GetHorizonSec() {
+  return (_cNBuckets - 1) * _bucketSec.load(std::memory_order_relaxed);
+}
+
+uint32_t QuizExpiryWheel::GetBucketSec() {
+  return _bucketSec.load(std::memory_order_relaxed);
+}
+
+size_t QuizExpiryWheel::GetNScheduled() {
+  SRLock<SRCriticalSection> csl(_cs);
+  DrainInboxes();
+  return _nScheduled;
+}
+
+void QuizExpiryWheel::Schedule(const TPqaId iQuiz, const uint32_t deadlineSec) {
+  Inbox &inbox = _inboxes[GetThreadInbox()];
+  SRLock<TSync> sl(inbox._sync);
+  inbox._pending.push_back(Deadline{ iQuiz, deadlineSec });
+}
+
+void QuizExpiryWheel::TakeDue(const uint32_t nowSec, std::vector<TPqaId> &dest) {
+  SRLock<SRCriticalSection> csl(_cs);
+  DrainInboxes();
+  const uint32_t iNowBucket = nowSec / _bucketSec.load(std::memory_order_relaxed);
+  // After a long pause, don't iterate over the same buckets multiple times.
+  const uint32_t iLim = std::min(iNowBucket + 1, _cursor + _cNBuckets);
+  for (uint32_t i = _cursor; i < iLim; i++) {
+    std::vector<TPqaId> &bucket = _buckets[i & (_cNBuckets - 1)];
+    _nScheduled -= bucket.size();
+    dest.insert(dest.end(), bucket.begin(), bucket.end());
+    bucket.clear();
+  }
+  _cursor = std::max(_cursor, iNowBucket + 1);
+}
+
+uint32_t QuizExpiryWheel::TakeEarliest(const uint32_t iFrom, const uint32_t iLim, std::vector<TPqaId> &dest) {
+  SRLock<SRCriticalSection> csl(_cs);
+  DrainInboxes();
+  const uint32_t iEnd = std::min(iLim, _cursor + _cNBuckets);
+  for (uint32_t i = std::max(iFrom, _cursor); i < iEnd; i++) {
+    std::vector<TPqaId> &bucket = _buckets[i & (_cNBuckets - 1)];
+    if (bucket.empty()) {
+      continue;
+    }
+    _nScheduled -= bucket.size();
+    dest.insert(dest.end(), bucket.begin(), bucket.end());
+    bucket.clear();
+    return i;
+  }
+  return iLim;
+}
+
+void QuizExpiryWheel::GetBucketRange(uint32_t &iFirst, uint32_t &iLim) {
+  SRLock<SRCriticalSection> csl(_cs);
+  iFirst = _cursor;
+  iLim = _cursor + _cNBuckets;
+}
+
+uint32_t QuizExpiryWheel::GetBucketEndSec(const uint32_t iBucket) {
+  return (iBucket + 1) * _bucketSec.load(std::memory_order_relaxed);
+}
+
+void QuizExpiryWheel::Reset(const uint32_t horizonSec, const uint32_t nowSec) {
+  SRLock<SRCriticalSection> csl(_cs);
+  for (uint32_t i = 0; i < _cNInboxes; i++) {
+    SRLock<TSync> sl(_inboxes[i]._sync);
+    _inboxes[i]._pending.clear();
+  }
+  for (uint32_t i = 0; i < _cNBuckets; i++) {
+    _buckets[i].clear();
+  }
+  _nScheduled = 0;
+  const uint32_t bucketSec = std::max(uint32_t(1), SRMath::PosDivideRoundUp(horizonSec, _cNBuckets - 1));
+  _bucketSec.store(bucketSec, std::memory_order_relaxed);
+  _cursor = nowSec / bucketSec;
+}
+
+} // namespace ProbQA
@@ -0,0 +1,83 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/Interface/PqaCommon.h"
+
+namespace ProbQA {
+
+// Hashed timing wheel of quiz expiration deadlines, in terms of QuizRegistry::CoarseNowSec(). The deadlines are
+//   lazy: a quiz used after scheduling is not moved in the wheel, but rather rescheduled by the client when its bucket
+//   comes due. Thus the cost of expiry is proportional to the number of expired and rescheduled quizzes, rather than
+//   to the number of all the quizzes.
+// The horizon of the wheel is kept no less than the maximum deadline distance, so that each bucket holds the deadlines
+//   of a single revolution.
+// Thread-safe. Scheduling only appends to the inbox of the current thread's group, so that the threads starting
+//   quizzes don't serialize on the wheel. The inboxes are emptied into the buckets when the wheel is read.
+class QuizExpiryWheel {
+public: // constants
+  static constexpr uint8_t _cLogNBuckets = 10;
+  static constexpr uint32_t _cNBuckets = uint32_t(1) << _cLogNBuckets;
+  static constexpr uint8_t _cLogNInboxes = 4;
+  static constexpr uint32_t _cNInboxes = uint32_t(1) << _cLogNInboxes;
+
+private: // types
+  typedef SRPlat::SRSpinSync<1 << 5> TSync;
+
+  struct Deadline {
+    TPqaId _iQuiz;
+    uint32_t _sec;
+  };
+
+  struct alignas(SRPlat::SRCpuInfo::_cacheLineBytes) Inbox {
+    TSync _sync;
+    std::vector<Deadline> _pending; // Guarded by _sync
+  };
+
+private: // variables
+  Inbox _inboxes[_cNInboxes];
+  SRPlat::SRCriticalSection _cs;
+  //// Guarded by _cs
+  std::vector<TPqaId> _buckets[_cNBuckets];
+  std::vector<Deadline> _draining; // keeps the capacity for swapping with the inboxes
+  uint32_t _cursor; // absolute number of the earliest bucket not processed yet
+  size_t _nScheduled;
+  //// Changes only under _cs
+  std::atomic<uint32_t> _bucketSec; // granularity of the buckets, in seconds
+
+private: // methods
+  static uint32_t GetThreadInbox();
+  // Must be called with |_cs| locked.
+  uint32_t ClampedBucket(const uint32_t deadlineSec) const;
+  // Must be called with |_cs| locked.
+  void DrainInboxes();
+
+public: // methods
+  explicit QuizExpiryWheel(const uint32_t nowSec);
+  QuizExpiryWheel(const QuizExpiryWheel&) = delete;
+  QuizExpiryWheel& operator=(const QuizExpiryWheel&) = delete;
+
+  // The distance to the furthest deadline that can be scheduled, in seconds.
+  uint32_t GetHorizonSec();
+  uint32_t GetBucketSec();
+  size_t GetNScheduled();
+
+  // Deadlines in the past become due at the next tick, and deadlines beyond the horizon are brought to the horizon.
+  void Schedule(const TPqaId iQuiz, const uint32_t deadlineSec);
+  // Moves into |dest| the quiz IDs from the buckets that are due by |nowSec|, advancing the cursor.
+  void TakeDue(const uint32_t nowSec, std::vector<TPqaId> &dest);
+  // Moves into |dest| the quiz IDs from the earliest non-empty bucket at or after absolute bucket |iFrom|, stopping
+  //   before |iLim|. Returns the absolute number of the bucket taken, or |iLim| if all the buckets are empty.
+  uint32_t TakeEarliest(const uint32_t iFrom, const uint32_t iLim, std::vector<TPqaId> &dest);
+  // Returns the range of absolute bucket numbers currently in the wheel, and the end of bucket |iBucket| in seconds.
+  void GetBucketRange(uint32_t &iFirst, uint32_t &iLim);
+  uint32_t GetBucketEndSec(const uint32_t iBucket);
+
+  // Drops all the quiz IDs and changes the granularity so that the horizon is at least |horizonSec|. The client is
+  //   expected to schedule the live quizzes anew.
+  void Reset(const uint32_t horizonSec, const uint32_t nowSec);
+};
+
+} // namespace ProbQA
@@ -0,0 +1,251 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/QuizRegistry.h"
+#include "../PqaCore/PqaException.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+namespace {
+  std::atomic<uint32_t> gNextThreadShard = 0;
+  constexpr uint32_t cGenerationMask = (uint32_t(1) << QuizRegistry::_cGenerationBits) - 1;
+}
+
+QuizRegistry::QuizRegistry() : _nextFresh(0), _nLive(0) {
+  for (uint8_t i = 0; i < _cNChunks; i++) {
+    _chunks[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+QuizRegistry::~QuizRegistry() {
+  for (uint8_t i = 0; i < _cNChunks; i++) {
+    delete[] _chunks[i].load(std::memory_order_relaxed);
+  }
+}
+
+uint32_t QuizRegistry::GetThreadShard() {
+  thread_local const uint32_t tlShard = gNextThreadShard.fetch_add(1, std::memory_order_relaxed) & (_cNShards - 1);
+  return tlShard;
+}
+
+void QuizRegistry::Locate(const uint32_t iSlot, uint8_t &iChunk, uint32_t &iInChunk) {
+  // Chunk |i| holds slots [2**(F+i) - 2**F; 2**(F+i+1) - 2**F), where F=_cLogFirstChunk .
+  const uint64_t shifted = uint64_t(iSlot) + (uint64_t(1) << _cLogFirstChunk);
+  unsigned long iMsb;
+  _BitScanReverse64(&iMsb, shifted);
+  iChunk = uint8_t(iMsb - _cLogFirstChunk);
+  iInChunk = uint32_t(shifted - (uint64_t(1) << iMsb));
+}
+
+QuizRegistry::Entry* QuizRegistry::GetEntry(const uint32_t iSlot) const {
+  uint8_t iChunk;
+  uint32_t iInChunk;
+  Locate(iSlot, iChunk, iInChunk);
+  Entry *pChunk = _chunks[iChunk].load(std::memory_order_acquire);
+  if (pChunk == nullptr) {
+    return nullptr;
+  }
+  return pChunk + iInChunk;
+}
+
+QuizRegistry::Entry& QuizRegistry::EnsureEntry(const uint32_t iSlot) {
+  uint8_t iChunk;
+  uint32_t iInChunk;
+  Locate(iSlot, iChunk, iInChunk);
+  Entry *pChunk = _chunks[iChunk].load(std::memory_order_acquire);
+  if (pChunk == nullptr) {
+    Entry *pNew = new Entry[ChunkSize(iChunk)];
+    if (_chunks[iChunk].compare_exchange_strong(pChunk, pNew, std::memory_order_acq_rel, std::memory_order_acquire))
+    {
+      pChunk = pNew;
+    }
+    else {
+      // Another thread has allocated this chunk meanwhile: |pChunk| now points to it.
+      delete[] pNew;
+    }
+  }
+  return pChunk[iInChunk];
+}
+
+bool QuizRegistry::TryPopFree(Shard &shard, uint32_t &iSlot) {
+  SRLock<TSync> sl(shard._sync);
+  if (shard._freeSlots.empty()) {
+    return false;
+  }
+  iSlot = shard._freeSlots.back();
+  shard._freeSlots.pop_back();
+  return true;
+}
+
+uint32_t QuizRegistry::Reserve() {
+  const uint32_t iOwnShard = GetThreadShard();
+  uint32_t iSlot;
+  bool bFound = false;
+  for (uint32_t i = 0; i < _cNShards; i++) {
+    if (TryPopFree(_shards[(iOwnShard + i) & (_cNShards - 1)], iSlot)) {
+      bFound = true;
+      break;
+    }
+  }
+  if (!bFound) {
+    iSlot = _nextFresh.load(std::memory_order_relaxed);
+    do {
+      if (iSlot == uint32_t(_cSlotMask)) {
+        throw PqaException(PqaErrorCode::Internal, new InternalErrorParams(__FILE__, __LINE__),
+          SRString::MakeUnowned(SR_FILE_LINE "Quiz registry is full."));
+      }
+      // Allocate the storage before publishing the slot range, so that ForEachLive() doesn't step beyond it.
+      EnsureEntry(iSlot);
+    } while (!_nextFresh.compare_exchange_weak(iSlot, iSlot + 1, std::memory_order_acq_rel,
+      std::memory_order_relaxed));
+  }
+  return iSlot;
+}
+
+TPqaId QuizRegistry::Publish(const uint32_t iSlot, BaseQuiz *pQuiz) {
+  Entry &entry = EnsureEntry(iSlot);
+  const uint32_t generation = (GenerationOf(entry._state.load(std::memory_order_relaxed)) + 1) & cGenerationMask;
+  assert((generation & 1) == 1);
+  entry._lastUsageSec.store(CoarseNowSec(), std::memory_order_relaxed);
+  entry._pQuiz.store(pQuiz, std::memory_order_release);
+  // The users of the previous quiz in the slot may still be leaving.
+  const bool bBumped = TryBumpGeneration(entry, generation - 1);
+  assert(bBumped); (void)bBumped;
+  _nLive.fetch_add(1, std::memory_order_relaxed);
+  return MakeId(iSlot, generation);
+}
+
+QuizRegistry::Entry* QuizRegistry::LocateLive(const TPqaId iQuiz, uint32_t &generation) const {
+  if (iQuiz < 0) {
+    return nullptr;
+  }
+  generation = uint32_t(uint64_t(iQuiz) >> _cSlotBits);
+  if ((generation & 1) == 0) {
+    return nullptr;
+  }
+  return GetEntry(SlotFromId(iQuiz));
+}
+
+bool QuizRegistry::TryBumpGeneration(Entry &entry, const uint32_t generation) {
+  uint64_t state = entry._state.load(std::memory_order_acquire);
+  do {
+    if (GenerationOf(state) != generation) {
+      return false;
+    }
+  } while (!entry._state.compare_exchange_weak(state, (state & ~_cSlotMask) | ((generation + 1) & cGenerationMask),
+    std::memory_order_acq_rel, std::memory_order_acquire));
+  return true;
+}
+
+BaseQuiz* QuizRegistry::Lookup(const TPqaId iQuiz) const {
+  uint32_t generation;
+  const Entry *pEntry = LocateLive(iQuiz, generation);
+  if (pEntry == nullptr) {
+    return nullptr;
+  }
+  if (GenerationOf(pEntry->_state.load(std::memory_order_acquire)) != generation) {
+    return nullptr;
+  }
+  BaseQuiz *pQuiz = pEntry->_pQuiz.load(std::memory_order_acquire);
+  // Recheck, because the slot may have been released and reused meanwhile.
+  if (GenerationOf(pEntry->_state.load(std::memory_order_acquire)) != generation) {
+    return nullptr;
+  }
+  return pQuiz;
+}
+
+BaseQuiz* QuizRegistry::Use(const TPqaId iQuiz) {
+  uint32_t generation;
+  Entry *pEntry = LocateLive(iQuiz, generation);
+  if (pEntry == nullptr) {
+    return nullptr;
+  }
+  // Count the user only while the generation matches, so that an eviction can't succeed after this.
+  uint64_t state = pEntry->_state.load(std::memory_order_acquire);
+  do {
+    if (GenerationOf(state) != generation) {
+      return nullptr;
+    }
+  } while (!pEntry->_state.compare_exchange_weak(state, state + _cUserUnit, std::memory_order_acq_rel,
+    std::memory_order_acquire));
+  BaseQuiz *pQuiz = pEntry->_pQuiz.load(std::memory_order_acquire);
+  if (pQuiz == nullptr) {
+    // Released explicitly meanwhile
+    Unuse(iQuiz);
+    return nullptr;
+  }
+  const uint32_t nowSec = CoarseNowSec();
+  // Avoid dirtying the cache line on each access: the time changes only once per second.
+  if (pEntry->_lastUsageSec.load(std::memory_order_relaxed) != nowSec) {
+    pEntry->_lastUsageSec.store(nowSec, std::memory_order_relaxed);
+  }
+  return pQuiz;
+}
+
+void QuizRegistry::Unuse(const TPqaId iQuiz) {
+  Entry *pEntry = GetEntry(SlotFromId(iQuiz));
+  assert(pEntry != nullptr);
+  pEntry->_state.fetch_sub(_cUserUnit, std::memory_order_acq_rel);
+}
+
+uint32_t QuizRegistry::GetLastUsageSec(const TPqaId iQuiz) const {
+  const Entry *pEntry = GetEntry(SlotFromId(iQuiz));
+  assert(pEntry != nullptr);
+  return pEntry->_lastUsageSec.load(std::memory_order_relaxed);
+}
+
+BaseQuiz* QuizRegistry::Invalidate(const TPqaId iQuiz) {
+  uint32_t generation;
+  Entry *pEntry = LocateLive(iQuiz, generation);
+  if (pEntry == nullptr) {
+    return nullptr;
+  }
+  if (!TryBumpGeneration(*pEntry, generation)) {
+    return nullptr; // a stale ID, or a concurrent release has won
+  }
+  BaseQuiz *pQuiz = pEntry->_pQuiz.exchange(nullptr, std::memory_order_acq_rel);
+  _nLive.fetch_sub(1, std::memory_order_relaxed);
+  return pQuiz;
+}
+
+BaseQuiz* QuizRegistry::InvalidateIfUnused(const TPqaId iQuiz) {
+  uint32_t generation;
+  Entry *pEntry = LocateLive(iQuiz, generation);
+  if (pEntry == nullptr) {
+    return nullptr;
+  }
+  // Succeeds only if there are no users, which can't come after this because the generation doesn't match then.
+  uint64_t state = generation;
+  if (!pEntry->_state.compare_exchange_strong(state, (generation + 1) & cGenerationMask, std::memory_order_acq_rel,
+    std::memory_order_relaxed))
+  {
+    return nullptr; // in use, a stale ID, or a concurrent release has won
+  }
+  BaseQuiz *pQuiz = pEntry->_pQuiz.exchange(nullptr, std::memory_order_acq_rel);
+  _nLive.fetch_sub(1, std::memory_order_relaxed);
+  return pQuiz;
+}
+
+void QuizRegistry::Recycle(const uint32_t iSlot) {
+  Shard &shard = _shards[GetThreadShard()];
+  SRLock<TSync> sl(shard._sync);
+  shard._freeSlots.push_back(iSlot);
+}
+
+TPqaId QuizRegistry::IdAtSlot(const uint32_t iSlot) const {
+  const Entry *pEntry = GetEntry(iSlot);
+  if (pEntry == nullptr) {
+    return cInvalidPqaId;
+  }
+  const uint32_t generation = GenerationOf(pEntry->_state.load(std::memory_order_acquire));
+  if ((generation & 1) == 0) {
+    return cInvalidPqaId;
+  }
+  return MakeId(iSlot, generation);
+}
+
+} // namespace ProbQA
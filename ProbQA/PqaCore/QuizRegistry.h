@@ -0,0 +1,154 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/Interface/PqaCommon.h"
+
+namespace ProbQA {
+
+class BaseQuiz;
+
+// Concurrent slot map of the quizzes. Quiz ID consists of the slot index in the lower bits and the generation of the
+//   slot in the upper bits, so that a stale ID (of a quiz released earlier, whose slot may have been reused already)
+//   is detected without locking. Lookup is wait-free. Acquisition and release of slots use sharded free lists.
+// The operations in progress on a quiz are counted along with the generation of its slot, so that the expiry can
+//   release only the quizzes no one is using.
+// The slots are stored in chunks of geometrically growing size, which are never moved or freed till destruction, so
+//   that a lookup doesn't need to synchronize with growth.
+class QuizRegistry {
+public: // constants
+  static constexpr uint8_t _cSlotBits = 32;
+  static constexpr uint64_t _cSlotMask = (uint64_t(1) << _cSlotBits) - 1;
+  // The upper bits of quiz IDs are left for the version of the KB in HotSwapEngine.
+  static constexpr uint8_t _cGenerationBits = 24;
+  static constexpr uint8_t _cIdBits = _cSlotBits + _cGenerationBits;
+  static constexpr uint8_t _cLogFirstChunk = 10;
+  static constexpr uint8_t _cNChunks = _cSlotBits - _cLogFirstChunk + 1;
+  static constexpr uint8_t _cLogNShards = 4;
+  static constexpr uint32_t _cNShards = uint32_t(1) << _cLogNShards;
+
+private: // types
+  typedef SRPlat::SRSpinSync<1 << 5> TSync;
+
+  struct Entry {
+    std::atomic<BaseQuiz*> _pQuiz = nullptr;
+    // The lower 32 bits are the generation: odd when the slot is occupied, even when the slot is free. Only the lower
+    //   _cGenerationBits bits of it are used, so that quiz IDs are non-negative. The upper 32 bits are the number of
+    //   operations using the quiz.
+    std::atomic<uint64_t> _state = 0;
+    std::atomic<uint32_t> _lastUsageSec = 0; // in terms of CoarseNowSec()
+  };
+
+  struct alignas(SRPlat::SRCpuInfo::_cacheLineBytes) Shard {
+    TSync _sync;
+    std::vector<uint32_t> _freeSlots; // Guarded by _sync
+  };
+
+private: // constants
+  static constexpr uint64_t _cUserUnit = uint64_t(1) << 32;
+
+private: // variables
+  std::atomic<Entry*> _chunks[_cNChunks];
+  Shard _shards[_cNShards];
+  std::atomic<uint32_t> _nextFresh; // the slots starting from this one have never been used
+  std::atomic<TPqaId> _nLive;
+
+private: // methods
+  static uint32_t GetThreadShard();
+  static void Locate(const uint32_t iSlot, uint8_t &iChunk, uint32_t &iInChunk);
+  static uint32_t ChunkSize(const uint8_t iChunk) { return uint32_t(1) << (_cLogFirstChunk + iChunk); }
+  static TPqaId MakeId(const uint32_t iSlot, const uint32_t generation) {
+    return TPqaId((uint64_t(generation) << _cSlotBits) | iSlot);
+  }
+  static uint32_t GenerationOf(const uint64_t state) { return uint32_t(state); }
+  // Returns nullptr if the ID can't be live, otherwise the entry of its slot and the generation of the ID.
+  Entry* LocateLive(const TPqaId iQuiz, uint32_t &generation) const;
+  // Replaces the generation in the state of the entry, keeping the number of users.
+  static bool TryBumpGeneration(Entry &entry, const uint32_t generation);
+
+  // Returns nullptr if the slot is beyond the storage allocated so far.
+  Entry* GetEntry(const uint32_t iSlot) const;
+  Entry& EnsureEntry(const uint32_t iSlot);
+  bool TryPopFree(Shard &shard, uint32_t &iSlot);
+
+public: // methods
+  explicit QuizRegistry();
+  ~QuizRegistry();
+  QuizRegistry(const QuizRegistry&) = delete;
+  QuizRegistry& operator=(const QuizRegistry&) = delete;
+
+  static uint32_t SlotFromId(const TPqaId iQuiz) { return uint32_t(uint64_t(iQuiz) & _cSlotMask); }
+  // Seconds with the resolution of the system timer. It reads a value maintained by the OS, without a system call.
+  static uint32_t CoarseNowSec() { return uint32_t(GetTickCount64() / 1000); }
+
+  // Takes a slot off the free lists, or a fresh one. The slot is not live till Publish() and is not reused till
+  //   Recycle(), so that the caller can maintain the data indexed by slots in between.
+  uint32_t Reserve();
+  // Makes the quiz live in a reserved slot. Returns the ID assigned to the quiz.
+  TPqaId Publish(const uint32_t iSlot, BaseQuiz *pQuiz);
+  // Returns the quiz if the ID is live, otherwise nullptr.
+  BaseQuiz* Lookup(const TPqaId iQuiz) const;
+  // Same as Lookup(), but also records the usage time of the quiz and counts the caller as a user of it till Unuse().
+  BaseQuiz* Use(const TPqaId iQuiz);
+  void Unuse(const TPqaId iQuiz);
+  // Returns the time of the last usage of the quiz in terms of CoarseNowSec(). The ID must refer to a slot in the
+  //   range.
+  uint32_t GetLastUsageSec(const TPqaId iQuiz) const;
+  // Returns the quiz taken out of the registry, or nullptr if the ID is not live. Only one of the concurrent
+  //   invalidations of the same ID succeeds. The slot stays reserved: the caller must destroy the quiz and then
+  //   Recycle() the slot.
+  BaseQuiz* Invalidate(const TPqaId iQuiz);
+  // Same as Invalidate(), but fails if the quiz is in use.
+  BaseQuiz* InvalidateIfUnused(const TPqaId iQuiz);
+  // Puts a reserved slot back on the free lists.
+  void Recycle(const uint32_t iSlot);
+  // Returns the ID of the quiz currently occupying the slot, or cInvalidPqaId if the slot is free.
+  TPqaId IdAtSlot(const uint32_t iSlot) const;
+
+  // The number of slots ever used, i.e. the upper bound of slot indices in quiz IDs.
+  TPqaId GetSlotRange() const { return _nextFresh.load(std::memory_order_acquire); }
+  TPqaId GetNLive() const { return _nLive.load(std::memory_order_relaxed); }
+
+  // Calls |f(iQuiz, pQuiz)| for each quiz live at the moment its slot is visited.
+  template<typename taCallback> void ForEachLive(const taCallback &f) const;
+
+  // Counts an operation as a user of a quiz between a successful Use() and the destruction of the object.
+  class UsageLock {
+    QuizRegistry *_pReg;
+    TPqaId _iQuiz;
+
+  public:
+    UsageLock() : _pReg(nullptr), _iQuiz(cInvalidPqaId) { }
+    ~UsageLock() {
+      if (_pReg != nullptr) {
+        _pReg->Unuse(_iQuiz);
+      }
+    }
+    UsageLock(const UsageLock&) = delete;
+    UsageLock& operator=(const UsageLock&) = delete;
+    void Init(QuizRegistry &reg, const TPqaId iQuiz) {
+      assert(_pReg == nullptr);
+      _pReg = &reg;
+      _iQuiz = iQuiz;
+    }
+  };
+};
+
+template<typename taCallback> void QuizRegistry::ForEachLive(const taCallback &f) const {
+  const uint32_t slotRange = _nextFresh.load(std::memory_order_acquire);
+  for (uint32_t i = 0; i < slotRange; i++) {
+    const TPqaId iQuiz = IdAtSlot(i);
+    if (iQuiz == cInvalidPqaId) {
+      continue;
+    }
+    BaseQuiz *pQuiz = Lookup(iQuiz);
+    if (pQuiz == nullptr) {
+      continue;
+    }
+    f(iQuiz, pQuiz);
+  }
+}
+
+} // namespace ProbQA
@@ -0,0 +1,237 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../PqaCore/WriteAheadLog.h"
+#include "../PqaCore/PqaException.h"
+
+using namespace SRPlat;
+
+namespace ProbQA {
+
+SRSmartFile* WriteAheadLog::CreateLog(const char* const path, const uint64_t baseCheckpointId) {
+  std::unique_ptr<SRSmartFile> pSf(new SRSmartFile(std::fopen(path, "wb")));
+  if (pSf->Get() == nullptr) {
+    return nullptr;
+  }
+  WalFileHeader wfh;
+  wfh._magic = WalFileHeader::_cMagic;
+  wfh._formatVersion = WalFileHeader::_cVersion;
+  wfh._headerBytes = sizeof(WalFileHeader);
+  wfh._baseCheckpointId = baseCheckpointId;
+  if (std::fwrite(&wfh, sizeof(wfh), 1, pSf->Get()) != 1 || !pSf->HardFlush()) {
+    return nullptr;
+  }
+  return pSf.release();
+}
+
+WriteAheadLog::WriteAheadLog(const char* const path, const uint64_t baseCheckpointId, const uint64_t validBytes,
+  const uint64_t lastLsn) : _lastLsn(lastLsn), _committedLsn(lastLsn), _path(path),
+  _nBytes((validBytes == 0) ? sizeof(WalFileHeader) : validBytes)
+{
+  if (validBytes == 0) {
+    _pFile.reset(CreateLog(path, baseCheckpointId));
+  }
+  else {
+    _pFile.reset(new SRSmartFile(std::fopen(path, "r+b")));
+    // Cut off a torn record at the end, if any, so that the new records follow the valid ones.
+    if (_pFile->Get() != nullptr && (_chsize_s(_fileno(_pFile->Get()), int64_t(validBytes)) != 0
+      || _fseeki64(_pFile->Get(), 0, SEEK_END) != 0))
+    {
+      _pFile.reset();
+    }
+  }
+  if (_pFile == nullptr || _pFile->Get() == nullptr) {
+    throw PqaException(PqaErrorCode::CantOpenFile, new CantOpenFileErrorParams(path), SRString::MakeUnowned(
+      SR_FILE_LINE "Can't open the write-ahead log."));
+  }
+  _ioThread = std::thread(&WriteAheadLog::RunIo, this);
+}
+
+WriteAheadLog::~WriteAheadLog() {
+  {
+    SRLock<SRCriticalSection> csl(_cs);
+    _bShutdown = true;
+  }
+  _cvWork.WakeAll();
+  _ioThread.join();
+}
+
+void WriteAheadLog::Append(const uint64_t lsn, const WalOp op, std::initializer_list<Chunk> chunks) {
+  WalRecordHeader wrh;
+  std::memset(&wrh, 0, sizeof(wrh));
+  wrh._lsn = lsn;
+  wrh._op = op;
+  size_t nBytes = 0;
+  for (const Chunk& c : chunks) {
+    nBytes += c._nBytes;
+  }
+  if (nBytes > std::numeric_limits<uint32_t>::max()) {
+    throw PqaException(PqaErrorCode::IndexOutOfRange, new IndexOutOfRangeErrorParams(TPqaId(nBytes), 0,
+      TPqaId(std::numeric_limits<uint32_t>::max())), SRString::MakeUnowned(SR_FILE_LINE "The operation is too large"
+        " for a record of the write-ahead log."));
+  }
+  wrh._nBytes = uint32_t(nBytes);
+  uint32_t crc = SRChecksum::Crc32c(&wrh, sizeof(wrh));
+  for (const Chunk& c : chunks) {
+    crc = SRChecksum::Crc32c(c._p, c._nBytes, crc);
+  }
+  wrh._checksum = crc;
+
+  {
+    SRLock<SRCriticalSection> csl(_cs);
+    assert(lsn == _lastLsn + 1);
+    const uint8_t *pWrh = reinterpret_cast<const uint8_t*>(&wrh);
+    _queued.insert(_queued.end(), pWrh, pWrh + sizeof(wrh));
+    for (const Chunk& c : chunks) {
+      const uint8_t *p = static_cast<const uint8_t*>(c._p);
+      _queued.insert(_queued.end(), p, p + c._nBytes);
+    }
+    _lastLsn = lsn;
+  }
+  _cvWork.WakeOne();
+}
+
+uint64_t WriteAheadLog::GetLastLsn() {
+  SRLock<SRCriticalSection> csl(_cs);
+  return _lastLsn;
+}
+
+std::string WriteAheadLog::GetPath() {
+  SRLock<SRCriticalSection> fl(_csFile);
+  return _path;
+}
+
+uint64_t WriteAheadLog::GetNBytes() {
+  SRLock<SRCriticalSection> fl(_csFile);
+  return _nBytes;
+}
+
+bool WriteAheadLog::WaitCommitted(const uint64_t lsn) {
+  SRLock<SRCriticalSection> csl(_cs);
+  while (_committedLsn < lsn && !_bFailed) {
+    _cvCommit.Wait(_cs);
+  }
+  return _committedLsn >= lsn;
+}
+
+bool WriteAheadLog::WriteGroup(const std::vector<uint8_t> &group) {
+  for (SRSmartFile *pSf : { _pFile.get(), _pRotFile.get() }) {
+    if (pSf == nullptr) {
+      continue;
+    }
+    if (std::fwrite(group.data(), 1, group.size(), pSf->Get()) != group.size() || !pSf->HardFlush()) {
+      SRMessageBuilder mb(SR_FILE_LINE "Can't write to the write-ahead log, discarding the further records: ");
+      mb((pSf == _pFile.get()) ? _path : _rotPath);
+      SRDefaultLogger::Get()->Log(ISRLogger::Severity::Error, mb.GetUnownedSRString());
+      return false;
+    }
+    ((pSf == _pFile.get()) ? _nBytes : _rotNBytes) += group.size();
+  }
+  return true;
+}
+
+void WriteAheadLog::RunIo() {
+  std::vector<uint8_t> group;
+  SRLock<SRCriticalSection> csl(_cs);
+  for (;;) {
+    while (_queued.empty() && !_bShutdown) {
+      _cvWork.Wait(_cs);
+    }
+    if (_queued.empty()) {
+      break; // shutting down, and all the records are flushed
+    }
+    // Take all the records queued meanwhile, so that they are flushed at once.
+    group.swap(_queued);
+    const uint64_t groupLsn = _lastLsn;
+    const bool bFailed = _bFailed;
+    csl.EarlyRelease();
+
+    bool bOk = false;
+    if (!bFailed) {
+      SRLock<SRCriticalSection> fl(_csFile);
+      bOk = WriteGroup(group);
+    }
+    group.clear();
+
+    csl.Init(_cs);
+    if (bOk) {
+      _committedLsn = groupLsn;
+    }
+    else {
+      _bFailed = true;
+    }
+    _cvCommit.WakeAll();
+  }
+}
+
+bool WriteAheadLog::BeginRotation(const char* const path, const uint64_t baseCheckpointId) {
+  // The records queued belong to the current base.
+  if (!WaitCommitted(GetLastLsn())) {
+    return false;
+  }
+  SRLock<SRCriticalSection> fl(_csFile);
+  // If the base file is being overwritten, the new log is written aside and replaces the current log only once the
+  //   new base file has replaced the old one, because till then the current log is still needed for the old base.
+  _bRotInPlace = (_path == path);
+  _rotPath = _bRotInPlace ? (_path + ".tmp") : path;
+  _pRotFile.reset(CreateLog(_rotPath.c_str(), baseCheckpointId));
+  _rotNBytes = sizeof(WalFileHeader);
+  return _pRotFile != nullptr;
+}
+
+void WriteAheadLog::FinishRotation(const bool bConfirm) {
+  SRLock<SRCriticalSection> fl(_csFile);
+  // Discards the further records, as they can't be logged for the new base file.
+  auto&& fnFail = [&](const uint32_t le) {
+    _pFile.reset();
+    SRMessageBuilder mb(SR_FILE_LINE "Can't switch to the new write-ahead log, discarding the further records: ");
+    mb(_path)(", GetLastError=")(le);
+    SRDefaultLogger::Get()->Log(ISRLogger::Severity::Error, mb.GetUnownedSRString());
+    _rotPath.clear();
+    fl.EarlyRelease();
+    SRLock<SRCriticalSection> csl(_cs);
+    _bFailed = true;
+    _cvCommit.WakeAll();
+  };
+  if (_pRotFile == nullptr) {
+    // The new log couldn't be created.
+    if (bConfirm && !_rotPath.empty()) {
+      fnFail(0);
+    }
+    return;
+  }
+  if (!bConfirm) {
+    _pRotFile.reset();
+    std::remove(_rotPath.c_str());
+    _rotPath.clear();
+    return;
+  }
+  if (!_bRotInPlace) {
+    // The old log stays consistent with the old base file.
+    _pFile = std::move(_pRotFile);
+    _path.swap(_rotPath);
+    _nBytes = _rotNBytes;
+    _rotPath.clear();
+    return;
+  }
+  // The records are hard-flushed as they are written, so closing the files loses nothing.
+  _pFile.reset();
+  _pRotFile.reset();
+  if (!MoveFileExA(_rotPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    const uint32_t le = GetLastError();
+    std::remove(_rotPath.c_str());
+    fnFail(le);
+    return;
+  }
+  _pFile.reset(new SRSmartFile(std::fopen(_path.c_str(), "r+b")));
+  if (_pFile->Get() == nullptr || _fseeki64(_pFile->Get(), 0, SEEK_END) != 0) {
+    fnFail(0);
+    return;
+  }
+  _nBytes = _rotNBytes;
+  _rotPath.clear();
+}
+
+} // namespace ProbQA
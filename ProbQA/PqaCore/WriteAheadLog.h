@@ -0,0 +1,161 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../PqaCore/Interface/PqaCommon.h"
+
+namespace ProbQA {
+
+// The write-ahead log holds the operations changing the KB since a base KB file in format version 2, so that they
+//   are replayed on top of the base (and its delta file, if any) when the KB is loaded. The file starts with this
+//   header, followed by the records. Each record has a log sequence number (LSN), which grows by 1 with each record
+//   over the lifetime of the KB, and the KB files store the LSN of the last record they include.
+// The records are appended in groups, and the file is flushed to the disk once per group. A torn or corrupt record can
+//   only be at the end of the log, and it ends the replay.
+struct WalFileHeader {
+  static constexpr uint64_t _cMagic = 0x6C77424B41515250; // "PRQAKBwl" in little-endian
+  static constexpr uint32_t _cVersion = 1;
+
+  uint64_t _magic;
+  uint32_t _formatVersion;
+  uint32_t _headerBytes;
+  uint64_t _baseCheckpointId;
+
+  // The log file is named after the base file.
+  static std::string PathFor(const char* const basePath) { return std::string(basePath) + ".wal"; }
+};
+
+enum class WalOp : uint8_t {
+  // Payload: WalTrainingHead, followed by the answered questions.
+  Train = 0,
+  // Same as Train, but doesn't count the questions asked.
+  QuizTarget = 1,
+  // Payload: WalAddHead, followed by the initial amounts of the questions, then of the targets.
+  AddQsTs = 2,
+  // Payload: the number of IDs, followed by the IDs.
+  RemoveQuestions = 3,
+  RemoveTargets = 4,
+  // Payload: uint8_t 1 if the targets were ordered by weight, otherwise 0. Formerly no payload.
+  Compact = 5,
+  // Same as AddQsTs, but the questions and targets were appended rather than placed at the gaps.
+  AppendQsTs = 6,
+  // Payload: the maximum number of targets moved.
+  CompactSlice = 7,
+  // Payload: WalDecayHead.
+  Decay = 8,
+  // Payload: WalQuestionRange.
+  RecomputeD = 9
+};
+
+struct WalRecordHeader {
+  uint64_t _lsn;
+  uint32_t _nBytes; // of the payload following this header
+  // CRC-32C of the payload, continued from the CRC-32C of this header with zero in place of the checksum.
+  uint32_t _checksum;
+  WalOp _op;
+  uint8_t _reserved[7];
+};
+
+struct WalTrainingHead {
+  TPqaId _iTarget;
+  TPqaAmount _amount;
+  TPqaId _nAQs;
+};
+
+struct WalAddHead {
+  TPqaId _nQuestions;
+  TPqaId _nTargets;
+};
+
+struct WalDecayHead {
+  TPqaAmount _factor;
+  TPqaId _iFirstQuestion;
+  TPqaId _iLimQuestion;
+  uint8_t _bDecayB;
+  uint8_t _reserved[7];
+};
+
+struct WalQuestionRange {
+  TPqaId _iFirstQuestion;
+  TPqaId _iLimQuestion;
+};
+
+// A training record being replayed. The answered questions point into the buffer of the records read.
+struct WalTraining {
+  const AnsweredQuestion *_pAQs;
+  TPqaId _nAQs;
+  TPqaId _iTarget;
+  TPqaAmount _amount;
+  bool _bCountAsked; // whether to add |_nAQs| to the number of questions asked
+};
+
+// Appends the records in the background: a dedicated thread writes all the records queued by the moment it wakes up,
+//   and flushes the file once for them. The engine assigns LSNs and appends under exclusive KB lock, so that the order
+//   of the records is the order the operations are applied in. Thread-safe.
+class WriteAheadLog {
+public: // types
+  struct Chunk {
+    const void *_p;
+    size_t _nBytes;
+  };
+
+private: // variables
+  SRPlat::SRCriticalSection _cs;
+  SRPlat::SRConditionVariable _cvWork; // the I/O thread waits for records or shutdown
+  SRPlat::SRConditionVariable _cvCommit; // the clients wait for their records to be flushed
+  std::vector<uint8_t> _queued; // Guarded by _cs
+  uint64_t _lastLsn; // of the records queued. Guarded by _cs
+  uint64_t _committedLsn; // of the records flushed. Guarded by _cs
+  bool _bFailed = false; // Guarded by _cs . After an I/O error the records are discarded.
+  bool _bShutdown = false; // Guarded by _cs
+
+  // Serializes the access to the files between the I/O thread and the rotation.
+  SRPlat::SRCriticalSection _csFile;
+  std::string _path; // Guarded by _csFile
+  std::unique_ptr<SRPlat::SRSmartFile> _pFile; // Guarded by _csFile
+  uint64_t _nBytes; // The size of the log written. Guarded by _csFile
+  // The log for the base KB file being saved. Till the save is confirmed, the records go to both logs.
+  std::string _rotPath; // Guarded by _csFile
+  // Whether the base KB file is saved over the current one, and the new log is thus at a temporary path, to be moved
+  //   over the current log on confirmation. Guarded by _csFile
+  bool _bRotInPlace = false;
+  std::unique_ptr<SRPlat::SRSmartFile> _pRotFile; // Guarded by _csFile
+  uint64_t _rotNBytes = 0; // Guarded by _csFile
+
+  std::thread _ioThread;
+
+private: // methods
+  static SRPlat::SRSmartFile* CreateLog(const char* const path, const uint64_t baseCheckpointId);
+  void RunIo();
+  // Must be called with |_csFile| locked.
+  bool WriteGroup(const std::vector<uint8_t> &group);
+
+public: // methods
+  // Continues the log at |path| from byte |validBytes|, discarding anything after it, or creates the log if
+  //   |validBytes| is 0. Throws on failure.
+  explicit WriteAheadLog(const char* const path, const uint64_t baseCheckpointId, const uint64_t validBytes,
+    const uint64_t lastLsn);
+  // Flushes the records queued.
+  ~WriteAheadLog();
+  WriteAheadLog(const WriteAheadLog&) = delete;
+  WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+  // Queues a record with the payload concatenated from |chunks|.
+  void Append(const uint64_t lsn, const WalOp op, std::initializer_list<Chunk> chunks);
+  uint64_t GetLastLsn();
+  std::string GetPath();
+  // The size of the records flushed, including the header of the log file.
+  uint64_t GetNBytes();
+  // Waits till the records up to |lsn| are flushed. Returns false if the log has failed.
+  bool WaitCommitted(const uint64_t lsn);
+
+  // Starts the log for a new base KB file. Must be called when no records can be appended concurrently.
+  bool BeginRotation(const char* const path, const uint64_t baseCheckpointId);
+  // Switches to the new log once the base KB file is durable in its place, or removes the new log if saving the base
+  //   has failed.
+  void FinishRotation(const bool bConfirm);
+};
+
+} // namespace ProbQA
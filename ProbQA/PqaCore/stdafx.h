@@ -21,13 +21,16 @@
 // STL
 #pragma warning( push )
 #pragma warning( disable : 4251 ) // needs to have dll-interface to be used by clients of class
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
+#include <ctime>
 #include <io.h>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <queue>
 #include <random>
 #include <string>
@@ -53,6 +56,8 @@
 #include "../SRPlatform/Interface/SRBucketSummatorPar.h"
 #include "../SRPlatform/Interface/SRBucketSummatorSeq.h"
 #include "../SRPlatform/Interface/SRCast.h"
+#include "../SRPlatform/Interface/SRChecksum.h"
+#include "../SRPlatform/Interface/SRCompression.h"
 #include "../SRPlatform/Interface/SRConditionVariable.h"
 #include "../SRPlatform/Interface/SRCpuInfo.h"
 #include "../SRPlatform/Interface/SRCriticalSection.h"
@@ -68,9 +73,11 @@
 #include "../SRPlatform/Interface/SRLogStream.h"
 #include "../SRPlatform/Interface/SRMath.h"
 #include "../SRPlatform/Interface/SRMaxSizeof.h"
+#include "../SRPlatform/Interface/SRMemMappedFile.h"
 #include "../SRPlatform/Interface/SRMemPool.h"
 #include "../SRPlatform/Interface/SRMinimalTask.h"
 #include "../SRPlatform/Interface/SRPoolRunner.h"
+#include "../SRPlatform/Interface/SRPositionalFile.h"
 #include "../SRPlatform/Interface/SRReaderWriterSync.h"
 #include "../SRPlatform/Interface/SRSimd.h"
 #include "../SRPlatform/Interface/SRSmartFile.h"
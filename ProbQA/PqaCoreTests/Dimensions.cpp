@@ -84,3 +84,230 @@ TEST(Dimensions, CpuIncrease) {
   }
   delete pEngine;
 }
+
+TEST(Dimensions, CpuOnlineIncrease) {
+  const TPqaAmount initAm = 1.0;
+  PqaError err;
+  EngineDefinition ed;
+  ed._dims._nAnswers = 3;
+  ed._dims._nQuestions = 4;
+  ed._dims._nTargets = 5;
+  ed._initAmount = initAm;
+  ed._prec._type = TPqaPrecisionType::Double;
+  IPqaEngine *pEngine = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  ASSERT_TRUE(err.IsOk());
+  ASSERT_TRUE(pEngine != nullptr);
+
+  // One quiz shares the priors of fresh quizzes, and the other one has its own after an answer.
+  const TPqaId iQuiz1 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const TPqaId iQuiz2 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->SetActiveQuestion(iQuiz2, 0);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->RecordAnswer(iQuiz2, 1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // Add in regular mode, without closing the quizzes.
+  constexpr TPqaId cnQuToAdd = 1;
+  constexpr TPqaId cnTaToAdd = 2;
+  vector<AddQuestionParam> aqps(cnQuToAdd);
+  for (AddQuestionParam &aqp : aqps) {
+    aqp._initialAmount = initAm;
+    aqp._iQuestion = cInvalidPqaId;
+  }
+  vector<AddTargetParam> atps(cnTaToAdd);
+  for (AddTargetParam &atp : atps) {
+    atp._initialAmount = initAm;
+    atp._iTarget = cInvalidPqaId;
+  }
+  err = pEngine->AddQsTs(cnQuToAdd, aqps.data(), cnTaToAdd, atps.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const EngineDimensions dims = pEngine->CopyDims();
+  ASSERT_EQ(dims._nQuestions, ed._dims._nQuestions + cnQuToAdd);
+  ASSERT_EQ(dims._nTargets, ed._dims._nTargets + cnTaToAdd);
+  ASSERT_EQ(aqps[0]._iQuestion, ed._dims._nQuestions);
+  ASSERT_EQ(atps[0]._iTarget, ed._dims._nTargets);
+  ASSERT_EQ(atps[1]._iTarget, ed._dims._nTargets + 1);
+
+  // The untrained KB gives all the targets the same probability, whether they were in the quiz or added after.
+  vector<RatedTarget> rts(dims._nTargets);
+  for (const TPqaId iQuiz : { iQuiz1, iQuiz2 }) {
+    ASSERT_EQ(pEngine->ListTopTargets(err, iQuiz, dims._nTargets, rts.data()), dims._nTargets);
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+    for (const RatedTarget &rt : rts) {
+      ASSERT_NEAR(rt._prob, 1.0 / dims._nTargets, 1e-9);
+    }
+  }
+
+  // The quizzes can be asked and answered the question added.
+  err = pEngine->SetActiveQuestion(iQuiz2, aqps[0]._iQuestion);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->RecordAnswer(iQuiz2, 2);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  pEngine->NextQuestion(err, iQuiz1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->RecordQuizTarget(iQuiz2, atps[1]._iTarget);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iQuiz1).IsOk());
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iQuiz2).IsOk());
+  delete pEngine;
+}
+
+TEST(Dimensions, CpuCompactSlices) {
+  PqaError err;
+  EngineDefinition ed;
+  ed._dims._nAnswers = 3;
+  ed._dims._nQuestions = 2;
+  ed._dims._nTargets = 20;
+  ed._prec._type = TPqaPrecisionType::Double;
+  IPqaEngine *pEngine = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  ASSERT_TRUE(err.IsOk());
+  ASSERT_TRUE(pEngine != nullptr);
+
+  // Each target gets its own weight, so to check that it moves with the target.
+  const AnsweredQuestion aq(1, 2);
+  for (TPqaId i = 0; i < ed._dims._nTargets; i++) {
+    ASSERT_TRUE(pEngine->Train(1, &aq, i, TPqaAmount(i + 1)).IsOk());
+  }
+  vector<TPqaAmount> bBefore(ed._dims._nTargets);
+  err = pEngine->CopyBTargets(ed._dims._nTargets, bBefore.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaAmount> aBefore(ed._dims._nTargets);
+  err = pEngine->CopyATargets(aq._iQuestion, aq._iAnswer, ed._dims._nTargets, aBefore.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaId> permIds(ed._dims._nTargets);
+  for (TPqaId i = 0; i < ed._dims._nTargets; i++) {
+    permIds[i] = i;
+  }
+  ASSERT_TRUE(pEngine->TargetPermFromComp(ed._dims._nTargets, permIds.data()));
+  // The compact IDs of the targets before compaction, by permanent ID.
+  vector<TPqaId> compByPerm;
+  for (TPqaId i = 0; i < ed._dims._nTargets; i++) {
+    if (permIds[i] >= TPqaId(compByPerm.size())) {
+      compByPerm.resize(permIds[i] + 1, cInvalidPqaId);
+    }
+    compByPerm[permIds[i]] = i;
+  }
+
+  err = pEngine->StartMaintenance(false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const TPqaId removed[] = { 1, 2, 3, 5, 8, 13, 19 };
+  constexpr TPqaId cnRemoved = sizeof(removed) / sizeof(removed[0]);
+  err = pEngine->RemoveTargets(cnRemoved, removed);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  for (const TPqaId iTarget : removed) {
+    compByPerm[permIds[iTarget]] = cInvalidPqaId;
+  }
+
+  constexpr TPqaId cMaxMoves = 2;
+  TPqaId nSlices = 0;
+  TPqaId nPrevGaps = cnRemoved;
+  CompactionResult cr;
+  do {
+    err = pEngine->CompactSlice(cr, cMaxMoves);
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+    ASSERT_LT(cr._nTargetGaps, nPrevGaps);
+    nPrevGaps = cr._nTargetGaps;
+    TPqaId nInvalid = 0;
+    for (TPqaId i = 0; i < cr._nTargets; i++) {
+      if (cr._pOldTargets[i] == cInvalidPqaId) {
+        nInvalid++;
+      }
+    }
+    ASSERT_EQ(nInvalid, cr._nTargetGaps);
+    nSlices++;
+  } while (cr._nTargetGaps > 0);
+  ASSERT_GT(nSlices, 1);
+  ASSERT_EQ(cr._nTargets, ed._dims._nTargets - cnRemoved);
+  err = pEngine->FinishMaintenance();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  const EngineDimensions dims = pEngine->CopyDims();
+  ASSERT_EQ(dims._nTargets, ed._dims._nTargets - cnRemoved);
+  vector<TPqaAmount> bAfter(dims._nTargets);
+  err = pEngine->CopyBTargets(dims._nTargets, bAfter.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaAmount> aAfter(dims._nTargets);
+  err = pEngine->CopyATargets(aq._iQuestion, aq._iAnswer, dims._nTargets, aAfter.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  permIds.resize(dims._nTargets);
+  for (TPqaId i = 0; i < dims._nTargets; i++) {
+    permIds[i] = i;
+  }
+  ASSERT_TRUE(pEngine->TargetPermFromComp(dims._nTargets, permIds.data()));
+  for (TPqaId i = 0; i < dims._nTargets; i++) {
+    ASSERT_LT(permIds[i], TPqaId(compByPerm.size()));
+    const TPqaId iOld = compByPerm[permIds[i]];
+    ASSERT_NE(iOld, cInvalidPqaId);
+    ASSERT_EQ(bAfter[i], bBefore[iOld]);
+    ASSERT_EQ(aAfter[i], aBefore[iOld]);
+  }
+  delete pEngine;
+}
+
+TEST(Dimensions, CpuCompactByWeight) {
+  PqaError err;
+  EngineDefinition ed;
+  ed._dims._nAnswers = 3;
+  ed._dims._nQuestions = 2;
+  ed._dims._nTargets = 11;
+  ed._prec._type = TPqaPrecisionType::Double;
+  IPqaEngine *pEngine = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  ASSERT_TRUE(err.IsOk());
+  ASSERT_TRUE(pEngine != nullptr);
+
+  // The weights are not in the order of the targets.
+  const AnsweredQuestion aq(0, 1);
+  for (TPqaId i = 0; i < ed._dims._nTargets; i++) {
+    ASSERT_TRUE(pEngine->Train(1, &aq, i, TPqaAmount(1 + (i * 7) % ed._dims._nTargets)).IsOk());
+  }
+  vector<TPqaAmount> bBefore(ed._dims._nTargets);
+  err = pEngine->CopyBTargets(ed._dims._nTargets, bBefore.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaAmount> aBefore(ed._dims._nTargets);
+  err = pEngine->CopyATargets(aq._iQuestion, aq._iAnswer, ed._dims._nTargets, aBefore.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaId> permBefore(ed._dims._nTargets);
+  for (TPqaId i = 0; i < ed._dims._nTargets; i++) {
+    permBefore[i] = i;
+  }
+  ASSERT_TRUE(pEngine->TargetPermFromComp(ed._dims._nTargets, permBefore.data()));
+
+  err = pEngine->StartMaintenance(false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const TPqaId iRemoved = 4;
+  err = pEngine->RemoveTargets(1, &iRemoved);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  CompactionResult cr;
+  err = pEngine->Compact(cr, true);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->FinishMaintenance();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_EQ(cr._nTargets, ed._dims._nTargets - 1);
+  ASSERT_EQ(cr._nTargetGaps, 0);
+
+  vector<TPqaAmount> bAfter(cr._nTargets);
+  err = pEngine->CopyBTargets(cr._nTargets, bAfter.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaAmount> aAfter(cr._nTargets);
+  err = pEngine->CopyATargets(aq._iQuestion, aq._iAnswer, cr._nTargets, aAfter.data());
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaId> permAfter(cr._nTargets);
+  for (TPqaId i = 0; i < cr._nTargets; i++) {
+    permAfter[i] = i;
+  }
+  ASSERT_TRUE(pEngine->TargetPermFromComp(cr._nTargets, permAfter.data()));
+  for (TPqaId i = 0; i < cr._nTargets; i++) {
+    if (i > 0) {
+      ASSERT_GE(bAfter[i - 1], bAfter[i]);
+    }
+    const TPqaId iOld = cr._pOldTargets[i];
+    ASSERT_NE(iOld, iRemoved);
+    ASSERT_EQ(bAfter[i], bBefore[iOld]);
+    ASSERT_EQ(aAfter[i], aBefore[iOld]);
+    ASSERT_EQ(permAfter[i], permBefore[iOld]);
+  }
+  delete pEngine;
+}
@@ -0,0 +1,569 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "TestHelpers.h"
+
+using namespace ProbQA;
+using namespace SRPlat;
+using namespace std;
+
+namespace {
+
+IPqaEngine* MakeTrainedEngine() {
+  PqaError err;
+  EngineDefinition ed;
+  ed._dims._nAnswers = 3;
+  ed._dims._nQuestions = 4;
+  ed._dims._nTargets = 5;
+  ed._prec._type = TPqaPrecisionType::Double;
+  IPqaEngine *pEngine = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  EXPECT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const AnsweredQuestion aqs[2] = { AnsweredQuestion(0, 1), AnsweredQuestion(3, 2) };
+  for (TPqaId i = 0; i < 7; i++) {
+    err = pEngine->Train(2, aqs, i % 5, 1 + i);
+    EXPECT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  }
+  return pEngine;
+}
+
+// Waits, with a generous timeout, for the checkpointer to finish the number of checkpoints given, counting the failed
+//   ones too.
+CheckpointStats WaitCheckpoints(IPqaEngine *pEngine, const uint64_t nCheckpoints) {
+  CheckpointStats stats;
+  for (int i = 0; i < 200; i++) {
+    EXPECT_TRUE(pEngine->GetCheckpointStats(stats).IsOk());
+    if (stats._nCheckpoints + stats._nFailures >= nCheckpoints && !stats._bInProgress) {
+      break;
+    }
+    this_thread::sleep_for(chrono::milliseconds(50));
+  }
+  return stats;
+}
+
+} // anonymous namespace
+
+TEST(Persistence, MappedKBRoundTrip) {
+  const char* const cKbPath = "PersistenceTest1.kb";
+  const char* const cKbPath2 = "PersistenceTest2.kb";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pOrig, pLoaded);
+  ASSERT_EQ(pOrig->GetTotalQuestionsAsked(err), pLoaded->GetTotalQuestionsAsked(err));
+
+  // The mapping is copy-on-write: training the loaded engine must not change the file.
+  const AnsweredQuestion aq(1, 0);
+  ASSERT_TRUE(pLoaded->Train(1, &aq, 4, 3).IsOk());
+  err = pLoaded->SaveKB(cKbPath2, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  IPqaEngine *pReloaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pOrig, pReloaded);
+  delete pReloaded;
+  IPqaEngine *pTrained = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath2);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pLoaded, pTrained);
+  delete pTrained;
+
+  // Saving back to the file mapped moves the statistics out of the mapping first.
+  err = pLoaded->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  pReloaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pLoaded, pReloaded);
+  // The loaded engine keeps training in its own memory.
+  ASSERT_TRUE(pLoaded->Train(1, &aq, 2, 1).IsOk());
+
+  delete pReloaded;
+  delete pLoaded;
+  delete pOrig;
+  std::remove(cKbPath);
+  std::remove(cKbPath2);
+}
+
+TEST(Persistence, CorruptRegionRejected) {
+  const char* const cKbPath = "PersistenceTest3.kb";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  delete pOrig;
+
+  { // Flip a bit in the first row of the A section, which starts at the allocation granularity after the header.
+    constexpr long cFirstSectionOffset = 1 << 16;
+    FILE *fp = std::fopen(cKbPath, "r+b");
+    ASSERT_TRUE(fp != nullptr);
+    ASSERT_EQ(std::fseek(fp, cFirstSectionOffset, SEEK_SET), 0);
+    const int c = std::fgetc(fp);
+    ASSERT_EQ(std::fseek(fp, cFirstSectionOffset, SEEK_SET), 0);
+    ASSERT_NE(std::fputc(c ^ 1, fp), EOF);
+    ASSERT_EQ(std::fclose(fp), 0);
+  }
+
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(pLoaded == nullptr);
+  ASSERT_FALSE(err.IsOk());
+  std::remove(cKbPath);
+}
+
+TEST(Persistence, IncrementalSaveAndFold) {
+  const char* const cKbPath = "PersistenceTest4.kb";
+  const char* const cFoldedPath = "PersistenceTest5.kb";
+  const string deltaPath = string(cKbPath) + ".delta";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  // There is no base yet.
+  ASSERT_FALSE(pOrig->SaveIncremental().IsOk());
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  const AnsweredQuestion aq(2, 1);
+  ASSERT_TRUE(pOrig->Train(1, &aq, 3, 2).IsOk());
+  err = pOrig->SaveIncremental();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // The delta is applied on load.
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pOrig, pLoaded);
+  ASSERT_EQ(pOrig->GetTotalQuestionsAsked(err), pLoaded->GetTotalQuestionsAsked(err));
+
+  // The loaded engine keeps saving the changes against the same base, including those from the delta loaded.
+  const AnsweredQuestion aq2(0, 2);
+  ASSERT_TRUE(pLoaded->Train(1, &aq2, 1, 5).IsOk());
+  err = pLoaded->SaveIncremental();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  IPqaEngine *pReloaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pLoaded, pReloaded);
+
+  err = PqaGetEngineFactory().FoldKBDelta(cKbPath, cFoldedPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  IPqaEngine *pFolded = PqaGetEngineFactory().LoadCpuEngine(err, cFoldedPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pLoaded, pFolded);
+  ASSERT_EQ(pLoaded->GetTotalQuestionsAsked(err), pFolded->GetTotalQuestionsAsked(err));
+
+  delete pFolded;
+  delete pReloaded;
+  delete pLoaded;
+  delete pOrig;
+  std::remove(cKbPath);
+  std::remove(deltaPath.c_str());
+  std::remove(cFoldedPath);
+}
+
+TEST(Persistence, WalReplay) {
+  const char* const cKbPath = "PersistenceTest6.kb";
+  const string walPath = string(cKbPath) + ".wal";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  // There is no base yet.
+  ASSERT_FALSE(pOrig->StartWal(true).IsOk());
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pOrig->StartWal(true);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  const AnsweredQuestion aqs[3] = { AnsweredQuestion(2, 1), AnsweredQuestion(0, 0), AnsweredQuestion(2, 2) };
+  ASSERT_TRUE(pOrig->Train(3, aqs, 3, 2).IsOk());
+  ASSERT_TRUE(pOrig->Train(1, aqs + 1, 4, 3).IsOk());
+
+  // The engine isn't saved, as if it has crashed: the training is replayed from the log.
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pOrig, pLoaded);
+  ASSERT_EQ(pOrig->GetTotalQuestionsAsked(err), pLoaded->GetTotalQuestionsAsked(err));
+
+  // The loaded engine continues the same log.
+  err = pLoaded->StartWal(false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_TRUE(pLoaded->Train(2, aqs, 0, 1).IsOk());
+  err = pLoaded->StopWal();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  IPqaEngine *pReloaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pLoaded, pReloaded);
+
+  // Training while the log is stopped is lost on a crash, so the log can't be continued until the KB is saved.
+  ASSERT_TRUE(pReloaded->Train(1, aqs, 1, 1).IsOk());
+  ASSERT_FALSE(pReloaded->StartWal(true).IsOk());
+
+  delete pReloaded;
+  delete pLoaded;
+  delete pOrig;
+  std::remove(cKbPath);
+  std::remove(walPath.c_str());
+}
+
+TEST(Persistence, SnapshotUnderTraining) {
+  const char* const cKbPath = "PersistenceTest7.kb";
+  PqaError err;
+  EngineDefinition ed;
+  ed._dims._nAnswers = 3;
+  ed._dims._nQuestions = 200;
+  ed._dims._nTargets = 2000;
+  ed._prec._type = TPqaPrecisionType::Double;
+  IPqaEngine *pEngine = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaAmount> initB(size_t(ed._dims._nTargets));
+  ASSERT_TRUE(pEngine->CopyBTargets(ed._dims._nTargets, initB.data()).IsOk());
+
+  // Train while saving: the file must have either all or none of each training.
+  const AnsweredQuestion aq(0, 1);
+  std::atomic<bool> bStop(false);
+  std::thread trainer([&]() {
+    while (!bStop.load(std::memory_order_relaxed)) {
+      EXPECT_TRUE(pEngine->Train(1, &aq, 7, 1).IsOk());
+    }
+  });
+  err = pEngine->SaveKB(cKbPath, false);
+  bStop.store(true, std::memory_order_relaxed);
+  trainer.join();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  vector<TPqaAmount> b(initB.size());
+  ASSERT_TRUE(pLoaded->CopyBTargets(ed._dims._nTargets, b.data()).IsOk());
+  const TPqaId nTrainings = TPqaId(b[7] - initB[7]);
+  ASSERT_EQ(TPqaId(pLoaded->GetTotalQuestionsAsked(err)), nTrainings);
+
+  // The same number of trainings in another engine gives the same statistics.
+  IPqaEngine *pExpected = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  for (TPqaId i = 0; i < nTrainings; i++) {
+    ASSERT_TRUE(pExpected->Train(1, &aq, 7, 1).IsOk());
+  }
+  ExpectSameStatistics(pExpected, pLoaded);
+
+  delete pExpected;
+  delete pLoaded;
+  delete pEngine;
+  std::remove(cKbPath);
+}
+
+TEST(Persistence, CompressedKBRoundTrip) {
+  const char* const cKbPath = "PersistenceTest8.kb";
+  const char* const cFoldedPath = "PersistenceTest9.kb";
+  const string deltaPath = string(cKbPath) + ".delta";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  ASSERT_TRUE(pOrig->SetCompressKB(true).IsOk());
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pOrig, pLoaded);
+  ASSERT_EQ(pOrig->GetTotalQuestionsAsked(err), pLoaded->GetTotalQuestionsAsked(err));
+
+  // A compressed file is a base for incremental saves too, and its delta is folded into a compressed file.
+  const AnsweredQuestion aq(2, 1);
+  ASSERT_TRUE(pLoaded->Train(1, &aq, 3, 2).IsOk());
+  err = pLoaded->SaveIncremental();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  IPqaEngine *pReloaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pLoaded, pReloaded);
+  err = PqaGetEngineFactory().FoldKBDelta(cKbPath, cFoldedPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  IPqaEngine *pFolded = PqaGetEngineFactory().LoadCpuEngine(err, cFoldedPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pLoaded, pFolded);
+  ASSERT_EQ(pLoaded->GetTotalQuestionsAsked(err), pFolded->GetTotalQuestionsAsked(err));
+
+  delete pFolded;
+  delete pReloaded;
+  delete pLoaded;
+  delete pOrig;
+  std::remove(cKbPath);
+  std::remove(deltaPath.c_str());
+  std::remove(cFoldedPath);
+}
+
+TEST(Persistence, CheckpointScheduler) {
+  const char* const cKbPath = "PersistenceTest10.kb";
+  const string deltaPath = string(cKbPath) + ".delta";
+  IPqaEngine *pEngine = MakeTrainedEngine();
+  ASSERT_TRUE(pEngine != nullptr);
+  CheckpointPolicy policy;
+  ASSERT_EQ(pEngine->StartCheckpointer(policy).GetCode(), PqaErrorCode::NullArgument);
+  policy._filePath = cKbPath;
+  ASSERT_EQ(pEngine->StartCheckpointer(policy).GetCode(), PqaErrorCode::NonPositiveAmount);
+  policy._nTrainings = 1;
+  policy._maxIncremental = 1;
+  policy._maxBytesPerSec = 1 << 20;
+  PqaError err = pEngine->StartCheckpointer(policy);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // Wait for the scheduler to notice the training.
+  const AnsweredQuestion aq(1, 0);
+  ASSERT_TRUE(pEngine->Train(1, &aq, 2, 3).IsOk());
+  CheckpointStats stats = WaitCheckpoints(pEngine, 1);
+  ASSERT_EQ(stats._nCheckpoints, uint64_t(1));
+  ASSERT_EQ(stats._nFailures, uint64_t(0));
+  ASSERT_FALSE(stats._bLastIncremental);
+  ASSERT_GT(stats._lastTimeSec, 0);
+  ASSERT_GT(stats._lastBytes, 0);
+
+  // The next checkpoint is against the base just saved.
+  ASSERT_TRUE(pEngine->Train(1, &aq, 4, 5).IsOk());
+  stats = WaitCheckpoints(pEngine, 2);
+  ASSERT_EQ(stats._nCheckpoints, uint64_t(2));
+  ASSERT_TRUE(stats._bLastIncremental);
+  ASSERT_TRUE(pEngine->StopCheckpointer().IsOk());
+
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pEngine, pLoaded);
+
+  delete pLoaded;
+  delete pEngine;
+  std::remove(cKbPath);
+  std::remove(deltaPath.c_str());
+}
+
+TEST(Persistence, CheckpointerOnLoadedKB) {
+  const char* const cKbPath = "PersistenceTest16.kb";
+  const string deltaPath = string(cKbPath) + ".delta";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  delete pOrig;
+
+  // The checkpoints go to the file the engine is mapped from, which is the base of the incremental ones.
+  IPqaEngine *pEngine = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  CheckpointPolicy policy;
+  policy._filePath = cKbPath;
+  policy._nTrainings = 1;
+  policy._maxIncremental = 1;
+  err = pEngine->StartCheckpointer(policy);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  const AnsweredQuestion aq(2, 1);
+  ASSERT_TRUE(pEngine->Train(1, &aq, 0, 2).IsOk());
+  CheckpointStats stats = WaitCheckpoints(pEngine, 1);
+  ASSERT_EQ(stats._nCheckpoints, uint64_t(1));
+  ASSERT_TRUE(stats._bLastIncremental);
+
+  // The full checkpoint replaces the file mapped.
+  ASSERT_TRUE(pEngine->Train(1, &aq, 3, 4).IsOk());
+  stats = WaitCheckpoints(pEngine, 2);
+  ASSERT_EQ(stats._nCheckpoints, uint64_t(2));
+  ASSERT_EQ(stats._nFailures, uint64_t(0));
+  ASSERT_FALSE(stats._bLastIncremental);
+
+  // And the incremental checkpoints resume against it.
+  ASSERT_TRUE(pEngine->Train(1, &aq, 1, 3).IsOk());
+  stats = WaitCheckpoints(pEngine, 3);
+  ASSERT_EQ(stats._nCheckpoints, uint64_t(3));
+  ASSERT_EQ(stats._nFailures, uint64_t(0));
+  ASSERT_TRUE(stats._bLastIncremental);
+  ASSERT_TRUE(pEngine->StopCheckpointer().IsOk());
+
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pEngine, pLoaded);
+
+  delete pLoaded;
+  delete pEngine;
+  std::remove(cKbPath);
+  std::remove(deltaPath.c_str());
+}
+
+TEST(Persistence, HotSwap) {
+  const char* const cKbPath1 = "PersistenceTest11.kb";
+  const char* const cKbPath2 = "PersistenceTest12.kb";
+  IPqaEngine *pSource = MakeTrainedEngine();
+  ASSERT_TRUE(pSource != nullptr);
+  ASSERT_TRUE(pSource->SaveKB(cKbPath1, false).IsOk());
+  const AnsweredQuestion aq(2, 1);
+  ASSERT_TRUE(pSource->Train(1, &aq, 1, 20).IsOk());
+  ASSERT_TRUE(pSource->SaveKB(cKbPath2, false).IsOk());
+
+  PqaError err;
+  IPqaEngine *pEngine = PqaGetEngineFactory().LoadHotSwapCpuEngine(err, cKbPath1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const TPqaId iOldQuiz = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  TPqaId iOldPerm = iOldQuiz;
+  ASSERT_TRUE(pEngine->QuizPermFromComp(1, &iOldPerm));
+
+  err = pEngine->HotSwapKB(cKbPath2);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pSource, pEngine);
+
+  // The quiz started before the swap keeps running on the old KB.
+  pEngine->NextQuestion(err, iOldQuiz);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  RatedTarget rt;
+  ASSERT_EQ(pEngine->ListTopTargets(err, iOldQuiz, 1, &rt), 1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // But its target trains the KB in service.
+  const TPqaId iOldQuestion = pEngine->GetActiveQuestionId(err, iOldQuiz);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_TRUE(pEngine->RecordAnswer(iOldQuiz, 0).IsOk());
+  err = pEngine->RecordQuizTarget(iOldQuiz, 1, 2);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const AnsweredQuestion oldAq(iOldQuestion, 0);
+  ASSERT_TRUE(pSource->Train(1, &oldAq, 1, 2).IsOk());
+  ExpectSameStatistics(pSource, pEngine);
+
+  // The new quizzes run on the new KB and don't reuse the permanent IDs of the old KB.
+  TPqaId iNewQuiz = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_NE(iNewQuiz, iOldQuiz);
+  ASSERT_EQ(pEngine->ListTopTargets(err, iNewQuiz, 1, &rt), 1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_EQ(rt._iTarget, 1);
+  TPqaId iNewPerm = iNewQuiz;
+  ASSERT_TRUE(pEngine->QuizPermFromComp(1, &iNewPerm));
+  ASSERT_GT(iNewPerm, iOldPerm);
+
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iOldQuiz).IsOk());
+  ASSERT_EQ(pEngine->ReleaseQuiz(iOldQuiz).GetCode(), PqaErrorCode::AbsentId);
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iNewQuiz).IsOk());
+
+  delete pEngine;
+  delete pSource;
+  std::remove(cKbPath1);
+  std::remove(cKbPath2);
+}
+
+TEST(Persistence, WarmupOnLoad) {
+  const char* const cKbPath = "PersistenceTest13.kb";
+  IPqaEngine *pSource = MakeTrainedEngine();
+  ASSERT_TRUE(pSource != nullptr);
+  ASSERT_TRUE(pSource->SaveKB(cKbPath, false).IsOk());
+
+  PqaError err;
+  IPqaEngine *pEngine = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath, EngineDefinition::_cDefaultMemPoolMaxBytes,
+    /*bWarmup*/ true);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  // The synthetic quiz neither trains the KB nor counts as a question asked.
+  ExpectSameStatistics(pSource, pEngine);
+  ASSERT_EQ(pEngine->GetTotalQuestionsAsked(err), pSource->GetTotalQuestionsAsked(err));
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  ASSERT_TRUE(pEngine->StartMaintenance(false).IsOk());
+  ASSERT_EQ(pEngine->Warmup().GetCode(), PqaErrorCode::WrongMode);
+  ASSERT_TRUE(pEngine->FinishMaintenance().IsOk());
+  err = pEngine->Warmup();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  delete pEngine;
+  delete pSource;
+  std::remove(cKbPath);
+}
+
+TEST(Persistence, DecayReplay) {
+  const char* const cKbPath = "PersistenceTest14.kb";
+  const string walPath = string(cKbPath) + ".wal";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pOrig->StartWal(true);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  const EngineDimensions dims = pOrig->CopyDims();
+  vector<TPqaAmount> aBefore(size_t(dims._nTargets)), dBefore(size_t(dims._nTargets)), bBefore(size_t(dims._nTargets));
+  ASSERT_TRUE(pOrig->CopyATargets(3, 2, dims._nTargets, aBefore.data()).IsOk());
+  ASSERT_TRUE(pOrig->CopyDTargets(3, dims._nTargets, dBefore.data()).IsOk());
+  ASSERT_TRUE(pOrig->CopyBTargets(dims._nTargets, bBefore.data()).IsOk());
+  ASSERT_EQ(pOrig->DecayStatistics(0, 1).GetCode(), PqaErrorCode::NonPositiveAmount);
+  // The slices don't divide the questions evenly.
+  err = pOrig->DecayStatistics(0.5, 3);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // A and D hold the squares of the amounts.
+  vector<TPqaAmount> after(size_t(dims._nTargets));
+  ASSERT_TRUE(pOrig->CopyATargets(3, 2, dims._nTargets, after.data()).IsOk());
+  for (TPqaId i = 0; i < dims._nTargets; i++) {
+    ASSERT_EQ(after[i], aBefore[i] * 0.25);
+  }
+  ASSERT_TRUE(pOrig->CopyDTargets(3, dims._nTargets, after.data()).IsOk());
+  for (TPqaId i = 0; i < dims._nTargets; i++) {
+    ASSERT_EQ(after[i], dBefore[i] * 0.25);
+  }
+  ASSERT_TRUE(pOrig->CopyBTargets(dims._nTargets, after.data()).IsOk());
+  for (TPqaId i = 0; i < dims._nTargets; i++) {
+    ASSERT_EQ(after[i], bBefore[i] * 0.5);
+  }
+
+  // The log replays the decay in the order of the training around it.
+  const AnsweredQuestion aq(1, 0);
+  ASSERT_TRUE(pOrig->Train(1, &aq, 2, 3).IsOk());
+
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pOrig, pLoaded);
+
+  delete pLoaded;
+  delete pOrig;
+  std::remove(cKbPath);
+  std::remove(walPath.c_str());
+}
+
+TEST(Persistence, RecomputeDReplay) {
+  const char* const cKbPath = "PersistenceTest15.kb";
+  const string walPath = string(cKbPath) + ".wal";
+  IPqaEngine *pOrig = MakeTrainedEngine();
+  ASSERT_TRUE(pOrig != nullptr);
+  PqaError err = pOrig->SaveKB(cKbPath, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pOrig->StartWal(true);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // Amounts not representable exactly in binary leave rounding errors in D.
+  const AnsweredQuestion aqs[2] = { AnsweredQuestion(1, 0), AnsweredQuestion(2, 1) };
+  for (TPqaId i = 0; i < 20; i++) {
+    ASSERT_TRUE(pOrig->Train(2, aqs, i % 5, 0.1 * (i + 1)).IsOk());
+  }
+  TPqaAmount maxDrift = -1;
+  err = pOrig->RecomputeD(maxDrift, 3);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_GE(maxDrift, 0);
+  ASSERT_LT(maxDrift, 1e-9);
+
+  const EngineDimensions dims = pOrig->CopyDims();
+  vector<TPqaAmount> a(size_t(dims._nTargets)), sums(size_t(dims._nTargets), 0), d(size_t(dims._nTargets));
+  for (TPqaId i = 0; i < dims._nQuestions; i++) {
+    std::fill(sums.begin(), sums.end(), 0);
+    for (TPqaId k = 0; k < dims._nAnswers; k++) {
+      ASSERT_TRUE(pOrig->CopyATargets(i, k, dims._nTargets, a.data()).IsOk());
+      for (TPqaId j = 0; j < dims._nTargets; j++) {
+        sums[j] += a[j];
+      }
+    }
+    ASSERT_TRUE(pOrig->CopyDTargets(i, dims._nTargets, d.data()).IsOk());
+    for (TPqaId j = 0; j < dims._nTargets; j++) {
+      ASSERT_DOUBLE_EQ(sums[j], d[j]);
+    }
+  }
+  // D is now exact, so there's nothing left to correct.
+  err = pOrig->RecomputeD(maxDrift);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_EQ(maxDrift, 0);
+
+  ASSERT_TRUE(pOrig->Train(1, aqs, 3, 0.7).IsOk());
+  IPqaEngine *pLoaded = PqaGetEngineFactory().LoadCpuEngine(err, cKbPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ExpectSameStatistics(pOrig, pLoaded);
+
+  delete pLoaded;
+  delete pOrig;
+  std::remove(cKbPath);
+  std::remove(walPath.c_str());
+}
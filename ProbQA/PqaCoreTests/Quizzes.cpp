@@ -0,0 +1,293 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "TestHelpers.h"
+
+using namespace ProbQA;
+using namespace SRPlat;
+using namespace std;
+
+namespace {
+
+IPqaEngine* MakeSmallEngine() {
+  PqaError err;
+  EngineDefinition ed;
+  ed._dims._nAnswers = 3;
+  ed._dims._nQuestions = 4;
+  ed._dims._nTargets = 5;
+  ed._prec._type = TPqaPrecisionType::Double;
+  IPqaEngine *pEngine = PqaGetEngineFactory().CreateCpuEngine(err, ed);
+  EXPECT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  return pEngine;
+}
+
+} // anonymous namespace
+
+TEST(Quizzes, StaleIdRejected) {
+  IPqaEngine *pEngine = MakeSmallEngine();
+  ASSERT_TRUE(pEngine != nullptr);
+  PqaError err;
+
+  const TPqaId iQuiz1 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->ReleaseQuiz(iQuiz1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // The slot is reused, but the old ID must not refer to the new quiz.
+  const TPqaId iQuiz2 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_NE(iQuiz1, iQuiz2);
+  pEngine->GetActiveQuestionId(err, iQuiz1);
+  ASSERT_EQ(err.GetCode(), PqaErrorCode::AbsentId);
+  err = pEngine->ReleaseQuiz(iQuiz1);
+  ASSERT_EQ(err.GetCode(), PqaErrorCode::AbsentId);
+
+  pEngine->GetActiveQuestionId(err, iQuiz2);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->ReleaseQuiz(iQuiz2);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  delete pEngine;
+}
+
+TEST(Quizzes, ReapByCount) {
+  IPqaEngine *pEngine = MakeSmallEngine();
+  ASSERT_TRUE(pEngine != nullptr);
+  PqaError err;
+
+  constexpr TPqaId cnQuizzes = 100;
+  constexpr TPqaId cMaxCount = 10;
+  vector<TPqaId> quizIds;
+  for (TPqaId i = 0; i < cnQuizzes; i++) {
+    quizIds.push_back(pEngine->StartQuiz(err));
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  }
+  err = pEngine->SetQuizExpiry(cMaxCount, 0, false);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->ReapQuizzes();
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  TPqaId nLive = 0;
+  for (const TPqaId iQuiz : quizIds) {
+    pEngine->GetActiveQuestionId(err, iQuiz);
+    if (err.IsOk()) {
+      nLive++;
+    }
+    else {
+      ASSERT_EQ(err.GetCode(), PqaErrorCode::AbsentId);
+    }
+  }
+  ASSERT_EQ(nLive, cMaxCount);
+  delete pEngine;
+}
+
+TEST(Quizzes, SharedPriorsCopyOnWrite) {
+  IPqaEngine *pEngine = MakeSmallEngine();
+  ASSERT_TRUE(pEngine != nullptr);
+  PqaError err;
+  constexpr TPqaId cnTargets = 5;
+  RatedTarget rts[cnTargets];
+
+  const TPqaId iQuiz1 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const TPqaId iQuiz2 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  // Answering in one quiz must not change the priors of the other.
+  const AnsweredQuestion aq(0, 0);
+  ASSERT_TRUE(pEngine->Train(1, &aq, 2, 10).IsOk());
+  pEngine->NextQuestion(err, iQuiz1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->RecordAnswer(iQuiz1, 0);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_EQ(pEngine->ListTopTargets(err, iQuiz2, cnTargets, rts), cnTargets);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  for (TPqaId i = 0; i < cnTargets; i++) {
+    ASSERT_NEAR(rts[i]._prob, 1.0 / cnTargets, 1e-9);
+  }
+
+  // A quiz started after training must see the new priors.
+  const TPqaId iQuiz3 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_EQ(pEngine->ListTopTargets(err, iQuiz3, 1, rts), 1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_EQ(rts[0]._iTarget, 2);
+
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iQuiz1).IsOk());
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iQuiz2).IsOk());
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iQuiz3).IsOk());
+  delete pEngine;
+}
+
+TEST(Quizzes, SaveLoad) {
+  IPqaEngine *pEngine = MakeSmallEngine();
+  ASSERT_TRUE(pEngine != nullptr);
+  PqaError err;
+  constexpr TPqaId cnTargets = 5;
+  const char* const cQuizPath = "QuizzesTest1.qz";
+
+  const AnsweredQuestion aq(1, 2);
+  ASSERT_TRUE(pEngine->Train(1, &aq, 3, 10).IsOk());
+  const TPqaId iQuiz1 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const TPqaId iQuiz2 = pEngine->ResumeQuiz(err, 1, &aq);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  err = pEngine->SetActiveQuestion(iQuiz2, 0);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  RatedTarget expected[cnTargets];
+  ASSERT_EQ(pEngine->ListTopTargets(err, iQuiz2, cnTargets, expected), cnTargets);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  TPqaId permIds[2] = { iQuiz1, iQuiz2 };
+  ASSERT_TRUE(pEngine->QuizPermFromComp(2, permIds));
+
+  err = pEngine->SaveQuizzes(cQuizPath);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  pEngine->LoadQuizzes(err, cQuizPath);
+  ASSERT_EQ(err.GetCode(), PqaErrorCode::QuizzesActive);
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iQuiz1).IsOk());
+  ASSERT_TRUE(pEngine->ReleaseQuiz(iQuiz2).IsOk());
+
+  // The priors of the quiz answered must be restored as saved, rather than recomputed from the KB trained meanwhile.
+  ASSERT_TRUE(pEngine->Train(1, &aq, 4, 100).IsOk());
+  ASSERT_EQ(pEngine->LoadQuizzes(err, cQuizPath), 2);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  TPqaId quizIds[2] = { permIds[0], permIds[1] };
+  ASSERT_TRUE(pEngine->QuizCompFromPerm(2, quizIds));
+  ASSERT_NE(quizIds[0], cInvalidPqaId);
+  ASSERT_NE(quizIds[1], cInvalidPqaId);
+  ASSERT_EQ(pEngine->GetActiveQuestionId(err, quizIds[1]), 0);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  RatedTarget actual[cnTargets];
+  ASSERT_EQ(pEngine->ListTopTargets(err, quizIds[1], cnTargets, actual), cnTargets);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  for (TPqaId i = 0; i < cnTargets; i++) {
+    ASSERT_EQ(actual[i]._iTarget, expected[i]._iTarget);
+    ASSERT_EQ(actual[i]._prob, expected[i]._prob);
+  }
+  // The answers are restored too, so the questions answered aren't asked again.
+  err = pEngine->RecordAnswer(quizIds[1], 1);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  const TPqaId iNextQ = pEngine->NextQuestion(err, quizIds[1]);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_TRUE(iNextQ == 2 || iNextQ == 3);
+
+  // The quizzes started after the restore don't reuse the permanent IDs.
+  TPqaId iQuiz3 = pEngine->StartQuiz(err);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  ASSERT_TRUE(pEngine->QuizPermFromComp(1, &iQuiz3));
+  ASSERT_GT(iQuiz3, std::max(permIds[0], permIds[1]));
+  delete pEngine;
+}
+
+TEST(Quizzes, AnalyzeQuestions) {
+  IPqaEngine *pEngine = MakeSmallEngine();
+  ASSERT_TRUE(pEngine != nullptr);
+  PqaError err;
+  constexpr TPqaId cnQuestions = 4;
+  constexpr TPqaId cnTargets = 5;
+  QuestionInfo infos[cnQuestions];
+
+  // Question 1 splits the targets as question 0 does, but with less evidence. Questions 2 and 3 are untrained.
+  for (TPqaId i = 0; i < cnTargets; i++) {
+    const AnsweredQuestion aq0(0, i % 3);
+    ASSERT_TRUE(pEngine->Train(1, &aq0, i, 100).IsOk());
+    const AnsweredQuestion aq1(1, i % 3);
+    ASSERT_TRUE(pEngine->Train(1, &aq1, i, 10).IsOk());
+  }
+  ASSERT_EQ(pEngine->AnalyzeQuestions(err, cnQuestions, infos), cnQuestions);
+  ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+
+  ASSERT_EQ(infos[0]._iQuestion, 2);
+  ASSERT_NEAR(infos[0]._infoGain, 0, 1e-9);
+  ASSERT_EQ(infos[0]._iRedundantWith, cInvalidPqaId);
+  ASSERT_EQ(infos[1]._iQuestion, 3);
+  ASSERT_NEAR(infos[1]._infoGain, 0, 1e-9);
+  ASSERT_EQ(infos[1]._iRedundantWith, 2);
+  ASSERT_EQ(infos[2]._iQuestion, 1);
+  ASSERT_GT(infos[2]._infoGain, 1e-3);
+  ASSERT_EQ(infos[2]._iRedundantWith, 0);
+  ASSERT_EQ(infos[3]._iQuestion, 0);
+  ASSERT_GT(infos[3]._infoGain, infos[2]._infoGain);
+  ASSERT_EQ(infos[3]._iRedundantWith, cInvalidPqaId);
+  TPqaAmount totSelProb = 0;
+  for (TPqaId i = 0; i < cnQuestions; i++) {
+    ASSERT_GE(infos[i]._selectionProb, 0);
+    totSelProb += infos[i]._selectionProb;
+  }
+  ASSERT_NEAR(totSelProb, 1, 1e-9);
+
+  ASSERT_EQ(pEngine->AnalyzeQuestions(err, 1, infos), 1);
+  ASSERT_EQ(infos[0]._iQuestion, 2);
+  pEngine->AnalyzeQuestions(err, -1, infos);
+  ASSERT_EQ(err.GetCode(), PqaErrorCode::NegativeCount);
+  delete pEngine;
+}
+
+TEST(Quizzes, RecordLongQuizTarget) {
+  IPqaEngine *pQuizzed = MakeSmallEngine();
+  ASSERT_TRUE(pQuizzed != nullptr);
+  IPqaEngine *pTrained = MakeSmallEngine();
+  ASSERT_TRUE(pTrained != nullptr);
+  PqaError err;
+  constexpr TPqaId cnAnswers = 3;
+  constexpr TPqaId cnQuestions = 4;
+
+  // Both short and long quizzes, the latter recorded by the workers, must train the KB as Train() does.
+  for (const TPqaId nAnswered : { TPqaId(5), TPqaId(67) }) {
+    vector<AnsweredQuestion> aqs;
+    for (TPqaId i = 0; i < nAnswered; i++) {
+      aqs.emplace_back(i % cnQuestions, (i / cnQuestions) % cnAnswers);
+    }
+    const TPqaId iQuiz = pQuizzed->ResumeQuiz(err, nAnswered, aqs.data());
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+    err = pQuizzed->RecordQuizTarget(iQuiz, 2, 1.5);
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+    ASSERT_TRUE(pQuizzed->ReleaseQuiz(iQuiz).IsOk());
+    err = pTrained->Train(nAnswered, aqs.data(), 2, 1.5);
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+  }
+
+  ExpectSameStatistics(pTrained, pQuizzed);
+  delete pTrained;
+  delete pQuizzed;
+}
+
+TEST(Quizzes, RecordQuizTargetInQuartets) {
+  IPqaEngine *pQuizzed = MakeSmallEngine();
+  ASSERT_TRUE(pQuizzed != nullptr);
+  IPqaEngine *pTrained = MakeSmallEngine();
+  ASSERT_TRUE(pTrained != nullptr);
+  PqaError err;
+
+  // The answered questions are trained in quartets, which fall back to pairs when a question repeats, so the questions
+  //   repeat in the leading pair, across the pairs and in the tail pair of a quartet. The KB must be the same as after
+  //   one answered question at a time.
+  const vector<vector<AnsweredQuestion>> cases = {
+    // The first quartet has distinct questions, and the second has question 2 at positions 0 and 2.
+    { AnsweredQuestion(0, 1), AnsweredQuestion(1, 2), AnsweredQuestion(2, 0), AnsweredQuestion(3, 1),
+      AnsweredQuestion(2, 1), AnsweredQuestion(0, 0), AnsweredQuestion(2, 2), AnsweredQuestion(3, 0),
+      AnsweredQuestion(1, 1) },
+    // Question 1 at positions 0 and 1, with different answers, then question 3 with the same answer.
+    { AnsweredQuestion(1, 0), AnsweredQuestion(1, 2), AnsweredQuestion(0, 1), AnsweredQuestion(3, 2),
+      AnsweredQuestion(3, 1), AnsweredQuestion(3, 1), AnsweredQuestion(2, 0), AnsweredQuestion(0, 2) },
+    // Question 2 at positions 2 and 3, with different answers, then question 0 with the same answer.
+    { AnsweredQuestion(0, 2), AnsweredQuestion(3, 1), AnsweredQuestion(2, 0), AnsweredQuestion(2, 1),
+      AnsweredQuestion(1, 1), AnsweredQuestion(3, 0), AnsweredQuestion(0, 2), AnsweredQuestion(0, 2) },
+  };
+  for (const vector<AnsweredQuestion>& aqs : cases) {
+    const TPqaId nAnswered = TPqaId(aqs.size());
+    const TPqaId iQuiz = pQuizzed->ResumeQuiz(err, nAnswered, aqs.data());
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+    err = pQuizzed->RecordQuizTarget(iQuiz, 4, 0.3);
+    ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+    ASSERT_TRUE(pQuizzed->ReleaseQuiz(iQuiz).IsOk());
+    for (TPqaId i = 0; i < nAnswered; i++) {
+      err = pTrained->Train(1, aqs.data() + i, 4, 0.3);
+      ASSERT_TRUE(err.IsOk()) << err.ToString(true).ToStd();
+    }
+    ExpectSameStatistics(pTrained, pQuizzed);
+  }
+  delete pTrained;
+  delete pQuizzed;
+}
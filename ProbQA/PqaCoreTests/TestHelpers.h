@@ -0,0 +1,29 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+// Asserts that the engines have the same dimensions and exactly the same A, D and B statistics.
+inline void ExpectSameStatistics(ProbQA::IPqaEngine *pExpected, ProbQA::IPqaEngine *pActual) {
+  using namespace ProbQA;
+  const EngineDimensions dims = pExpected->CopyDims();
+  const EngineDimensions actDims = pActual->CopyDims();
+  ASSERT_EQ(dims._nAnswers, actDims._nAnswers);
+  ASSERT_EQ(dims._nQuestions, actDims._nQuestions);
+  ASSERT_EQ(dims._nTargets, actDims._nTargets);
+  std::vector<TPqaAmount> expected(size_t(dims._nTargets)), actual(size_t(dims._nTargets));
+  for (TPqaId i = 0; i < dims._nQuestions; i++) {
+    for (TPqaId k = 0; k < dims._nAnswers; k++) {
+      ASSERT_TRUE(pExpected->CopyATargets(i, k, dims._nTargets, expected.data()).IsOk());
+      ASSERT_TRUE(pActual->CopyATargets(i, k, dims._nTargets, actual.data()).IsOk());
+      ASSERT_EQ(expected, actual);
+    }
+    ASSERT_TRUE(pExpected->CopyDTargets(i, dims._nTargets, expected.data()).IsOk());
+    ASSERT_TRUE(pActual->CopyDTargets(i, dims._nTargets, actual.data()).IsOk());
+    ASSERT_EQ(expected, actual);
+  }
+  ASSERT_TRUE(pExpected->CopyBTargets(dims._nTargets, expected.data()).IsOk());
+  ASSERT_TRUE(pActual->CopyBTargets(dims._nTargets, actual.data()).IsOk());
+  ASSERT_EQ(expected, actual);
+}
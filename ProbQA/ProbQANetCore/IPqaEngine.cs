@@ -26,5 +26,6 @@ namespace ProbQANetCore
     PqaError ReleaseQuiz(Int64 iQuiz);
 
     PqaError SaveKB(string filePath, bool bDoubleBuffer);
+    PqaError HotSwapKB(string filePath);
   }
 }
@@ -282,5 +282,14 @@ namespace ProbQANetCore
     {
       return PqaError.Factor(PqaEngine_SaveKB(_nativeEngine, filePath, (byte)(bDoubleBuffer ? 1 : 0)));
     }
+
+    [DllImport("PqaCore.dll", CallingConvention = CallingConvention.Cdecl)]
+    private static extern IntPtr PqaEngine_HotSwapKB(IntPtr pEngine, string filePath);
+
+    // Only supported by the engines loaded with PqaEngineFactory.LoadHotSwapCpuEngine().
+    public PqaError HotSwapKB(string filePath)
+    {
+      return PqaError.Factor(PqaEngine_HotSwapKB(_nativeEngine, filePath));
+    }
   }
 }
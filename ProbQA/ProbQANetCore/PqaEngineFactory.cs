@@ -32,6 +32,10 @@ namespace ProbQANetCore
     private static extern IntPtr PqaEngineFactory_LoadCpuEngine(IntPtr pFactory, ref IntPtr ppError, string filePath,
       UInt64 memPoolMaxBytes = EngineDefinition.cDefaultMemPoolMaxBytes);
 
+    [DllImport("PqaCore.dll", CallingConvention = CallingConvention.Cdecl)]
+    private static extern IntPtr PqaEngineFactory_LoadHotSwapCpuEngine(IntPtr pFactory, ref IntPtr ppError,
+      string filePath, UInt64 memPoolMaxBytes = EngineDefinition.cDefaultMemPoolMaxBytes);
+
     private static PqaEngineFactory _instance;
     private static Object _sync = new Object();
 
@@ -111,5 +115,26 @@ namespace ProbQANetCore
       }
       return new PqaEngine(nativeEngine);
     }
+
+    public PqaEngine LoadHotSwapCpuEngine(out PqaError err, string filePath,
+      ulong memPoolMaxBytes = EngineDefinition.cDefaultMemPoolMaxBytes)
+    {
+      IntPtr nativeEngine;
+      IntPtr nativeError = IntPtr.Zero;
+      try
+      {
+        nativeEngine = PqaEngineFactory_LoadHotSwapCpuEngine(_nativeFactory, ref nativeError, filePath,
+          memPoolMaxBytes);
+      }
+      finally
+      {
+        err = PqaError.Factor(nativeError);
+      }
+      if(nativeEngine == IntPtr.Zero)
+      {
+        return null; // Shall we throw an exception here instead?
+      }
+      return new PqaEngine(nativeEngine);
+    }
   }
 }
@@ -28,6 +28,8 @@ public:
   }
   inline SRAccumVectDbl256& __vectorcall Add(const __m256d value);
   inline SRAccumVectDbl256& __vectorcall Add(SRVectCompCount at, const double value);
+  // The sums of the components taken separately.
+  __m256d __vectorcall GetComponents() const { return _mm256_sub_pd(_sum, _corr); }
   //Note: this method is not at maximum precision.
   inline double __vectorcall GetFullSum() const;
   inline double __vectorcall PreciseSum() const;
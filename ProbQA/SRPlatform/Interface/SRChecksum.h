@@ -0,0 +1,18 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../SRPlatform/Interface/SRPlatform.h"
+
+namespace SRPlat {
+
+class SRPLATFORM_API SRChecksum {
+public: // methods
+  // CRC-32C (Castagnoli) using the SSE4.2 instruction. Pass the result of the previous call as |crc| in order to
+  //   continue the checksum over multiple chunks.
+  static uint32_t Crc32c(const void *p, const size_t nBytes, const uint32_t crc = 0);
+};
+
+} // namespace SRPlat
@@ -0,0 +1,37 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../SRPlatform/Interface/SRPlatform.h"
+
+namespace SRPlat {
+
+// Block compression for arrays of numbers. The bytes of the numbers are shuffled first, so that the bytes of the same
+//   significance become adjacent: the exponents and the upper bytes of the mantissas of similar numbers then form long
+//   repeats. The blocks are compressed with an LZ77 codec in the manner of LZ4, independently of each other, so that
+//   multiple threads can compress and decompress different blocks.
+class SRPLATFORM_API SRCompression {
+public: // constants
+  static constexpr size_t _cMinMatch = 4;
+  // Matches are looked up within this distance back.
+  static constexpr size_t _cMaxOffset = (size_t(1) << 16) - 1;
+
+public: // methods
+  // The size of the destination buffer that Compress() needs for a block of |nBytes|.
+  static size_t MaxCompressedBytes(const size_t nBytes) { return nBytes + nBytes / 255 + 16; }
+
+  // Transposes |nBytes| / |itemBytes| items, so that the destination holds the first bytes of all the items, then the
+  //   second bytes, etc. The trailing bytes not making a whole item are copied as is.
+  static void Shuffle(const void *pSrc, const size_t nBytes, const size_t itemBytes, void *pDest);
+  // The inverse of Shuffle().
+  static void Unshuffle(const void *pSrc, const size_t nBytes, const size_t itemBytes, void *pDest);
+
+  // Returns the size of the compressed block written to |pDest|, which must have MaxCompressedBytes(nSrcBytes).
+  static size_t Compress(const void *pSrc, const size_t nSrcBytes, void *pDest);
+  // Returns false if the block is corrupt or doesn't decompress to exactly |nDestBytes|.
+  static bool Decompress(const void *pSrc, const size_t nSrcBytes, void *pDest, const size_t nDestBytes);
+};
+
+} // namespace SRPlat
@@ -23,11 +23,15 @@ protected: // variables
 
 // It must be possible to init and copy items trivially, but they may have constructors/assignment operators which do
 //   not block this possibility.
+// The array can also borrow memory it doesn't own, e.g. a memory-mapped file. Such memory is never freed by the array,
+//   and the array owns its memory again after a reallocation.
 template<typename taItem, bool taCacheDefault> class SRFastArray : public SRFastArrayBase {
 public: // constants
 
 private: // variables
   taItem *_pItems;
+  size_t _capacity; // the number of items the memory suffices for, including the padding of the allocation
+  bool _bBorrowed;
 
 private: // methods
   //TODO: consider unifying such methods with SRQueue etc.
@@ -53,17 +57,39 @@ private: // methods
     size_t paddedBytes;
     return ThrowingAlloc(nItems, paddedBytes);
   }
+  static size_t CapacityFromBytes(const size_t paddedBytes) {
+    return paddedBytes / sizeof(taItem);
+  }
+  // Reallocates for |capacity| items, keeping the current items.
+  template<bool taCache> void Reallocate(const size_t capacity) {
+    size_t newPaddedBytes;
+    AlignedUniquePtr<taItem> pNewItems(ThrowingAlloc(capacity, newPaddedBytes));
+    const size_t oldPaddedBytes = GetPaddedByteCount(_count);
+    SRUtils::Copy256<taCache, false>(pNewItems.get(), _pItems,
+      std::min(newPaddedBytes, oldPaddedBytes) >> SRSimd::_cLogNBytes);
+    FreeItems();
+    _pItems = pNewItems.release();
+    _capacity = CapacityFromBytes(newPaddedBytes);
+  }
+  void FreeItems() {
+    if (!_bBorrowed) {
+      _mm_free(_pItems);
+    }
+    _bBorrowed = false;
+  }
 
   // Leaves the destination object empty if unable to allocate memory. This is to avoid excessive memory usage.
   template<bool taFellowCD> SRFastArray& CopyAssign(const SRFastArray<taItem, taFellowCD>& fellow) {
     if (static_cast<SRFastArrayBase*>(this) != static_cast<const SRFastArrayBase*>(&fellow)) {
-      const size_t oldBytes = GetPaddedByteCount(_count);
+      const size_t oldBytes = GetPaddedByteCount(_capacity);
       const size_t targetBytes = GetPaddedByteCount(fellow._count);
-      if (oldBytes != targetBytes) {
-        _mm_free(_pItems);
-        _pItems = _mm_malloc(targetBytes, sizeof(__m256i));
+      if (oldBytes != targetBytes || _bBorrowed) {
+        FreeItems();
+        _pItems = static_cast<taItem*>(_mm_malloc(targetBytes, sizeof(__m256i)));
+        _capacity = CapacityFromBytes(targetBytes);
         if (_pItems == nullptr) {
           _count = 0;
+          _capacity = 0;
           throw SRException(SRMessageBuilder(SR_FILE_LINE " failed to reallocate from ")(oldBytes)(" to ")
             (targetBytes)(" bytes.").GetOwnedSRString());
         }
@@ -77,19 +103,24 @@ private: // methods
 
   template<bool taFellowCD> SRFastArray& MoveAssign(SRFastArray<taItem, taFellowCD>&& fellow) noexcept {
     if (static_cast<SRFastArrayBase*>(this) != static_cast<const SRFastArrayBase*>(&fellow)) {
-      _mm_free(_pItems);
+      FreeItems();
       _pItems = fellow._pItems;
       _count = fellow._count;
+      _capacity = fellow._capacity;
+      _bBorrowed = fellow._bBorrowed;
       fellow._pItems = nullptr;
       fellow._count = 0;
+      fellow._capacity = 0;
+      fellow._bBorrowed = false;
     }
     return *this;
   }
 
 public: // methods
-  explicit SRFastArray() : _pItems(nullptr) { }
-  explicit SRFastArray(const size_t count) : SRFastArrayBase(count), _pItems(ThrowingAlloc(count)) {
-  }
+  explicit SRFastArray() : _pItems(nullptr), _capacity(0), _bBorrowed(false) { }
+  explicit SRFastArray(const size_t count) : SRFastArrayBase(count), _pItems(ThrowingAlloc(count)),
+    _capacity(CapacityFromBytes(GetPaddedByteCount(count))), _bBorrowed(false)
+  { }
   ~SRFastArray() {
     Clear();
   }
@@ -97,10 +128,11 @@ public: // methods
   SRFastArray(const SRFastArray& fellow) : SRFastArray(fellow, 0) { }
 
   template<bool taFellowCD> SRFastArray(const SRFastArray<taItem, taFellowCD>& fellow, int=0)
-    : SRFastArrayBase(fellow)
+    : SRFastArrayBase(fellow), _bBorrowed(false)
   {
     size_t paddedBytes;
     _pItems = ThrowingAlloc(_count, paddedBytes);
+    _capacity = CapacityFromBytes(paddedBytes);
     const size_t nVects = paddedBytes >> SRSimd::_cLogNBytes;
     SRUtils::Copy256<taCacheDefault, taFellowCD>(_pItems, fellow._pItems, nVects);
   }
@@ -117,18 +149,21 @@ public: // methods
   SRFastArray(SRFastArray&& fellow) noexcept : SRFastArray(std::forward<SRFastArray>(fellow), 0) { }
 
   template<bool taFellowCD> SRFastArray(SRFastArray<taItem, taFellowCD>&& fellow, int=0) noexcept
-    : SRFastArrayBase(std::forward<SRFastArrayBase>(fellow)), _pItems(fellow._pItems)
+    : SRFastArrayBase(std::forward<SRFastArrayBase>(fellow)), _pItems(fellow._pItems),
+    _capacity(fellow._capacity), _bBorrowed(fellow._bBorrowed)
   {
     fellow._pItems = nullptr;
     fellow._count = 0;
+    fellow._capacity = 0;
+    fellow._bBorrowed = false;
   }
 
 
   SRFastArray& operator=(SRFastArray&& fellow) noexcept {
-    return MoveAssign(fellow);
+    return MoveAssign(std::move(fellow));
   }
   template<bool taFellowCD> SRFastArray& operator=(SRFastArray<taItem, taFellowCD>&& fellow) noexcept {
-    return MoveAssign(fellow);
+    return MoveAssign(std::move(fellow));
   }
 
   // __vectorcall can pass in registers first 4 integer parameters, but 6 first vector parameters. Therefore vector
@@ -194,19 +229,25 @@ public: // methods
   }
 
   // If newCount is greater than the current count, the new items are left uninitialized.
-  // Note: unline vector::resize(), repeatedly calling this method results in quadratic complexity because the array
-  //   doesn't operate any capacity, but only the size. This method is O(N).
+  // Note: unline vector::resize(), repeatedly calling this method results in quadratic complexity because it always
+  //   reallocates to the exact size. This method is O(N). See GrowTo() for growing with a headroom.
   template<bool taCache> void Resize(const size_t newCount) {
-    size_t newPaddedBytes;
-    AlignedUniquePtr<taItem> pNewItems(ThrowingAlloc(newCount, newPaddedBytes));
-    const size_t oldPaddedBytes = GetPaddedByteCount(_count);
-    SRUtils::Copy256<taCache, false>(pNewItems.get(), _pItems,
-      std::min(newPaddedBytes, oldPaddedBytes) >> SRSimd::_cLogNBytes);
-    _mm_free(_pItems);
-    _pItems = pNewItems.release();
+    Reallocate<taCache>(newCount);
+    _count = newCount;
+  }
+
+  // Grows the array to |newCount| items in place if the capacity suffices. Otherwise reallocates with |headroom| more
+  //   items, so that the next growths within it neither reallocate nor copy. The new items are left uninitialized.
+  template<bool taCache> void GrowTo(const size_t newCount, const size_t headroom) {
+    assert(newCount >= _count);
+    if (newCount > _capacity || _bBorrowed) {
+      Reallocate<taCache>(newCount + headroom);
+    }
     _count = newCount;
   }
 
+  size_t GetCapacity() const { return _capacity; }
+
   taItem& operator[](const size_t index) {
     return _pItems[index];
   }
@@ -215,9 +256,28 @@ public: // methods
   }
 
   void Clear() {
-    _mm_free(_pItems);
+    FreeItems();
     _pItems = nullptr;
     _count = 0;
+    _capacity = 0;
+  }
+
+  // |pItems| must be SIMD-aligned and span the padded byte count for |count| items. The memory must stay valid until
+  //   the array is cleared, destroyed or reallocated.
+  void Borrow(taItem *pItems, const size_t count) {
+    FreeItems();
+    _pItems = pItems;
+    _count = count;
+    _capacity = count;
+    _bBorrowed = true;
+  }
+
+  bool IsBorrowed() const { return _bBorrowed; }
+  // Copies the items borrowed into memory owned by the array, so that the memory borrowed can be released.
+  template<bool taCache> void Own() {
+    if (_bBorrowed) {
+      Reallocate<taCache>(_count);
+    }
   }
 
   taItem* Get() {
@@ -230,6 +290,8 @@ public: // methods
   template<bool taFellowCD> void Swap(SRFastArray<taItem, taFellowCD>& fellow) {
     std::swap(_count, fellow._count);
     std::swap(_pItems, fellow._pItems);
+    std::swap(_capacity, fellow._capacity);
+    std::swap(_bBorrowed, fellow._bBorrowed);
   }
 };
 
@@ -0,0 +1,49 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../SRPlatform/Interface/SRPlatform.h"
+
+namespace SRPlat {
+
+// Maps a whole file into the address space of the process. The pages are shared with the page cache and other
+//   processes mapping the same file, until a page is written in copy-on-write mode: then the process gets a private
+//   copy of the page, and the file is never modified.
+class SRPLATFORM_API SRMemMappedFile {
+public: // types
+  enum class Mode : uint8_t {
+    ReadOnly = 0,
+    CopyOnWrite = 1
+  };
+
+public: // constants
+  // Offsets of the views must be multiples of this on Windows. It's also a multiple of page size.
+  static constexpr uint64_t _cAllocGranularity = uint64_t(1) << 16;
+
+private: // variables
+  HANDLE _hFile;
+  HANDLE _hMapping;
+  uint8_t *_pView;
+  uint64_t _nBytes;
+
+private: // methods
+  void Close();
+
+public: // methods
+  // Throws SRException if the file can't be opened or mapped.
+  explicit SRMemMappedFile(const char* const filePath, const Mode mode);
+  ~SRMemMappedFile();
+  SRMemMappedFile(const SRMemMappedFile&) = delete;
+  SRMemMappedFile& operator=(const SRMemMappedFile&) = delete;
+  SRMemMappedFile(SRMemMappedFile&&) = delete;
+  SRMemMappedFile& operator=(SRMemMappedFile&&) = delete;
+
+  uint8_t* Get() const { return _pView; }
+  uint64_t Size() const { return _nBytes; }
+  // Whether |filePath| refers to the file mapped, even through a different path or link.
+  bool IsOf(const char* const filePath) const;
+};
+
+} // namespace SRPlat
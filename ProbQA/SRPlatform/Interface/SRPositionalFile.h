@@ -0,0 +1,40 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#pragma once
+
+#include "../SRPlatform/Interface/SRPlatform.h"
+
+namespace SRPlat {
+
+// A file for reading and writing at explicit offsets. Unlike stdio streams, it has no file position and no buffer, so
+//   multiple threads can issue their I/O operations concurrently, and the operations are not serialized by the OS.
+class SRPLATFORM_API SRPositionalFile {
+public: // types
+  enum class Mode : uint8_t {
+    Read = 0,
+    Write = 1
+  };
+
+private: // variables
+  HANDLE _hFile;
+
+private: // methods
+  template<bool taWrite> bool Transfer(void *p, size_t nBytes, uint64_t offset);
+
+public: // methods
+  // The file must exist. Other handles may read and write it meanwhile. Throws SRException if the file can't be opened.
+  explicit SRPositionalFile(const char* const filePath, const Mode mode);
+  ~SRPositionalFile();
+  SRPositionalFile(const SRPositionalFile&) = delete;
+  SRPositionalFile& operator=(const SRPositionalFile&) = delete;
+
+  // These methods are thread-safe. They return false and log the error on failure.
+  bool Read(void *pDest, const size_t nBytes, const uint64_t offset);
+  bool Write(const void *pSrc, const size_t nBytes, const uint64_t offset);
+  // Makes the data written reach the disk.
+  bool Flush();
+};
+
+} // namespace SRPlat
@@ -0,0 +1,26 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../SRPlatform/Interface/SRChecksum.h"
+
+namespace SRPlat {
+
+uint32_t SRChecksum::Crc32c(const void *p, const size_t nBytes, const uint32_t crc) {
+  const uint8_t *pCur = static_cast<const uint8_t*>(p);
+  const uint8_t *const pLim = pCur + nBytes;
+  uint64_t state = uint32_t(~crc);
+  //TODO: interleave 3 independent chains to hide the latency of the instruction. A single chain is still several GB/s
+  //  per core though.
+  for (; pCur + sizeof(uint64_t) <= pLim; pCur += sizeof(uint64_t)) {
+    state = _mm_crc32_u64(state, *reinterpret_cast<const uint64_t*>(pCur));
+  }
+  uint32_t state32 = uint32_t(state);
+  for (; pCur < pLim; pCur++) {
+    state32 = _mm_crc32_u8(state32, *pCur);
+  }
+  return ~state32;
+}
+
+} // namespace SRPlat
@@ -0,0 +1,202 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../SRPlatform/Interface/SRCompression.h"
+
+// The compressed block is a sequence of (token, literals, offset, match) in the format of LZ4. The high nibble of the
+//   token is the number of literals, the low nibble is the match length minus _cMinMatch. A nibble of 15 is continued in
+//   the following bytes, which are added up till a byte other than 255. The offset of the match back from the current
+//   position takes 2 bytes in little-endian. The last sequence has only the literals.
+
+namespace SRPlat {
+
+namespace {
+  constexpr uint8_t cNibbleMax = 15;
+  constexpr uint32_t cHashLog = 16;
+
+  inline uint32_t Read32(const uint8_t *p) {
+    uint32_t ans;
+    std::memcpy(&ans, p, sizeof(ans));
+    return ans;
+  }
+
+  inline uint32_t Hash(const uint32_t seq) {
+    return (seq * 2654435761U) >> (32 - cHashLog);
+  }
+
+  inline uint8_t* WriteLengthTail(uint8_t *pOut, size_t len) {
+    for (; len >= 255; len -= 255) {
+      *pOut++ = 255;
+    }
+    *pOut++ = uint8_t(len);
+    return pOut;
+  }
+
+  inline bool ReadLengthTail(const uint8_t *&pIn, const uint8_t *const pInEnd, size_t &len) {
+    for (;;) {
+      if (pIn >= pInEnd) {
+        return false;
+      }
+      const uint8_t b = *pIn++;
+      len += b;
+      if (b != 255) {
+        return true;
+      }
+    }
+  }
+
+  // |matchLen|=0 for the last sequence.
+  uint8_t* WriteSequence(uint8_t *pOut, const uint8_t *pLiterals, const size_t nLiterals, const size_t offset,
+    const size_t matchLen)
+  {
+    uint8_t *pToken = pOut++;
+    uint8_t token;
+    if (nLiterals >= cNibbleMax) {
+      token = cNibbleMax << 4;
+      pOut = WriteLengthTail(pOut, nLiterals - cNibbleMax);
+    }
+    else {
+      token = uint8_t(nLiterals << 4);
+    }
+    std::memcpy(pOut, pLiterals, nLiterals);
+    pOut += nLiterals;
+    if (matchLen != 0) {
+      *pOut++ = uint8_t(offset);
+      *pOut++ = uint8_t(offset >> 8);
+      const size_t matchCode = matchLen - SRCompression::_cMinMatch;
+      if (matchCode >= cNibbleMax) {
+        token |= cNibbleMax;
+        pOut = WriteLengthTail(pOut, matchCode - cNibbleMax);
+      }
+      else {
+        token |= uint8_t(matchCode);
+      }
+    }
+    *pToken = token;
+    return pOut;
+  }
+}
+
+void SRCompression::Shuffle(const void *pSrc, const size_t nBytes, const size_t itemBytes, void *pDest) {
+  const uint8_t *pIn = static_cast<const uint8_t*>(pSrc);
+  uint8_t *pOut = static_cast<uint8_t*>(pDest);
+  const size_t nItems = nBytes / itemBytes;
+  for (size_t i = 0; i < nItems; i++) {
+    for (size_t j = 0; j < itemBytes; j++) {
+      pOut[j * nItems + i] = pIn[i * itemBytes + j];
+    }
+  }
+  const size_t nWhole = nItems * itemBytes;
+  std::memcpy(pOut + nWhole, pIn + nWhole, nBytes - nWhole);
+}
+
+void SRCompression::Unshuffle(const void *pSrc, const size_t nBytes, const size_t itemBytes, void *pDest) {
+  const uint8_t *pIn = static_cast<const uint8_t*>(pSrc);
+  uint8_t *pOut = static_cast<uint8_t*>(pDest);
+  const size_t nItems = nBytes / itemBytes;
+  for (size_t i = 0; i < nItems; i++) {
+    for (size_t j = 0; j < itemBytes; j++) {
+      pOut[i * itemBytes + j] = pIn[j * nItems + i];
+    }
+  }
+  const size_t nWhole = nItems * itemBytes;
+  std::memcpy(pOut + nWhole, pIn + nWhole, nBytes - nWhole);
+}
+
+size_t SRCompression::Compress(const void *pSrc, const size_t nSrcBytes, void *pDest) {
+  const uint8_t *const pBase = static_cast<const uint8_t*>(pSrc);
+  const uint8_t *const pEnd = pBase + nSrcBytes;
+  uint8_t *pOut = static_cast<uint8_t*>(pDest);
+  const uint8_t *pAnchor = pBase;
+  if (nSrcBytes > _cMinMatch) {
+    // The positions of the last occurrences of 4-byte sequences, by hash. The candidates are verified, so the table
+    //   doesn't need initialization beyond zeros, and the positions truncated in huge blocks only miss matches.
+    std::unique_ptr<uint32_t[]> table(new uint32_t[size_t(1) << cHashLog]());
+    const uint8_t *const pMatchFirstLim = pEnd - _cMinMatch + 1;
+    const uint8_t *pCur = pBase + 1;
+    uint32_t nMisses = 0;
+    while (pCur < pMatchFirstLim) {
+      const uint32_t seq = Read32(pCur);
+      uint32_t &slot = table[Hash(seq)];
+      const uint8_t *pRef = pBase + slot;
+      slot = uint32_t(pCur - pBase);
+      if (pRef >= pCur || size_t(pCur - pRef) > _cMaxOffset || Read32(pRef) != seq) {
+        // Skip faster through the data that doesn't compress.
+        pCur += 1 + (nMisses++ >> 6);
+        continue;
+      }
+      nMisses = 0;
+      while (pCur > pAnchor && pRef > pBase && pCur[-1] == pRef[-1]) {
+        pCur--;
+        pRef--;
+      }
+      const uint8_t *pMatchEnd = pCur + _cMinMatch;
+      for (const uint8_t *pRefCur = pRef + _cMinMatch; pMatchEnd < pEnd && *pMatchEnd == *pRefCur; pRefCur++) {
+        pMatchEnd++;
+      }
+      pOut = WriteSequence(pOut, pAnchor, pCur - pAnchor, pCur - pRef, pMatchEnd - pCur);
+      pCur = pAnchor = pMatchEnd;
+    }
+  }
+  pOut = WriteSequence(pOut, pAnchor, pEnd - pAnchor, 0, 0);
+  return pOut - static_cast<uint8_t*>(pDest);
+}
+
+bool SRCompression::Decompress(const void *pSrc, const size_t nSrcBytes, void *pDest, const size_t nDestBytes) {
+  const uint8_t *pIn = static_cast<const uint8_t*>(pSrc);
+  const uint8_t *const pInEnd = pIn + nSrcBytes;
+  uint8_t *const pOutBase = static_cast<uint8_t*>(pDest);
+  uint8_t *pOut = pOutBase;
+  uint8_t *const pOutEnd = pOutBase + nDestBytes;
+  for (;;) {
+    if (pIn >= pInEnd) {
+      return false;
+    }
+    const uint8_t token = *pIn++;
+    size_t nLiterals = token >> 4;
+    if (nLiterals == cNibbleMax && !ReadLengthTail(pIn, pInEnd, nLiterals)) {
+      return false;
+    }
+    if (nLiterals > size_t(pInEnd - pIn) || nLiterals > size_t(pOutEnd - pOut)) {
+      return false;
+    }
+    std::memcpy(pOut, pIn, nLiterals);
+    pIn += nLiterals;
+    pOut += nLiterals;
+    if (pIn == pInEnd) {
+      return pOut == pOutEnd; // the last sequence
+    }
+
+    if (pInEnd - pIn < 2) {
+      return false;
+    }
+    const size_t offset = size_t(pIn[0]) | (size_t(pIn[1]) << 8);
+    pIn += 2;
+    if (offset == 0 || offset > size_t(pOut - pOutBase)) {
+      return false;
+    }
+    size_t matchLen = token & cNibbleMax;
+    if (matchLen == cNibbleMax && !ReadLengthTail(pIn, pInEnd, matchLen)) {
+      return false;
+    }
+    matchLen += _cMinMatch;
+    if (matchLen > size_t(pOutEnd - pOut)) {
+      return false;
+    }
+    const uint8_t *pMatch = pOut - offset;
+    if (offset >= matchLen) {
+      std::memcpy(pOut, pMatch, matchLen);
+    }
+    else {
+      // The match overlaps the output, repeating the last |offset| bytes.
+      for (size_t i = 0; i < matchLen; i++) {
+        pOut[i] = pMatch[i];
+      }
+    }
+    pOut += matchLen;
+  }
+}
+
+} // namespace SRPlat
@@ -0,0 +1,90 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../SRPlatform/Interface/SRMemMappedFile.h"
+#include "../SRPlatform/Interface/SRException.h"
+#include "../SRPlatform/Interface/SRLogMacros.h"
+#include "../SRPlatform/Interface/SRMessageBuilder.h"
+
+namespace SRPlat {
+
+SRMemMappedFile::SRMemMappedFile(const char* const filePath, const Mode mode) : _hFile(INVALID_HANDLE_VALUE),
+  _hMapping(nullptr), _pView(nullptr), _nBytes(0)
+{
+  auto&& fnFail = [&](const char* const what) {
+    const uint32_t le = GetLastError();
+    Close();
+    throw SRException(SRMessageBuilder(SR_FILE_LINE)(what)(" failed for file ")(filePath)(", GetLastError=")(le)
+      .GetOwnedSRString());
+  };
+  // Writers are not allowed, because the mapping must reflect the file as of the moment of opening.
+  _hFile = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+  if (_hFile == INVALID_HANDLE_VALUE) {
+    fnFail("CreateFileA()");
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(_hFile, &fileSize)) {
+    fnFail("GetFileSizeEx()");
+  }
+  _nBytes = uint64_t(fileSize.QuadPart);
+  if (_nBytes == 0) {
+    return; // Windows can't map an empty file
+  }
+  _hMapping = CreateFileMappingA(_hFile, nullptr, (mode == Mode::CopyOnWrite) ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0,
+    nullptr);
+  if (_hMapping == nullptr) {
+    fnFail("CreateFileMappingA()");
+  }
+  _pView = static_cast<uint8_t*>(MapViewOfFile(_hMapping, (mode == Mode::CopyOnWrite) ? FILE_MAP_COPY : FILE_MAP_READ,
+    0, 0, 0));
+  if (_pView == nullptr) {
+    fnFail("MapViewOfFile()");
+  }
+}
+
+SRMemMappedFile::~SRMemMappedFile() {
+  Close();
+}
+
+void SRMemMappedFile::Close() {
+  if (_pView != nullptr) {
+    if (!UnmapViewOfFile(_pView)) {
+      SR_DLOG_WINFAIL_GLE(Error);
+    }
+    _pView = nullptr;
+  }
+  if (_hMapping != nullptr) {
+    if (!CloseHandle(_hMapping)) {
+      SR_DLOG_WINFAIL_GLE(Error);
+    }
+    _hMapping = nullptr;
+  }
+  if (_hFile != INVALID_HANDLE_VALUE) {
+    if (!CloseHandle(_hFile)) {
+      SR_DLOG_WINFAIL_GLE(Error);
+    }
+    _hFile = INVALID_HANDLE_VALUE;
+  }
+}
+
+bool SRMemMappedFile::IsOf(const char* const filePath) const {
+  // Opening without access rights doesn't conflict with the sharing mode of |_hFile|.
+  HANDLE hOther = CreateFileA(filePath, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (hOther == INVALID_HANDLE_VALUE) {
+    return false; // a file that doesn't exist can't be mapped
+  }
+  BY_HANDLE_FILE_INFORMATION mine, other;
+  const bool bSame = GetFileInformationByHandle(_hFile, &mine) && GetFileInformationByHandle(hOther, &other)
+    && mine.dwVolumeSerialNumber == other.dwVolumeSerialNumber && mine.nFileIndexHigh == other.nFileIndexHigh
+    && mine.nFileIndexLow == other.nFileIndexLow;
+  if (!CloseHandle(hOther)) {
+    SR_DLOG_WINFAIL_GLE(Error);
+  }
+  return bSame;
+}
+
+} // namespace SRPlat
@@ -0,0 +1,94 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+#include "../SRPlatform/Interface/SRPositionalFile.h"
+#include "../SRPlatform/Interface/SRException.h"
+#include "../SRPlatform/Interface/SRLogMacros.h"
+#include "../SRPlatform/Interface/SRMessageBuilder.h"
+
+namespace SRPlat {
+
+namespace {
+  // ReadFile() and WriteFile() take 32-bit byte counts.
+  constexpr size_t cMaxChunkBytes = size_t(1) << 30;
+}
+
+SRPositionalFile::SRPositionalFile(const char* const filePath, const Mode mode) {
+  // Overlapped handle, otherwise the OS serializes the operations on it.
+  _hFile = CreateFileA(filePath, (mode == Mode::Write) ? GENERIC_WRITE : GENERIC_READ,
+    FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+  if (_hFile == INVALID_HANDLE_VALUE) {
+    const uint32_t le = GetLastError();
+    throw SRException(SRMessageBuilder(SR_FILE_LINE "CreateFileA() failed for file ")(filePath)(", GetLastError=")(le)
+      .GetOwnedSRString());
+  }
+}
+
+SRPositionalFile::~SRPositionalFile() {
+  if (!CloseHandle(_hFile)) {
+    SR_DLOG_WINFAIL_GLE(Error);
+  }
+}
+
+template<bool taWrite> bool SRPositionalFile::Transfer(void *p, size_t nBytes, uint64_t offset) {
+  HANDLE hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+  if (hEvent == nullptr) {
+    SR_DLOG_WINFAIL_GLE(Error);
+    return false;
+  }
+  bool bOk = true;
+  uint8_t *pCur = static_cast<uint8_t*>(p);
+  while (nBytes > 0) {
+    const DWORD nChunk = DWORD(std::min(nBytes, cMaxChunkBytes));
+    OVERLAPPED ovl;
+    memset(&ovl, 0, sizeof(ovl));
+    ovl.Offset = DWORD(offset);
+    ovl.OffsetHigh = DWORD(offset >> 32);
+    ovl.hEvent = hEvent;
+    const BOOL bStarted = taWrite ? WriteFile(_hFile, pCur, nChunk, nullptr, &ovl)
+      : ReadFile(_hFile, pCur, nChunk, nullptr, &ovl);
+    if (!bStarted && GetLastError() != ERROR_IO_PENDING) {
+      SR_DLOG_WINFAIL_GLE(Error);
+      bOk = false;
+      break;
+    }
+    DWORD nDone;
+    if (!GetOverlappedResult(_hFile, &ovl, &nDone, TRUE)) {
+      SR_DLOG_WINFAIL_GLE(Error);
+      bOk = false;
+      break;
+    }
+    if (nDone == 0) {
+      // Reading beyond the end of file
+      bOk = false;
+      break;
+    }
+    pCur += nDone;
+    nBytes -= nDone;
+    offset += nDone;
+  }
+  if (!CloseHandle(hEvent)) {
+    SR_DLOG_WINFAIL_GLE(Error);
+  }
+  return bOk;
+}
+
+bool SRPositionalFile::Read(void *pDest, const size_t nBytes, const uint64_t offset) {
+  return Transfer<false>(pDest, nBytes, offset);
+}
+
+bool SRPositionalFile::Write(const void *pSrc, const size_t nBytes, const uint64_t offset) {
+  return Transfer<true>(const_cast<void*>(pSrc), nBytes, offset);
+}
+
+bool SRPositionalFile::Flush() {
+  if (!FlushFileBuffers(_hFile)) {
+    SR_DLOG_WINFAIL_GLE(Error);
+    return false;
+  }
+  return true;
+}
+
+} // namespace SRPlat
@@ -0,0 +1,56 @@
+// Probabilistic Question-Answering system
+// @2017 Sarge Rogatch
+// This software is distributed under GNU AGPLv3 license. See file LICENSE in repository root for details.
+
+#include "stdafx.h"
+
+using namespace SRPlat;
+
+namespace {
+
+void RoundTrip(const std::vector<double> &src, const size_t nBytes) {
+  const uint8_t *pSrc = reinterpret_cast<const uint8_t*>(src.data());
+  std::vector<uint8_t> shuffled(nBytes + 1), compressed(SRCompression::MaxCompressedBytes(nBytes)),
+    decompressed(nBytes + 1), restored(nBytes + 1);
+  SRCompression::Shuffle(pSrc, nBytes, sizeof(double), shuffled.data());
+  const size_t nCompressed = SRCompression::Compress(shuffled.data(), nBytes, compressed.data());
+  ASSERT_LE(nCompressed, compressed.size());
+  ASSERT_TRUE(SRCompression::Decompress(compressed.data(), nCompressed, decompressed.data(), nBytes));
+  SRCompression::Unshuffle(decompressed.data(), nBytes, sizeof(double), restored.data());
+  ASSERT_EQ(0, std::memcmp(restored.data(), pSrc, nBytes));
+  // A truncated block, or the wrong size of the output, must be detected.
+  ASSERT_FALSE(SRCompression::Decompress(compressed.data(), nCompressed - 1, decompressed.data(), nBytes));
+  ASSERT_FALSE(SRCompression::Decompress(compressed.data(), nCompressed, decompressed.data(), nBytes + 1));
+}
+
+} // anonymous namespace
+
+TEST(SRCompressionTest, RoundTrip) {
+  std::mt19937_64 rng(17);
+  for (const size_t nItems : { 0, 1, 2, 7, 100, 5000, 300000 }) {
+    std::vector<double> constant(nItems, 1.0), similar(nItems), noise(nItems);
+    for (size_t i = 0; i < nItems; i++) {
+      similar[i] = double(rng() % 100) / 7;
+      noise[i] = double(rng());
+    }
+    for (const std::vector<double> *pV : { &constant, &similar, &noise }) {
+      // Also an odd number of bytes, for the trailing bytes of the shuffle.
+      RoundTrip(*pV, nItems * sizeof(double));
+      if (nItems != 0) {
+        RoundTrip(*pV, nItems * sizeof(double) - 3);
+      }
+    }
+  }
+}
+
+TEST(SRCompressionTest, Ratio) {
+  constexpr size_t cnItems = 1 << 16;
+  std::vector<double> v(cnItems);
+  for (size_t i = 0; i < cnItems; i++) {
+    v[i] = 1.0 + (i % 64);
+  }
+  std::vector<uint8_t> shuffled(sizeof(v[0]) * cnItems), compressed(SRCompression::MaxCompressedBytes(shuffled.size()));
+  SRCompression::Shuffle(v.data(), shuffled.size(), sizeof(v[0]), shuffled.data());
+  const size_t nCompressed = SRCompression::Compress(shuffled.data(), shuffled.size(), compressed.data());
+  EXPECT_LT(nCompressed * 8, shuffled.size());
+}
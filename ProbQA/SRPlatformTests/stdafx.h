@@ -41,6 +41,7 @@
 #include "../SRPlatform/Interface/SRBitArray.h"
 #include "../SRPlatform/Interface/SRBucketSummatorPar.h"
 #include "../SRPlatform/Interface/SRBucketSummatorSeq.h"
+#include "../SRPlatform/Interface/SRCompression.h"
 #include "../SRPlatform/Interface/SRFastRandom.h"
 #include "../SRPlatform/Interface/SRHeap.h"
 #include "../SRPlatform/Interface/SRQueue.h"